@@ -0,0 +1,86 @@
+#include "persistence_adapter.h"
+#include "config.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <cstdlib>
+
+// Adapter-level throughput against a local PostgreSQL: caller threads issue insert() (write batching
+// off, one autocommit statement per call) and then get() on a key range for a fixed duration, with 16-byte
+// and 4 KiB values, straight through PersistenceAdapter without the HTTP server. Connection string from
+// PG_CONNINFO or config/db.json (see config.h). Writes keys from 910000000 upwards and removes them
+// afterwards. Size the pool (DB_POOL_SIZE) to at least the thread count to measure the wire, not the pool.
+//
+//   g++ -std=c++17 -O2 bench/bench_adapter.cpp persistence_adapter.cpp -I include -I third_party
+//       -I"$(pg_config --includedir)" -L"$(pg_config --libdir)" -lpq -lpthread -o bench_adapter.out
+// Usage: ./bench_adapter.out [duration_ms=2000] [threads=4] [keys=10000]
+
+namespace {
+
+constexpr int64_t kKeyBase = 910000000;
+
+// Calls op(rng) from every thread until duration_ms elapses; returns successful calls per second.
+double run_ops(int threads, int duration_ms, const std::function<bool(std::mt19937_64&)>& op) {
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> done(threads, 0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937_64 rng(static_cast<uint64_t>(t) * 7919u + 1u);
+            unsigned long long local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (op(rng)) ++local;
+            }
+            done[t] = local;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long total = 0;
+    for (auto v : done) total += v;
+    return static_cast<double>(total) / secs;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 4;
+    int keys = argc > 3 ? std::atoi(argv[3]) : 10000;
+    if (duration_ms <= 0) duration_ms = 2000;
+    if (threads <= 0) threads = 4;
+    if (keys <= 0) keys = 10000;
+
+    std::unique_ptr<PersistenceAdapter> db;
+    try {
+        db = std::make_unique<PersistenceAdapter>(load_conninfo());
+    } catch (const std::exception& e) {
+        std::cerr << "cannot connect to PostgreSQL: " << e.what() << "\n";
+        return 2;
+    }
+    db->setWriteBatching(0, std::chrono::microseconds(0));
+
+    std::cout << "binary values (bytea): " << (db->binaryValues() ? "yes" : "no") << ", threads: " << threads
+              << ", keys: " << keys << "\n";
+    std::cout << "value bytes     insert/s        get/s\n";
+    for (size_t size : {size_t{16}, size_t{4096}}) {
+        const std::string value(size, 'v');
+        auto pick = [keys](std::mt19937_64& rng) { return kKeyBase + static_cast<int64_t>(rng() % static_cast<uint64_t>(keys)); };
+        double inserts = run_ops(threads, duration_ms, [&](std::mt19937_64& rng) { return db->insert(pick(rng), value); });
+        double gets = run_ops(threads, duration_ms, [&](std::mt19937_64& rng) { return db->get(pick(rng)) != nullptr; });
+        std::cout << std::setw(11) << size << std::fixed << std::setprecision(0)
+                  << std::setw(13) << inserts << std::setw(13) << gets << "\n";
+    }
+
+    for (int64_t k = kKeyBase; k < kKeyBase + keys; ++k) db->remove(k);
+    return 0;
+}
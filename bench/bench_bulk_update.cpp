@@ -0,0 +1,98 @@
+#include "server.h"
+#include "persistence_adapter.h"
+#include "config.h"
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+// /bulk_update latency against a local PostgreSQL for transactions of 1, 10, 100 and 1000 insert
+// operations, with PersistenceAdapter's libpq pipeline mode on and off. Runs an in-process server on the
+// given port; connection string from PG_CONNINFO or config/db.json (see config.h). Writes keys from
+// 900000000 upwards and removes them afterwards.
+//
+// Build with -DUSE_PG so /bulk_update runs as one database transaction:
+//   g++ -std=c++17 -O2 -DUSE_PG bench/bench_bulk_update.cpp server.cpp persistence_adapter.cpp -I include -I third_party
+//       -I"$(pg_config --includedir)" -L"$(pg_config --libdir)" -lpq -lpthread -o bench_bulk_update.out
+// Usage: ./bench_bulk_update.out [repetitions=20] [port=23890]
+
+namespace {
+
+constexpr int64_t kKeyBase = 900000000;
+
+struct Latency {
+    double median_ms;
+    double p95_ms;
+};
+
+Latency run_size(httplib::Client& cli, int ops, int reps) {
+    std::vector<double> samples;
+    samples.reserve(reps);
+    for (int r = 0; r < reps; ++r) {
+        nlohmann::json body{{"operations", nlohmann::json::array()}};
+        for (int i = 0; i < ops; ++i) {
+            body["operations"].push_back({{"operation", "insert"}, {"key", kKeyBase + i}, {"value", "v" + std::to_string(r)}});
+        }
+        std::string payload = body.dump();
+        auto start = std::chrono::steady_clock::now();
+        auto res = cli.Post("/bulk_update", payload, "application/json");
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!res || res->status != 200) {
+            std::cerr << "bulk_update of " << ops << " ops failed" << (res ? ": " + res->body : std::string()) << "\n";
+            continue;
+        }
+        samples.push_back(ms);
+    }
+    if (samples.empty()) return Latency{0.0, 0.0};
+    std::sort(samples.begin(), samples.end());
+    return Latency{samples[samples.size() / 2], samples[std::min(samples.size() - 1, samples.size() * 95 / 100)]};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reps = argc > 1 ? std::atoi(argv[1]) : 20;
+    int port = argc > 2 ? std::atoi(argv[2]) : 23890;
+    if (reps <= 0) reps = 20;
+
+    PersistenceAdapter* adapter = nullptr;
+    KeyValueServer server{"localhost", port};
+    try {
+        auto owned = std::make_unique<PersistenceAdapter>(load_conninfo());
+        adapter = owned.get();
+        server.setPersistenceProvider(std::move(owned), "bench");
+    } catch (const std::exception& e) {
+        std::cerr << "cannot connect to PostgreSQL: " << e.what() << "\n";
+        return 2;
+    }
+    server.setSkipPreload(true);
+    server.setLoggingEnabled(false);
+    server.setupRoutes();
+    std::thread listener([&] { server.start(); });
+
+    httplib::Client cli("localhost", port);
+    cli.set_read_timeout(60, 0);
+    for (int i = 0; i < 100 && !cli.Get("/health"); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::cout << "ops   pipelined median/p95 (ms)   sequential median/p95 (ms)\n";
+    for (int ops : {1, 10, 100, 1000}) {
+        adapter->setPipelining(true);
+        Latency on = run_size(cli, ops, reps);
+        adapter->setPipelining(false);
+        Latency off = run_size(cli, ops, reps);
+        std::cout << std::setw(4) << ops << std::fixed << std::setprecision(2)
+                  << std::setw(12) << on.median_ms << " / " << std::setw(8) << on.p95_ms
+                  << std::setw(14) << off.median_ms << " / " << std::setw(8) << off.p95_ms << "\n";
+    }
+
+    for (int64_t k = kKeyBase; k < kKeyBase + 1000; ++k) adapter->remove(k);
+    server.stop();
+    listener.join();
+    return 0;
+}
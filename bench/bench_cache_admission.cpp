@@ -0,0 +1,62 @@
+#include "inline_cache.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <random>
+#include <cstdlib>
+
+// Hit ratio under load_generator.py workload 1: 85% of reads go to the hot keys 1..1000, 15% to the
+// cold range 1001..500000. Every miss is "hydrated from persistence" and offered to the cache through
+// insert_if_admitted, as getKeyHandler does. The cache holds `capacity` entries, so without admission
+// each cold miss evicts a hot key. Reports the hit ratio with and without TinyLFU for each policy.
+//
+// Usage: ./bench_cache_admission.out [capacity=2000] [requests=2000000]
+
+namespace {
+
+void run(const char* label, InlineCache::Policy policy, InlineCache::Admission admission, size_t capacity, size_t requests) {
+    const std::string value(64, 'v');
+    size_t perEntry = 0;
+    {
+        InlineCache probe{policy, SIZE_MAX / 2};
+        probe.update_or_insert(0, value);
+        perEntry = probe.stats().bytes_estimated;
+    }
+    InlineCache cache{policy, perEntry * capacity, 1031, 1, InlineCache::Storage::Chained, admission};
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> hot(1, 1000);
+    std::uniform_int_distribution<int> cold(1001, 500000);
+    for (size_t i = 0; i < requests; ++i) {
+        int key = coin(rng) < 0.85 ? hot(rng) : cold(rng);
+        if (!cache.get(key)) cache.insert_if_admitted(key, value);
+    }
+
+    auto st = cache.stats();
+    double ratio = static_cast<double>(st.hits) / static_cast<double>(st.hits + st.misses);
+    std::cout << "  " << std::left << std::setw(8) << label << std::setw(10)
+              << (admission == InlineCache::Admission::TinyLFU ? "tinylfu" : "none") << std::right
+              << std::setw(10) << std::fixed << std::setprecision(4) << ratio
+              << std::setw(12) << st.admitted << std::setw(12) << st.rejected << std::setw(12) << st.evictions << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    size_t requests = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    if (capacity == 0) capacity = 2000;
+    if (requests == 0) requests = 2000000;
+
+    std::cout << "workload 1 hit ratio: capacity=" << capacity << " entries, " << requests << " reads\n";
+    std::cout << "  policy  admission hit_ratio    admitted    rejected   evictions\n";
+    const std::pair<const char*, InlineCache::Policy> policies[] = {
+        {"lru", InlineCache::Policy::LRU}, {"fifo", InlineCache::Policy::FIFO},
+        {"random", InlineCache::Policy::Random}, {"clock", InlineCache::Policy::Clock}};
+    for (const auto& p : policies) {
+        run(p.first, p.second, InlineCache::Admission::None, capacity, requests);
+        run(p.first, p.second, InlineCache::Admission::TinyLFU, capacity, requests);
+    }
+    return 0;
+}
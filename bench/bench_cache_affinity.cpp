@@ -0,0 +1,86 @@
+#include "core_affinity_cache.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// Per-core GET hot-path benchmark: caller threads issue get() on the hot key range 1..1000 against
+// (a) one shared lock-striped cache and (b) one shared-nothing cache per pinned core with every get
+// shipped to the key's core. Reports aggregate hits/s and hits/s per core for 1..max_threads callers.
+//
+// Usage: ./bench_cache_affinity.out [duration_ms=500] [cores=hardware threads] [max_threads=2*cores]
+
+namespace {
+
+constexpr int kHotKeys = 1000;
+
+using Cache = CoreAffinityCache<int64_t>;
+
+double run_hits(Cache& cache, int threads, int duration_ms) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> ops(threads, 0);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(static_cast<unsigned>(t) * 7919u + 1u);
+            std::uniform_int_distribution<int> dist(1, kHotKeys);
+            unsigned long long local = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) {
+                    auto v = cache.get_handle(dist(rng));
+                    if (v) ++local;
+                }
+            }
+            ops[t] = local;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long total = 0;
+    for (auto v : ops) total += v;
+    return static_cast<double>(total) / secs;
+}
+
+void run_series(const char* label, size_t cores, size_t pinned, int max_threads, int duration_ms) {
+    Cache cache{InlineCache::Policy::LRU, 64 * 1024 * 1024, 1031 * 4, cores, InlineCache::Storage::Chained,
+                InlineCache::Admission::None, pinned};
+    for (int k = 1; k <= kHotKeys; ++k) cache.update_or_insert(k, "value-" + std::to_string(k));
+
+    std::cout << label << " (shards=" << cache.shard_count() << " pinned cores=" << cache.core_count() << ")\n";
+    std::cout << "  threads        hits/s   hits/s/core\n";
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double rate = run_hits(cache, threads, duration_ms);
+        std::cout << "  " << std::setw(7) << threads
+                  << std::setw(14) << std::fixed << std::setprecision(0) << rate
+                  << std::setw(14) << rate / static_cast<double>(cores) << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned hw = std::thread::hardware_concurrency();
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 500;
+    size_t cores = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : (hw ? hw : 1);
+    if (duration_ms <= 0) duration_ms = 500;
+    if (cores == 0) cores = hw ? hw : 1;
+    int max_threads = argc > 3 ? std::atoi(argv[3]) : static_cast<int>(2 * cores);
+    if (max_threads <= 0) max_threads = static_cast<int>(2 * cores);
+
+    std::cout << "hardware threads: " << hw << " cores: " << cores << "\n";
+    run_series("shared lock-striped", cores, 0, max_threads, duration_ms);
+    run_series("pinned shared-nothing", cores, cores, max_threads, duration_ms);
+    return 0;
+}
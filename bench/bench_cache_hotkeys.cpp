@@ -0,0 +1,113 @@
+#include "inline_cache.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <optional>
+
+// Hot-key GET throughput (workload 4: every thread reads keys 1..100). Compares InlineCache's lock-free
+// seqlock hit path with a reference cache using the previous design, where every hit takes the shard's
+// mutex to move the entry to the front of its LRU list and copy the value out.
+//
+// Usage: ./bench_cache_hotkeys.out [duration_ms=500] [shards=16] [value_bytes=64]
+
+namespace {
+
+constexpr int kHotKeys = 100;
+
+// Mutex-per-shard LRU cache: the read path InlineCache had before optimistic reads.
+class MutexLruCache {
+public:
+    explicit MutexLruCache(size_t shards) : shards_(shards) {}
+
+    void put(int key, const std::string& value) {
+        Shard& s = shards_[static_cast<unsigned>(key) % shards_.size()];
+        std::lock_guard<std::mutex> lk(s.mtx);
+        s.order.push_front(key);
+        s.map[key] = {value, s.order.begin()};
+    }
+
+    std::optional<std::string> get(int key) {
+        Shard& s = shards_[static_cast<unsigned>(key) % shards_.size()];
+        std::lock_guard<std::mutex> lk(s.mtx);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) return std::nullopt;
+        s.order.splice(s.order.begin(), s.order, it->second.second);
+        return it->second.first;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::list<int> order;
+        std::unordered_map<int, std::pair<std::string, std::list<int>::iterator>> map;
+    };
+    std::vector<Shard> shards_;
+};
+
+template <typename Lookup>
+double run_hits(int threads, int duration_ms, Lookup lookup) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> ops(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(static_cast<unsigned>(t) * 7919u + 1u);
+            std::uniform_int_distribution<int> dist(1, kHotKeys);
+            unsigned long long local = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) local += lookup(dist(rng)) ? 1 : 0;
+            }
+            ops[t] = local;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long total = 0;
+    for (auto v : ops) total += v;
+    return static_cast<double>(total) / secs;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 500;
+    size_t shards = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+    size_t value_bytes = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    if (duration_ms <= 0) duration_ms = 500;
+    if (shards == 0) shards = 16;
+
+    const std::string value(value_bytes, 'v');
+    InlineCache cache{InlineCache::Policy::LRU, 64 * 1024 * 1024, 1031, shards};
+    MutexLruCache reference{shards};
+    for (int k = 1; k <= kHotKeys; ++k) {
+        cache.update_or_insert(k, value);
+        reference.put(k, value);
+    }
+
+    std::cout << "hot-key GETs (keys 1.." << kHotKeys << ", " << value_bytes << "-byte values, shards=" << shards
+              << ", hardware threads: " << std::thread::hardware_concurrency() << ")\n";
+    std::cout << "  threads   mutex hits/s  seqlock hits/s   speedup\n";
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        double locked = run_hits(threads, duration_ms, [&](int key) { return reference.get(key).has_value(); });
+        double optimistic = run_hits(threads, duration_ms, [&](int key) { return cache.get(key).has_value(); });
+        std::cout << "  " << std::setw(7) << threads << std::setw(15) << std::fixed << std::setprecision(0) << locked
+                  << std::setw(16) << optimistic << std::setw(9) << std::setprecision(2)
+                  << (locked > 0 ? optimistic / locked : 0.0) << "x\n";
+    }
+    return 0;
+}
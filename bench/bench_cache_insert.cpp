@@ -0,0 +1,61 @@
+#include "inline_cache.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+// Insert throughput at a full cache: the cache is first filled to its byte budget, then every
+// further insert of a fresh key forces one eviction (write-heavy workload 2 with a warm cache).
+// Reports inserts/s, mean ns per insert and the bytes the cache has allocated for each eviction policy.
+//
+// Usage: ./bench_cache_insert.out [entries=100000] [inserts=200000] [shards=1]
+
+namespace {
+
+void run_policy(const char* label, InlineCache::Policy policy, size_t entries, size_t inserts, size_t shards) {
+    const std::string value(64, 'v');
+
+    // size the budget from the cache's own accounting so the fill phase ends exactly at capacity
+    size_t perEntry = 0;
+    {
+        InlineCache probe{policy, SIZE_MAX / 2};
+        probe.update_or_insert(0, value);
+        perEntry = probe.stats().bytes_estimated;
+    }
+    InlineCache cache{policy, perEntry * entries, 1031 * 16, shards};
+
+    int key = 0;
+    while (cache.stats().evictions == 0) cache.update_or_insert(++key, value);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < inserts; ++i) cache.update_or_insert(++key, value);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto st = cache.stats();
+    std::cout << "  " << std::left << std::setw(8) << label << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0) << (inserts / secs)
+              << std::setw(12) << std::setprecision(1) << (secs * 1e9 / inserts)
+              << std::setw(12) << st.size_entries
+              << std::setw(12) << st.evictions
+              << std::setw(14) << std::setprecision(2) << (st.bytes_reserved / (1024.0 * 1024.0)) << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t entries = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t inserts = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    size_t shards = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+    if (entries == 0) entries = 100000;
+    if (inserts == 0) inserts = 200000;
+    if (shards == 0) shards = 1;
+
+    std::cout << "full-cache inserts: capacity=" << entries << " entries, " << inserts << " inserts, shards=" << shards << "\n";
+    std::cout << "  policy       inserts/s   ns/insert     entries   evictions  reserved_MB\n";
+    run_policy("lru", InlineCache::Policy::LRU, entries, inserts, shards);
+    run_policy("fifo", InlineCache::Policy::FIFO, entries, inserts, shards);
+    run_policy("random", InlineCache::Policy::Random, entries, inserts, shards);
+    run_policy("clock", InlineCache::Policy::Clock, entries, inserts, shards);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "inline_cache.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// Cache-hit scaling benchmark: every thread issues InlineCache::get on the hot key range 1..1000
+// (the read-heavy GET workload) and we report aggregate hit throughput for 1..32 threads,
+// once with a single shard (global recency list) and once with the lock-striped layout.
+//
+// Usage: ./bench_cache_scaling.out [duration_ms=500] [shards=64] [policy=lru|clock|fifo|random] [storage=chained|open]
+
+namespace {
+
+constexpr int kHotKeys = 1000;
+
+double run_hits(InlineCache& cache, int threads, int duration_ms) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> ops(threads, 0);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(static_cast<unsigned>(t) * 7919u + 1u);
+            std::uniform_int_distribution<int> dist(1, kHotKeys);
+            unsigned long long local = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) {
+                    auto v = cache.get(dist(rng));
+                    if (v) ++local;
+                }
+            }
+            ops[t] = local;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long total = 0;
+    for (auto v : ops) total += v;
+    return static_cast<double>(total) / secs;
+}
+
+void run_series(const char* label, InlineCache::Policy policy, size_t shards, InlineCache::Storage storage, int duration_ms) {
+    InlineCache cache{policy, 64 * 1024 * 1024, 1031 * 4, shards, storage};
+    for (int k = 1; k <= kHotKeys; ++k) cache.update_or_insert(k, "value-" + std::to_string(k));
+
+    std::cout << label << " (shards=" << cache.shard_count() << ")\n";
+    std::cout << "  threads        hits/s   speedup\n";
+    double base = 0.0;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        double rate = run_hits(cache, threads, duration_ms);
+        if (threads == 1) base = rate;
+        std::cout << "  " << std::setw(7) << threads
+                  << std::setw(14) << std::fixed << std::setprecision(0) << rate
+                  << std::setw(9) << std::setprecision(2) << (base > 0 ? rate / base : 0.0) << "x\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 500;
+    size_t shards = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 64;
+    if (duration_ms <= 0) duration_ms = 500;
+    if (shards == 0) shards = 64;
+    std::string policy_arg = argc > 3 ? argv[3] : "lru";
+    InlineCache::Policy policy = InlineCache::Policy::LRU;
+    if (policy_arg == "clock") policy = InlineCache::Policy::Clock;
+    else if (policy_arg == "fifo") policy = InlineCache::Policy::FIFO;
+    else if (policy_arg == "random") policy = InlineCache::Policy::Random;
+    std::string storage_arg = argc > 4 ? argv[4] : "chained";
+    InlineCache::Storage storage = storage_arg == "open" ? InlineCache::Storage::OpenAddressing : InlineCache::Storage::Chained;
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << " policy: " << policy_arg << " storage: " << storage_arg << "\n";
+    run_series("single shard", policy, 1, storage, duration_ms);
+    run_series("lock-striped", policy, shards, storage, duration_ms);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "local_store.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <filesystem>
+#include <cstdlib>
+
+// LocalStore throughput, the embedded counterpart of bench_adapter: caller threads issue insert() (each one
+// durable before it returns, concurrent ones sharing an fdatasync) and then get() on a key range for a fixed
+// duration, with 16-byte and 4 KiB values. Runs in a fresh directory that is removed afterwards; put it on
+// the disk you want to measure. Writes per fsync show how much group commit the thread count buys.
+//
+//   g++ -std=c++17 -O2 bench/bench_local_store.cpp local_store.cpp -I include -I third_party -lpthread
+//       -o bench_local_store.out
+// Usage: ./bench_local_store.out [duration_ms=2000] [threads=4] [keys=10000] [dir=./bench_local_store.data]
+
+namespace {
+
+// Calls op(rng) from every thread until duration_ms elapses; returns successful calls per second.
+double run_ops(int threads, int duration_ms, const std::function<bool(std::mt19937_64&)>& op) {
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> done(threads, 0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937_64 rng(static_cast<uint64_t>(t) * 7919u + 1u);
+            unsigned long long local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (op(rng)) ++local;
+            }
+            done[t] = local;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true);
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long total = 0;
+    for (auto v : done) total += v;
+    return static_cast<double>(total) / secs;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 4;
+    int keys = argc > 3 ? std::atoi(argv[3]) : 10000;
+    std::string dir = argc > 4 ? argv[4] : "bench_local_store.data";
+    if (duration_ms <= 0) duration_ms = 2000;
+    if (threads <= 0) threads = 4;
+    if (keys <= 0) keys = 10000;
+
+    std::filesystem::remove_all(dir);
+    {
+        std::unique_ptr<LocalStore> db;
+        try {
+            db = std::make_unique<LocalStore>(dir);
+        } catch (const std::exception& e) {
+            std::cerr << "cannot open local store: " << e.what() << "\n";
+            return 2;
+        }
+
+        std::cout << "dir: " << dir << ", threads: " << threads << ", keys: " << keys << "\n";
+        std::cout << "value bytes     insert/s        get/s  writes/fsync  segments\n";
+        for (size_t size : {size_t{16}, size_t{4096}}) {
+            const std::string value(size, 'v');
+            auto pick = [keys](std::mt19937_64& rng) { return static_cast<int64_t>(rng() % static_cast<uint64_t>(keys)); };
+            auto before = db->metrics()["log"];
+            double inserts = run_ops(threads, duration_ms, [&](std::mt19937_64& rng) { return db->insert(pick(rng), value); });
+            auto after = db->metrics()["log"];
+            double gets = run_ops(threads, duration_ms, [&](std::mt19937_64& rng) { return db->get(pick(rng)) != nullptr; });
+            double records = after.value("records", 0.0) - before.value("records", 0.0);
+            double fsyncs = after.value("fsyncs", 0.0) - before.value("fsyncs", 0.0);
+            std::cout << std::setw(11) << size << std::fixed << std::setprecision(0)
+                      << std::setw(13) << inserts << std::setw(13) << gets << std::setprecision(1)
+                      << std::setw(14) << (fsyncs > 0 ? records / fsyncs : 0.0) << std::setw(10) << db->segmentCount() << "\n";
+        }
+    }
+    std::filesystem::remove_all(dir);
+    return 0;
+}
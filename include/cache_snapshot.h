@@ -0,0 +1,222 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* CacheSnapshot: warm-restart file holding an integer-key cache's entries, coldest first.
+   Implementation details:
+    - Layout, in host byte order (a snapshot is read back by the same build on the same host): a 48-byte
+      header {magic "KVSNAP01", format, cache policy, entry count, persistence version, written at (unix
+      ms), reserved}; then one record per entry {int64 key, uint32 length, uint8 flags, value bytes}; then
+      the 64-bit FNV-1a checksum of the record region.
+    - Writer streams records through a 1 MiB stdio buffer to "<path>.tmp", rewrites the header with the
+      final count, fsyncs and renames the file over path, so a crash mid-write leaves the previous
+      snapshot in place.
+    - Reader maps the file read-only with mmap and checks the magic, format, checksum and every record's
+      bounds before it exposes anything. Values are views into the mapping, valid while the Reader lives.
+    - The persistence version is an opaque clock supplied by the caller (kNoVersion if it has none), used
+      to validate the entries against the backing store before they are served again.
+*/
+
+class CacheSnapshot {
+public:
+    static constexpr int64_t kNoVersion = INT64_MIN;
+    static constexpr uint8_t kReferenced = 1; // entry's CLOCK/LRU reference bit
+
+    struct Header {
+        char magic[8];
+        uint32_t format;
+        uint32_t policy;
+        uint64_t entries;
+        int64_t version;
+        int64_t written_ms;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(Header) == 48, "snapshot header layout");
+
+    class Writer {
+    public:
+        Writer() = default;
+        ~Writer() {
+            if (file_) {
+                std::fclose(file_);
+                std::remove(tmp_.c_str());
+            }
+        }
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool open(const std::string& path) {
+            path_ = path;
+            tmp_ = path + ".tmp";
+            file_ = std::fopen(tmp_.c_str(), "wb");
+            if (!file_) return false;
+            std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+            Header blank{};
+            return put(&blank, sizeof(blank), false);
+        }
+
+        bool add(int64_t key, std::string_view value, bool referenced) {
+            uint32_t length = static_cast<uint32_t>(value.size());
+            uint8_t flags = referenced ? kReferenced : 0;
+            bool ok = put(&key, sizeof(key)) && put(&length, sizeof(length)) && put(&flags, sizeof(flags)) &&
+                      put(value.data(), value.size());
+            if (ok) ++entries_;
+            return ok;
+        }
+
+        // Complete the file and move it into place; false (and no file at path changed) on any error.
+        bool commit(uint32_t policy, int64_t version, int64_t written_ms) {
+            if (!file_ || !ok_) return false;
+            bool ok = std::fwrite(&hash_, sizeof(hash_), 1, file_) == 1;
+            Header h{};
+            std::memcpy(h.magic, kMagic, sizeof(h.magic));
+            h.format = kFormat;
+            h.policy = policy;
+            h.entries = entries_;
+            h.version = version;
+            h.written_ms = written_ms;
+            ok = ok && std::fseek(file_, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, file_) == 1;
+            ok = ok && std::fflush(file_) == 0 && ::fsync(fileno(file_)) == 0;
+            ok = std::fclose(file_) == 0 && ok;
+            file_ = nullptr;
+            if (ok) ok = std::rename(tmp_.c_str(), path_.c_str()) == 0;
+            if (!ok) std::remove(tmp_.c_str());
+            return ok;
+        }
+
+        uint64_t entries() const { return entries_; }
+
+    private:
+        bool put(const void* p, size_t n, bool hashed = true) {
+            if (!ok_) return false;
+            if (n && std::fwrite(p, n, 1, file_) != 1) ok_ = false;
+            if (hashed) hash_ = fnv1a(hash_, p, n);
+            return ok_;
+        }
+
+        std::string path_;
+        std::string tmp_;
+        std::FILE* file_{nullptr};
+        bool ok_{true};
+        uint64_t entries_{0};
+        uint64_t hash_{kFnvBasis};
+    };
+
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader() {
+            if (data_) ::munmap(const_cast<char*>(data_), size_);
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // Map and verify path; on failure error says why and nothing is exposed.
+        bool open(const std::string& path, std::string& error) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                error = "cannot open " + path;
+                return false;
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header) + sizeof(uint64_t)) {
+                ::close(fd);
+                error = "truncated snapshot";
+                return false;
+            }
+            size_ = static_cast<size_t>(st.st_size);
+            void* map = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED) {
+                error = "mmap failed";
+                return false;
+            }
+            data_ = static_cast<const char*>(map);
+            ::madvise(map, size_, MADV_SEQUENTIAL);
+            std::memcpy(&header_, data_, sizeof(header_));
+            if (std::memcmp(header_.magic, kMagic, sizeof(header_.magic)) != 0 || header_.format != kFormat) {
+                error = "not a snapshot of this format";
+                return close();
+            }
+            const size_t end = size_ - sizeof(uint64_t);
+            uint64_t stored = 0;
+            std::memcpy(&stored, data_ + end, sizeof(stored));
+            if (fnv1a(kFnvBasis, data_ + sizeof(Header), end - sizeof(Header)) != stored) {
+                error = "checksum mismatch";
+                return close();
+            }
+            uint64_t count = 0;
+            for (size_t pos = sizeof(Header); pos < end; ++count) {
+                if (end - pos < kRecordHead) {
+                    error = "truncated record";
+                    return close();
+                }
+                uint32_t length = 0;
+                std::memcpy(&length, data_ + pos + 8, sizeof(length));
+                if (end - pos - kRecordHead < length) {
+                    error = "truncated record";
+                    return close();
+                }
+                pos += kRecordHead + length;
+            }
+            if (count != header_.entries) {
+                error = "entry count mismatch";
+                return close();
+            }
+            return true;
+        }
+
+        const Header& header() const { return header_; }
+
+        // fn(key, value, referenced) for every record, in file order.
+        template <typename Fn>
+        void for_each(Fn&& fn) const {
+            const size_t end = size_ - sizeof(uint64_t);
+            for (size_t pos = sizeof(Header); pos < end;) {
+                int64_t key = 0;
+                uint32_t length = 0;
+                std::memcpy(&key, data_ + pos, sizeof(key));
+                std::memcpy(&length, data_ + pos + 8, sizeof(length));
+                bool referenced = (static_cast<uint8_t>(data_[pos + 12]) & kReferenced) != 0;
+                fn(key, std::string_view(data_ + pos + kRecordHead, length), referenced);
+                pos += kRecordHead + length;
+            }
+        }
+
+    private:
+        bool close() {
+            ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+            return false;
+        }
+
+        const char* data_{nullptr};
+        size_t size_{0};
+        Header header_{};
+    };
+
+private:
+    static constexpr char kMagic[8] = {'K', 'V', 'S', 'N', 'A', 'P', '0', '1'};
+    static constexpr uint32_t kFormat = 1;
+    static constexpr size_t kRecordHead = 8 + 4 + 1;
+    static constexpr uint64_t kFnvBasis = 0xcbf29ce484222325ULL;
+
+    static uint64_t fnv1a(uint64_t h, const void* p, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; ++i) {
+            h ^= b[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/* Key and value types for BasicInlineCache.
+   Implementation details:
+    - ShortKey<N>: string key of up to N bytes stored inline (N bytes plus a length byte, zero padded), so
+      entries and index slots hold it without a heap allocation. Equality compares the whole padded
+      buffer with one memcmp, which stays safe when a seqlock reader races a writer.
+    - CacheHash<Key>: 64-bit hash consumed by the cache. Integral keys hash to themselves: shards and
+      chained buckets take the key modulo their count, and FlatIndex and FrequencySketch mix the bits
+      further. ShortKey hashes its bytes with FNV-1a.
+    - CacheValueTraits<Value>: how a value type is stored. std::string values are variable length (inline
+      in the entry when short, otherwise in a slab block). Any other trivially copyable type is a
+      fixed-width value, stored by its object representation and always inline in the entry.
+*/
+
+template <size_t N>
+struct ShortKey {
+    static_assert(N > 0 && N < 256, "ShortKey length must fit its one-byte length field");
+    static constexpr size_t kMaxBytes = N;
+
+    char bytes[N]{};
+    uint8_t len{0};
+
+    ShortKey() = default;
+
+    // Build a key from s; returns false (and leaves out untouched) if s is longer than N bytes.
+    static bool from(std::string_view s, ShortKey& out) {
+        if (s.size() > N) return false;
+        ShortKey k;
+        if (!s.empty()) std::memcpy(k.bytes, s.data(), s.size());
+        k.len = static_cast<uint8_t>(s.size());
+        out = k;
+        return true;
+    }
+
+    std::string_view view() const { return std::string_view(bytes, len <= N ? len : N); }
+
+    bool operator==(const ShortKey& o) const { return std::memcmp(this, &o, sizeof(ShortKey)) == 0; }
+    bool operator!=(const ShortKey& o) const { return !(*this == o); }
+};
+
+template <typename Key, typename = void>
+struct CacheHash;
+
+template <typename Key>
+struct CacheHash<Key, std::enable_if_t<std::is_integral<Key>::value>> {
+    uint64_t operator()(Key key) const {
+        return static_cast<uint64_t>(static_cast<std::make_unsigned_t<Key>>(key));
+    }
+};
+
+template <size_t N>
+struct CacheHash<ShortKey<N>> {
+    uint64_t operator()(const ShortKey<N>& key) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : key.view()) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
+
+template <typename Value, typename = void>
+struct CacheValueTraits {
+    static_assert(std::is_trivially_copyable<Value>::value, "fixed-width cache values must be trivially copyable");
+    static constexpr bool kFixedWidth = true;
+    static std::string_view bytes(const Value& v) { return std::string_view(reinterpret_cast<const char*>(&v), sizeof(Value)); }
+    static Value decode(const char* data, size_t) {
+        Value v;
+        std::memcpy(&v, data, sizeof(Value));
+        return v;
+    }
+};
+
+template <>
+struct CacheValueTraits<std::string> {
+    static constexpr bool kFixedWidth = false;
+    static std::string_view bytes(const std::string& v) { return v; }
+    static std::string decode(const char* data, size_t size) { return std::string(data, size); }
+};
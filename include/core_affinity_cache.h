@@ -0,0 +1,293 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include "inline_cache.h"
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* CoreAffinityCache<Key, Value, Hash>: BasicInlineCache front end that either shares one lock-striped
+   cache between all calling threads (cores == 0) or runs N independent single-shard caches, each owned
+   by a worker thread pinned to its own CPU (shared-nothing).
+   Implementation details:
+    - Same operations as BasicInlineCache, so callers switch modes without code changes.
+    - Pinned mode: a key belongs to core Hash(key) % N. Every operation on the key is shipped to that
+      core's worker and the caller waits for the result, so a core's entries, index, recency list and
+      lock words are only ever written by one thread and never bounce between CPU caches. Each core gets
+      maxBytes / N and a prime bucket count, so the keys of one residue class still spread over all of
+      its chained buckets.
+    - Calls are stack-allocated tasks pushed onto the core's lock-free intrusive stack. The worker takes
+      the whole stack at once and runs it oldest first, spinning briefly before sleeping on a condition
+      variable when idle. A caller spins, then yields, until its task is marked done.
+    - Worker i is pinned to CPU i % hardware_concurrency (Linux only; elsewhere threads are unpinned).
+    - stats() reads every core's counters directly (relaxed atomics). expire() runs on every core in
+      parallel with the budget applied per core.
+    - Values from get_handle() stay valid on the calling thread: releasing a handle only returns the
+      block to the owning core's lock-free return stack.
+*/
+
+template <typename Key = int, typename Value = std::string, typename Hash = CacheHash<Key>>
+class CoreAffinityCache : public InlineCacheBase {
+public:
+    using Cache = BasicInlineCache<Key, Value, Hash>;
+
+    // cores == 0 keeps one shared cache with shardCount shards; otherwise shardCount is ignored and each of
+    // the cores pinned workers owns a single-shard cache.
+    CoreAffinityCache(Policy policy, size_t maxBytes, size_t bucketCount, size_t shardCount, Storage storage,
+                      Admission admission, size_t cores = 0) {
+        if (cores == 0) {
+            shared_ = std::make_unique<Cache>(policy, maxBytes, bucketCount, shardCount, storage, admission);
+            return;
+        }
+        size_t buckets = nextPrime(bucketCount / cores > 7 ? bucketCount / cores : 7);
+        unsigned cpus = std::thread::hardware_concurrency();
+        cores_.reserve(cores);
+        for (size_t i = 0; i < cores; ++i) {
+            cores_.push_back(std::make_unique<Core>(policy, maxBytes / cores, buckets, storage, admission));
+        }
+        for (size_t i = 0; i < cores; ++i) {
+            Core* core = cores_[i].get();
+            core->worker = std::thread([core]() { core->run(); });
+            pin(core->worker, cpus ? static_cast<unsigned>(i % cpus) : 0);
+        }
+    }
+
+    ~CoreAffinityCache() {
+        for (auto& core : cores_) {
+            {
+                std::lock_guard<std::mutex> lk(core->mtx);
+                core->stop = true;
+            }
+            core->cv.notify_one();
+        }
+        for (auto& core : cores_) {
+            if (core->worker.joinable()) core->worker.join();
+        }
+    }
+
+    CoreAffinityCache(const CoreAffinityCache&) = delete;
+    CoreAffinityCache& operator=(const CoreAffinityCache&) = delete;
+
+    std::optional<Value> get(const Key& key) {
+        return onOwner(key, [&](Cache& c) { return c.get(key); });
+    }
+
+    std::optional<ValueHandle> get_handle(const Key& key) {
+        return onOwner(key, [&](Cache& c) { return c.get_handle(key); });
+    }
+
+    bool update_or_insert(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        return onOwner(key, [&](Cache& c) { return c.update_or_insert(key, value, ttl); });
+    }
+
+    bool insert_if_absent(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        return onOwner(key, [&](Cache& c) { return c.insert_if_absent(key, value, ttl); });
+    }
+
+    bool insert_if_admitted(const Key& key, const Value& value) {
+        return onOwner(key, [&](Cache& c) { return c.insert_if_admitted(key, value); });
+    }
+
+    bool update(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        return onOwner(key, [&](Cache& c) { return c.update(key, value, ttl); });
+    }
+
+    bool erase(const Key& key) {
+        return onOwner(key, [&](Cache& c) { return c.erase(key); });
+    }
+
+    // Remove up to budget expired entries (per core in pinned mode); returns the number removed.
+    size_t expire(size_t budget = SIZE_MAX) {
+        if (shared_) return shared_->expire(budget);
+        struct Ctx {
+            size_t budget;
+            size_t removed;
+        };
+        std::vector<Ctx> ctx(cores_.size(), Ctx{budget, 0});
+        std::vector<Task> tasks(cores_.size());
+        for (size_t i = 0; i < cores_.size(); ++i) {
+            tasks[i].ctx = &ctx[i];
+            tasks[i].fn = [](void* p, Cache& c) {
+                auto* x = static_cast<Ctx*>(p);
+                x->removed = c.expire(x->budget);
+            };
+            cores_[i]->submit(&tasks[i]);
+        }
+        size_t removed = 0;
+        for (size_t i = 0; i < cores_.size(); ++i) {
+            tasks[i].wait();
+            removed += ctx[i].removed;
+        }
+        return removed;
+    }
+
+    // Warm restart (see BasicInlineCache). In pinned mode each core's cache is read from the calling thread
+    // under that cache's own shard lock, one core after another; restores go to the key's core.
+    template <typename Fn>
+    void for_each_entry(Fn&& fn) const {
+        if (shared_) {
+            shared_->for_each_entry(fn);
+            return;
+        }
+        for (const auto& core : cores_) core->cache.for_each_entry(fn);
+    }
+
+    bool restore_entry(const Key& key, std::string_view bytes, bool referenced) {
+        return onOwner(key, [&](Cache& c) { return c.restore_entry(key, bytes, referenced); });
+    }
+
+    Stats stats() const {
+        if (shared_) return shared_->stats();
+        Stats total;
+        for (const auto& core : cores_) {
+            Stats s = core->cache.stats();
+            total.size_entries += s.size_entries;
+            total.bytes_estimated += s.bytes_estimated;
+            total.bytes_reserved += s.bytes_reserved;
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.evictions += s.evictions;
+            total.admitted += s.admitted;
+            total.rejected += s.rejected;
+            total.expirations += s.expirations;
+        }
+        return total;
+    }
+
+    Policy policy() const { return shared_ ? shared_->policy() : cores_.front()->cache.policy(); }
+    Storage storage() const { return shared_ ? shared_->storage() : cores_.front()->cache.storage(); }
+    Admission admission() const { return shared_ ? shared_->admission() : cores_.front()->cache.admission(); }
+
+    // Lock-striped shards of the shared cache, or one per pinned core.
+    size_t shard_count() const { return shared_ ? shared_->shard_count() : cores_.size(); }
+
+    // Pinned worker threads (0 in shared mode).
+    size_t core_count() const { return cores_.size(); }
+
+private:
+    struct Task {
+        void (*fn)(void*, Cache&){nullptr};
+        void* ctx{nullptr};
+        Task* next{nullptr};
+        std::atomic<bool> done{false};
+
+        void wait() const {
+            for (int spin = 0; !done.load(std::memory_order_acquire); ++spin) {
+                if (spin >= kSpinLimit) std::this_thread::yield();
+            }
+        }
+    };
+
+    struct Core {
+        Cache cache;
+        std::atomic<Task*> head{nullptr};
+        std::atomic<bool> sleeping{false};
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool stop{false};
+        std::thread worker;
+
+        Core(Policy policy, size_t maxBytes, size_t buckets, Storage storage, Admission admission)
+            : cache(policy, maxBytes, buckets, 1, storage, admission) {}
+
+        void submit(Task* t) {
+            Task* old = head.load(std::memory_order_relaxed);
+            do {
+                t->next = old;
+            } while (!head.compare_exchange_weak(old, t));
+            // seq_cst push then load pairs with the worker's seq_cst store to sleeping then load of head.
+            if (sleeping.load()) {
+                std::lock_guard<std::mutex> lk(mtx);
+                cv.notify_one();
+            }
+        }
+
+        void run() {
+            for (;;) {
+                Task* list = head.exchange(nullptr, std::memory_order_acquire);
+                if (!list) {
+                    for (int spin = 0; spin < kSpinLimit && !head.load(std::memory_order_relaxed); ++spin) {}
+                    if (head.load(std::memory_order_relaxed)) continue;
+                    std::unique_lock<std::mutex> lk(mtx);
+                    sleeping.store(true);
+                    cv.wait(lk, [&] { return stop || head.load() != nullptr; });
+                    sleeping.store(false);
+                    if (stop && !head.load()) return;
+                    continue;
+                }
+                // The stack holds the newest task first; run oldest first.
+                Task* ordered = nullptr;
+                while (list) {
+                    Task* next = list->next;
+                    list->next = ordered;
+                    ordered = list;
+                    list = next;
+                }
+                while (ordered) {
+                    Task* next = ordered->next; // the caller may return as soon as done is set
+                    ordered->fn(ordered->ctx, cache);
+                    ordered->done.store(true, std::memory_order_release);
+                    ordered = next;
+                }
+            }
+        }
+    };
+
+    static constexpr int kSpinLimit = 2000;
+
+    template <typename Fn>
+    auto onOwner(const Key& key, Fn&& fn) -> decltype(fn(std::declval<Cache&>())) {
+        using Result = decltype(fn(std::declval<Cache&>()));
+        if (shared_) return fn(*shared_);
+        struct Ctx {
+            Fn* fn;
+            std::optional<Result> result;
+        } ctx{&fn, std::nullopt};
+        Task task;
+        task.ctx = &ctx;
+        task.fn = [](void* p, Cache& c) {
+            auto* x = static_cast<Ctx*>(p);
+            x->result.emplace((*x->fn)(c));
+        };
+        cores_[Hash{}(key) % cores_.size()]->submit(&task);
+        task.wait();
+        return std::move(*ctx.result);
+    }
+
+    static size_t nextPrime(size_t n) {
+        auto prime = [](size_t v) {
+            if (v < 2) return false;
+            for (size_t d = 2; d * d <= v; ++d) {
+                if (v % d == 0) return false;
+            }
+            return true;
+        };
+        while (!prime(n)) ++n;
+        return n;
+    }
+
+    static void pin(std::thread& t, unsigned cpu) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+        (void)t;
+        (void)cpu;
+#endif
+    }
+
+    std::unique_ptr<Cache> shared_;
+    std::vector<std::unique_ptr<Core>> cores_;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "cache_traits.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* BasicFlatIndex: open-addressing hash index from keys to 32-bit slot ids (Swiss-table layout).
+   Implementation details:
+    - One control byte per slot: kEmpty, kDeleted, or the low 7 bits of the key hash (h2) when full.
+    - Slots are probed in aligned groups of 16 control bytes; a group is matched against h2 with a
+      single SSE2 compare + movemask (scalar loop when SSE2 is unavailable), so most lookups read
+      one control group and one slot.
+    - Slots store the key inline next to the id, so candidate matches are confirmed without touching
+      the entry they point to. The key's CacheHash is mixed once more (murmur3 fmix64) to derive the
+      group and tag, so identity hashes of sequential integer keys still spread evenly.
+    - Groups are visited in triangular (quadratic) order; the group count is a power of two so the
+      sequence covers every group.
+    - Erase leaves a kDeleted tombstone. When full + deleted slots exceed 7/8 of capacity the table is
+      rebuilt: doubled if more than half of that is live, otherwise rehashed in place to drop tombstones.
+    - Writers must be serialized by the owning shard lock. find() may additionally run concurrently with
+      a writer as part of a seqlock read: the live table is published through one atomic pointer, and
+      tables are never freed while the index lives (a retired table of the same capacity is reused by the
+      next in-place rehash), so a racing find() always probes valid memory and terminates. Its result is
+      only meaningful once the caller has validated its sequence number.
+*/
+
+template <typename Key = int, typename Hash = CacheHash<Key>>
+class BasicFlatIndex {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit BasicFlatIndex(size_t minCapacity = kGroupWidth) { reset(minCapacity); }
+
+    BasicFlatIndex(const BasicFlatIndex&) = delete;
+    BasicFlatIndex& operator=(const BasicFlatIndex&) = delete;
+
+    // Drop every key and size the table for at least minCapacity slots.
+    void reset(size_t minCapacity) {
+        size_t groups = 1;
+        while (groups * kGroupWidth < minCapacity) groups <<= 1;
+        table_.store(acquireTable(groups), std::memory_order_release);
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // Slot id stored for key, or npos.
+    uint32_t find(const Key& key) const {
+        const Table* t = table_.load(std::memory_order_acquire);
+        uint64_t h = hash(key);
+        uint8_t tag = h2(h);
+        size_t group = h1(h) & t->groupMask;
+        for (size_t step = 1; ; ++step) {
+            const uint8_t* ctrl = &t->ctrl[group * kGroupWidth];
+            for (uint32_t bits = matchTag(ctrl, tag); bits != 0; bits &= bits - 1) {
+                const Slot& s = t->slots[group * kGroupWidth + ctz(bits)];
+                if (s.key == key) return s.id;
+            }
+            if (matchTag(ctrl, kEmpty) != 0) return npos;
+            if (step > t->groupMask) return npos; // visited every group
+            group = (group + step) & t->groupMask;
+        }
+    }
+
+    // Insert key -> id. The key must not already be present.
+    void insert(const Key& key, uint32_t id) {
+        if ((size_ + deleted_ + 1) * 8 > capacity() * 7) rebuild();
+        Table* t = table_.load(std::memory_order_relaxed);
+        uint64_t h = hash(key);
+        size_t pos = findInsertPos(*t, h);
+        if (t->ctrl[pos] == kDeleted) --deleted_;
+        t->slots[pos] = Slot{key, id};
+        t->ctrl[pos] = h2(h);
+        ++size_;
+    }
+
+    // Remove key; returns true if it was present.
+    bool erase(const Key& key) {
+        Table* t = table_.load(std::memory_order_relaxed);
+        uint64_t h = hash(key);
+        uint8_t tag = h2(h);
+        size_t group = h1(h) & t->groupMask;
+        for (size_t step = 1; ; ++step) {
+            const uint8_t* ctrl = &t->ctrl[group * kGroupWidth];
+            for (uint32_t bits = matchTag(ctrl, tag); bits != 0; bits &= bits - 1) {
+                size_t pos = group * kGroupWidth + ctz(bits);
+                if (t->slots[pos].key == key) {
+                    t->ctrl[pos] = kDeleted;
+                    --size_;
+                    ++deleted_;
+                    return true;
+                }
+            }
+            if (matchTag(ctrl, kEmpty) != 0) return false;
+            if (step > t->groupMask) return false;
+            group = (group + step) & t->groupMask;
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return table_.load(std::memory_order_relaxed)->capacity(); }
+
+    // Heap bytes owned by the index (control bytes + slots of the live and retired tables).
+    size_t memory_bytes() const {
+        size_t bytes = 0;
+        for (const auto& t : tables_) bytes += t->capacity() * (1 + sizeof(Slot));
+        return bytes;
+    }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr uint8_t kEmpty = 0x80;
+    static constexpr uint8_t kDeleted = 0xFE;
+
+    struct Slot {
+        Key key;
+        uint32_t id;
+    };
+
+    struct Table {
+        size_t groupMask;
+        std::unique_ptr<uint8_t[]> ctrl;
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity() const { return (groupMask + 1) * kGroupWidth; }
+    };
+
+    std::vector<std::unique_ptr<Table>> tables_; // every table allocated so far; readers may still probe retired ones
+    std::atomic<Table*> table_{nullptr};         // live table
+    size_t size_{0};
+    size_t deleted_{0};
+
+    static uint64_t hash(const Key& key) {
+        // murmur3 fmix64 finalizer: spreads sequential keys over groups and tags
+        uint64_t h = Hash{}(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+    static size_t h1(uint64_t h) { return static_cast<size_t>(h >> 7); }
+    static uint8_t h2(uint64_t h) { return static_cast<uint8_t>(h & 0x7F); }
+
+    static unsigned ctz(uint32_t bits) { return static_cast<unsigned>(__builtin_ctz(bits)); }
+
+    // Bitmask of control bytes in the group equal to tag.
+    static uint32_t matchTag(const uint8_t* ctrl, uint8_t tag) {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        __m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)));
+        return static_cast<uint32_t>(_mm_movemask_epi8(match));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            if (ctrl[i] == tag) bits |= (1u << i);
+        }
+        return bits;
+#endif
+    }
+
+    // Bitmask of empty or deleted control bytes (high bit set, unlike full tags).
+    static uint32_t matchFree(const uint8_t* ctrl) {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            if (ctrl[i] & 0x80) bits |= (1u << i);
+        }
+        return bits;
+#endif
+    }
+
+    static size_t findInsertPos(const Table& t, uint64_t h) {
+        size_t group = h1(h) & t.groupMask;
+        for (size_t step = 1; ; ++step) {
+            uint32_t bits = matchFree(&t.ctrl[group * kGroupWidth]);
+            if (bits != 0) return group * kGroupWidth + ctz(bits);
+            group = (group + step) & t.groupMask;
+        }
+    }
+
+    // An empty table of the given group count: a retired table of that size if one exists, else a new one.
+    Table* acquireTable(size_t groups) {
+        Table* live = table_.load(std::memory_order_relaxed);
+        Table* t = nullptr;
+        for (auto& candidate : tables_) {
+            if (candidate.get() != live && candidate->groupMask + 1 == groups) {
+                t = candidate.get();
+                break;
+            }
+        }
+        if (t == nullptr) {
+            tables_.emplace_back(new Table{groups - 1, std::unique_ptr<uint8_t[]>(new uint8_t[groups * kGroupWidth]),
+                                           std::unique_ptr<Slot[]>(new Slot[groups * kGroupWidth])});
+            t = tables_.back().get();
+        }
+        std::memset(t->ctrl.get(), kEmpty, t->capacity());
+        return t;
+    }
+
+    // Rehash live keys into a fresh table, then publish it.
+    void rebuild() {
+        const Table* old = table_.load(std::memory_order_relaxed);
+        size_t live = size_;
+        // grow when live entries alone would fill more than 7/16 of the table, otherwise purge tombstones
+        size_t groups = old->groupMask + 1;
+        if (live * 16 > old->capacity() * 7) groups *= 2;
+        Table* t = acquireTable(groups);
+        for (size_t pos = 0; pos < old->capacity(); ++pos) {
+            if (old->ctrl[pos] & 0x80) continue;
+            uint64_t h = hash(old->slots[pos].key);
+            size_t dst = findInsertPos(*t, h);
+            t->ctrl[dst] = h2(h);
+            t->slots[dst] = old->slots[pos];
+        }
+        deleted_ = 0;
+        table_.store(t, std::memory_order_release);
+    }
+};
+
+using FlatIndex = BasicFlatIndex<>;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/* FrequencySketch: approximate access-frequency counter used for TinyLFU cache admission.
+   Implementation details:
+    - Count-min sketch of 4-bit saturating counters packed sixteen to a 64-bit word. Keys are given by
+      their 64-bit CacheHash; each maps to one counter in each of four rows (independent rehashes) and
+      its estimate is the minimum of the four.
+    - increment() is lock-free (CAS on the owning word), so it can be called by readers that hold a
+      shared lock. Concurrent increments of the same counter may be coalesced; the sketch is an
+      estimate either way.
+    - Aging: once the number of increments reaches the sample size (10x the expected entry count)
+      every counter is halved, so the sketch tracks recent popularity rather than all-time totals.
+    - The table is sized to the next power of two >= expected entries (capped at kMaxWords words).
+*/
+
+class FrequencySketch {
+public:
+    static constexpr unsigned kMaxCount = 15;
+
+    explicit FrequencySketch(size_t expectedEntries = 0) { resize(expectedEntries); }
+
+    FrequencySketch(const FrequencySketch&) = delete;
+    FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+    // (Re)allocate for expectedEntries distinct keys; 0 disables the sketch. Not thread safe.
+    void resize(size_t expectedEntries) {
+        size_t words = 0;
+        if (expectedEntries > 0) {
+            words = 1;
+            while (words < expectedEntries && words < kMaxWords) words <<= 1;
+        }
+        table_ = std::vector<std::atomic<uint64_t>>(words);
+        mask_ = words == 0 ? 0 : words - 1;
+        sampleSize_ = expectedEntries == 0 ? 0 : 10 * expectedEntries;
+        additions_.store(0, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return !table_.empty(); }
+
+    // Record one access to the key with the given hash.
+    void increment(uint64_t keyHash) {
+        if (table_.empty()) return;
+        uint64_t h = spread(keyHash);
+        bool added = false;
+        for (unsigned row = 0; row < kDepth; ++row) {
+            uint64_t rh = rehash(h, row);
+            added |= incrementAt(rh & mask_, offset(rh));
+        }
+        if (added && additions_.fetch_add(1, std::memory_order_relaxed) + 1 == sampleSize_) reset();
+    }
+
+    // Estimated recent access count of the key with the given hash (0..kMaxCount).
+    unsigned frequency(uint64_t keyHash) const {
+        if (table_.empty()) return 0;
+        uint64_t h = spread(keyHash);
+        unsigned freq = kMaxCount;
+        for (unsigned row = 0; row < kDepth; ++row) {
+            uint64_t rh = rehash(h, row);
+            uint64_t word = table_[rh & mask_].load(std::memory_order_relaxed);
+            unsigned count = static_cast<unsigned>((word >> offset(rh)) & 0xF);
+            if (count < freq) freq = count;
+        }
+        return freq;
+    }
+
+    // Number of aging passes so far (for tests and diagnostics).
+    size_t resets() const { return resets_.load(std::memory_order_relaxed); }
+
+    size_t memory_bytes() const { return table_.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr unsigned kDepth = 4;
+    static constexpr size_t kMaxWords = size_t{1} << 17; // 1 MB, 2M counters
+    static constexpr uint64_t kSeeds[kDepth] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+    std::vector<std::atomic<uint64_t>> table_;
+    size_t mask_{0};
+    size_t sampleSize_{0};
+    std::atomic<size_t> additions_{0};
+    std::atomic<size_t> resets_{0};
+
+    static uint64_t spread(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+    static uint64_t rehash(uint64_t h, unsigned row) {
+        h = (h + kSeeds[row]) * 0x9e3779b97f4a7c15ULL;
+        return h ^ (h >> 29);
+    }
+    // Bit offset of the row's 4-bit counter inside its word (taken from the high hash bits).
+    static unsigned offset(uint64_t rh) { return static_cast<unsigned>((rh >> 60) & 0xF) << 2; }
+
+    bool incrementAt(size_t index, unsigned shift) {
+        auto& word = table_[index];
+        uint64_t cur = word.load(std::memory_order_relaxed);
+        while (((cur >> shift) & 0xF) < kMaxCount) {
+            if (word.compare_exchange_weak(cur, cur + (uint64_t{1} << shift), std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    // Halve every counter. Runs concurrently with increments; each word is halved atomically.
+    void reset() {
+        for (auto& word : table_) {
+            uint64_t cur = word.load(std::memory_order_relaxed);
+            while (!word.compare_exchange_weak(cur, (cur >> 1) & 0x7777777777777777ULL, std::memory_order_relaxed)) {}
+        }
+        additions_.store(0, std::memory_order_relaxed);
+        resets_.fetch_add(1, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <unordered_map>
+#include <set>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+/* HotKeyProfile: sampled access-frequency profile of integer keys (top-K heavy hitters), kept across restarts.
+   Implementation details:
+    - Space-Saving over a fixed number of counters: a sampled key without a counter takes over the smallest
+      one and starts from its count, so every key read more often than total/capacity times is tracked and
+      no count is an underestimate.
+    - record() samples one call in sample_every with a thread-local xorshift generator and only takes the
+      lock for the sampled ones, so the read path normally costs a few arithmetic instructions. Random rather
+      than every n-th call, so a key that recurs with a fixed stride is not always (or never) sampled.
+    - Counters sit in an ordered set by (count, key): bump and take-over of the minimum are O(log capacity).
+    - decay() halves every count and drops those that reach zero, so a profile decayed periodically follows
+      the running workload instead of all of history.
+    - save() writes "<key> <count>" lines hottest first under a "kvhot 1" header to "<path>.tmp" and renames
+      it over path; load() merges such a file into the counters.
+*/
+
+class HotKeyProfile {
+public:
+    struct Entry {
+        int64_t key;
+        uint64_t count;
+    };
+
+    static constexpr size_t default_capacity = 16384;
+    static constexpr uint32_t default_sample_every = 16;
+
+    explicit HotKeyProfile(size_t capacity = default_capacity, uint32_t sample_every = default_sample_every)
+        : capacity_(capacity ? capacity : 1), sample_every_(sample_every ? sample_every : 1) {}
+
+    HotKeyProfile(const HotKeyProfile&) = delete;
+    HotKeyProfile& operator=(const HotKeyProfile&) = delete;
+
+    // Count one access of key, if it is sampled.
+    void record(int64_t key) {
+        if (sample_every_ > 1 && nextRandom() % sample_every_ != 0) return;
+        sampled_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lk(mtx_);
+        bump(key, 1);
+    }
+
+    // Up to n tracked keys, hottest first.
+    std::vector<Entry> top(size_t n) const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        std::vector<Entry> out;
+        out.reserve(std::min(n, order_.size()));
+        for (auto it = order_.rbegin(); it != order_.rend() && out.size() < n; ++it) out.push_back({it->second, it->first});
+        return out;
+    }
+
+    void decay() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        std::set<std::pair<uint64_t, int64_t>> halved;
+        for (auto it = counts_.begin(); it != counts_.end();) {
+            it->second /= 2;
+            if (it->second == 0) {
+                it = counts_.erase(it);
+            } else {
+                halved.emplace(it->second, it->first);
+                ++it;
+            }
+        }
+        order_.swap(halved);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return counts_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // Accesses that were sampled since construction.
+    uint64_t sampled() const { return sampled_.load(std::memory_order_relaxed); }
+
+    bool save(const std::string& path) const {
+        std::vector<Entry> entries = top(capacity_);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::trunc);
+            if (!f) return false;
+            f << kHeader << '\n';
+            for (const Entry& e : entries) f << e.key << ' ' << e.count << '\n';
+            f.flush();
+            if (!f) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Merge the counts of a saved profile; false if path is missing or not a profile. Lines after a malformed
+    // one are ignored.
+    bool load(const std::string& path) {
+        std::ifstream f(path);
+        std::string header;
+        if (!f || !std::getline(f, header) || header != kHeader) return false;
+        std::lock_guard<std::mutex> lk(mtx_);
+        int64_t key = 0;
+        uint64_t count = 0;
+        while (f >> key >> count) {
+            if (count) bump(key, count);
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* kHeader = "kvhot 1";
+
+    void bump(int64_t key, uint64_t by) {
+        auto it = counts_.find(key);
+        if (it != counts_.end()) {
+            order_.erase({it->second, key});
+            it->second += by;
+            order_.emplace(it->second, key);
+            return;
+        }
+        uint64_t base = 0;
+        if (counts_.size() >= capacity_) {
+            auto smallest = order_.begin();
+            base = smallest->first;
+            counts_.erase(smallest->second);
+            order_.erase(smallest);
+        }
+        counts_.emplace(key, base + by);
+        order_.emplace(base + by, key);
+    }
+
+    static uint64_t nextRandom() {
+        thread_local uint64_t state = 0;
+        if (state == 0) {
+            state = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                    reinterpret_cast<uintptr_t>(&state) ^ 0x9e3779b97f4a7c15ULL;
+            if (state == 0) state = 1;
+        }
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+
+    const size_t capacity_;
+    const uint32_t sample_every_;
+    std::atomic<uint64_t> sampled_{0};
+    mutable std::mutex mtx_;
+    std::unordered_map<int64_t, uint64_t> counts_;
+    std::set<std::pair<uint64_t, int64_t>> order_; // (count, key), coldest first
+};
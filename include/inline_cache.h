@@ -1,262 +1,1016 @@
 #pragma once
 
 #include <vector>
-#include <list>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <shared_mutex>
 #include <optional>
 #include <chrono>
 #include <random>
 #include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "cache_traits.h"
+#include "flat_index.h"
+#include "frequency_sketch.h"
+#include "slab_arena.h"
+#include "value_handle.h"
+#include "timing_wheel.h"
+#include <cstring>
 
-/* InlineCache: header-only in-memory cache for integer->string values supporting
-    eviction policies: LRU, FIFO, RANDOM; separate bucket lock for thread safety.
+/* BasicInlineCache<Key, Value, Hash>: header-only in-memory key->value cache supporting
+    eviction policies: LRU, FIFO, RANDOM, CLOCK; lock-striped shards for thread safety.
     Constraints: total estimated memory footprint <= ~2MB (soft limit).
+    InlineCache is the int -> std::string instantiation.
    Implementation details:
-    - Fixed prime number of buckets (default 1031) chosen to reduce collisions.
-    - Each bucket stores entries in a std::list (stable iterators for LRU list references).
-    - Global usage list for LRU ordering (front = most recent, back = least recent).
-    - FIFO eviction uses insertion order recorded per entry.
-    - RANDOM eviction chooses a random non-empty bucket then a random element in that bucket.
-    - Timestamps stored (steady_clock) for potential time-based heuristics (currently used for FIFO tie-breaking consistency).
-    - Memory accounting is approximate: key sizeof(int) + value.size() + entry struct overhead.
-    - When memory exceeds budget, evict one entry according to selected policy; repeat until under budget.
+    - Key, value and hash types are template parameters (see cache_traits.h). Keys are stored inline in
+      the entry and in the index: any integral type, or ShortKey<N> for short strings. Values are
+      std::string (variable length) or any trivially copyable fixed-width type, which is always stored
+      inline. The inline value area is whatever is left of the 64-byte entry after the key (24 bytes for
+      int keys, 16 for 64-bit and 16-byte keys, never less than a pointer), so every specialization keeps
+      one entry per cache line; keys longer than 16 bytes spill the entry past one line.
+    - Two storage engines for the key index (Storage):
+        Chained:        fixed prime number of buckets (default 1031) chosen to reduce collisions; each
+                        bucket chains slot indices through the entries.
+        OpenAddressing: per-shard FlatIndex (Swiss-table control bytes, 16-wide SIMD group probing,
+                        int keys stored inline in the index), grown on demand; a hit reads one control
+                        group, one index slot and the entry, whose small values sit inline.
+    - Keys are striped across shards (default 1). Each shard owns its own bucket range,
+      recency list, byte budget (maxBytes / shardCount) and statistics, all guarded by one
+      shard reader/writer lock. Operations on different shards never contend with each other.
+    - Entries of a shard live in one slot array indexed by either engine; freed slots are recycled
+      through a free list, so eviction policies are shared by both engines. The array grows in fixed
+      chunks that never move, so a slot id always maps to the same memory.
+    - Per-shard usage list for LRU ordering (front = most recent, back = least recent), linked
+      through slot indices. Writes move an entry to the front; a hit only sets the entry's reference
+      bit, and the bit is applied lazily: an entry found referenced at the tail is moved to the front
+      (bit cleared) instead of being evicted. With more than one shard LRU is approximate: the victim
+      is the least recently used entry of the shard that went over its budget.
+    - FIFO eviction pops the oldest insertion from a per-shard ring buffer of (slot, insertion order)
+      pairs. Erased or recycled slots leave tombstones behind that are recognised by their stale
+      insertion order and skipped; the ring is compacted once tombstones outnumber live entries,
+      so eviction is amortized O(1).
+    - RANDOM eviction chooses a random occupied slot of the shard.
+    - CLOCK eviction: a hit only sets the entry's atomic reference bit; the eviction hand sweeps the
+      slot array, clearing set bits and evicting the first entry whose bit is clear (second chance).
+    - Lookups are optimistic seqlock reads and take no lock. Writers hold the exclusive shard lock and bump
+      the shard's sequence number to odd before they modify it and back to even afterwards. A reader
+      snapshots an even sequence, probes the index, copies the value and re-checks the sequence. If the
+      sequence changed it retries, and after a few failed attempts it falls back to the shared lock. Every
+      structure a reader can reach stays allocated while the cache lives: slot chunks, FlatIndex tables and
+      arena slabs are never freed. Values larger than the arena's biggest size class are read under the
+      shared lock, because their blocks are released on update.
+    - Optional per-entry TTL: writes may pass a time-to-live, stored as a steady-clock deadline in the entry
+      (0 = never expires; a write without a TTL clears any previous one). Expiry is lazy and active:
+      readers treat an entry past its deadline as a miss (the clock is only read for entries that carry a
+      deadline), writers that find one remove it before proceeding, and expire() removes due entries
+      incrementally from a per-shard TimingWheel, so expired values stop holding budget without waiting
+      to be evicted.
+    - Values up to kInlineValue bytes are stored inside the 64-byte entry; larger values live in
+      reference-counted ValueBlocks carved from a per-shard SlabArena (size classes with per-class free
+      lists), so inserts and updates stop allocating once the workload reaches steady state. An update
+      that stays within its size class is copied in place when no reader holds the block.
+    - get_handle() returns a ValueHandle sharing the entry's block instead of copying the bytes; a block
+      outlives its entry until the last handle drops it. get() is get_handle() plus one copy.
+    - Memory accounting counts real bytes: each live entry is charged its slot (sizeof(Entry)) plus the
+      size-class block holding its value. Stats::bytes_reserved additionally reports everything the
+      cache obtained from the system allocator (slot arrays, index tables, FIFO rings, arena slabs,
+      sketches), which is what the process actually holds.
+    - Statistics are relaxed atomic per-shard counters on their own cache lines: the hit/miss pair
+      bumped by readers is kept apart from the counters the shard's writer publishes, and both are
+      apart from the lock and index fields. stats() sums them without taking any lock; each field is
+      exact, but a snapshot is not atomic across fields.
+    - When a shard exceeds its budget, evict one of its entries according to the selected policy; repeat until under budget.
     - Public API uses update_or_insert semantics for insert/put.
-    - Thread safe via per-bucket mutex; LRU list modifications also protected by its own mutex.
-      (Coarse improvement: we avoid a global lock for all operations except usage list updates.)
+    - Eviction runs under the shard lock that is already held by the writer, so it never re-locks
+      a bucket or takes a second lock.
+    - Optional TinyLFU admission (Admission::TinyLFU): every get() records the key in a per-shard
+      FrequencySketch (lock-free, aged by halving). insert_if_admitted() only displaces the entry the
+      policy would evict next when the candidate's estimated frequency is higher than the victim's;
+      otherwise the candidate is rejected and the cache is left untouched. Plain inserts and updates
+      always admit.
+    - Warm restart: for_each_entry() walks live entries coldest first in the policy's own order and
+      restore_entry() inserts them back as the newest use, so a dump reloaded in order keeps its recency
+      (LRU), insertion order (FIFO) and reference bits (CLOCK).
 
 */
 
-class InlineCache {
-    
-public:
-    enum class Policy { LRU, FIFO, Random };
+// Key-independent configuration shared by every BasicInlineCache specialization.
+struct InlineCacheBase {
+    enum class Policy { LRU, FIFO, Random, Clock };
+    enum class Storage { Chained, OpenAddressing };
+    enum class Admission { None, TinyLFU };
 
     struct Stats {
         size_t size_entries{0};
-        size_t bytes_estimated{0};
+        size_t bytes_estimated{0}; // bytes held by live entries (slots + value blocks); the budget applies to this
+        size_t bytes_reserved{0};  // bytes allocated by the cache, including free slots, free blocks and indexes
         size_t hits{0};
         size_t misses{0};
         size_t evictions{0};
+        size_t admitted{0}; // insert_if_admitted candidates that displaced a victim
+        size_t rejected{0}; // insert_if_admitted candidates turned away by the admission filter
+        size_t expirations{0}; // entries removed because their TTL passed (by expire() or a writer)
     };
 
-    // Construct cache with given eviction policy, maxBytes budget (default 2MB), bucket count.
-    InlineCache(Policy policy, size_t maxBytes = 2 * 1024 * 1024, size_t bucketCount = 1031)
-        : policy_(policy), maxBytes_(maxBytes), buckets_(bucketCount), rng_(std::random_device{}()) {}
+    static constexpr std::chrono::milliseconds kNoTtl{0};
+};
 
-    // Non-copyable
-    InlineCache(const InlineCache&) = delete;
-    InlineCache& operator=(const InlineCache&) = delete;
-
-    // Attempt to get value; updates LRU usage if found.
-    std::optional<std::string> get(int key) {
-        auto& bucket = bucketFor(key);
-        std::lock_guard<std::mutex> lg(bucket.mtx);
-        for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
-            if (it->key == key) {
-                stats_.hits++;
-                touchLRU(it->lru_iterator);
-                return it->value;
+template <typename Key = int, typename Value = std::string, typename Hash = CacheHash<Key>>
+class BasicInlineCache : public InlineCacheBase {
+    using ValueTraits = CacheValueTraits<Value>;
+
+public:
+
+    // Construct cache with given eviction policy, maxBytes budget (default 2MB), bucket count, shard count,
+    // storage engine and admission filter. Buckets and the byte budget are split evenly across shards; with
+    // OpenAddressing the bucket count only sizes the initial per-shard index.
+    BasicInlineCache(Policy policy, size_t maxBytes = 2 * 1024 * 1024, size_t bucketCount = 1031, size_t shardCount = 1,
+                     Storage storage = Storage::Chained, Admission admission = Admission::None)
+        : policy_(policy), storage_(storage), admission_(admission), maxBytes_(maxBytes),
+          shards_(shardCount == 0 ? 1 : shardCount) {
+        size_t bucketsPerShard = bucketCount / shards_.size();
+        if (bucketsPerShard == 0) bucketsPerShard = 1;
+        std::random_device rd;
+        for (auto& shard : shards_) {
+            if (storage_ == Storage::Chained) shard.buckets.assign(bucketsPerShard, kNil);
+            else shard.flat.reset(bucketsPerShard);
+            shard.maxBytes = maxBytes_ / shards_.size();
+            shard.rng.seed(rd());
+            // size the sketch for the entries a shard can hold with small values
+            if (admission_ == Admission::TinyLFU) shard.sketch.resize(shard.maxBytes / (sizeof(Entry) + 32) + 1);
+            publishStats(shard);
+        }
+    }
+
+    ~BasicInlineCache() {
+        for (auto& shard : shards_) {
+            for (uint32_t id = 0; id < shard.slots.size(); ++id) {
+                if (shard.slots[id].occupied) releaseValue(shard, shard.slots[id]);
             }
+            reclaimReturned(shard);
+        }
+    }
+
+    // Non-copyable
+    BasicInlineCache(const BasicInlineCache&) = delete;
+    BasicInlineCache& operator=(const BasicInlineCache&) = delete;
+
+    // Attempt to get value; records the hit for the eviction policy if found.
+    std::optional<Value> get(const Key& key) {
+        auto handle = get_handle(key);
+        if (!handle) return std::nullopt;
+        return ValueTraits::decode(handle->data(), handle->size());
+    }
+
+    // Like get(), but shares the cached bytes instead of copying them: values longer than
+    // ValueHandle::kInlineBytes are returned as a reference to the immutable block the entry holds. With
+    // TinyLFU admission every lookup, hit or miss, is counted in the shard's frequency sketch. An entry
+    // past its TTL is a miss.
+    std::optional<ValueHandle> get_handle(const Key& key) {
+        auto& shard = shardFor(key);
+        shard.sketch.increment(Hash{}(key));
+        ValueHandle value;
+        for (int attempt = 0; attempt < kOptimisticAttempts; ++attempt) {
+            ReadOutcome outcome = readOptimistic(shard, key, value);
+            if (outcome == ReadOutcome::Hit) return value;
+            if (outcome == ReadOutcome::Miss) return std::nullopt;
+            if (outcome == ReadOutcome::NeedLock) break;
+        }
+        std::shared_lock<std::shared_mutex> lk(shard.mtx);
+        uint32_t id = findSlot(shard, key);
+        if (id == kNil || isExpired(shard.slots[id].expires_at)) {
+            shard.readStats.misses.add();
+            return std::nullopt;
         }
-        stats_.misses++;
-        return std::nullopt;
+        shard.readStats.hits.add();
+        Entry& e = shard.slots[id];
+        e.referenced.set();
+        if (e.length <= kInlineValue) return ValueHandle(e.inlineValue, e.length);
+        e.block->refs.fetch_add(1, std::memory_order_relaxed); // the entry's own reference keeps it alive
+        return ValueHandle(e.block);
     }
 
     // Insert or update value; returns true if inserted new, false if updated existing.
-    bool update_or_insert(int key, const std::string& value) {
-        auto& bucket = bucketFor(key);
-        std::lock_guard<std::mutex> lg(bucket.mtx);
-        for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
-            if (it->key == key) {
-                // update existing
-                adjustBytesOnUpdate(it->value, value);
-                it->value = value;
-                it->timestamp = now();
-                touchLRU(it->lru_iterator);
-                evictIfNeeded();
-                return false;
-            }
+    // A positive ttl makes the entry expire that long from now; zero means it never expires.
+    bool update_or_insert(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        uint32_t id = findLive(shard, key);
+        if (id != kNil) {
+            // update existing
+            assignValue(shard, id, ValueTraits::bytes(value));
+            setExpiry(shard, id, ttl);
+            touch(shard, id);
+            evictIfNeeded(shard);
+            publishStats(shard);
+            return false;
         }
         // new entry
-        size_t entryOverhead = sizeof(Entry) + value.size();
-        bucket.entries.push_front(Entry{key, value, now(), {}, fifoCounter_++});
-    std::lock_guard<std::mutex> lru_lock(lruMutex_);
-    auto listIter = lruList_.insert(lruList_.begin(), key); // most recent at front
-        bucket.entries.front().lru_iterator = listIter;
-        stats_.size_entries++;
-        stats_.bytes_estimated += entryOverhead;
-        evictIfNeeded();
+        id = insertEntry(shard, key, ValueTraits::bytes(value));
+        setExpiry(shard, id, ttl);
+        evictIfNeeded(shard);
+        publishStats(shard);
         return true;
     }
 
-    // Insert only if absent; returns true if inserted, false if key existed.
-    bool insert_if_absent(int key, const std::string& value) {
-        auto& bucket = bucketFor(key);
-        std::lock_guard<std::mutex> lg(bucket.mtx);
-        for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
-            if (it->key == key) {
-                touchLRU(it->lru_iterator);
-                return false;
-            }
+    // Insert only if absent (an expired entry counts as absent); returns true if inserted, false if key existed.
+    bool insert_if_absent(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        uint32_t id = findLive(shard, key);
+        if (id != kNil) {
+            touch(shard, id);
+            publishStats(shard);
+            return false;
         }
-        size_t entryOverhead = sizeof(Entry) + value.size();
-        bucket.entries.push_front(Entry{key, value, now(), {}, fifoCounter_++});
-    std::lock_guard<std::mutex> lru_lock(lruMutex_);
-    auto listIter = lruList_.insert(lruList_.begin(), key);
-        bucket.entries.front().lru_iterator = listIter;
-        stats_.size_entries++;
-        stats_.bytes_estimated += entryOverhead;
-        evictIfNeeded();
+        id = insertEntry(shard, key, ValueTraits::bytes(value));
+        setExpiry(shard, id, ttl);
+        evictIfNeeded(shard);
+        publishStats(shard);
         return true;
     }
 
-    // Update only if present; returns true if updated, false if missing.
-    bool update(int key, const std::string& value) {
-        auto& bucket = bucketFor(key);
-        std::lock_guard<std::mutex> lg(bucket.mtx);
-        for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
-            if (it->key == key) {
-                adjustBytesOnUpdate(it->value, value);
-                it->value = value;
-                it->timestamp = now();
-                touchLRU(it->lru_iterator);
-                evictIfNeeded();
-                return true;
+    // Insert a value fetched from the backing store, subject to the admission filter. An existing key is
+    // updated. A new key is inserted directly while the shard has room; once it is full the key is only
+    // admitted if its estimated frequency beats that of the next eviction victim. Returns true if the value
+    // is now cached. Without an admission filter this behaves like update_or_insert. The entry never expires.
+    bool insert_if_admitted(const Key& key, const Value& value) {
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        uint32_t id = findLive(shard, key);
+        if (id != kNil) {
+            assignValue(shard, id, ValueTraits::bytes(value));
+            setExpiry(shard, id, kNoTtl);
+            touch(shard, id);
+            evictIfNeeded(shard);
+            publishStats(shard);
+            return true;
+        }
+        if (admission_ != Admission::None && shard.bytesEstimated + entryBytes(ValueTraits::bytes(value).size()) > shard.maxBytes) {
+            uint32_t victim = peekVictim(shard);
+            if (victim != kNil) {
+                if (shard.sketch.frequency(Hash{}(key)) <= shard.sketch.frequency(Hash{}(shard.slots[victim].key))) {
+                    shard.writeStats.rejected.add();
+                    publishStats(shard);
+                    return false;
+                }
+                removeEntry(shard, victim);
+                shard.writeStats.evictions.add();
             }
+            shard.writeStats.admitted.add();
+        }
+        insertEntry(shard, key, ValueTraits::bytes(value));
+        evictIfNeeded(shard);
+        publishStats(shard);
+        return true;
+    }
+
+    // Update only if present and not expired; returns true if updated, false if missing. ttl as for update_or_insert.
+    bool update(const Key& key, const Value& value, std::chrono::milliseconds ttl = kNoTtl) {
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        uint32_t id = findLive(shard, key);
+        if (id == kNil) {
+            publishStats(shard);
+            return false;
         }
-        return false;
+        assignValue(shard, id, ValueTraits::bytes(value));
+        setExpiry(shard, id, ttl);
+        touch(shard, id);
+        evictIfNeeded(shard);
+        publishStats(shard);
+        return true;
     }
 
     // Remove key if exists; returns true if erased.
-    bool erase(int key) {
-        auto& bucket = bucketFor(key);
-        std::lock_guard<std::mutex> lg(bucket.mtx);
-        for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
-            if (it->key == key) {
-                removeEntry(bucket, it);
-                return true;
+    bool erase(const Key& key) {
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        uint32_t id = findLive(shard, key);
+        if (id == kNil) {
+            publishStats(shard);
+            return false;
+        }
+        removeEntry(shard, id);
+        publishStats(shard);
+        return true;
+    }
+
+    // Active expiry: remove up to budget entries whose TTL has passed, visiting the shards' timing wheels in
+    // turn (each under its own shard lock, skipping shards with no pending timers). Returns the number of
+    // entries removed; a result equal to budget means more may be due. Meant to be called periodically by a
+    // background sweeper.
+    size_t expire(size_t budget = SIZE_MAX) {
+        size_t removed = 0;
+        size_t first = sweepCursor_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < shards_.size() && removed < budget; ++i) {
+            Shard& shard = shards_[(first + i) % shards_.size()];
+            if (shard.writeStats.timers.load() == 0) continue;
+            WriteLock lk(shard);
+            size_t expired = 0;
+            // timers of entries that were erased, rewritten or re-armed since are ignored
+            shard.wheel.advance(nowMs(), budget - removed, [&](uint32_t id, uint64_t deadline) {
+                Entry& e = shard.slots[id];
+                if (!e.occupied || e.expires_at != deadline) return;
+                removeEntry(shard, id);
+                ++expired;
+            });
+            shard.writeStats.expirations.add(expired);
+            removed += expired;
+            publishStats(shard);
+        }
+        return removed;
+    }
+
+    // Fetch statistics snapshot (sum over all shards). Lock-free: never waits for a writer.
+    Stats stats() const {
+        Stats total;
+        for (const auto& shard : shards_) {
+            total.size_entries += shard.writeStats.entries.load();
+            total.bytes_estimated += shard.writeStats.bytes.load();
+            total.bytes_reserved += shard.writeStats.reserved.load();
+            total.hits += shard.readStats.hits.load();
+            total.misses += shard.readStats.misses.load();
+            total.evictions += shard.writeStats.evictions.load();
+            total.admitted += shard.writeStats.admitted.load();
+            total.rejected += shard.writeStats.rejected.load();
+            total.expirations += shard.writeStats.expirations.load();
+        }
+        return total;
+    }
+
+    // Warm restart: visit every live entry without a TTL, one shard at a time under its shared lock, coldest
+    // first (LRU tail to head, FIFO oldest insertion first, CLOCK and RANDOM in slot order). fn(key, bytes,
+    // referenced) gets the stored value bytes and the entry's reference bit. Entries with a TTL are skipped:
+    // their deadline is on this process's steady clock.
+    template <typename Fn>
+    void for_each_entry(Fn&& fn) const {
+        for (const auto& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lk(shard.mtx);
+            auto visit = [&](uint32_t id) {
+                const Entry& e = shard.slots[id];
+                if (!e.occupied || e.expires_at != 0) return;
+                std::string_view bytes = e.length <= kInlineValue ? std::string_view(e.inlineValue, e.length)
+                                                                  : std::string_view(e.block->data(), e.length);
+                fn(e.key, bytes, e.referenced.test());
+            };
+            if (policy_ == Policy::LRU) {
+                for (uint32_t id = shard.lruTail; id != kNil; id = shard.slots[id].lru_prev) visit(id);
+            } else if (policy_ == Policy::FIFO) {
+                for (size_t i = 0; i < shard.fifo.count; ++i) {
+                    const FifoItem& item = shard.fifo.items[(shard.fifo.head + i) % shard.fifo.items.size()];
+                    if (isLive(shard, item)) visit(item.slot);
+                }
+            } else {
+                for (uint32_t id = 0; id < shard.slots.size(); ++id) visit(id);
             }
         }
-        return false;
     }
 
-    // Fetch statistics snapshot.
-    Stats stats() const { return stats_; }
+    // Put back an entry visited by for_each_entry unless the key is cached already: inserted as the newest
+    // use, with its reference bit, so restoring in visit order rebuilds LRU and FIFO order. Returns true if
+    // inserted.
+    bool restore_entry(const Key& key, std::string_view bytes, bool referenced) {
+        if (ValueTraits::kFixedWidth && bytes.size() != sizeof(Value)) return false;
+        auto& shard = shardFor(key);
+        WriteLock lk(shard);
+        if (findLive(shard, key) != kNil) {
+            publishStats(shard);
+            return false;
+        }
+        uint32_t id = insertEntry(shard, key, bytes);
+        if (referenced) shard.slots[id].referenced.set();
+        evictIfNeeded(shard);
+        publishStats(shard);
+        return true;
+    }
 
     // Current policy
     Policy policy() const { return policy_; }
 
+    // Current storage engine
+    Storage storage() const { return storage_; }
+
+    // Current admission filter
+    Admission admission() const { return admission_; }
+
+    // Number of lock-striped shards
+    size_t shard_count() const { return shards_.size(); }
+
 private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    // CLOCK reference bit. Set by readers holding the shard lock in shared mode, so it is atomic;
+    // copyable so the slot array can grow (growth only happens under the exclusive lock).
+    struct RefBit {
+        std::atomic<uint8_t> bit{0};
+        RefBit() = default;
+        RefBit(const RefBit& o) : bit(o.bit.load(std::memory_order_relaxed)) {}
+        RefBit& operator=(const RefBit& o) { bit.store(o.bit.load(std::memory_order_relaxed), std::memory_order_relaxed); return *this; }
+        void set() { if (!bit.load(std::memory_order_relaxed)) bit.store(1, std::memory_order_relaxed); }
+        void clear() { bit.store(0, std::memory_order_relaxed); }
+        bool test() const { return bit.load(std::memory_order_relaxed) != 0; }
+    };
+
+    // Entry bytes ahead of the value union (key, flags, chain link, length), and the inline value area that
+    // fills the rest of a 64-byte entry (the 24-byte tail holds the LRU links, TTL deadline and FIFO order).
+    static constexpr size_t kEntryHead = (sizeof(Key) + 12 + 7) & ~size_t{7};
+    static constexpr size_t kInlineValue =
+        kEntryHead + 24 + sizeof(ValueBlock*) >= 64 ? sizeof(ValueBlock*)
+        : 64 - 24 - kEntryHead > ValueHandle::kInlineBytes ? ValueHandle::kInlineBytes : 64 - 24 - kEntryHead;
+    static_assert(!ValueTraits::kFixedWidth || sizeof(Value) <= kInlineValue,
+                  "fixed-width values must fit in the entry's inline value area");
+
+    // One cache line per entry; fields read on a hit (key, length, value bytes) come first.
     struct Entry {
-        int key;
-        std::string value;
-        std::chrono::steady_clock::time_point timestamp;
-        std::list<int>::iterator lru_iterator; // reference into global lruList_
-        size_t fifo_order; // increasing counter for FIFO
+        Key key{};
+        bool occupied{false};
+        RefBit referenced;            // CLOCK second-chance bit
+        uint32_t next{kNil};          // next slot in the same bucket chain (or free list)
+        uint32_t length{0};           // value size in bytes
+        union {
+            char inlineValue[kInlineValue];
+            ValueBlock* block;        // length > kInlineValue
+        };
+        uint32_t lru_prev{kNil};      // towards most recent
+        uint32_t lru_next{kNil};      // towards least recent
+        uint64_t expires_at{0};       // TTL deadline in nowMs() units; 0 = never expires
+        size_t fifo_order{0}; // increasing counter for FIFO
+    };
+    static_assert(sizeof(Entry) <= 64 || sizeof(Key) > 16, "Entry should fit in one cache line");
+
+    // Entry storage of a shard: chunks of kChunk entries that are never moved or freed while the cache
+    // lives. Writers (exclusive shard lock) append; optimistic readers resolve ids through tryAt().
+    class SlotArray {
+    public:
+        SlotArray() = default;
+        SlotArray(const SlotArray&) = delete;
+        SlotArray& operator=(const SlotArray&) = delete;
+
+        Entry& operator[](uint32_t id) { return chunks_[id >> kChunkShift][id & (kChunk - 1)]; }
+        const Entry& operator[](uint32_t id) const { return chunks_[id >> kChunkShift][id & (kChunk - 1)]; }
+        uint32_t size() const { return size_.load(std::memory_order_relaxed); }
+
+        // Append a default entry (exclusive lock held).
+        void emplace_back() {
+            uint32_t n = size();
+            if ((n & (kChunk - 1)) == 0 && (n >> kChunkShift) == chunks_.size()) addChunk();
+            chunks_[n >> kChunkShift][n & (kChunk - 1)] = Entry{};
+            size_.store(n + 1, std::memory_order_release);
+        }
+
+        // Entry for id, or nullptr if id is out of range. Safe without the lock.
+        Entry* tryAt(uint32_t id) const {
+            if (id >= size_.load(std::memory_order_acquire)) return nullptr;
+            const std::atomic<Entry*>* table = table_.load(std::memory_order_acquire);
+            return table[id >> kChunkShift].load(std::memory_order_relaxed) + (id & (kChunk - 1));
+        }
+
+        size_t memory_bytes() const {
+            size_t bytes = chunks_.size() * kChunk * sizeof(Entry);
+            for (const auto& t : tables_) bytes += t.second * sizeof(std::atomic<Entry*>);
+            return bytes;
+        }
+
+    private:
+        static constexpr uint32_t kChunkShift = 10;
+        static constexpr uint32_t kChunk = 1u << kChunkShift;
+
+        std::vector<std::unique_ptr<Entry[]>> chunks_;
+        // chunk pointer tables published to readers; outgrown tables are kept for readers still using them
+        std::vector<std::pair<std::unique_ptr<std::atomic<Entry*>[]>, size_t>> tables_;
+        std::atomic<std::atomic<Entry*>*> table_{nullptr};
+        std::atomic<uint32_t> size_{0};
+
+        void addChunk() {
+            chunks_.emplace_back(new Entry[kChunk]);
+            size_t capacity = tables_.empty() ? 0 : tables_.back().second;
+            if (chunks_.size() > capacity) {
+                size_t next = capacity == 0 ? 8 : capacity * 2;
+                std::unique_ptr<std::atomic<Entry*>[]> table(new std::atomic<Entry*>[next]);
+                for (size_t i = 0; i < next; ++i) {
+                    table[i].store(i < chunks_.size() - 1 ? chunks_[i].get() : nullptr, std::memory_order_relaxed);
+                }
+                tables_.emplace_back(std::move(table), next);
+            }
+            tables_.back().first[chunks_.size() - 1].store(chunks_.back().get(), std::memory_order_relaxed);
+            table_.store(tables_.back().first.get(), std::memory_order_release);
+        }
+    };
+
+    struct FifoItem {
+        uint32_t slot;
+        size_t order; // Entry::fifo_order at insertion time; a mismatch marks a tombstone
+    };
+
+    // Growable circular buffer of insertions, oldest at head.
+    struct FifoRing {
+        std::vector<FifoItem> items;
+        size_t head{0};
+        size_t count{0};
+
+        void push(const FifoItem& item) {
+            if (count == items.size()) grow();
+            items[(head + count) % items.size()] = item;
+            ++count;
+        }
+        bool pop(FifoItem& out) {
+            if (count == 0) return false;
+            out = items[head];
+            head = (head + 1) % items.size();
+            --count;
+            return true;
+        }
+        void grow() {
+            std::vector<FifoItem> next(items.empty() ? 16 : items.size() * 2);
+            for (size_t i = 0; i < count; ++i) next[i] = items[(head + i) % items.size()];
+            items.swap(next);
+            head = 0;
+        }
     };
 
-    struct Bucket {
-        std::list<Entry> entries; // linked list of entries
-        std::mutex mtx;           // per-bucket lock
+    // Relaxed atomic statistics counter.
+    struct Counter {
+        std::atomic<size_t> value{0};
+        void add(size_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+        void set(size_t n) { value.store(n, std::memory_order_relaxed); }
+        size_t load() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    // Counters only written by the holder of the exclusive shard lock.
+    struct alignas(64) WriterStats {
+        Counter entries;   // published copy of Shard::sizeEntries
+        Counter bytes;     // published copy of Shard::bytesEstimated
+        Counter reserved;  // published reservedBytes()
+        Counter evictions;
+        Counter admitted;
+        Counter rejected;
+        Counter expirations;
+        Counter timers;    // published wheel.size(); lets expire() skip shards without TTL entries
+    };
+
+    // Counters bumped concurrently by readers holding the shared lock.
+    struct alignas(64) ReaderStats {
+        Counter hits;
+        Counter misses;
+    };
+
+    // One lock stripe. Aligned to a cache line so neighbouring shard locks do not false-share.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mtx; // guards every field below except the stats counters and sketch
+        std::atomic<uint64_t> seq{0};  // seqlock sequence: odd while a writer modifies the shard
+        std::vector<uint32_t> buckets; // Chained: this shard's bucket range, head slot of each chain
+        BasicFlatIndex<Key, Hash> flat; // OpenAddressing: key -> slot index
+        SlotArray slots;               // entry storage swept by the CLOCK hand
+        uint32_t freeHead{kNil};       // recycled slots, chained through Entry::next
+        uint32_t lruHead{kNil};        // most recent
+        uint32_t lruTail{kNil};        // least recent
+        size_t clockHand{0};
+        size_t maxBytes{0};            // this shard's share of the byte budget
+        size_t fifoCounter{0};
+        FifoRing fifo;                 // insertion order (FIFO policy only)
+        size_t sizeEntries{0};
+        size_t bytesEstimated{0};
+        std::mt19937 rng;
+        FrequencySketch sketch;        // TinyLFU access counts (empty unless admission is enabled)
+        SlabArena arena;               // value blocks larger than kInlineValue
+        TimingWheel wheel;             // TTL deadlines of entries, by slot id
+        std::atomic<ValueBlock*> returned{nullptr}; // blocks whose last reference was dropped by a handle
+        WriterStats writeStats;
+        ReaderStats readStats;
+    };
+
+    // Exclusive shard lock that also holds the shard's sequence number odd, so optimistic readers that
+    // overlap the critical section discard what they read.
+    class WriteLock {
+    public:
+        explicit WriteLock(Shard& shard) : shard_(shard), lk_(shard.mtx) {
+            shard_.seq.store(shard_.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteLock() { shard_.seq.store(shard_.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+        WriteLock(const WriteLock&) = delete;
+        WriteLock& operator=(const WriteLock&) = delete;
+
+    private:
+        Shard& shard_;
+        std::unique_lock<std::shared_mutex> lk_;
     };
 
+    enum class ReadOutcome { Hit, Miss, Retry, NeedLock };
+    static constexpr int kOptimisticAttempts = 4;
+
     Policy policy_;
+    Storage storage_;
+    Admission admission_;
     size_t maxBytes_;
-    std::vector<Bucket> buckets_;
-    mutable std::mutex lruMutex_; // protects lruList_ modifications
-    std::list<int> lruList_;      // most recent front
-    std::atomic<size_t> fifoCounter_{0};
-    Stats stats_;
-    std::mt19937 rng_;
+    std::vector<Shard> shards_;
+    std::atomic<size_t> sweepCursor_{0}; // shard expire() starts from, rotated so a small budget reaches every shard
+
+    Shard& shardFor(const Key& key) { return shards_[Hash{}(key) % shards_.size()]; }
+
+    // Keys that share a shard are spread over that shard's buckets using the remaining hash bits.
+    size_t bucketIndex(const Shard& shard, const Key& key) const {
+        uint64_t h = Hash{}(key) / shards_.size();
+        return h % shard.buckets.size();
+    }
+
+    // Monotonic milliseconds, offset by one so a deadline is never 0.
+    static uint64_t nowMs() {
+        auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(t).count()) + 1;
+    }
+
+    static bool isExpired(uint64_t expiresAt) { return expiresAt != 0 && expiresAt <= nowMs(); }
+
+    // Bytes charged to a live entry holding a value of the given length.
+    static size_t entryBytes(size_t length) {
+        return sizeof(Entry) + (length > kInlineValue ? SlabArena::block_bytes(sizeof(ValueBlock) + length) : 0);
+    }
+
+    size_t reservedBytes(const Shard& shard) const {
+        return shard.slots.memory_bytes() + shard.buckets.capacity() * sizeof(uint32_t) +
+               shard.flat.memory_bytes() + shard.fifo.items.capacity() * sizeof(FifoItem) +
+               shard.arena.reserved_bytes() + shard.sketch.memory_bytes() + shard.wheel.memory_bytes();
+    }
+
+    // Make the shard's sizes visible to stats(); called by writers before releasing the lock.
+    void publishStats(Shard& shard) const {
+        shard.writeStats.entries.set(shard.sizeEntries);
+        shard.writeStats.bytes.set(shard.bytesEstimated);
+        shard.writeStats.reserved.set(reservedBytes(shard));
+        shard.writeStats.timers.set(shard.wheel.size());
+    }
+
+    // Copy value into an entry that currently holds none.
+    static void storeValue(Shard& shard, Entry& e, std::string_view value) {
+        e.length = static_cast<uint32_t>(value.size());
+        if (value.size() <= kInlineValue) {
+            if (!value.empty()) std::memcpy(e.inlineValue, value.data(), value.size());
+            return;
+        }
+        reclaimReturned(shard);
+        uint8_t cls = 0;
+        ValueBlock* b = new (shard.arena.allocate(sizeof(ValueBlock) + value.size(), cls)) ValueBlock;
+        b->refs.store(1, std::memory_order_release);
+        b->length = e.length;
+        b->sizeClass = cls;
+        b->returnTo = &shard.returned;
+        std::memcpy(b->data(), value.data(), value.size());
+        e.block = b;
+    }
+
+    // Drop the entry's reference to its value; the block is freed now unless a handle still holds it.
+    static void releaseValue(Shard& shard, Entry& e) {
+        if (e.length > kInlineValue && e.block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            freeBlock(shard, e.block);
+        }
+        e.length = 0;
+    }
 
-    Bucket& bucketFor(int key) { return buckets_[static_cast<size_t>(key) % buckets_.size()]; }
+    // Free blocks keep refs == 0 (the arena links them past it), so a stale reader's tryRetain() fails.
+    static_assert(offsetof(ValueBlock, refs) + sizeof(ValueBlock::refs) <= SlabArena::kLinkOffset,
+                  "the free-list link must not overlap ValueBlock::refs");
 
-    static std::chrono::steady_clock::time_point now() { return std::chrono::steady_clock::now(); }
+    static void freeBlock(Shard& shard, ValueBlock* b) {
+        shard.arena.deallocate(reinterpret_cast<char*>(b), b->sizeClass, sizeof(ValueBlock) + b->length);
+    }
+
+    // Return blocks released by handles to the arena's free lists.
+    static void reclaimReturned(Shard& shard) {
+        if (shard.returned.load(std::memory_order_relaxed) == nullptr) return;
+        ValueBlock* b = shard.returned.exchange(nullptr, std::memory_order_acquire);
+        while (b != nullptr) {
+            ValueBlock* next = b->nextReturned;
+            freeBlock(shard, b);
+            b = next;
+        }
+    }
+
+    // All helpers below expect the shard lock to be held by the caller (exclusively unless noted).
+
+    // Shared lock is sufficient.
+    uint32_t findSlot(const Shard& shard, const Key& key) const {
+        if (storage_ == Storage::OpenAddressing) return shard.flat.find(key);
+        for (uint32_t id = shard.buckets[bucketIndex(shard, key)]; id != kNil; id = shard.slots[id].next) {
+            if (shard.slots[id].key == key) return id;
+        }
+        return kNil;
+    }
+
+    // findSlot() that removes the entry instead if it has expired.
+    uint32_t findLive(Shard& shard, const Key& key) {
+        uint32_t id = findSlot(shard, key);
+        if (id == kNil || !isExpired(shard.slots[id].expires_at)) return id;
+        removeEntry(shard, id);
+        shard.writeStats.expirations.add();
+        return kNil;
+    }
 
-    void touchLRU(std::list<int>::iterator& itKey) {
-        std::lock_guard<std::mutex> lock(lruMutex_);
-        // move key to front if not already
-        if (itKey != lruList_.begin()) {
-            int k = *itKey;
-            lruList_.erase(itKey);
-            itKey = lruList_.insert(lruList_.begin(), k);
+    // Arm (ttl > 0) or clear the entry's deadline. A replaced timer stays in the wheel until it comes due
+    // and is then ignored because it no longer matches the entry's deadline.
+    void setExpiry(Shard& shard, uint32_t id, std::chrono::milliseconds ttl) {
+        Entry& e = shard.slots[id];
+        if (ttl.count() <= 0) {
+            e.expires_at = 0;
+            return;
         }
+        e.expires_at = nowMs() + static_cast<uint64_t>(ttl.count());
+        shard.wheel.schedule(id, e.expires_at);
     }
 
-    void adjustBytesOnUpdate(const std::string& oldVal, const std::string& newVal) {
-        if (newVal.size() > oldVal.size()) stats_.bytes_estimated += (newVal.size() - oldVal.size());
-        else stats_.bytes_estimated -= (oldVal.size() - newVal.size());
+    // True if no writer entered the shard since the reader sampled begin.
+    static bool validate(const Shard& shard, uint64_t begin) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return shard.seq.load(std::memory_order_relaxed) == begin;
     }
 
-    void removeEntry(Bucket& bucket, std::list<Entry>::iterator it) {
-        {
-            std::lock_guard<std::mutex> lock(lruMutex_);
-            lruList_.erase(it->lru_iterator);
+    // Lock-free lookup. The index walk and entry reads may race with a writer; nothing read is trusted
+    // until the sequence number is validated, and nothing is dereferenced except memory that is never freed.
+    ReadOutcome readOptimistic(Shard& shard, const Key& key, ValueHandle& out) const {
+        uint64_t begin = shard.seq.load(std::memory_order_acquire);
+        if (begin & 1) return ReadOutcome::Retry;
+        uint32_t id = kNil;
+        if (storage_ == Storage::OpenAddressing) {
+            id = shard.flat.find(key);
+        } else {
+            // bound the walk: a chain being relinked by a writer may briefly look cyclic
+            uint32_t hops = shard.slots.size() + 1;
+            for (uint32_t cur = shard.buckets[bucketIndex(shard, key)]; cur != kNil && hops-- > 0;) {
+                const Entry* e = shard.slots.tryAt(cur);
+                if (e == nullptr) break;
+                if (e->key == key) {
+                    id = cur;
+                    break;
+                }
+                cur = e->next;
+            }
+        }
+        Entry* e = id == kNil ? nullptr : shard.slots.tryAt(id);
+        if (e == nullptr) {
+            if (!validate(shard, begin)) return ReadOutcome::Retry;
+            shard.readStats.misses.add();
+            return ReadOutcome::Miss;
+        }
+        uint32_t length = e->length;
+        uint64_t expiresAt = e->expires_at;
+        ValueBlock* block = nullptr;
+        if (length > kInlineValue) block = e->block;
+        else out = ValueHandle(e->inlineValue, length);
+        bool match = e->occupied && e->key == key;
+        if (!validate(shard, begin) || !match) return ReadOutcome::Retry;
+        if (isExpired(expiresAt)) {
+            // left in place for the sweeper or the next writer; readers never modify the shard
+            shard.readStats.misses.add();
+            return ReadOutcome::Miss;
         }
-        stats_.bytes_estimated -= (sizeof(Entry) + it->value.size());
-        stats_.size_entries--;
-        bucket.entries.erase(it);
+        if (block != nullptr) {
+            // (length, block) are now a consistent pair. Arena blocks are never unmapped and the free list
+            // leaves refs at 0, so tryRetain() may touch a block recycled meanwhile: it fails on a free block,
+            // and a reference taken on a block reused for another value is dropped below. Large blocks may be
+            // unmapped, so they go through the lock.
+            if (sizeof(ValueBlock) + length > SlabArena::kMaxClassBytes) return ReadOutcome::NeedLock;
+            if (!block->tryRetain()) return ReadOutcome::Retry;
+            if (!validate(shard, begin)) {
+                block->release(); // recycled for another value
+                return ReadOutcome::Retry;
+            }
+            ValueHandle held(block); // validated: length is no longer written while we hold a reference
+            out = std::move(held);
+        }
+        shard.readStats.hits.add();
+        e->referenced.set();
+        return ReadOutcome::Hit;
     }
 
-    void evictIfNeeded() {
+    void lruUnlink(Shard& shard, uint32_t id) {
+        Entry& e = shard.slots[id];
+        if (e.lru_prev != kNil) shard.slots[e.lru_prev].lru_next = e.lru_next; else shard.lruHead = e.lru_next;
+        if (e.lru_next != kNil) shard.slots[e.lru_next].lru_prev = e.lru_prev; else shard.lruTail = e.lru_prev;
+        e.lru_prev = e.lru_next = kNil;
+    }
+
+    void lruPushFront(Shard& shard, uint32_t id) {
+        Entry& e = shard.slots[id];
+        e.lru_prev = kNil;
+        e.lru_next = shard.lruHead;
+        if (shard.lruHead != kNil) shard.slots[shard.lruHead].lru_prev = id;
+        shard.lruHead = id;
+        if (shard.lruTail == kNil) shard.lruTail = id;
+    }
+
+    // Record a use of the entry for the eviction policy.
+    void touch(Shard& shard, uint32_t id) {
+        if (policy_ == Policy::LRU) {
+            // move to front if not already
+            if (shard.lruHead != id) {
+                lruUnlink(shard, id);
+                lruPushFront(shard, id);
+            }
+        } else if (policy_ == Policy::Clock) {
+            shard.slots[id].referenced.set();
+        }
+    }
+
+    uint32_t insertEntry(Shard& shard, const Key& key, std::string_view value) {
+        uint32_t id;
+        if (shard.freeHead != kNil) {
+            id = shard.freeHead;
+            shard.freeHead = shard.slots[id].next;
+        } else {
+            id = static_cast<uint32_t>(shard.slots.size());
+            shard.slots.emplace_back();
+        }
+        Entry& e = shard.slots[id];
+        e.key = key;
+        e.occupied = true;
+        e.referenced.clear(); // new entries must earn their second chance
+        storeValue(shard, e, value);
+        e.expires_at = 0;
+        e.fifo_order = shard.fifoCounter++;
+        if (storage_ == Storage::OpenAddressing) {
+            shard.flat.insert(key, id);
+        } else {
+            size_t b = bucketIndex(shard, key);
+            e.next = shard.buckets[b];
+            shard.buckets[b] = id;
+        }
+        if (policy_ == Policy::LRU) lruPushFront(shard, id); // most recent at front
+        if (policy_ == Policy::FIFO) fifoPush(shard, id);
+        shard.sizeEntries++;
+        shard.bytesEstimated += entryBytes(value.size());
+        return id;
+    }
+
+    void assignValue(Shard& shard, uint32_t id, std::string_view value) {
+        Entry& e = shard.slots[id];
+        shard.bytesEstimated -= entryBytes(e.length);
+        shard.bytesEstimated += entryBytes(value.size());
+        // a block can be rewritten only while no handle shares it
+        bool sameBlock = e.length > kInlineValue && value.size() > kInlineValue &&
+                         e.block->sizeClass != SlabArena::kLargeClass &&
+                         SlabArena::class_for(sizeof(ValueBlock) + value.size()) == e.block->sizeClass &&
+                         e.block->refs.load(std::memory_order_acquire) == 1;
+        if (sameBlock) {
+            std::memcpy(e.block->data(), value.data(), value.size());
+            e.block->length = static_cast<uint32_t>(value.size());
+            e.length = e.block->length;
+        } else if (e.length <= kInlineValue && value.size() <= kInlineValue) {
+            if (!value.empty()) std::memcpy(e.inlineValue, value.data(), value.size());
+            e.length = static_cast<uint32_t>(value.size());
+        } else {
+            releaseValue(shard, e);
+            storeValue(shard, e, value);
+        }
+    }
+
+    void removeEntry(Shard& shard, uint32_t id) {
+        Entry& e = shard.slots[id];
+        if (storage_ == Storage::OpenAddressing) {
+            shard.flat.erase(e.key);
+        } else {
+            // unlink from bucket chain
+            uint32_t* link = &shard.buckets[bucketIndex(shard, e.key)];
+            while (*link != id) link = &shard.slots[*link].next;
+            *link = e.next;
+        }
+        if (policy_ == Policy::LRU) lruUnlink(shard, id);
+        shard.bytesEstimated -= entryBytes(e.length);
+        shard.sizeEntries--;
+        e.occupied = false;
+        e.referenced.clear();
+        releaseValue(shard, e); // block goes back to its class free list once unshared
+        e.next = shard.freeHead;
+        shard.freeHead = id;
+    }
+
+    void evictIfNeeded(Shard& shard) {
         // Loop while over budget (avoid long loops by capping iterations)
         int guard = 0;
-        while (stats_.bytes_estimated > maxBytes_ && stats_.size_entries > 0 && guard < 10000) {
+        while (shard.bytesEstimated > shard.maxBytes && shard.sizeEntries > 0 && guard < 10000) {
             ++guard;
-            if (policy_ == Policy::LRU) evictLRU();
-            else if (policy_ == Policy::FIFO) evictFIFO();
-            else evictRandom();
-            stats_.evictions++;
+            if (policy_ == Policy::LRU) evictLRU(shard);
+            else if (policy_ == Policy::FIFO) evictFIFO(shard);
+            else if (policy_ == Policy::Clock) evictClock(shard);
+            else evictRandom(shard);
+            shard.writeStats.evictions.add();
         }
     }
 
-    void evictLRU() {
-        int victimKey = -1;
-        {
-            std::lock_guard<std::mutex> lock(lruMutex_);
-            victimKey = lruList_.empty() ? -1 : lruList_.back();
+    // Slot the policy would evict next, without evicting it (kNil if the shard is empty). May advance
+    // internal cursors (FIFO tombstones, CLOCK hand and reference bits) exactly as an eviction would.
+    uint32_t peekVictim(Shard& shard) {
+        if (shard.sizeEntries == 0) return kNil;
+        if (policy_ == Policy::LRU) return lruVictim(shard);
+        if (policy_ == Policy::FIFO) {
+            FifoItem item;
+            while (shard.fifo.count > 0) {
+                item = shard.fifo.items[shard.fifo.head];
+                if (isLive(shard, item)) return item.slot;
+                shard.fifo.pop(item);
+            }
+            return kNil;
+        }
+        if (policy_ == Policy::Clock) {
+            size_t n = shard.slots.size();
+            for (size_t step = 0; step < 2 * n; ++step) {
+                if (shard.clockHand >= n) shard.clockHand = 0;
+                Entry& e = shard.slots[shard.clockHand];
+                if (e.occupied && !e.referenced.test()) return static_cast<uint32_t>(shard.clockHand);
+                e.referenced.clear();
+                ++shard.clockHand;
+            }
+            return kNil;
+        }
+        std::uniform_int_distribution<size_t> dist(0, shard.slots.size() - 1);
+        for (int attempts = 0; attempts < 32; ++attempts) {
+            uint32_t id = static_cast<uint32_t>(dist(shard.rng));
+            if (shard.slots[id].occupied) return id;
         }
-        if (victimKey == -1) return;
-        erase(victimKey);
+        for (uint32_t id = 0; id < shard.slots.size(); ++id) {
+            if (shard.slots[id].occupied) return id;
+        }
+        return kNil;
     }
 
-    void evictFIFO() {
-        // scan buckets for minimal fifo_order (could be optimized but simple scan is fine given size constraints)
-        int victimKey = -1;
-        size_t victimOrder = SIZE_MAX;
-        for (auto& b : buckets_) {
-            std::lock_guard<std::mutex> lg(b.mtx);
-            for (auto it = b.entries.begin(); it != b.entries.end(); ++it) {
-                if (it->fifo_order < victimOrder) {
-                    victimOrder = it->fifo_order;
-                    victimKey = it->key;
-                }
+    // Least recently used entry, after moving tail entries that were hit since their last visit to the front.
+    uint32_t lruVictim(Shard& shard) {
+        for (size_t moved = 0; shard.lruTail != kNil && moved < shard.sizeEntries; ++moved) {
+            uint32_t id = shard.lruTail;
+            Entry& e = shard.slots[id];
+            if (!e.referenced.test()) return id;
+            e.referenced.clear();
+            lruUnlink(shard, id);
+            lruPushFront(shard, id);
+        }
+        return shard.lruTail;
+    }
+
+    void evictLRU(Shard& shard) {
+        uint32_t id = lruVictim(shard);
+        if (id == kNil) return;
+        removeEntry(shard, id);
+    }
+
+    static bool isLive(const Shard& shard, const FifoItem& item) {
+        const Entry& e = shard.slots[item.slot];
+        return e.occupied && e.fifo_order == item.order;
+    }
+
+    void fifoPush(Shard& shard, uint32_t id) {
+        // Drop tombstones once they outnumber live entries so the ring stays O(entries).
+        if (shard.fifo.count >= 2 * shard.sizeEntries + 16) {
+            FifoRing live;
+            FifoItem item;
+            while (shard.fifo.pop(item)) {
+                if (isLive(shard, item)) live.push(item);
             }
+            shard.fifo = std::move(live);
         }
-        if (victimKey != -1) erase(victimKey);
+        shard.fifo.push(FifoItem{id, shard.slots[id].fifo_order});
     }
 
-    void evictRandom() {
-        // pick random non-empty bucket
-        std::uniform_int_distribution<size_t> distBucket(0, buckets_.size() - 1);
+    void evictFIFO(Shard& shard) {
+        // pop the oldest insertion, skipping tombstones left by erase/eviction
+        FifoItem item;
+        while (shard.fifo.pop(item)) {
+            if (!isLive(shard, item)) continue;
+            removeEntry(shard, item.slot);
+            return;
+        }
+    }
+
+    void evictClock(Shard& shard) {
+        // Two full sweeps always find a victim: the first clears every reference bit it passes.
+        size_t n = shard.slots.size();
+        for (size_t step = 0; step < 2 * n; ++step) {
+            if (shard.clockHand >= n) shard.clockHand = 0;
+            uint32_t id = static_cast<uint32_t>(shard.clockHand++);
+            Entry& e = shard.slots[id];
+            if (!e.occupied) continue;
+            if (e.referenced.test()) {
+                e.referenced.clear();
+                continue;
+            }
+            removeEntry(shard, id);
+            return;
+        }
+    }
+
+    void evictRandom(Shard& shard) {
+        // pick random occupied slot of this shard
+        std::uniform_int_distribution<size_t> dist(0, shard.slots.size() - 1);
         for (int attempts = 0; attempts < 32; ++attempts) {
-            size_t bi = distBucket(rng_);
-            Bucket& b = buckets_[bi];
-            std::lock_guard<std::mutex> lg(b.mtx);
-            if (b.entries.empty()) continue;
-            // choose random entry index
-            std::uniform_int_distribution<size_t> distEntry(0, b.entries.size() - 1);
-            size_t idx = distEntry(rng_);
-            auto it = b.entries.begin();
-            std::advance(it, idx);
-            int victimKey = it->key;
-            // release lock before erase to avoid deadlock (erase will re-lock bucket)
-            // but we need a copy of key only
-            erase(victimKey);
+            uint32_t id = static_cast<uint32_t>(dist(shard.rng));
+            if (!shard.slots[id].occupied) continue;
+            removeEntry(shard, id);
             return;
         }
-        // fallback: LRU if random failed
-        evictLRU();
+        // fallback for sparse slot arrays: sweep from the hand (reference bits are never set under RANDOM)
+        evictClock(shard);
     }
 };
+
+using InlineCache = BasicInlineCache<>;
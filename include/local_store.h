@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include "persistence_adapter.h"
+
+// LocalStore: embedded, in-process persistence for single-node deployments; a log-structured store for
+// integer and string keys kept in one directory, with no external service.
+//
+// Usage: LocalStore store{"data"}; then use it through the PersistenceProvider interface.
+//
+// Implementation details (local_store.cpp):
+//  - Writes go to a write-ahead log (write_ahead_log.h, group fsync) and to an in-memory sorted memtable; a
+//    write returns once its log record is on disk. Integer and string keys share one ordered key space
+//    (integers first, encoded so byte order is numeric order).
+//  - A memtable past LOCAL_MEMTABLE_BYTES is frozen and a background thread writes it out as an immutable
+//    sorted segment file (mmapped, with a sparse key index and a CRC-32C over its contents), after which its
+//    log is deleted. Writers only wait if the previous memtable is still being written out.
+//  - Reads look in the memtable, the frozen memtable, then segments newest first; deletes are tombstones.
+//  - Once LOCAL_COMPACT_SEGMENTS segments exist the background thread merges all of them into one, keeping
+//    the newest version of each key and dropping tombstones.
+//  - The MANIFEST file lists live segments, oldest first, and the oldest log still needed; it is replaced
+//    atomically (write, fsync, rename), so a crash at any point leaves a consistent set of files. On open the
+//    surviving logs are replayed, up to the first torn record, and written out as a segment.
+//  - A LOCK file held with flock() keeps a second store (in any process) out of the directory.
+class LocalStore : public PersistenceProvider {
+public:
+    struct Options {
+        size_t memtable_bytes{8u << 20};          // freeze and write out the memtable past this size
+        size_t compact_segments{4};               // merge all segments once this many exist
+        std::chrono::microseconds sync_window{0}; // WriteAheadLog group commit window
+        size_t sync_batch{128};                   // records that end the window early
+
+        // Defaults overridden by LOCAL_MEMTABLE_BYTES, LOCAL_COMPACT_SEGMENTS, LOCAL_SYNC_US, LOCAL_SYNC_BATCH.
+        static Options fromEnv();
+    };
+
+    // Opens (creating it if needed) and recovers the store in dir; throws std::runtime_error on failure.
+    explicit LocalStore(const std::string &dir, Options options = Options::fromEnv());
+    ~LocalStore();
+
+    LocalStore(const LocalStore&) = delete;
+    LocalStore& operator=(const LocalStore&) = delete;
+
+    // insert is an upsert (always true unless the log fails); update and remove return false if the key is
+    // absent.
+    bool insert(int64_t key, const std::string &value) override;
+    bool update(int64_t key, const std::string &value) override;
+    bool remove(int64_t key) override;
+    std::unique_ptr<std::string> get(int64_t key) override;
+    std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t> &keys) override;
+
+    // Merged scan of the memtables and segments in key order; keyBounds spans every stored integer key,
+    // possibly including recently deleted ones.
+    bool scanRange(int64_t from, int64_t to, const RowSink &sink) override;
+    std::optional<std::pair<int64_t, int64_t>> keyBounds() override;
+
+    bool insertStringKey(const std::string &key, const std::string &value) override;
+    bool updateStringKey(const std::string &key, const std::string &value) override;
+    bool removeStringKey(const std::string &key) override;
+    std::unique_ptr<std::string> getStringKey(const std::string &key) override;
+
+    nlohmann::json metrics() override;
+
+    // Write the memtable out as a segment / merge all segments now, waiting for the result (tests, tools).
+    void flush();
+    void compact();
+    size_t segmentCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> p_;
+};
@@ -3,11 +3,18 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <future>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <cstdint>
 #include "nlohmann/json.hpp"
 
 // PersistenceAdapter: lightweight wrapper around PostgreSQL C client (libpq)
-// to perform simple integer-keyed string-value operations.
+// to perform simple integer-keyed (bigint) string-value operations, plus a separate
+// short-string key space stored in a bytea-keyed table.
 //
 // Usage: create with a libpq connection string (e.g. "dbname=kvstore user=...")
 
@@ -15,10 +22,45 @@ class PersistenceProvider {
 public:
     virtual ~PersistenceProvider() = default;
 
-    virtual bool insert(int key, const std::string &value) = 0;
-    virtual bool update(int key, const std::string &value) = 0;
-    virtual bool remove(int key) = 0;
-    virtual std::unique_ptr<std::string> get(int key) = 0;
+    virtual bool insert(int64_t key, const std::string &value) = 0;
+    virtual bool update(int64_t key, const std::string &value) = 0;
+    virtual bool remove(int64_t key) = 0;
+    // nullptr only when the key does not exist; a failed read throws, so callers never take an error for
+    // absence.
+    virtual std::unique_ptr<std::string> get(int64_t key) = 0;
+
+    // Values of every key in keys that exists; absent keys are left out of the map and a failed read throws.
+    // The default issues one get() per key; providers override it with a single round-trip.
+    virtual std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t> &keys) {
+        std::unordered_map<int64_t, std::string> out;
+        for (int64_t key : keys) {
+            if (auto v = get(key)) out.emplace(key, std::move(*v));
+        }
+        return out;
+    }
+
+    // Bulk read for cache preload. scanRange streams every stored row with from <= key <= to, in no particular
+    // order, to sink until the range is exhausted or sink returns false; it returns false if the scan failed.
+    // keyBounds is the smallest and largest stored key, or nullopt when the table is empty or the provider
+    // cannot scan (the defaults), in which case preload falls back to multiGet.
+    using RowSink = std::function<bool(int64_t key, std::string &&value)>;
+    virtual bool scanRange(int64_t /*from*/, int64_t /*to*/, const RowSink &/*sink*/) { return false; }
+    virtual std::optional<std::pair<int64_t, int64_t>> keyBounds() { return std::nullopt; }
+
+    // Warm restart validation. versionNow is the provider's write clock (microseconds), or nullopt when rows
+    // carry no write time (the default: snapshots are then validated by comparing values read with multiGet).
+    // unchangedSince returns the keys that still exist and were last written at or before version.
+    virtual std::optional<int64_t> versionNow() { return std::nullopt; }
+    virtual std::vector<int64_t> unchangedSince(const std::vector<int64_t> &/*keys*/, int64_t /*version*/) { return {}; }
+
+    // Storage-engine counters for /metrics ("persistence_store"); null (the default) if the provider has none.
+    virtual nlohmann::json metrics() { return nullptr; }
+
+    // String keys (arbitrary bytes, bytea column). Providers without a string key space fail every call.
+    virtual bool insertStringKey(const std::string &/*key*/, const std::string &/*value*/) { return false; }
+    virtual bool updateStringKey(const std::string &/*key*/, const std::string &/*value*/) { return false; }
+    virtual bool removeStringKey(const std::string &/*key*/) { return false; }
+    virtual std::unique_ptr<std::string> getStringKey(const std::string &/*key*/) { return nullptr; }
 };
 
 class PersistenceAdapter : public PersistenceProvider {
@@ -27,16 +69,36 @@ public:
     ~PersistenceAdapter();
 
     // insert or update a key/value pair. Returns true on success.
-    bool insert(int key, const std::string &value) override;
+    bool insert(int64_t key, const std::string &value) override;
 
     // update an existing key's value. Returns true if a row was updated (key existed).
-    bool update(int key, const std::string &value) override;
+    bool update(int64_t key, const std::string &value) override;
 
     // remove a key. Returns true if a row was deleted.
-    bool remove(int key) override;
+    bool remove(int64_t key) override;
 
-    // retrieve a value for a key. Returns nullptr if not found or on error.
-    std::unique_ptr<std::string> get(int key) override;
+    // retrieve a value for a key. Returns nullptr if not found; throws std::runtime_error on error.
+    std::unique_ptr<std::string> get(int64_t key) override;
+
+    // retrieve many keys with one `key = ANY($1)` query. Missing keys are left out; throws on error.
+    std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t> &keys) override;
+
+    // Stream a key range with `COPY (SELECT key, value ...) TO STDOUT (FORMAT binary)` on one pooled
+    // connection; a sink that stops early cancels the COPY. keyBounds is one min/max query on the primary key.
+    bool scanRange(int64_t from, int64_t to, const RowSink &sink) override;
+    std::optional<std::pair<int64_t, int64_t>> keyBounds() override;
+
+    // Versions are kv_store.created_at, which every write sets: versionNow is the database's
+    // clock_timestamp() and unchangedSince one `key = ANY($1) AND created_at <= $2` query per 10000 keys.
+    std::optional<int64_t> versionNow() override;
+    std::vector<int64_t> unchangedSince(const std::vector<int64_t> &keys, int64_t version) override;
+
+    // Same operations on the kv_store_bytes table (bytea keys). They fail if that table did not exist when
+    // the adapter connected (the adapter still starts, with the string key space disabled).
+    bool insertStringKey(const std::string &key, const std::string &value) override;
+    bool updateStringKey(const std::string &key, const std::string &value) override;
+    bool removeStringKey(const std::string &key) override;
+    std::unique_ptr<std::string> getStringKey(const std::string &key) override;
 
     // Batch transactional execution with two modes
     enum class TxMode { RollbackOnError, Silent };
@@ -44,13 +106,14 @@ public:
 
     struct Operation {
         OpType type;
-        int key;
+        int64_t key;
         std::string value; // can be ignored for remove operation
     };
 
     struct FailedOp {
         Operation op;
         std::string error; // for storing error message
+        bool no_rows{false}; // the statement ran but matched no row (update/remove of a missing key)
     };
 
     struct TxResult {
@@ -76,14 +139,37 @@ public:
     */
     nlohmann::json runTransactionJson(const std::vector<Operation>& ops, TxMode mode);
 
-    // Async variants: submit work to an internal worker pool and return a future.
-    // These are concrete APIs on the adapter (not part of the abstract PersistenceProvider).
-    std::future<std::unique_ptr<std::string>> getAsync(int key);
+    // Async variants: return a future without tying up a thread per query. They run on an event-driven engine
+    // (DB_ASYNC_CONNS non-blocking connections, default 4, driven by DB_IO_THREADS epoll loops, default 1)
+    // that keeps many queries in flight per connection; with pipelining off, without async connections or
+    // off Linux they run on the internal worker pool instead.
+    // These are concrete APIs on the adapter (not part of the abstract PersistenceProvider). A failed
+    // getAsync read is stored in the future as an exception, like get() throwing.
+    std::future<std::unique_ptr<std::string>> getAsync(int64_t key);
     std::future<nlohmann::json> runTransactionJsonAsync(const std::vector<Operation>& ops, TxMode mode);
 
+    // libpq pipeline mode (default on, DB_PIPELINE=0 turns it off): a transaction's BEGIN and operations
+    // go out in one network flight (chunks of 256 statements), and getAsync calls queued concurrently are
+    // sent together on one connection. Off, every statement is its own round-trip.
+    void setPipelining(bool enable);
+    bool pipelining() const;
+
+    // Group commit for insert/update/remove: concurrent calls are collected for up to window after the first
+    // one, or until max_ops are waiting, and committed in one transaction; each call still returns its own
+    // outcome. max_ops <= 1 sends every write on its own. Defaults from DB_WRITE_BATCH_MAX (128) and
+    // DB_WRITE_BATCH_US (200).
+    void setWriteBatching(size_t max_ops, std::chrono::microseconds window);
+
+    // Parameters and results travel in binary format (int8 keys, raw value bytes). True when kv_store.value
+    // is bytea, so values may hold any byte including NUL; false on a text column not yet migrated by
+    // sql/init_kv.sql, where values must be valid UTF-8 without NULs.
+    bool binaryValues() const;
+
     // runtime metrics/accessors
     int droppedPoolConnections() const;
-    // Return a JSON object with pool metrics: pool_size, free_conns, dropped_conns, total_conn_creates, total_conn_failures
+    // Return a JSON object with pool metrics: pool_size, free_conns, dropped_conns, total_conn_creates, total_conn_failures,
+    // async_engine {connections, io_threads, in_flight, completed} when the async engine runs, and
+    // write_batch {max_ops, window_us, batches, writes, fallbacks}
     nlohmann::json poolMetrics() const;
 
 private:
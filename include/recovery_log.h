@@ -0,0 +1,227 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <algorithm>
+#include <system_error>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include "write_ahead_log.h"
+#include "write_behind_queue.h"
+
+/* RecoveryLog: the server's write-ahead log of acknowledged integer key writes (write-behind mode), kept in a
+   directory of numbered files so the prefix already persisted can be deleted.
+   Implementation details:
+    - Files are "wal-<n>.log" WriteAheadLogs (length-prefixed, CRC-32C checked records, group fdatasync).
+      open() never appends to an existing file: it starts file max+1, so a torn tail left by a crash stays
+      behind the point where replay() stops reading that file.
+    - One record holds a batch of writes, {uint32 count, then per write: uint8 op, int64 key, uint32 length,
+      value} in host byte order, so a multi-key write is replayed entirely or not at all.
+    - append() runs its after_sync callback (queueing the writes) under a shared lock that rotate() takes
+      exclusively, so everything logged in a file has been queued before rotate()'s at_switch callback runs:
+      once the queue has persisted what it held at that point, the files before the new one can be retired.
+    - replay() folds every file below the current one into the latest write per key; a file is read up to its
+      first torn, corrupt or undecodable record.
+*/
+
+class RecoveryLog {
+public:
+    using Write = WriteBehindQueue::Write;
+    using Options = WriteAheadLog::Options;
+
+    struct Stats {
+        uint64_t generation{0}; // number of the file being appended to
+        uint64_t records{0};    // records appended since open()
+        uint64_t syncs{0};      // fdatasync calls since open()
+        uint64_t bytes{0};      // size of the current file
+    };
+
+    struct Replay {
+        std::vector<Write> writes; // latest write of each key
+        uint64_t records{0};       // intact records read
+        uint64_t files{0};
+    };
+
+    RecoveryLog() = default;
+    RecoveryLog(const RecoveryLog&) = delete;
+    RecoveryLog& operator=(const RecoveryLog&) = delete;
+
+    // Create dir if needed and start a new file after the existing ones.
+    bool open(const std::string& dir, Options options, std::string& error) {
+        dir_ = dir;
+        options_ = options;
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        if (ec) {
+            error = "cannot create " + dir_ + ": " + ec.message();
+            return false;
+        }
+        uint64_t last = 0;
+        for (uint64_t id : files()) last = std::max(last, id);
+        return openFile(last + 1, error) != nullptr;
+    }
+
+    const std::string& dir() const { return dir_; }
+
+    // Read the files left by earlier runs (everything below the current file).
+    Replay replay() const {
+        Replay out;
+        std::unordered_map<int64_t, size_t> index;
+        const uint64_t current = stats().generation;
+        for (uint64_t id : files()) {
+            if (id >= current) continue;
+            ++out.files;
+            bool intact = true;
+            WriteAheadLog::replay(path(id), [&](std::string_view payload) {
+                if (!intact) return;
+                std::vector<Write> batch;
+                if (!decode(payload, batch)) {
+                    intact = false;
+                    return;
+                }
+                ++out.records;
+                for (Write& w : batch) {
+                    auto [it, inserted] = index.emplace(w.key, out.writes.size());
+                    if (inserted) {
+                        out.writes.push_back(std::move(w));
+                    } else {
+                        out.writes[it->second] = std::move(w);
+                    }
+                }
+            });
+        }
+        return out;
+    }
+
+    // Log writes as one record and wait until it is durable, then run after_sync (before any rotate() can
+    // switch files). False if the log failed; after_sync does not run then.
+    bool append(const std::vector<Write>& writes, const std::function<void()>& after_sync = {}) {
+        const std::string payload = encode(writes);
+        std::shared_lock<std::shared_mutex> lk(mtx_);
+        uint64_t seq = log_->append(payload);
+        if (seq == 0 || !log_->sync(seq)) return false;
+        if (after_sync) after_sync();
+        return true;
+    }
+
+    // Continue in a new file, running at_switch while no append() is in progress. Returns the new file's
+    // number (retire() below it once what at_switch saw is persisted), or 0 if it cannot be created. One
+    // rotate() at a time.
+    uint64_t rotate(const std::function<void()>& at_switch, std::string& error) {
+        uint64_t next = stats().generation + 1;
+        auto fresh = std::make_shared<WriteAheadLog>();
+        if (!fresh->open(path(next), options_, error)) return 0;
+        std::unique_lock<std::shared_mutex> lk(mtx_);
+        auto st = log_->stats();
+        records_before_ += st.appended;
+        syncs_before_ += st.syncs;
+        log_ = std::move(fresh);
+        generation_ = next;
+        if (at_switch) at_switch();
+        return next;
+    }
+
+    // Delete the files numbered below id.
+    void retire(uint64_t id) {
+        for (uint64_t f : files()) {
+            if (f < id) std::remove(path(f).c_str());
+        }
+    }
+
+    Stats stats() const {
+        std::shared_lock<std::shared_mutex> lk(mtx_);
+        if (!log_) return Stats{};
+        auto st = log_->stats();
+        return Stats{generation_, records_before_ + st.appended, syncs_before_ + st.syncs, st.bytes};
+    }
+
+    static std::string encode(const std::vector<Write>& writes) {
+        std::string out;
+        put(out, static_cast<uint32_t>(writes.size()));
+        for (const Write& w : writes) {
+            out.push_back(static_cast<char>(w.op == WriteBehindQueue::Op::Upsert ? kUpsert : kRemove));
+            put(out, w.key);
+            put(out, static_cast<uint32_t>(w.value.size()));
+            out.append(w.value);
+        }
+        return out;
+    }
+
+    static bool decode(std::string_view in, std::vector<Write>& out) {
+        uint32_t count = 0;
+        if (!get(in, count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint8_t op = 0;
+            int64_t key = 0;
+            uint32_t length = 0;
+            if (!get(in, op) || (op != kUpsert && op != kRemove) || !get(in, key) || !get(in, length) || in.size() < length) {
+                return false;
+            }
+            out.push_back(Write{key, op == kUpsert ? WriteBehindQueue::Op::Upsert : WriteBehindQueue::Op::Remove,
+                                std::string(in.substr(0, length))});
+            in.remove_prefix(length);
+        }
+        return in.empty();
+    }
+
+private:
+    static constexpr uint8_t kUpsert = 1;
+    static constexpr uint8_t kRemove = 2;
+
+    template <typename T>
+    static void put(std::string& out, T v) {
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    template <typename T>
+    static bool get(std::string_view& in, T& v) {
+        if (in.size() < sizeof(v)) return false;
+        std::memcpy(&v, in.data(), sizeof(v));
+        in.remove_prefix(sizeof(v));
+        return true;
+    }
+
+    std::string path(uint64_t id) const {
+        return (std::filesystem::path(dir_) / ("wal-" + std::to_string(id) + ".log")).string();
+    }
+
+    // Numbers of the log files in the directory, ascending.
+    std::vector<uint64_t> files() const {
+        std::vector<uint64_t> ids;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= 8 || name.compare(0, 4, "wal-") != 0 || name.compare(name.size() - 4, 4, ".log") != 0) continue;
+            const std::string digits = name.substr(4, name.size() - 8);
+            if (digits.size() > 19 || digits.find_first_not_of("0123456789") != std::string::npos) continue;
+            ids.push_back(std::stoull(digits));
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    WriteAheadLog* openFile(uint64_t id, std::string& error) {
+        auto fresh = std::make_shared<WriteAheadLog>();
+        if (!fresh->open(path(id), options_, error)) return nullptr;
+        std::unique_lock<std::shared_mutex> lk(mtx_);
+        log_ = std::move(fresh);
+        generation_ = id;
+        return log_.get();
+    }
+
+    std::string dir_;
+    Options options_{};
+    mutable std::shared_mutex mtx_; // appends shared, file switch exclusive
+    std::shared_ptr<WriteAheadLog> log_;
+    uint64_t generation_{0};
+    uint64_t records_before_{0}; // counters of files rotated away
+    uint64_t syncs_before_{0};
+};
@@ -2,16 +2,30 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <array>
+#include <condition_variable>
+#include <atomic>
 #include "inline_cache.h"
+#include "core_affinity_cache.h"
+#include "single_flight.h"
+#include "write_behind_queue.h"
+#include "recovery_log.h"
+#include "cache_snapshot.h"
+#include "hot_key_profile.h"
 #include "config.h"
 #include "persistence_adapter.h"
 
 // KeyValueServer: wraps httplib::Server providing route setup and lifecycle control.
 // Responsibility:
-//  - Register HTTP routes (home, get_key, bulk_query, insert, bulk_update, delete_key, update_key, stop)
+//  - Register HTTP routes (home, get_key, bulk_query, insert, bulk_update, delete_key, update_key, stop, and the
+//    *_skey routes of the string key space)
 //  - Start listening on a host:port
 //  - Provide structured logging of requests and responses
 //  - Require a PersistenceAdapter for DB operations (server startup fails without one)
@@ -23,13 +37,23 @@
 //
 class KeyValueServer {
 public:
-    KeyValueServer(const std::string& host, int port, InlineCache::Policy = InlineCache::Policy::LRU, bool json_logging = false);
+    // cache_shards: number of lock-striped InlineCache shards (each with its own recency list and byte budget).
+    // cache_storage: InlineCache index engine (chained buckets or open addressing).
+    // cache_admission: admission filter applied to values hydrated from persistence on a cache miss.
+    // cache_cores: if non-zero, the integer key cache runs as that many shared-nothing caches, each owned by a
+    //   worker thread pinned to its own CPU, and handlers hand every cache operation to the key's core
+    //   (cache_shards is then ignored for that cache).
+    KeyValueServer(const std::string& host, int port, InlineCache::Policy = InlineCache::Policy::LRU, bool json_logging = false,
+                   size_t cache_shards = default_cache_shards,
+                   InlineCache::Storage cache_storage = InlineCache::Storage::Chained,
+                   InlineCache::Admission cache_admission = InlineCache::Admission::None,
+                   size_t cache_cores = 0);
     ~KeyValueServer();
 
     // Register all routes on the underlying server instance.
     void setupRoutes();
 
-    // Start blocking listen call. Returns when server stops or fails.
+    // Start blocking listen call. Returns when server stops or fails. The cache TTL sweeper runs while listening.
     bool start();
 
     // Signal server to stop (non-blocking). Safe to call from handler.
@@ -41,22 +65,89 @@ public:
     // Allow skipping preload of cache on startup
     void setSkipPreload(bool skip) { skip_preload = skip; }
 
+    // Parallel streams of the startup preload, each scanning one key-range partition on its own
+    // persistence connection (0 means 1).
+    void setPreloadThreads(size_t threads) { preload_threads = threads ? threads : 1; }
+
+    // Warm restart snapshot of the integer key cache (cache_snapshot.h). With a path, start() reloads the file
+    // before serving, keeping only entries persistence confirms are unchanged, and skips preload if any were
+    // restored; the cache is written back when listening ends and, with a nonzero interval, periodically
+    // while serving. An empty path disables snapshots.
+    void setSnapshot(const std::string& path, std::chrono::seconds interval = std::chrono::seconds(0)) {
+        snapshot_path = path;
+        snapshot_interval = interval;
+    }
+
+    // Access-frequency profile of integer key reads (hot_key_profile.h), one read in sample_every sampled. With
+    // a path, start() loads the saved profile and, instead of the range preload, fetches its hottest keys into
+    // the cache in the background while already serving; the profile is saved, then decayed, every
+    // save_interval and saved again when listening ends. An empty path disables profiling.
+    void setHotKeyProfile(const std::string& path, std::chrono::seconds save_interval = default_hot_key_save_interval,
+                          uint32_t sample_every = HotKeyProfile::default_sample_every) {
+        hot_key_path = path;
+        hot_key_save_interval = save_interval;
+        hot_keys = path.empty() ? nullptr : std::make_unique<HotKeyProfile>(HotKeyProfile::default_capacity, sample_every);
+    }
+
     // Enable or disable all stdout/stderr logging (both JSON and plain text). Default: enabled.
     void setLoggingEnabled(bool enable) { logging_enabled = enable; }
 
     // Enable or disable the `/metrics` endpoint computation. If disabled, the endpoint will be short-circuited.
     void setMetricsEnabled(bool enable) { metrics_enabled = enable; }
 
+    // How long a key found absent from persistence is answered as not found without a DB round-trip
+    // (0 disables the negative cache). Inserts of the key invalidate it immediately.
+    void setNegativeCacheTtl(std::chrono::milliseconds ttl) { negative_cache_ttl = ttl; }
+
+    // Through: single-key writes (insert, update, delete) return once persistence has them. Behind: they return
+    // once the cache and the write-behind queue have them, and a background flusher persists them in batches,
+    // coalescing repeated writes to a key; reads consult the queue before persistence, /bulk_update waits for
+    // its keys to be flushed, and stopping the server drains the queue. String keys are always write-through.
+    enum class WriteMode { Through, Behind };
+    void setWriteMode(WriteMode mode) { write_mode = mode; }
+
+    // Write-ahead log for write-behind mode (recovery_log.h): with a directory, /insert, /update_key and
+    // /delete_key return only once their write is in the log (concurrent writes share an fdatasync: the syncing
+    // writer waits up to sync_window for up to sync_batch records), and /bulk_update logs what it committed.
+    // start() first persists and caches what earlier runs logged. Once the current file passes
+    // checkpoint_bytes the log moves to a new file and the old ones are deleted when the queue has persisted
+    // their writes. Ignored in write-through mode; an empty directory disables the log.
+    void setWal(const std::string& dir, std::chrono::microseconds sync_window = std::chrono::microseconds(0),
+                size_t sync_batch = default_wal_sync_batch, size_t checkpoint_bytes = default_wal_checkpoint_bytes) {
+        wal_dir = dir;
+        wal_options.sync_window = sync_window;
+        wal_options.max_batch = sync_batch ? sync_batch : 1;
+        wal_checkpoint_bytes = checkpoint_bytes;
+    }
+
     // Allow tests/consumers to inject custom persistence implementation.
     void setPersistenceProvider(std::unique_ptr<PersistenceProvider> provider, const std::string& status_label = "injected");
 
     PersistenceProvider* persistence() const { return persistence_adapter.get(); }
 
+    static constexpr size_t default_cache_shards = 16;
+    static constexpr size_t default_preload_threads = 4;
+    static constexpr size_t cache_max_bytes = 1ULL * 1024 * 1024 * 1024; // integer key cache budget
+    static constexpr std::chrono::milliseconds default_negative_cache_ttl{5000};
+    static constexpr std::chrono::seconds default_hot_key_save_interval{60};
+    static constexpr size_t default_wal_sync_batch = 128;
+    static constexpr size_t default_wal_checkpoint_bytes = 64ULL * 1024 * 1024;
+
+    // Integer keys are 64-bit (bigint in persistence). String keys of up to 31 bytes live in a separate key
+    // space (bytea in persistence) served by its own cache.
+    using KeyCache = CoreAffinityCache<int64_t>;
+    using StringKey = ShortKey<31>;
+    using StringKeyCache = BasicInlineCache<StringKey>;
+    // Integer keys known to be absent from persistence; the value is unused.
+    using NegativeCache = BasicInlineCache<int64_t, uint8_t>;
+
 private:
     std::string host_;
     int port_{};
     httplib::Server server_;
-    InlineCache inline_cache;
+    KeyCache inline_cache;
+    StringKeyCache string_cache;
+    NegativeCache negative_cache;
 
     struct RouteDescriptor {
         const char* method;
@@ -78,6 +169,10 @@ private:
     void bulkUpdateHandler(const httplib::Request& req, httplib::Response& res);
     void deletionHandler(const httplib::Request& req, httplib::Response& res);
     void updationHandler(const httplib::Request& req, httplib::Response& res);
+    void getStringKeyHandler(const httplib::Request& req, httplib::Response& res);
+    void insertStringKeyHandler(const httplib::Request& req, httplib::Response& res);
+    void updateStringKeyHandler(const httplib::Request& req, httplib::Response& res);
+    void deleteStringKeyHandler(const httplib::Request& req, httplib::Response& res);
     void healthHandler(const httplib::Request& req, httplib::Response& res);
     void metricsHandler(const httplib::Request& req, httplib::Response& res);
     void stopHandler(const httplib::Request& req, httplib::Response& res);
@@ -88,7 +183,122 @@ private:
 
     // Helpers
     static void json_response(httplib::Response& res, int status, const nlohmann::json& j, const char* reason = nullptr);
-    static bool parse_int(const std::string& s, int& out);
+    // json_response plus a "value" string member streamed from a cache handle without copying it.
+    static void json_response_with_value(httplib::Response& res, int status, const nlohmann::json& j, ValueHandle value,
+                                         const char* reason = nullptr);
+    static bool parse_key(const std::string& s, int64_t& out);
+    // Validate the `key` path parameter of a *_skey route; on failure the 400 response is already sent.
+    bool parse_string_key(const httplib::Request& req, httplib::Response& res, nlohmann::json& out, StringKey& key,
+                          std::chrono::steady_clock::time_point start);
+
+    // Negative cache of integer keys missing from persistence. A miss path snapshots absentEpoch() before
+    // querying persistence and passes it to rememberAbsent(); every write that can create a key calls
+    // forgetAbsent() after persisting it, which bumps the epoch so an in-flight miss never records a stale
+    // absence.
+    bool knownAbsent(int64_t key);
+    uint64_t absentEpoch() const { return absent_epoch.load(); }
+    void rememberAbsent(int64_t key, uint64_t epoch);
+    void forgetAbsent(int64_t key);
+    static constexpr size_t negative_cache_bytes = 4 * 1024 * 1024; // 64 bytes per key: 65536 keys
+
+    // Read-through of a cache miss: one persistence read per key at a time. Concurrent misses for the same key
+    // wait for the read already in flight (coalesced = true) and share its result; the caller that ran it
+    // populates the cache (admission permitting) or records the absence. Persistence errors propagate to every
+    // waiter.
+    struct Hydration {
+        std::optional<std::string> value;
+        bool cache_populated{false};
+    };
+    Hydration hydrateFromPersistence(int64_t key, bool& coalesced);
+    // Read-through of many misses with one PersistenceProvider::multiGet (duplicates are read once). Not
+    // coalesced with single-key reads in flight. A failed read throws and records no absence.
+    std::unordered_map<int64_t, Hydration> hydrateBatchFromPersistence(std::vector<int64_t> keys);
+
+    // Write-behind mode: latest unpersisted write of a key (nullopt in write-through mode or if none), and the
+    // queue's flush callback (one Silent transaction per batch on a PersistenceAdapter).
+    std::optional<WriteBehindQueue::Write> pendingWrite(int64_t key) const;
+    void flushWriteBehind(const std::vector<WriteBehindQueue::Write>& batch, std::vector<char>& ok);
+    // Write-behind: log the write (with a write-ahead log) and queue it. False if the log could not make it
+    // durable; nothing is queued then. Callers hold holdKey(key) across their cache change and this call.
+    bool queueWrite(int64_t key, WriteBehindQueue::Op op, const std::string& value = std::string());
+    // Write-behind: striped key locks that order single-key writes (shared) against /bulk_update (exclusive on
+    // its keys, from waiting for the queue until its committed ops are logged and cached). A single-key write
+    // is therefore logged either before the bulk update reads the queue or after its record, so replaying the
+    // log's latest write per key never puts the bulk value back over a newer acknowledged write. Both are
+    // no-ops in write-through mode.
+    std::shared_lock<std::shared_mutex> holdKey(int64_t key);
+    std::vector<std::unique_lock<std::shared_mutex>> holdKeys(const std::vector<int64_t>& keys);
+    static constexpr size_t write_stripe_count = 64;
+    static constexpr size_t write_behind_max_depth = 65536; // pending keys before writers block
+    static constexpr size_t write_behind_batch = 256;
+    static constexpr std::chrono::milliseconds write_behind_drain_timeout{30000};
+
+    // Startup preload: streams persisted rows into inline_cache with PersistenceProvider::scanRange, split
+    // into preload_threads key ranges scanned in parallel, until the cache is close to its byte budget.
+    // Providers that cannot scan get one multiGet of keys 1..1000.
+    struct PreloadSummary {
+        size_t rows{0};       // rows read from persistence
+        size_t loaded{0};     // rows inserted into the cache
+        size_t partitions{0}; // parallel scans; 0 for the multiGet fallback
+        bool budget_full{false};
+        double ms{0};
+    };
+    PreloadSummary preloadCache();
+
+    // Warm restart. restoreSnapshot() validates the snapshot's entries against persistence in chunks, in file
+    // order, and restores the confirmed ones. writeSnapshot() dumps the cache, leaving out keys with an
+    // unflushed write-behind write; the version it records is taken snapshot_version_slack before the dump
+    // starts, so a write still committing while the cache is read makes its key fail validation rather than
+    // come back stale. One dump at a time.
+    struct SnapshotRestore {
+        size_t entries{0};  // entries in the file
+        size_t restored{0}; // entries validated and put back
+        double ms{0};
+        std::string error;  // why nothing was read (missing or corrupt file)
+    };
+    SnapshotRestore restoreSnapshot();
+    bool writeSnapshot();
+    void startSnapshotter();
+    void stopSnapshotter();
+    static constexpr std::chrono::seconds snapshot_version_slack{5};
+    static constexpr size_t snapshot_validate_chunk = 10000;
+
+    // Hot-key preload: a background thread reads the profile's keys, hottest first, with one multiGet per
+    // hot_key_preload_chunk and inserts those not cached yet, until they are all read, the cache is close to its
+    // byte budget or listening ends. Keys with a write-behind write pending are left to the queue. A value
+    // fetched just before a concurrent delete can land in the cache after it, as with a read-through miss.
+    // The saver thread writes the profile every hot_key_save_interval and halves its counts afterwards.
+    void startHotKeyPreload(std::vector<int64_t> keys);
+    void stopHotKeyPreload();
+    void startHotKeySaver();
+    void stopHotKeySaver();
+    bool saveHotKeys();
+    static constexpr size_t hot_key_preload_chunk = 1000;
+
+    // Write-ahead log. replayWal() opens the log, persists the latest logged write of every key in
+    // write_behind_batch chunks, applies them to the cache and deletes the replayed files; on error the files
+    // are kept and startup is aborted. The checkpointer looks at the log every wal_checkpoint_poll and
+    // checkpoints it once the current file passes wal_checkpoint_bytes (or right away while wal_degraded is
+    // set): switch files, wait until the queue has persisted everything queued before the switch, delete the
+    // older files. checkpointWal() gives up at deadline; one checkpoint runs at a time.
+    struct WalReplay {
+        uint64_t files{0};
+        uint64_t records{0};
+        size_t writes{0}; // distinct keys persisted and cached
+        double ms{0};
+        std::string error;
+    };
+    WalReplay replayWal();
+    bool checkpointWal(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+    void startWalCheckpointer();
+    void stopWalCheckpointer();
+    static constexpr std::chrono::milliseconds wal_checkpoint_poll{1000};
+
+    // Background thread that removes TTL-expired cache entries incrementally (InlineCache::expire).
+    void startTtlSweeper();
+    void stopTtlSweeper();
+    static constexpr std::chrono::milliseconds ttl_sweep_interval{50};
+    static constexpr size_t ttl_sweep_budget = 1024; // entries per expire() call, so writers never wait long
 
     // logging mode flag
     bool json_logging_enabled{false};
@@ -103,7 +313,58 @@ private:
 
     // if true, do not perform preload of keys from persistence_adapter during start()
     bool skip_preload{false};
+    size_t preload_threads{default_preload_threads};
 
     // cached DB connection status message
     std::string db_connection_status;
+
+    std::chrono::milliseconds negative_cache_ttl{default_negative_cache_ttl};
+    std::atomic<uint64_t> absent_epoch{0};
+    SingleFlight<int64_t, Hydration> miss_flight;
+
+    WriteMode write_mode{WriteMode::Through};
+    // created by start() in write-behind mode, drained and destroyed when listening ends
+    std::unique_ptr<WriteBehindQueue> write_behind;
+    std::array<std::shared_mutex, write_stripe_count> write_stripes; // see holdKey()
+
+    std::string wal_dir;
+    RecoveryLog::Options wal_options{std::chrono::microseconds(0), default_wal_sync_batch};
+    size_t wal_checkpoint_bytes{default_wal_checkpoint_bytes};
+    std::unique_ptr<RecoveryLog> recovery_log; // opened by start() in write-behind mode with a wal_dir
+    std::thread wal_checkpointer;
+    std::mutex wal_checkpointer_mtx;
+    std::condition_variable wal_checkpointer_cv;
+    bool wal_checkpointer_stop{false};
+    std::atomic<uint64_t> wal_checkpoints{0};
+    std::mutex wal_checkpoint_mtx; // serializes checkpointWal()
+    // A committed /bulk_update could not be logged and no checkpoint has deleted the older log records of its
+    // keys yet: single-key writes are refused until one does, so none is acknowledged that a replay could undo.
+    std::atomic<bool> wal_degraded{false};
+    WalReplay wal_replay;
+
+    std::thread ttl_sweeper;
+    std::mutex sweeper_mtx;
+    std::condition_variable sweeper_cv;
+    bool sweeper_stop{false};
+
+    std::string snapshot_path;
+    std::chrono::seconds snapshot_interval{0};
+    std::thread snapshotter;
+    std::mutex snapshotter_mtx;
+    std::condition_variable snapshotter_cv;
+    bool snapshotter_stop{false};
+    std::mutex snapshot_write_mtx;
+
+    std::string hot_key_path;
+    std::chrono::seconds hot_key_save_interval{default_hot_key_save_interval};
+    std::unique_ptr<HotKeyProfile> hot_keys; // null unless profiling
+    std::thread hot_key_saver;
+    std::mutex hot_key_saver_mtx;
+    std::condition_variable hot_key_saver_cv;
+    bool hot_key_saver_stop{false};
+    std::thread hot_preloader;
+    std::atomic<bool> hot_preload_stop{false};
+    std::atomic<bool> hot_preload_done{false};
+    std::atomic<size_t> hot_preload_keys{0};   // keys the preload set out to read
+    std::atomic<size_t> hot_preload_loaded{0}; // keys it inserted into the cache
 };
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+/* SingleFlight<Key, Result>: coalesces concurrent calls for the same key into one execution.
+   Implementation details:
+    - The first caller for a key (the leader) registers a shared_future in the key's stripe and runs
+      the loader outside any lock; callers arriving while it runs (followers) wait on that future and
+      receive the same result, or the same exception.
+    - The key is removed from the table before the result is published, so a call that starts after
+      the leader finished always runs the loader again: results are never cached here.
+    - Keys are spread over kStripes mutex-guarded maps so unrelated keys rarely share a lock.
+    - Counters (relaxed atomics): executions = loader runs, coalesced = calls served by another
+      caller's execution.
+*/
+
+template <typename Key, typename Result, typename Hash = std::hash<Key>>
+class SingleFlight {
+public:
+    struct Stats {
+        uint64_t executions{0};
+        uint64_t coalesced{0};
+    };
+
+    SingleFlight() = default;
+
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    // Run loader() for key unless a call for the same key is already in flight, in which case wait for
+    // and return its result. coalesced (if non-null) reports which of the two happened.
+    template <typename Fn>
+    Result run(const Key& key, Fn&& loader, bool* coalesced = nullptr) {
+        Stripe& stripe = stripes_[Hash{}(key) % kStripes];
+        std::promise<Result> promise;
+        std::shared_future<Result> pending;
+        {
+            std::lock_guard<std::mutex> lk(stripe.mtx);
+            auto it = stripe.calls.find(key);
+            if (it != stripe.calls.end()) {
+                pending = it->second;
+            } else {
+                stripe.calls.emplace(key, promise.get_future().share());
+            }
+        }
+        if (pending.valid()) {
+            // wait outside the stripe lock: the leader takes it to unregister
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            if (coalesced) *coalesced = true;
+            return pending.get();
+        }
+        executions_.fetch_add(1, std::memory_order_relaxed);
+        if (coalesced) *coalesced = false;
+        try {
+            Result result = loader();
+            forget(stripe, key);
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            forget(stripe, key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    Stats stats() const {
+        return Stats{executions_.load(std::memory_order_relaxed), coalesced_.load(std::memory_order_relaxed)};
+    }
+
+    // Keys with a loader currently running.
+    size_t in_flight() const {
+        size_t n = 0;
+        for (const auto& s : stripes_) {
+            std::lock_guard<std::mutex> lk(s.mtx);
+            n += s.calls.size();
+        }
+        return n;
+    }
+
+private:
+    static constexpr size_t kStripes = 16;
+
+    struct Stripe {
+        mutable std::mutex mtx;
+        std::unordered_map<Key, std::shared_future<Result>, Hash> calls;
+    };
+
+    static void forget(Stripe& stripe, const Key& key) {
+        std::lock_guard<std::mutex> lk(stripe.mtx);
+        stripe.calls.erase(key);
+    }
+
+    Stripe stripes_[kStripes];
+    std::atomic<uint64_t> executions_{0};
+    std::atomic<uint64_t> coalesced_{0};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+/* SlabArena: size-class allocator for cached values.
+   Implementation details:
+    - Requests are rounded up to a size class: 16-byte steps up to 128 bytes, then ~25% geometric
+      steps (multiples of 16) up to kMaxClassBytes, so internal waste stays below a quarter of a block.
+    - Each class carves its blocks out of slabs of at least kSlabBytes. Freed blocks go onto the class's
+      free list (the link is stored in the block itself, kLinkOffset bytes in), so once a workload reaches
+      steady state every allocation is a free-list pop and no memory is returned to or requested from the
+      system allocator.
+    - The first kLinkOffset bytes of a freed block are left as the owner last wrote them. Lock-free readers
+      may still CAS a header field there (ValueBlock::refs) after the block is freed, so the arena never
+      writes to it.
+    - Slabs are only released when the arena is destroyed. A block address therefore stays valid memory
+      for the arena's lifetime even after the block is freed.
+    - Requests larger than kMaxClassBytes are served by operator new individually and accounted at their
+      rounded size.
+    - Not thread safe: the owning cache shard serializes access under its lock.
+*/
+
+class SlabArena {
+public:
+    static constexpr size_t kMaxClassBytes = 32 * 1024;
+    static constexpr size_t kSlabBytes = 64 * 1024;
+    static constexpr uint8_t kLargeClass = 0xFF;
+    static constexpr size_t kLinkOffset = 8; // free-list link position within a freed block
+    static_assert(kLinkOffset + sizeof(char*) <= 16, "the smallest class must hold the free-list link");
+
+    SlabArena() : freeLists_(classSizes().size(), nullptr), bumps_(classSizes().size()) {}
+
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    // Size class able to hold n bytes (kLargeClass above kMaxClassBytes).
+    static uint8_t class_for(size_t n) {
+        const auto& sizes = classSizes();
+        if (n > sizes.back()) return kLargeClass;
+        return static_cast<uint8_t>(std::lower_bound(sizes.begin(), sizes.end(), n) - sizes.begin());
+    }
+
+    // Bytes actually held by a block of n bytes (its class size, or the rounded size of a large block).
+    static size_t block_bytes(size_t n) {
+        uint8_t cls = class_for(n);
+        return cls == kLargeClass ? roundUp(n) : classSizes()[cls];
+    }
+
+    // Allocate a block for n bytes (n > 0); cls receives the class to pass back to deallocate().
+    char* allocate(size_t n, uint8_t& cls) {
+        cls = class_for(n);
+        if (cls == kLargeClass) {
+            largeBytes_ += roundUp(n);
+            return static_cast<char*>(::operator new(n));
+        }
+        if (char* block = freeLists_[cls]) {
+            std::memcpy(&freeLists_[cls], block + kLinkOffset, sizeof(char*));
+            return block;
+        }
+        size_t size = classSizes()[cls];
+        Bump& bump = bumps_[cls];
+        if (bump.next == nullptr || bump.next + size > bump.end) {
+            size_t slab = std::max(kSlabBytes, size * 8);
+            slabs_.emplace_back(new char[slab]);
+            slabBytes_ += slab;
+            bump.next = slabs_.back().get();
+            bump.end = bump.next + slab;
+        }
+        char* block = bump.next;
+        bump.next += size;
+        return block;
+    }
+
+    void deallocate(char* block, uint8_t cls, size_t n) {
+        if (cls == kLargeClass) {
+            largeBytes_ -= roundUp(n);
+            ::operator delete(block);
+            return;
+        }
+        std::memcpy(block + kLinkOffset, &freeLists_[cls], sizeof(char*));
+        freeLists_[cls] = block;
+    }
+
+    // Bytes obtained from the system allocator: all slabs plus live large blocks.
+    size_t reserved_bytes() const { return slabBytes_ + largeBytes_; }
+
+    static size_t class_count() { return classSizes().size(); }
+
+private:
+    struct Bump {
+        char* next{nullptr};
+        char* end{nullptr};
+    };
+
+    std::vector<char*> freeLists_;
+    std::vector<Bump> bumps_;
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    size_t slabBytes_{0};
+    size_t largeBytes_{0};
+
+    static size_t roundUp(size_t n) { return (n + 15) & ~size_t{15}; }
+
+    static const std::vector<uint32_t>& classSizes() {
+        static const std::vector<uint32_t> sizes = [] {
+            std::vector<uint32_t> v;
+            for (uint32_t s = 16; s <= 128; s += 16) v.push_back(s);
+            while (v.back() < kMaxClassBytes) {
+                uint32_t next = static_cast<uint32_t>(roundUp(v.back() + v.back() / 4));
+                v.push_back(std::min<uint32_t>(next, kMaxClassBytes));
+            }
+            return v;
+        }();
+        return sizes;
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/* TimingWheel: hashed timing wheel of (id, deadline) timers used for incremental TTL expiry.
+   Implementation details:
+    - kSlots buckets of kTickMs each; a timer is filed in the bucket of its deadline tick, so deadlines
+      further out than one revolution (kSlots * kTickMs) share a bucket with nearer ones and are skipped
+      until their own round comes up.
+    - advance() walks the buckets from the last processed tick up to now, handing every due timer to a
+      callback and removing it. A work budget bounds each call; an interrupted walk resumes from the
+      same bucket on the next call. A walk that fell more than one revolution behind visits each bucket
+      once, which is enough to find every due timer.
+    - Timers are never cancelled. The owner validates each due (id, deadline) pair against its own
+      state and ignores timers that were superseded.
+    - Buckets are allocated on the first schedule(). Not thread safe: the owning cache shard serializes
+      access under its lock.
+*/
+
+class TimingWheel {
+public:
+    static constexpr size_t kSlots = 256;
+    static constexpr uint64_t kTickMs = 16;
+
+    TimingWheel() = default;
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // File a timer for id firing at deadlineMs (same clock as advance()). Deadlines already behind the
+    // wheel's cursor go into the current bucket.
+    void schedule(uint32_t id, uint64_t deadlineMs) {
+        if (buckets_.empty()) buckets_.resize(kSlots);
+        uint64_t tick = deadlineMs / kTickMs;
+        if (tick < cursor_) tick = cursor_;
+        buckets_[tick % kSlots].push_back(Timer{id, deadlineMs});
+        ++count_;
+    }
+
+    // Remove up to budget timers whose deadline is <= nowMs, calling due(id, deadlineMs) for each.
+    // Returns the number of timers removed.
+    template <typename Fn>
+    size_t advance(uint64_t nowMs, size_t budget, Fn&& due) {
+        uint64_t target = nowMs / kTickMs;
+        if (count_ == 0) {
+            if (target > cursor_) cursor_ = target;
+            return 0;
+        }
+        if (target >= cursor_ + kSlots) cursor_ = target - (kSlots - 1);
+        size_t fired = 0;
+        for (;;) {
+            auto& bucket = buckets_[cursor_ % kSlots];
+            for (size_t i = 0; i < bucket.size();) {
+                if (bucket[i].deadline > nowMs) {
+                    ++i;
+                    continue;
+                }
+                if (fired == budget) return fired;
+                Timer t = bucket[i];
+                bucket[i] = bucket.back();
+                bucket.pop_back();
+                --count_;
+                ++fired;
+                due(t.id, t.deadline);
+            }
+            if (cursor_ >= target) break;
+            ++cursor_;
+        }
+        return fired;
+    }
+
+    // Pending timers, including superseded ones not yet reached.
+    size_t size() const { return count_; }
+
+    size_t memory_bytes() const {
+        size_t bytes = buckets_.capacity() * sizeof(std::vector<Timer>);
+        for (const auto& b : buckets_) bytes += b.capacity() * sizeof(Timer);
+        return bytes;
+    }
+
+private:
+    struct Timer {
+        uint32_t id;
+        uint64_t deadline;
+    };
+
+    std::vector<std::vector<Timer>> buckets_;
+    uint64_t cursor_{0}; // next tick to process
+    size_t count_{0};
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+/* ValueBlock / ValueHandle: immutable, reference-counted cache values.
+   Implementation details:
+    - A ValueBlock is a header followed by the value bytes, carved from the owning cache shard's
+      SlabArena. The cache entry holds one reference; each ValueHandle holds another. Bytes are never
+      modified while anyone but the entry holds a reference (the entry may overwrite in place only
+      when it is the sole owner).
+    - Releasing the last reference from a handle never touches the arena (which is guarded by the shard
+      lock): the block is pushed onto the shard's lock-free return stack, and the shard drains that
+      stack into its free lists the next time a writer stores a value.
+    - Values of up to kInlineBytes are copied into the handle itself, so small hits do no reference
+      counting at all.
+    - A handle must not outlive the InlineCache that produced it.
+*/
+
+struct ValueBlock {
+    // Stays 0 while the block is free. Not initialized by the constructor: a stale optimistic reader may be
+    // loading it when a recycled block is constructed, so the allocator stores the first reference atomically.
+    std::atomic<uint32_t> refs;
+    uint32_t length{0};
+    uint8_t sizeClass{0};                       // SlabArena class the block was allocated from
+    std::atomic<ValueBlock*>* returnTo{nullptr}; // owning shard's return stack
+    ValueBlock* nextReturned{nullptr};
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+
+    // Take a reference unless the block is already being reclaimed (count reached zero).
+    bool tryRetain() {
+        uint32_t r = refs.load(std::memory_order_relaxed);
+        while (r != 0) {
+            if (refs.compare_exchange_weak(r, r + 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    // Drop a reference held outside the shard lock; the last one hands the block back to its shard.
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        ValueBlock* head = returnTo->load(std::memory_order_relaxed);
+        do {
+            nextReturned = head;
+        } while (!returnTo->compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+};
+
+class ValueHandle {
+public:
+    static constexpr size_t kInlineBytes = 24;
+
+    ValueHandle() = default;
+
+    // Adopt one reference to block.
+    explicit ValueHandle(ValueBlock* block) : block_(block), size_(block->length) {}
+
+    // Copy a small value into the handle.
+    ValueHandle(const char* data, size_t size) : size_(static_cast<uint32_t>(size)) {
+        if (size > 0) std::memcpy(inline_, data, size);
+    }
+
+    ValueHandle(const ValueHandle& o) : block_(o.block_), size_(o.size_) {
+        if (block_) block_->refs.fetch_add(1, std::memory_order_relaxed);
+        else std::memcpy(inline_, o.inline_, size_);
+    }
+
+    ValueHandle(ValueHandle&& o) noexcept : block_(o.block_), size_(o.size_) {
+        if (!block_) std::memcpy(inline_, o.inline_, size_);
+        o.block_ = nullptr;
+        o.size_ = 0;
+    }
+
+    ValueHandle& operator=(ValueHandle o) noexcept {
+        swap(o);
+        return *this;
+    }
+
+    ~ValueHandle() {
+        if (block_) block_->release();
+    }
+
+    const char* data() const { return block_ ? block_->data() : inline_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data(), size_); }
+    std::string str() const { return std::string(data(), size_); }
+
+private:
+    ValueBlock* block_{nullptr};
+    uint32_t size_{0};
+    char inline_[kInlineBytes]{};
+
+    void swap(ValueHandle& o) noexcept {
+        char tmp[kInlineBytes];
+        std::memcpy(tmp, inline_, kInlineBytes);
+        std::memcpy(inline_, o.inline_, kInlineBytes);
+        std::memcpy(o.inline_, tmp, kInlineBytes);
+        std::swap(block_, o.block_);
+        std::swap(size_, o.size_);
+    }
+};
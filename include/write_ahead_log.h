@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <array>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* WriteAheadLog: append-only file of checksummed, length-prefixed records made durable by group fsync.
+   Implementation details:
+    - Record: {uint32 payload length, uint32 CRC-32C of the payload, payload}, host byte order. A record is
+      written with one write() under the log mutex, so records land in the order append() assigned their
+      sequence numbers.
+    - Group commit: sync(seq) waits until a completed fdatasync covers seq. The first waiter with nothing
+      in flight leads: it gives concurrent writers up to sync_window to append (cut short once max_batch
+      records are waiting), then syncs everything appended so far with one fdatasync while the others
+      wait. A window of zero still batches the writers that arrive during a sync.
+    - replay() reads records from the start and stops at the first torn or corrupt one (a crash mid-append
+      leaves at most a partial tail); valid_bytes is where it stopped, so the caller can truncate the tail
+      before appending again.
+    - After a failed write or fdatasync the log refuses further appends: the state of the file is unknown.
+*/
+
+inline uint32_t crc32c(const void* data, size_t n, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+class WriteAheadLog {
+public:
+    struct Options {
+        std::chrono::microseconds sync_window{0}; // how long a sync leader waits for more records
+        size_t max_batch{128};                    // records that end the wait early
+    };
+
+    struct Stats {
+        uint64_t appended{0}; // records
+        uint64_t synced{0};   // records covered by a completed fdatasync
+        uint64_t syncs{0};    // fdatasync calls
+        uint64_t bytes{0};    // file size
+    };
+
+    static constexpr size_t kRecordHead = 8;
+    static constexpr uint32_t kMaxPayload = 256u << 20;
+
+    WriteAheadLog() = default;
+    ~WriteAheadLog() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Open path for appending, creating it if needed; the file should have been replayed (and truncated to
+    // its valid bytes) first.
+    bool open(const std::string& path, Options options, std::string& error) {
+        options_ = options;
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd_, &st) == 0) bytes_ = static_cast<uint64_t>(st.st_size);
+        return true;
+    }
+
+    // Write one record; returns its sequence number (pass it to sync()), or 0 if the log is unusable.
+    uint64_t append(std::string_view payload) {
+        uint32_t head[2] = {static_cast<uint32_t>(payload.size()), crc32c(payload.data(), payload.size())};
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (fd_ < 0 || failed_ || payload.size() > kMaxPayload) return 0;
+        if (!writeAll(head, sizeof(head)) || !writeAll(payload.data(), payload.size())) {
+            failed_ = true;
+            cv_.notify_all();
+            return 0;
+        }
+        bytes_ += sizeof(head) + payload.size();
+        ++appended_;
+        if (syncing_ && appended_ - durable_ >= options_.max_batch) gather_cv_.notify_one();
+        return appended_;
+    }
+
+    // Wait until record seq is on stable storage; false if a sync failed.
+    bool sync(uint64_t seq) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        while (durable_ < seq) {
+            if (failed_) return false;
+            if (syncing_) {
+                cv_.wait(lk);
+                continue;
+            }
+            syncing_ = true;
+            if (options_.sync_window.count() > 0 && appended_ - durable_ < options_.max_batch) {
+                gather_cv_.wait_for(lk, options_.sync_window, [&] { return appended_ - durable_ >= options_.max_batch; });
+            }
+            const uint64_t target = appended_;
+            lk.unlock();
+            bool ok = ::fdatasync(fd_) == 0;
+            lk.lock();
+            syncing_ = false;
+            ++syncs_;
+            if (ok) {
+                durable_ = target;
+            } else {
+                failed_ = true;
+            }
+            cv_.notify_all();
+        }
+        return true;
+    }
+
+    // append() and sync() in one call.
+    bool write(std::string_view payload) {
+        uint64_t seq = append(payload);
+        return seq != 0 && sync(seq);
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return Stats{appended_, durable_, syncs_, bytes_};
+    }
+
+    // fn(payload) for every intact record of path, in order. Returns false only if the file exists but cannot
+    // be read; a missing file replays nothing.
+    static bool replay(const std::string& path, const std::function<void(std::string_view)>& fn,
+                       uint64_t* valid_bytes = nullptr, uint64_t* records = nullptr) {
+        if (valid_bytes) *valid_bytes = 0;
+        if (records) *records = 0;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return errno == ENOENT;
+        std::vector<char> buf;
+        char chunk[1 << 16];
+        for (;;) {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                ::close(fd);
+                return false;
+            }
+            if (n == 0) break;
+            buf.insert(buf.end(), chunk, chunk + n);
+        }
+        ::close(fd);
+        size_t pos = 0;
+        uint64_t count = 0;
+        while (buf.size() - pos >= kRecordHead) {
+            uint32_t head[2];
+            std::memcpy(head, buf.data() + pos, sizeof(head));
+            if (head[0] > kMaxPayload || buf.size() - pos - kRecordHead < head[0]) break;
+            const char* payload = buf.data() + pos + kRecordHead;
+            if (crc32c(payload, head[0]) != head[1]) break;
+            fn(std::string_view(payload, head[0]));
+            pos += kRecordHead + head[0];
+            ++count;
+        }
+        if (valid_bytes) *valid_bytes = pos;
+        if (records) *records = count;
+        return true;
+    }
+
+private:
+    bool writeAll(const void* p, size_t n) {
+        const char* c = static_cast<const char*>(p);
+        while (n > 0) {
+            ssize_t w = ::write(fd_, c, n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return false;
+            c += w;
+            n -= static_cast<size_t>(w);
+        }
+        return true;
+    }
+
+    Options options_{};
+    int fd_{-1};
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;        // waiters: a sync completed
+    std::condition_variable gather_cv_; // sync leader: max_batch records are waiting
+    bool syncing_{false};
+    bool failed_{false};
+    uint64_t appended_{0};
+    uint64_t durable_{0};
+    uint64_t syncs_{0};
+    uint64_t bytes_{0};
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <optional>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/* WriteBehindQueue: per-key queue of writes acknowledged before they are persisted, flushed in batches by a
+   background thread.
+   Implementation details:
+    - At most one pending write per key: a write to a key that is still queued replaces the queued one in
+      place (coalesced), keeping its position, so a hot key costs one persistence write per flush instead of
+      one per request.
+    - A write taken by the flusher stays visible through pending() until its flush succeeds, so readers that
+      consult the queue before persistence never see a gap. A write arriving for a key whose flush is in
+      flight is queued behind it; writes to one key are persisted in the order they were made.
+    - Failed writes go back to the queue (unless superseded meanwhile) and the flusher waits retry_interval
+      before its next attempt.
+    - put() blocks while max_depth keys are pending, so a stalled backend slows writers down instead of
+      growing memory without bound.
+    - put() returns a ticket (a running count of writes); wait_persisted(ticket) returns once that write and
+      every earlier one is persisted or superseded by a persisted write. Each entry remembers the ticket of
+      its oldest write not yet persisted, so the check does not depend on the order keys are flushed in.
+    - The destructor flushes whatever the backend accepts within drain_timeout and then stops.
+*/
+
+class WriteBehindQueue {
+public:
+    enum class Op { Upsert, Remove };
+
+    struct Write {
+        int64_t key;
+        Op op;
+        std::string value; // empty for Remove
+    };
+
+    // Persists a batch (keys are distinct); sets ok[i] for every write that is durable.
+    using Flush = std::function<void(const std::vector<Write>& batch, std::vector<char>& ok)>;
+
+    struct Stats {
+        size_t depth{0};                // keys with a pending write (queued or in flight)
+        size_t in_flight{0};            // writes handed to the current flush
+        uint64_t enqueued{0};           // put() calls
+        uint64_t coalesced{0};          // put() calls that replaced a queued write
+        uint64_t flushed{0};            // writes persisted
+        uint64_t failed{0};             // failed write attempts (retried)
+        uint64_t batches{0};            // flush calls
+        double flush_latency_ms_avg{0}; // first put() of a write to its successful flush
+        double flush_latency_ms_max{0};
+    };
+
+    static constexpr std::chrono::milliseconds default_retry_interval{100};
+    static constexpr std::chrono::milliseconds default_drain_timeout{30000};
+
+    WriteBehindQueue(Flush flush, size_t max_depth, size_t max_batch,
+                     std::chrono::milliseconds retry_interval = default_retry_interval,
+                     std::chrono::milliseconds drain_timeout = default_drain_timeout)
+        : flush_(std::move(flush)), max_depth_(max_depth ? max_depth : 1), max_batch_(max_batch ? max_batch : 1),
+          retry_interval_(retry_interval), drain_timeout_(drain_timeout) {
+        flusher_ = std::thread([this]() { run(); });
+    }
+
+    ~WriteBehindQueue() {
+        drain(drain_timeout_);
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (flusher_.joinable()) flusher_.join();
+    }
+
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    uint64_t put(int64_t key, Op op, const std::string& value = std::string()) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            space_cv_.wait(lk, [&] { return stop_ || entries_.size() < max_depth_; });
+            it = entries_.emplace(key, Entry{}).first;
+            it->second.since = std::chrono::steady_clock::now();
+            it->second.oldest = enqueued_ + 1;
+        } else if (it->second.queued) {
+            ++coalesced_;
+        } else {
+            it->second.after_flush = enqueued_ + 1; // first write since the flusher took the entry
+        }
+        const uint64_t ticket = ++enqueued_;
+        Entry& e = it->second;
+        e.op = op;
+        e.value = op == Op::Upsert ? value : std::string();
+        ++e.version;
+        if (!e.queued) {
+            e.queued = true;
+            order_.push_back(key);
+        }
+        lk.unlock();
+        cv_.notify_all();
+        return ticket;
+    }
+
+    // Latest write not yet persisted for key, if any.
+    std::optional<Write> pending(int64_t key) const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return std::nullopt;
+        return Write{key, it->second.op, it->second.value};
+    }
+
+    // Wait until every pending write is persisted; false on timeout.
+    bool drain(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        return space_cv_.wait_for(lk, timeout, [&] { return entries_.empty(); });
+    }
+
+    // Wait until the write put() returned ticket for, and every write before it, is persisted; false on
+    // timeout.
+    bool wait_persisted(uint64_t ticket, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        return space_cv_.wait_for(lk, timeout, [&] {
+            return std::none_of(entries_.begin(), entries_.end(), [&](const auto& kv) { return kv.second.oldest <= ticket; });
+        });
+    }
+
+    // Wait until none of keys has a pending write; false on timeout.
+    bool wait_flushed(const std::vector<int64_t>& keys, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        return space_cv_.wait_for(lk, timeout, [&] {
+            return std::none_of(keys.begin(), keys.end(), [&](int64_t k) { return entries_.count(k) != 0; });
+        });
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        Stats s;
+        s.depth = entries_.size();
+        s.in_flight = in_flight_;
+        s.enqueued = enqueued_;
+        s.coalesced = coalesced_;
+        s.flushed = flushed_;
+        s.failed = failed_;
+        s.batches = batches_;
+        s.flush_latency_ms_avg = flushed_ ? latency_ms_sum_ / static_cast<double>(flushed_) : 0.0;
+        s.flush_latency_ms_max = latency_ms_max_;
+        return s;
+    }
+
+private:
+    struct Entry {
+        Op op{Op::Upsert};
+        std::string value;
+        uint64_t version{0};
+        uint64_t oldest{0};      // ticket of the oldest write not yet persisted
+        uint64_t after_flush{0}; // ticket of the first write while a flush of the entry was in flight
+        bool queued{false};      // listed in order_
+        std::chrono::steady_clock::time_point since;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mtx_);
+        for (;;) {
+            cv_.wait(lk, [&] { return stop_ || !order_.empty(); });
+            if (order_.empty()) return; // stopping
+            std::vector<Write> batch;
+            std::vector<uint64_t> versions;
+            while (!order_.empty() && batch.size() < max_batch_) {
+                int64_t key = order_.front();
+                order_.pop_front();
+                Entry& e = entries_.at(key);
+                e.queued = false;
+                e.after_flush = 0;
+                batch.push_back(Write{key, e.op, e.value});
+                versions.push_back(e.version);
+            }
+            in_flight_ = batch.size();
+            lk.unlock();
+            std::vector<char> ok(batch.size(), 0);
+            try {
+                flush_(batch, ok);
+            } catch (...) {
+                std::fill(ok.begin(), ok.end(), 0);
+            }
+            lk.lock();
+            in_flight_ = 0;
+            ++batches_;
+            bool any_failed = false;
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < batch.size(); ++i) {
+                auto it = entries_.find(batch[i].key);
+                Entry& e = it->second;
+                if (!ok[i]) {
+                    ++failed_;
+                    any_failed = true;
+                    if (!e.queued) {
+                        e.queued = true;
+                        order_.push_back(batch[i].key);
+                    }
+                    continue;
+                }
+                double ms = std::chrono::duration<double, std::milli>(now - e.since).count();
+                ++flushed_;
+                latency_ms_sum_ += ms;
+                latency_ms_max_ = std::max(latency_ms_max_, ms);
+                if (e.version == versions[i]) {
+                    entries_.erase(it);
+                } else {
+                    e.since = now; // superseded during the flush: already queued again
+                    e.oldest = e.after_flush;
+                }
+            }
+            space_cv_.notify_all();
+            if (any_failed) {
+                if (stop_) return; // drain timed out: give up on what the backend still rejects
+                cv_.wait_for(lk, retry_interval_, [&] { return stop_; });
+            }
+        }
+    }
+
+    Flush flush_;
+    const size_t max_depth_;
+    const size_t max_batch_;
+    const std::chrono::milliseconds retry_interval_;
+    const std::chrono::milliseconds drain_timeout_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;       // flusher: work queued or stopping
+    std::condition_variable space_cv_; // writers and drain(): entries persisted
+    std::unordered_map<int64_t, Entry> entries_;
+    std::deque<int64_t> order_; // keys with a queued write, oldest first
+    size_t in_flight_{0};
+    bool stop_{false};
+    uint64_t enqueued_{0};
+    uint64_t coalesced_{0};
+    uint64_t flushed_{0};
+    uint64_t failed_{0};
+    uint64_t batches_{0};
+    double latency_ms_sum_{0};
+    double latency_ms_max_{0};
+    std::thread flusher_;
+};
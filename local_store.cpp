@@ -0,0 +1,923 @@
+#include "local_store.h"
+#include "write_ahead_log.h"
+
+#include <map>
+#include <shared_mutex>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+// Implementation of LocalStore: write-ahead log + memtable + immutable sorted segments + compaction
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ---- Keys ----
+// 0x00 + the integer big-endian with its sign bit flipped (byte order is numeric order), or 0x01 + the bytes of
+// a string key: integers sort before strings.
+constexpr char kIntSpace = '\x00';
+constexpr char kStringSpace = '\x01';
+constexpr size_t kIntKeySize = 9;
+
+std::string intKey(int64_t key) {
+    uint64_t u = static_cast<uint64_t>(key) ^ (uint64_t{1} << 63);
+    std::string out(kIntKeySize, kIntSpace);
+    for (int i = 0; i < 8; ++i) out[1 + i] = static_cast<char>(u >> (56 - 8 * i));
+    return out;
+}
+
+std::string stringKey(const std::string &key) {
+    std::string out(1, kStringSpace);
+    out += key;
+    return out;
+}
+
+bool isIntKey(std::string_view k) { return k.size() == kIntKeySize && k[0] == kIntSpace; }
+
+int64_t decodeIntKey(std::string_view k) {
+    uint64_t u = 0;
+    for (int i = 0; i < 8; ++i) u = (u << 8) | static_cast<unsigned char>(k[1 + i]);
+    return static_cast<int64_t>(u ^ (uint64_t{1} << 63));
+}
+
+// A value, or nullopt for a tombstone.
+using Slot = std::optional<std::string>;
+using Memtable = std::map<std::string, Slot, std::less<>>;
+
+// approximate memory of one memtable entry (map node overhead included)
+size_t entryBytes(std::string_view key, const Slot &slot) { return key.size() + (slot ? slot->size() : 0) + 80; }
+
+// ---- Log records: {uint8 op, uint32 key length, key, value} ----
+constexpr uint8_t kPut = 1;
+constexpr uint8_t kDelete = 2;
+
+std::string encodeRecord(uint8_t op, std::string_view key, const std::string *value) {
+    std::string rec;
+    rec.reserve(5 + key.size() + (value ? value->size() : 0));
+    rec.push_back(static_cast<char>(op));
+    uint32_t klen = static_cast<uint32_t>(key.size());
+    rec.append(reinterpret_cast<const char *>(&klen), sizeof(klen));
+    rec.append(key);
+    if (value) rec.append(*value);
+    return rec;
+}
+
+bool decodeRecord(std::string_view rec, uint8_t &op, std::string_view &key, std::string_view &value) {
+    if (rec.size() < 5) return false;
+    op = static_cast<uint8_t>(rec[0]);
+    uint32_t klen = 0;
+    std::memcpy(&klen, rec.data() + 1, sizeof(klen));
+    if (rec.size() - 5 < klen || (op != kPut && op != kDelete)) return false;
+    key = rec.substr(5, klen);
+    value = rec.substr(5 + klen);
+    return true;
+}
+
+bool fsyncDir(const std::string &dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// ---- Segments ----
+// Records {uint32 key length, uint32 value length (kTombstone for a delete), key, value} in key order, then a
+// sparse index {uint32 key length, key, uint64 record offset} of every kIndexEvery-th record, then a Footer.
+constexpr uint32_t kTombstone = UINT32_MAX;
+constexpr size_t kIndexEvery = 16;
+constexpr char kSegmentMagic[8] = {'K', 'V', 'S', 'E', 'G', '0', '0', '1'};
+
+struct Footer {
+    uint64_t index_offset;
+    uint64_t index_entries;
+    uint64_t records;
+    int64_t int_min;
+    int64_t int_max;
+    uint32_t crc;     // CRC-32C of everything before the footer
+    uint32_t has_int; // int_min/int_max are set
+    char magic[8];
+};
+static_assert(sizeof(Footer) == 56, "segment footer layout");
+
+class SegmentWriter {
+public:
+    ~SegmentWriter() {
+        if (file_) {
+            std::fclose(file_);
+            std::remove(tmp_.c_str());
+        }
+    }
+
+    bool open(const std::string &path) {
+        path_ = path;
+        tmp_ = path + ".tmp";
+        file_ = std::fopen(tmp_.c_str(), "wb");
+        if (!file_) return false;
+        std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+        return true;
+    }
+
+    // Keys must arrive in increasing order; value null writes a tombstone.
+    void add(std::string_view key, const std::string_view *value) {
+        if (records_ % kIndexEvery == 0) index_.emplace_back(std::string(key), offset_);
+        uint32_t head[2] = {static_cast<uint32_t>(key.size()), value ? static_cast<uint32_t>(value->size()) : kTombstone};
+        put(head, sizeof(head));
+        put(key.data(), key.size());
+        if (value) put(value->data(), value->size());
+        if (isIntKey(key)) {
+            int64_t k = decodeIntKey(key);
+            if (!has_int_) footer_.int_min = k;
+            footer_.int_max = k;
+            has_int_ = true;
+        }
+        ++records_;
+    }
+
+    // Complete the file, make it durable and move it into place.
+    bool finish() {
+        if (!file_) return false;
+        footer_.index_offset = offset_;
+        footer_.index_entries = index_.size();
+        for (const auto &[key, offset] : index_) {
+            uint32_t klen = static_cast<uint32_t>(key.size());
+            put(&klen, sizeof(klen));
+            put(key.data(), key.size());
+            put(&offset, sizeof(offset));
+        }
+        footer_.records = records_;
+        footer_.crc = crc_;
+        footer_.has_int = has_int_ ? 1 : 0;
+        std::memcpy(footer_.magic, kSegmentMagic, sizeof(footer_.magic));
+        bool ok = ok_ && std::fwrite(&footer_, sizeof(footer_), 1, file_) == 1;
+        ok = ok && std::fflush(file_) == 0 && ::fsync(fileno(file_)) == 0;
+        ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+        ok = ok && std::rename(tmp_.c_str(), path_.c_str()) == 0;
+        if (!ok) {
+            std::remove(tmp_.c_str());
+            return false;
+        }
+        return fsyncDir(fs::path(path_).parent_path().string());
+    }
+
+    uint64_t records() const { return records_; }
+
+private:
+    void put(const void *p, size_t n) {
+        if (!ok_ || n == 0) return;
+        if (std::fwrite(p, n, 1, file_) != 1) ok_ = false;
+        crc_ = crc32c(p, n, crc_);
+        offset_ += n;
+    }
+
+    std::string path_;
+    std::string tmp_;
+    std::FILE *file_{nullptr};
+    bool ok_{true};
+    uint64_t offset_{0};
+    uint64_t records_{0};
+    uint32_t crc_{0};
+    bool has_int_{false};
+    Footer footer_{};
+    std::vector<std::pair<std::string, uint64_t>> index_;
+};
+
+class Segment {
+public:
+    struct Record {
+        std::string_view key;
+        std::string_view value;
+        bool tombstone;
+    };
+
+    ~Segment() {
+        if (data_) ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    // Map a segment file; verify recomputes its checksum (skipped for files this process just wrote).
+    static std::shared_ptr<Segment> open(const std::string &path, uint64_t id, bool verify, std::string &error) {
+        auto seg = std::shared_ptr<Segment>(new Segment());
+        seg->id_ = id;
+        seg->path_ = path;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "cannot open " + path;
+            return nullptr;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Footer)) {
+            ::close(fd);
+            error = path + ": truncated segment";
+            return nullptr;
+        }
+        seg->size_ = static_cast<size_t>(st.st_size);
+        void *map = ::mmap(nullptr, seg->size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            error = path + ": mmap failed";
+            return nullptr;
+        }
+        seg->data_ = static_cast<const char *>(map);
+        const size_t body = seg->size_ - sizeof(Footer);
+        std::memcpy(&seg->footer_, seg->data_ + body, sizeof(Footer));
+        const Footer &f = seg->footer_;
+        if (std::memcmp(f.magic, kSegmentMagic, sizeof(f.magic)) != 0 || f.index_offset > body) {
+            error = path + ": not a segment";
+            return nullptr;
+        }
+        if (verify && crc32c(seg->data_, body) != f.crc) {
+            error = path + ": checksum mismatch";
+            return nullptr;
+        }
+        seg->data_end_ = f.index_offset;
+        size_t pos = f.index_offset;
+        seg->index_.reserve(f.index_entries);
+        for (uint64_t i = 0; i < f.index_entries; ++i) {
+            uint32_t klen = 0;
+            if (body - pos < sizeof(klen)) break;
+            std::memcpy(&klen, seg->data_ + pos, sizeof(klen));
+            if (body - pos - sizeof(klen) < klen + sizeof(uint64_t)) break;
+            uint64_t offset = 0;
+            std::memcpy(&offset, seg->data_ + pos + sizeof(klen) + klen, sizeof(offset));
+            seg->index_.emplace_back(std::string_view(seg->data_ + pos + sizeof(klen), klen), offset);
+            pos += sizeof(klen) + klen + sizeof(offset);
+        }
+        if (seg->index_.size() != f.index_entries) {
+            error = path + ": corrupt index";
+            return nullptr;
+        }
+        ::madvise(map, seg->size_, MADV_RANDOM);
+        return seg;
+    }
+
+    uint64_t id() const { return id_; }
+    const std::string &path() const { return path_; }
+    uint64_t records() const { return footer_.records; }
+    size_t bytes() const { return size_; }
+
+    std::optional<std::pair<int64_t, int64_t>> intBounds() const {
+        if (!footer_.has_int) return std::nullopt;
+        return std::make_pair(footer_.int_min, footer_.int_max);
+    }
+
+    // The key's entry in this segment (value or tombstone), or nullopt if the segment does not have it.
+    std::optional<Slot> find(std::string_view key) const {
+        for (size_t pos = seek(key); pos < data_end_;) {
+            Record r;
+            pos = read(pos, r);
+            if (r.key == key) return r.tombstone ? Slot() : Slot(std::string(r.value));
+            if (r.key > key) break;
+        }
+        return std::nullopt;
+    }
+
+    // Offset of the first record whose key may be >= key (start of its index block).
+    size_t seek(std::string_view key) const {
+        auto it = std::upper_bound(index_.begin(), index_.end(), key,
+                                   [](std::string_view k, const auto &entry) { return k < entry.first; });
+        return it == index_.begin() ? 0 : static_cast<size_t>(std::prev(it)->second);
+    }
+
+    size_t end() const { return data_end_; }
+
+    // Parse the record at pos; returns the offset of the next one.
+    size_t read(size_t pos, Record &r) const {
+        uint32_t head[2];
+        std::memcpy(head, data_ + pos, sizeof(head));
+        pos += sizeof(head);
+        r.key = std::string_view(data_ + pos, head[0]);
+        pos += head[0];
+        r.tombstone = head[1] == kTombstone;
+        r.value = r.tombstone ? std::string_view() : std::string_view(data_ + pos, head[1]);
+        return pos + r.value.size();
+    }
+
+private:
+    Segment() = default;
+
+    uint64_t id_{0};
+    std::string path_;
+    const char *data_{nullptr};
+    size_t size_{0};
+    size_t data_end_{0};
+    Footer footer_{};
+    std::vector<std::pair<std::string_view, uint64_t>> index_; // keys point into the mapping
+};
+
+using SegmentList = std::vector<std::shared_ptr<Segment>>; // oldest first
+
+// ---- Merged iteration ----
+// One sorted input of a merge: a memtable or a segment, positioned at or after a start key.
+class Source {
+public:
+    Source(const Memtable &table, std::string_view from) : table_(&table), it_(table.lower_bound(from)) {}
+    Source(const Segment &seg, std::string_view from) : seg_(&seg), pos_(seg.seek(from)) {
+        advance();
+        while (valid() && key_ < from) advance();
+    }
+
+    bool valid() const { return table_ ? it_ != table_->end() : valid_; }
+    std::string_view key() const { return table_ ? std::string_view(it_->first) : key_; }
+    bool tombstone() const { return table_ ? !it_->second.has_value() : tombstone_; }
+    std::string_view value() const { return table_ ? std::string_view(*it_->second) : value_; }
+
+    void next() {
+        if (table_) {
+            ++it_;
+        } else {
+            advance();
+        }
+    }
+
+private:
+    void advance() {
+        if (pos_ >= seg_->end()) {
+            valid_ = false;
+            return;
+        }
+        Segment::Record r;
+        pos_ = seg_->read(pos_, r);
+        key_ = r.key;
+        value_ = r.value;
+        tombstone_ = r.tombstone;
+        valid_ = true;
+    }
+
+    const Memtable *table_{nullptr};
+    Memtable::const_iterator it_{};
+    const Segment *seg_{nullptr};
+    size_t pos_{0};
+    bool valid_{false};
+    std::string_view key_;
+    std::string_view value_;
+    bool tombstone_{false};
+};
+
+// fn(key, tombstone, value) in key order for every key the sources hold up to *to (to the end if to is null),
+// with its newest entry; sources are ordered newest first. Stops when fn returns false.
+template <typename Fn>
+void mergeRange(std::vector<Source> &sources, const std::string_view *to, Fn &&fn) {
+    for (;;) {
+        const Source *newest = nullptr;
+        for (const Source &s : sources) {
+            if (s.valid() && (!newest || s.key() < newest->key())) newest = &s;
+        }
+        if (!newest || (to && newest->key() > *to)) return;
+        const std::string key(newest->key());
+        if (!fn(std::string_view(key), newest->tombstone(), newest->value())) return;
+        for (Source &s : sources) {
+            if (s.valid() && s.key() == key) s.next();
+        }
+    }
+}
+
+size_t envSize(const char *name, size_t fallback) {
+    if (const char *v = std::getenv(name)) {
+        try {
+            long long n = std::stoll(v);
+            if (n >= 0) return static_cast<size_t>(n);
+        } catch (...) {}
+        std::cerr << "Invalid " << name << " value '" << v << "', using " << fallback << "\n";
+    }
+    return fallback;
+}
+
+} // namespace
+
+LocalStore::Options LocalStore::Options::fromEnv() {
+    Options o;
+    o.memtable_bytes = std::max<size_t>(envSize("LOCAL_MEMTABLE_BYTES", o.memtable_bytes), 4096);
+    o.compact_segments = std::max<size_t>(envSize("LOCAL_COMPACT_SEGMENTS", o.compact_segments), 2);
+    o.sync_window = std::chrono::microseconds(envSize("LOCAL_SYNC_US", static_cast<size_t>(o.sync_window.count())));
+    o.sync_batch = std::max<size_t>(envSize("LOCAL_SYNC_BATCH", o.sync_batch), 1);
+    return o;
+}
+
+struct LocalStore::Impl {
+    std::string dir;
+    Options opt;
+
+    // memtables, segment list and active log; writers take it exclusively, readers shared
+    mutable std::shared_mutex mtx;
+    std::condition_variable_any space_cv;   // writers and flush(): the frozen memtable was written out
+    std::condition_variable_any flush_cv;   // flusher: a memtable was frozen, or stopping
+    std::condition_variable_any compact_cv; // compactor: enough segments, a request, or stopping
+    std::shared_ptr<Memtable> mem{std::make_shared<Memtable>()};
+    size_t mem_bytes{0};
+    std::shared_ptr<const Memtable> frozen; // being written out as a segment
+    uint64_t frozen_log{0};
+    std::shared_ptr<WriteAheadLog> log;
+    uint64_t log_id{0};
+    SegmentList segments;
+    uint64_t next_file{1}; // shared numbering of logs and segments
+    bool stop{false};
+    bool compact_requested{false};
+    uint64_t compaction_rounds{0};
+
+    std::mutex manifest_mtx; // one MANIFEST rewrite at a time
+    int lock_fd{-1};         // flock on LOCK: one process per directory
+    std::thread flusher;
+    std::thread compactor;
+
+    // counters for metrics(); log counters include rotated logs
+    std::atomic<uint64_t> flushes{0};
+    std::atomic<uint64_t> compactions{0};
+    std::atomic<uint64_t> log_records{0};
+    std::atomic<uint64_t> log_syncs{0};
+    std::atomic<uint64_t> replayed{0};
+    std::atomic<double> last_compaction_ms{0};
+
+    ~Impl() {
+        if (lock_fd >= 0) ::close(lock_fd);
+    }
+
+    std::string path(const char *prefix, uint64_t id, const char *suffix) const {
+        return (fs::path(dir) / (prefix + std::to_string(id) + suffix)).string();
+    }
+    std::string logPath(uint64_t id) const { return path("wal-", id, ".log"); }
+    std::string segmentPath(uint64_t id) const { return path("seg-", id, ".sst"); }
+    std::string manifestPath() const { return (fs::path(dir) / "MANIFEST").string(); }
+
+    // Newest entry of key in the memtables (caller holds mtx), or nullopt if neither has it.
+    std::optional<Slot> findInMemory(std::string_view key) const {
+        auto it = mem->find(key);
+        if (it != mem->end()) return it->second;
+        if (frozen) {
+            auto f = frozen->find(key);
+            if (f != frozen->end()) return f->second;
+        }
+        return std::nullopt;
+    }
+
+    static std::optional<Slot> findInSegments(const SegmentList &segs, std::string_view key) {
+        for (auto it = segs.rbegin(); it != segs.rend(); ++it) {
+            if (auto slot = (*it)->find(key)) return slot;
+        }
+        return std::nullopt;
+    }
+
+    std::unique_ptr<std::string> read(const std::string &key) const {
+        SegmentList segs;
+        {
+            std::shared_lock<std::shared_mutex> lk(mtx);
+            if (auto slot = findInMemory(key)) return *slot ? std::make_unique<std::string>(std::move(**slot)) : nullptr;
+            segs = segments;
+        }
+        auto slot = findInSegments(segs, key);
+        if (!slot || !*slot) return nullptr;
+        return std::make_unique<std::string>(std::move(**slot));
+    }
+
+    void applyLocked(std::string key, Slot slot) {
+        auto it = mem->find(key);
+        if (it != mem->end()) {
+            mem_bytes -= entryBytes(it->first, it->second);
+            mem_bytes += entryBytes(it->first, slot);
+            it->second = std::move(slot);
+        } else {
+            mem_bytes += entryBytes(key, slot);
+            mem->emplace(std::move(key), std::move(slot));
+        }
+    }
+
+    // Swap in an empty memtable and a new log; the flusher writes the old pair out. Caller holds mtx
+    // exclusively and has waited for the previous frozen memtable.
+    bool freezeLocked() {
+        auto next = std::make_shared<WriteAheadLog>();
+        const uint64_t id = next_file++;
+        std::string error;
+        if (!next->open(logPath(id), WriteAheadLog::Options{opt.sync_window, opt.sync_batch}, error)) {
+            std::cerr << "LocalStore: cannot rotate the log: " << error << "\n";
+            return false;
+        }
+        auto st = log->stats();
+        log_records += st.appended;
+        log_syncs += st.syncs;
+        frozen = std::move(mem);
+        frozen_log = log_id;
+        mem = std::make_shared<Memtable>();
+        mem_bytes = 0;
+        log = std::move(next);
+        log_id = id;
+        flush_cv.notify_all();
+        return true;
+    }
+
+    // Log and apply one write; value null deletes. With must_exist nothing is written for an absent key.
+    bool write(std::string key, const std::string *value, bool must_exist) {
+        std::shared_ptr<WriteAheadLog> target;
+        uint64_t seq = 0;
+        {
+            std::unique_lock<std::shared_mutex> lk(mtx);
+            if (mem_bytes >= opt.memtable_bytes) {
+                space_cv.wait(lk, [&] { return !frozen || stop; });
+                if (!frozen && mem_bytes >= opt.memtable_bytes) freezeLocked();
+            }
+            if (must_exist) {
+                auto slot = findInMemory(key);
+                if (!slot) slot = findInSegments(segments, key);
+                if (!slot || !*slot) return false;
+            }
+            seq = log->append(encodeRecord(value ? kPut : kDelete, key, value));
+            if (seq == 0) {
+                std::cerr << "LocalStore: log append failed\n";
+                return false;
+            }
+            applyLocked(std::move(key), value ? Slot(*value) : Slot());
+            target = log;
+        }
+        // durable before acknowledged; concurrent writers share one fdatasync
+        if (!target->sync(seq)) {
+            std::cerr << "LocalStore: log sync failed\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Write table as segment file id; nullptr on I/O error.
+    std::shared_ptr<Segment> writeSegment(uint64_t id, const std::function<void(SegmentWriter &)> &fill) {
+        SegmentWriter w;
+        if (!w.open(segmentPath(id))) return nullptr;
+        fill(w);
+        if (!w.finish()) return nullptr;
+        std::string error;
+        auto seg = Segment::open(segmentPath(id), id, false, error);
+        if (!seg) std::cerr << "LocalStore: " << error << "\n";
+        return seg;
+    }
+
+    static void fillFromTable(SegmentWriter &w, const Memtable &table) {
+        for (const auto &[key, slot] : table) {
+            if (slot) {
+                std::string_view v(*slot);
+                w.add(key, &v);
+            } else {
+                w.add(key, nullptr); // may shadow an older segment
+            }
+        }
+    }
+
+    // Replace MANIFEST with the current segment list and the oldest log not yet in a segment.
+    bool writeManifest() {
+        std::lock_guard<std::mutex> guard(manifest_mtx);
+        std::string text;
+        {
+            std::shared_lock<std::shared_mutex> lk(mtx);
+            text = "kvlocal 1\nnext_file " + std::to_string(next_file) + "\nlog_floor " +
+                   std::to_string(frozen ? frozen_log : log_id) + "\n";
+            for (const auto &seg : segments) text += "segment " + std::to_string(seg->id()) + "\n";
+        }
+        const std::string path = manifestPath();
+        const std::string tmp = path + ".tmp";
+        std::FILE *f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(text.data(), text.size(), 1, f) == 1 && std::fflush(f) == 0 && ::fsync(fileno(f)) == 0;
+        ok = std::fclose(f) == 0 && ok;
+        ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0 && fsyncDir(dir);
+        if (!ok) {
+            std::remove(tmp.c_str());
+            std::cerr << "LocalStore: writing MANIFEST failed\n";
+        }
+        return ok;
+    }
+
+    void runFlusher() {
+        std::unique_lock<std::shared_mutex> lk(mtx);
+        for (;;) {
+            flush_cv.wait(lk, [&] { return stop || frozen; });
+            if (!frozen) return; // stopping with nothing to write out
+            auto table = frozen;
+            const uint64_t old_log = frozen_log;
+            const uint64_t id = next_file++;
+            lk.unlock();
+            auto seg = writeSegment(id, [&](SegmentWriter &w) { fillFromTable(w, *table); });
+            lk.lock();
+            if (!seg) {
+                std::cerr << "LocalStore: writing segment " << id << " failed, retrying\n";
+                if (stop) return; // the log still holds the frozen writes
+                flush_cv.wait_for(lk, std::chrono::seconds(1), [&] { return stop; });
+                continue;
+            }
+            segments.push_back(std::move(seg));
+            frozen.reset();
+            lk.unlock();
+            if (writeManifest()) std::remove(logPath(old_log).c_str());
+            ++flushes;
+            lk.lock();
+            space_cv.notify_all();
+            compact_cv.notify_all();
+        }
+    }
+
+    void runCompactor() {
+        std::unique_lock<std::shared_mutex> lk(mtx);
+        for (;;) {
+            compact_cv.wait(lk, [&] { return stop || compact_requested || segments.size() >= opt.compact_segments; });
+            if (stop) return;
+            compact_requested = false;
+            SegmentList inputs = segments;
+            const uint64_t id = next_file++;
+            lk.unlock();
+            bool ok = inputs.size() < 2 || compactSegments(inputs, id);
+            lk.lock();
+            ++compaction_rounds;
+            space_cv.notify_all();
+            if (!ok) compact_cv.wait_for(lk, std::chrono::seconds(1), [&] { return stop; });
+        }
+    }
+
+    // Merge inputs (a prefix of the segment list: all segments older than any flushed meanwhile) into segment
+    // id. Nothing is older than the inputs, so tombstones are dropped.
+    bool compactSegments(const SegmentList &inputs, uint64_t id) {
+        auto started = std::chrono::steady_clock::now();
+        auto merged = writeSegment(id, [&](SegmentWriter &w) {
+            std::vector<Source> sources;
+            for (auto it = inputs.rbegin(); it != inputs.rend(); ++it) sources.emplace_back(**it, std::string_view());
+            mergeRange(sources, nullptr, [&](std::string_view key, bool tombstone, std::string_view value) {
+                if (!tombstone) w.add(key, &value);
+                return true;
+            });
+        });
+        if (!merged) {
+            std::cerr << "LocalStore: compaction into segment " << id << " failed\n";
+            return false;
+        }
+        {
+            std::unique_lock<std::shared_mutex> lk(mtx);
+            SegmentList next{merged};
+            next.insert(next.end(), segments.begin() + static_cast<std::ptrdiff_t>(inputs.size()), segments.end());
+            segments.swap(next);
+        }
+        if (writeManifest()) {
+            for (const auto &seg : inputs) std::remove(seg->path().c_str()); // mappings stay valid for readers
+        }
+        ++compactions;
+        last_compaction_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return true;
+    }
+
+    void recover() {
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        if (ec) throw std::runtime_error("LocalStore: cannot create " + dir + ": " + ec.message());
+        const std::string lock_path = (fs::path(dir) / "LOCK").string();
+        lock_fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lock_fd < 0) throw std::runtime_error("LocalStore: cannot open " + lock_path + ": " + std::strerror(errno));
+        if (::flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(lock_fd);
+            lock_fd = -1;
+            throw std::runtime_error("LocalStore: " + dir + " is in use by another process");
+        }
+
+        uint64_t log_floor = 0;
+        std::vector<uint64_t> listed;
+        if (std::ifstream mf{manifestPath()}) {
+            std::string header;
+            if (!std::getline(mf, header) || header != "kvlocal 1") throw std::runtime_error("LocalStore: bad MANIFEST in " + dir);
+            std::string field;
+            uint64_t value = 0;
+            while (mf >> field >> value) {
+                if (field == "next_file") next_file = value;
+                else if (field == "log_floor") log_floor = value;
+                else if (field == "segment") listed.push_back(value);
+            }
+        }
+        for (uint64_t id : listed) {
+            std::string error;
+            auto seg = Segment::open(segmentPath(id), id, true, error);
+            if (!seg) throw std::runtime_error("LocalStore: " + error);
+            segments.push_back(std::move(seg));
+        }
+
+        // leftovers of an interrupted flush or compaction, and logs already in segments
+        std::vector<uint64_t> logs;
+        for (const auto &entry : fs::directory_iterator(dir)) {
+            const std::string name = entry.path().filename().string();
+            uint64_t id = 0;
+            auto numbered = [&](const char *prefix, const char *suffix) {
+                size_t p = std::strlen(prefix), s = std::strlen(suffix);
+                if (name.size() <= p + s || name.compare(0, p, prefix) != 0 || name.compare(name.size() - s, s, suffix) != 0) return false;
+                try {
+                    id = std::stoull(name.substr(p, name.size() - p - s));
+                } catch (...) {
+                    return false;
+                }
+                return true;
+            };
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+                fs::remove(entry.path(), ec);
+            } else if (numbered("seg-", ".sst")) {
+                if (std::find(listed.begin(), listed.end(), id) == listed.end()) fs::remove(entry.path(), ec);
+                next_file = std::max(next_file, id + 1);
+            } else if (numbered("wal-", ".log")) {
+                if (id < log_floor) fs::remove(entry.path(), ec);
+                else logs.push_back(id);
+                next_file = std::max(next_file, id + 1);
+            }
+        }
+        std::sort(logs.begin(), logs.end());
+
+        for (uint64_t id : logs) {
+            uint64_t valid = 0, records = 0;
+            bool ok = WriteAheadLog::replay(logPath(id), [&](std::string_view rec) {
+                uint8_t op = 0;
+                std::string_view key, value;
+                if (!decodeRecord(rec, op, key, value)) return;
+                applyLocked(std::string(key), op == kPut ? Slot(std::string(value)) : Slot());
+            }, &valid, &records);
+            if (!ok) throw std::runtime_error("LocalStore: cannot read " + logPath(id));
+            replayed += records;
+        }
+        if (!mem->empty()) {
+            const uint64_t id = next_file++;
+            auto seg = writeSegment(id, [&](SegmentWriter &w) { fillFromTable(w, *mem); });
+            if (!seg) throw std::runtime_error("LocalStore: cannot write recovered segment in " + dir);
+            segments.push_back(std::move(seg));
+            mem = std::make_shared<Memtable>();
+            mem_bytes = 0;
+        }
+
+        log = std::make_shared<WriteAheadLog>();
+        log_id = next_file++;
+        std::string error;
+        if (!log->open(logPath(log_id), WriteAheadLog::Options{opt.sync_window, opt.sync_batch}, error)) {
+            throw std::runtime_error("LocalStore: " + error);
+        }
+        if (!writeManifest()) throw std::runtime_error("LocalStore: cannot write MANIFEST in " + dir);
+        for (uint64_t id : logs) std::remove(logPath(id).c_str());
+    }
+};
+
+LocalStore::LocalStore(const std::string &dir, Options options) : p_(std::make_unique<Impl>()) {
+    p_->dir = dir;
+    p_->opt = options;
+    p_->recover();
+    p_->flusher = std::thread([this] { p_->runFlusher(); });
+    p_->compactor = std::thread([this] { p_->runCompactor(); });
+}
+
+LocalStore::~LocalStore() {
+    {
+        std::unique_lock<std::shared_mutex> lk(p_->mtx);
+        p_->stop = true;
+    }
+    p_->flush_cv.notify_all();
+    p_->compact_cv.notify_all();
+    p_->space_cv.notify_all();
+    if (p_->flusher.joinable()) p_->flusher.join();
+    if (p_->compactor.joinable()) p_->compactor.join();
+}
+
+bool LocalStore::insert(int64_t key, const std::string &value) { return p_->write(intKey(key), &value, false); }
+
+bool LocalStore::update(int64_t key, const std::string &value) { return p_->write(intKey(key), &value, true); }
+
+bool LocalStore::remove(int64_t key) { return p_->write(intKey(key), nullptr, true); }
+
+std::unique_ptr<std::string> LocalStore::get(int64_t key) { return p_->read(intKey(key)); }
+
+std::unordered_map<int64_t, std::string> LocalStore::multiGet(const std::vector<int64_t> &keys) {
+    std::unordered_map<int64_t, std::string> out;
+    std::vector<std::pair<int64_t, std::string>> rest; // not in memory: looked up in segments
+    SegmentList segs;
+    {
+        std::shared_lock<std::shared_mutex> lk(p_->mtx);
+        for (int64_t key : keys) {
+            std::string k = intKey(key);
+            if (auto slot = p_->findInMemory(k)) {
+                if (*slot) out.emplace(key, std::move(**slot));
+            } else {
+                rest.emplace_back(key, std::move(k));
+            }
+        }
+        segs = p_->segments;
+    }
+    for (auto &[key, k] : rest) {
+        auto slot = Impl::findInSegments(segs, k);
+        if (slot && *slot) out.emplace(key, std::move(**slot));
+    }
+    return out;
+}
+
+bool LocalStore::scanRange(int64_t from, int64_t to, const RowSink &sink) {
+    if (from > to) return true;
+    const std::string lo = intKey(from);
+    const std::string hi = intKey(to);
+    // the active memtable keeps changing: copy its part of the range; the rest is immutable
+    Memtable active;
+    std::shared_ptr<const Memtable> frozen;
+    SegmentList segs;
+    {
+        std::shared_lock<std::shared_mutex> lk(p_->mtx);
+        for (auto it = p_->mem->lower_bound(lo); it != p_->mem->end() && it->first <= hi; ++it) active.insert(*it);
+        frozen = p_->frozen;
+        segs = p_->segments;
+    }
+    std::vector<Source> sources;
+    sources.emplace_back(active, lo);
+    if (frozen) sources.emplace_back(*frozen, lo);
+    for (auto it = segs.rbegin(); it != segs.rend(); ++it) sources.emplace_back(**it, lo);
+    const std::string_view last(hi);
+    mergeRange(sources, &last, [&](std::string_view key, bool tombstone, std::string_view value) {
+        return tombstone || sink(decodeIntKey(key), std::string(value));
+    });
+    return true;
+}
+
+std::optional<std::pair<int64_t, int64_t>> LocalStore::keyBounds() {
+    std::optional<std::pair<int64_t, int64_t>> bounds;
+    auto widen = [&](int64_t lo, int64_t hi) {
+        if (!bounds) bounds = std::make_pair(lo, hi);
+        bounds->first = std::min(bounds->first, lo);
+        bounds->second = std::max(bounds->second, hi);
+    };
+    auto tableBounds = [&](const Memtable &table) {
+        auto first = table.lower_bound(intKey(INT64_MIN));
+        if (first == table.end() || !isIntKey(first->first)) return;
+        auto last = std::prev(table.lower_bound(std::string(1, kStringSpace)));
+        widen(decodeIntKey(first->first), decodeIntKey(last->first));
+    };
+    std::shared_lock<std::shared_mutex> lk(p_->mtx);
+    tableBounds(*p_->mem);
+    if (p_->frozen) tableBounds(*p_->frozen);
+    for (const auto &seg : p_->segments) {
+        if (auto b = seg->intBounds()) widen(b->first, b->second);
+    }
+    return bounds;
+}
+
+bool LocalStore::insertStringKey(const std::string &key, const std::string &value) {
+    return p_->write(stringKey(key), &value, false);
+}
+
+bool LocalStore::updateStringKey(const std::string &key, const std::string &value) {
+    return p_->write(stringKey(key), &value, true);
+}
+
+bool LocalStore::removeStringKey(const std::string &key) { return p_->write(stringKey(key), nullptr, true); }
+
+std::unique_ptr<std::string> LocalStore::getStringKey(const std::string &key) { return p_->read(stringKey(key)); }
+
+nlohmann::json LocalStore::metrics() {
+    std::shared_lock<std::shared_mutex> lk(p_->mtx);
+    auto st = p_->log->stats();
+    uint64_t records = p_->log_records.load() + st.appended;
+    uint64_t syncs = p_->log_syncs.load() + st.syncs;
+    uint64_t segment_bytes = 0, segment_records = 0;
+    for (const auto &seg : p_->segments) {
+        segment_bytes += seg->bytes();
+        segment_records += seg->records();
+    }
+    return {{"engine", "local"},
+            {"dir", p_->dir},
+            {"memtable_entries", p_->mem->size()},
+            {"memtable_bytes", p_->mem_bytes},
+            {"flush_pending", static_cast<bool>(p_->frozen)},
+            {"segments", p_->segments.size()},
+            {"segment_bytes", segment_bytes},
+            {"segment_records", segment_records},
+            {"flushes", p_->flushes.load()},
+            {"compactions", p_->compactions.load()},
+            {"last_compaction_ms", p_->last_compaction_ms.load()},
+            {"replayed_records", p_->replayed.load()},
+            {"log", {{"records", records}, {"fsyncs", syncs},
+                     {"records_per_fsync", syncs ? static_cast<double>(records) / static_cast<double>(syncs) : 0.0}}}};
+}
+
+void LocalStore::flush() {
+    std::unique_lock<std::shared_mutex> lk(p_->mtx);
+    p_->space_cv.wait(lk, [&] { return !p_->frozen || p_->stop; });
+    if (p_->frozen || p_->mem->empty() || !p_->freezeLocked()) return;
+    p_->space_cv.wait(lk, [&] { return !p_->frozen || p_->stop; });
+}
+
+void LocalStore::compact() {
+    std::unique_lock<std::shared_mutex> lk(p_->mtx);
+    const uint64_t round = p_->compaction_rounds;
+    p_->compact_requested = true;
+    p_->compact_cv.notify_all();
+    p_->space_cv.wait(lk, [&] { return p_->compaction_rounds > round || p_->stop; });
+}
+
+size_t LocalStore::segmentCount() const {
+    std::shared_lock<std::shared_mutex> lk(p_->mtx);
+    return p_->segments.size();
+}
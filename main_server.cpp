@@ -1,8 +1,10 @@
 #include "server.h"
+#include "local_store.h"
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <thread>
 
 // Simple .env loader: reads lines of the form KEY=VALUE and sets environment variables
 static void load_dotenv(const std::string& path = ".env") {
@@ -46,12 +48,111 @@ static InlineCache::Policy parse_policy(int argc, char** argv) {
             if (v == "lru" || v == "LRU") return InlineCache::Policy::LRU;
             if (v == "fifo" || v == "FIFO") return InlineCache::Policy::FIFO;
             if (v == "random" || v == "RANDOM") return InlineCache::Policy::Random;
+            if (v == "clock" || v == "CLOCK") return InlineCache::Policy::Clock;
             std::cerr << "Unknown policy '" << v << "', defaulting to LRU\n";
         }
     }
     return InlineCache::Policy::LRU;
 }
 
+static size_t parse_cache_shards(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--cache-shards=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v > 0) return static_cast<size_t>(v);
+            } catch (...) {}
+            std::cerr << "Invalid cache shard count '" << arg.substr(pfx.size()) << "', defaulting to "
+                      << KeyValueServer::default_cache_shards << "\n";
+        }
+    }
+    return KeyValueServer::default_cache_shards;
+}
+
+// --cache-cores=N runs the integer key cache as N shared-nothing caches on pinned worker threads;
+// --cache-cores=auto uses one per hardware thread. Default 0: one shared lock-striped cache.
+static size_t parse_cache_cores(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--cache-cores=";
+        if (arg.rfind(pfx, 0) == 0) {
+            std::string v = arg.substr(pfx.size());
+            if (v == "auto") {
+                unsigned n = std::thread::hardware_concurrency();
+                return n ? n : 1;
+            }
+            try {
+                int n = std::stoi(v);
+                if (n >= 0) return static_cast<size_t>(n);
+            } catch (...) {}
+            std::cerr << "Invalid cache core count '" << v << "', using a shared cache\n";
+        }
+    }
+    return 0;
+}
+
+// --negative-cache-ttl-ms=N: how long keys missing from persistence are answered from memory (0 disables).
+static std::chrono::milliseconds parse_negative_cache_ttl(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--negative-cache-ttl-ms=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                long long v = std::stoll(arg.substr(pfx.size()));
+                if (v >= 0) return std::chrono::milliseconds(v);
+            } catch (...) {}
+            std::cerr << "Invalid negative cache TTL '" << arg.substr(pfx.size()) << "', defaulting to "
+                      << KeyValueServer::default_negative_cache_ttl.count() << " ms\n";
+        }
+    }
+    return KeyValueServer::default_negative_cache_ttl;
+}
+
+// --write-mode=through|behind: whether single-key writes wait for persistence or are flushed asynchronously.
+static KeyValueServer::WriteMode parse_write_mode(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--write-mode=";
+        if (arg.rfind(pfx, 0) == 0) {
+            std::string v = arg.substr(pfx.size());
+            if (v == "through") return KeyValueServer::WriteMode::Through;
+            if (v == "behind") return KeyValueServer::WriteMode::Behind;
+            std::cerr << "Unknown write mode '" << v << "', defaulting to through\n";
+        }
+    }
+    return KeyValueServer::WriteMode::Through;
+}
+
+static InlineCache::Storage parse_cache_storage(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--cache-storage=";
+        if (arg.rfind(pfx, 0) == 0) {
+            std::string v = arg.substr(pfx.size());
+            if (v == "chained") return InlineCache::Storage::Chained;
+            if (v == "open" || v == "flat") return InlineCache::Storage::OpenAddressing;
+            std::cerr << "Unknown cache storage '" << v << "', defaulting to chained\n";
+        }
+    }
+    return InlineCache::Storage::Chained;
+}
+
+static InlineCache::Admission parse_admission(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--admission=";
+        if (arg.rfind(pfx, 0) == 0) {
+            std::string v = arg.substr(pfx.size());
+            if (v == "none") return InlineCache::Admission::None;
+            if (v == "tinylfu") return InlineCache::Admission::TinyLFU;
+            std::cerr << "Unknown admission policy '" << v << "', defaulting to none\n";
+        }
+    }
+    return InlineCache::Admission::None;
+}
+
 static bool parse_json_logging(int argc, char** argv) {
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -84,9 +185,150 @@ static bool parse_skip_preload(int argc, char** argv) {
     return false;
 }
 
+// --preload-threads=N: parallel key-range scans of the startup preload (default 4)
+static size_t parse_preload_threads(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--preload-threads=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v > 0) return static_cast<size_t>(v);
+            } catch (...) {}
+            std::cerr << "Invalid preload thread count '" << arg.substr(pfx.size()) << "', defaulting to "
+                      << KeyValueServer::default_preload_threads << "\n";
+        }
+    }
+    return KeyValueServer::default_preload_threads;
+}
+
+// --snapshot=PATH: warm-restart cache snapshot, restored at startup and written on /stop (off by default)
+static std::string parse_snapshot_path(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--snapshot=";
+        if (arg.rfind(pfx, 0) == 0) return arg.substr(pfx.size());
+    }
+    return std::string();
+}
+
+// --snapshot-interval=SECONDS: also write the snapshot periodically (default 0: only on /stop)
+static std::chrono::seconds parse_snapshot_interval(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--snapshot-interval=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v >= 0) return std::chrono::seconds(v);
+            } catch (...) {}
+            std::cerr << "Invalid snapshot interval '" << arg.substr(pfx.size()) << "', snapshotting only on stop\n";
+        }
+    }
+    return std::chrono::seconds(0);
+}
+
+// --hot-keys=PATH: sampled access-frequency profile; its hottest keys are preloaded in the background (off by default)
+static std::string parse_hot_keys_path(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--hot-keys=";
+        if (arg.rfind(pfx, 0) == 0) return arg.substr(pfx.size());
+    }
+    return std::string();
+}
+
+// --hot-keys-interval=SECONDS: how often the profile is saved and decayed (default 60, 0: only on stop)
+static std::chrono::seconds parse_hot_keys_interval(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--hot-keys-interval=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v >= 0) return std::chrono::seconds(v);
+            } catch (...) {}
+            std::cerr << "Invalid hot-key save interval '" << arg.substr(pfx.size()) << "', defaulting to "
+                      << KeyValueServer::default_hot_key_save_interval.count() << "\n";
+        }
+    }
+    return KeyValueServer::default_hot_key_save_interval;
+}
+
+// --wal=DIR: write-ahead log of write-behind writes, replayed at startup (off by default; implies --write-mode=behind)
+static std::string parse_wal_dir(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--wal=";
+        if (arg.rfind(pfx, 0) == 0) return arg.substr(pfx.size());
+    }
+    return std::string();
+}
+
+// --wal-sync-us=N: how long a log fdatasync waits for more concurrent writes (default 0: only those already waiting)
+static std::chrono::microseconds parse_wal_sync_window(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--wal-sync-us=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v >= 0) return std::chrono::microseconds(v);
+            } catch (...) {}
+            std::cerr << "Invalid WAL sync window '" << arg.substr(pfx.size()) << "', defaulting to 0\n";
+        }
+    }
+    return std::chrono::microseconds(0);
+}
+
+// --wal-batch=N: waiting writes that end the sync window early (default 128)
+static size_t parse_wal_batch(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--wal-batch=";
+        if (arg.rfind(pfx, 0) == 0) {
+            try {
+                int v = std::stoi(arg.substr(pfx.size()));
+                if (v > 0) return static_cast<size_t>(v);
+            } catch (...) {}
+            std::cerr << "Invalid WAL batch '" << arg.substr(pfx.size()) << "', defaulting to "
+                      << KeyValueServer::default_wal_sync_batch << "\n";
+        }
+    }
+    return KeyValueServer::default_wal_sync_batch;
+}
+
+// --storage=postgres|local: persistence backend (default postgres; local is the embedded LocalStore)
+static std::string parse_storage(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--storage=";
+        if (arg.rfind(pfx, 0) == 0) {
+            std::string v = arg.substr(pfx.size());
+            if (v == "postgres" || v == "local") return v;
+            std::cerr << "Unknown storage '" << v << "', defaulting to postgres\n";
+        }
+    }
+    return "postgres";
+}
+
+// --data-dir=PATH: LocalStore directory for --storage=local (default "data")
+static std::string parse_data_dir(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const std::string pfx = "--data-dir=";
+        if (arg.rfind(pfx, 0) == 0 && arg.size() > pfx.size()) return arg.substr(pfx.size());
+    }
+    return "data";
+}
+
 int main(int argc, char** argv) {
     InlineCache::Policy policy = parse_policy(argc, argv);
     bool enable_json_logging = parse_json_logging(argc, argv);
+    size_t cache_shards = parse_cache_shards(argc, argv);
+    size_t cache_cores = parse_cache_cores(argc, argv);
+    InlineCache::Storage cache_storage = parse_cache_storage(argc, argv);
+    InlineCache::Admission cache_admission = parse_admission(argc, argv);
     // load .env (if present) so SERVER_HOST and SERVER_PORT can be provided there
     load_dotenv();
 
@@ -102,13 +344,36 @@ int main(int argc, char** argv) {
         }
     }
 
-    KeyValueServer server{host, port, policy, enable_json_logging};
+    KeyValueServer server{host, port, policy, enable_json_logging, cache_shards, cache_storage, cache_admission, cache_cores};
     bool disable_logging = parse_no_logging(argc, argv);
     if (disable_logging) server.setLoggingEnabled(false);
     bool disable_metrics = parse_no_metrics(argc, argv);
     if (disable_metrics) server.setMetricsEnabled(false);
+    server.setNegativeCacheTtl(parse_negative_cache_ttl(argc, argv));
+    KeyValueServer::WriteMode write_mode = parse_write_mode(argc, argv);
+    std::string wal_dir = parse_wal_dir(argc, argv);
+    if (!wal_dir.empty() && write_mode != KeyValueServer::WriteMode::Behind) {
+        std::cerr << "--wal logs write-behind writes; using --write-mode=behind\n";
+        write_mode = KeyValueServer::WriteMode::Behind;
+    }
+    server.setWriteMode(write_mode);
+    if (!wal_dir.empty()) server.setWal(wal_dir, parse_wal_sync_window(argc, argv), parse_wal_batch(argc, argv));
     bool skip_preload = parse_skip_preload(argc, argv);
     if (skip_preload) server.setSkipPreload(true);
+    server.setPreloadThreads(parse_preload_threads(argc, argv));
+    std::string snapshot_path = parse_snapshot_path(argc, argv);
+    if (!snapshot_path.empty()) server.setSnapshot(snapshot_path, parse_snapshot_interval(argc, argv));
+    std::string hot_keys_path = parse_hot_keys_path(argc, argv);
+    if (!hot_keys_path.empty()) server.setHotKeyProfile(hot_keys_path, parse_hot_keys_interval(argc, argv));
+    if (parse_storage(argc, argv) == "local") {
+        std::string data_dir = parse_data_dir(argc, argv);
+        try {
+            server.setPersistenceProvider(std::make_unique<LocalStore>(data_dir), "local:" + data_dir);
+        } catch (const std::exception& e) {
+            std::cerr << "Unable to open local storage: " << e.what() << "\n";
+            return 1;
+        }
+    }
     server.setupRoutes();
     if (!server.start()) {
         return 1;
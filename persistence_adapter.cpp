@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <cstdlib>
 #include <libpq-fe.h>
 #include <vector>
 #include "nlohmann/json.hpp"
@@ -11,9 +12,25 @@
 #include <future>
 #include <condition_variable>
 #include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <deque>
+#include <cerrno>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <unordered_set>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 // Implementation of PersistenceAdapter using libpq (PostgreSQL C client)
 
+class AsyncEngine;  // event-driven getAsync/runTransactionJsonAsync, defined with the transaction helpers
+class WriteBatcher; // group commit for insert/update/remove
+
 struct PersistenceAdapter::Impl {
     PGconn* conn{nullptr};
     bool prepared{false};
@@ -32,10 +49,141 @@ struct PersistenceAdapter::Impl {
     std::atomic<int> dropped_conns{0};
     std::atomic<int> total_conn_creates{0};
     std::atomic<int> total_conn_create_failures{0};
+    // kv_store_bytes statements prepared on every pooled connection
+    bool string_keys{false};
+    // type of kv_store.value (bytea, or text on databases not yet migrated)
+    Oid value_oid{25};
+    // libpq pipeline mode for transactions and batched gets (DB_PIPELINE=0 disables)
+    std::atomic<bool> pipeline{true};
+    // getAsync keys waiting for a worker to send them in one pipeline; guarded by tasks_mtx
+    struct PendingGet {
+        int64_t key;
+        std::shared_ptr<std::promise<std::unique_ptr<std::string>>> promise;
+    };
+    std::vector<PendingGet> pending_gets;
+    // non-blocking connections driven by epoll loops; null when disabled (DB_ASYNC_CONNS=0) or unsupported
+    std::unique_ptr<AsyncEngine> engine;
+    // group commit for insert/update/remove; disabled when max_ops <= 1
+    std::unique_ptr<WriteBatcher> batcher;
+
+    Impl();
+    ~Impl();
+
+    // Hand already-prepared connections to a new AsyncEngine run by io_threads loops.
+    void startEngine(std::vector<PGconn*> conns, int io_threads);
+    void stopEngine();
+    nlohmann::json engineMetrics() const;
+
+    void startWriteBatcher(size_t max_ops, std::chrono::microseconds window);
+    void stopWriteBatcher();
+    // Outcome of a write committed with its batch, or nullopt when batching is off.
+    std::optional<bool> batchWrite(OpType type, int64_t key, const std::string& value);
+    nlohmann::json batchMetrics() const;
+
+    PGconn* borrow() {
+        std::unique_lock<std::mutex> lk(pool_mtx);
+        pool_cv.wait(lk, [this](){ return !free_conns.empty(); });
+        PGconn* c = free_conns.front(); free_conns.pop();
+        return c;
+    }
+    void giveBack(PGconn* c) {
+        {
+            std::lock_guard<std::mutex> lg(pool_mtx);
+            free_conns.push(c);
+        }
+        pool_cv.notify_one();
+    }
+};
+
+// ---- Binary wire format ----
+// Prepared statements take their parameters and return their results in binary format: keys travel as
+// 8-byte network-order int8, values as raw bytes and key/value lists as binary one-dimensional arrays, so
+// no call formats or parses numbers as text, and a bytea value column stores any byte (NUL included).
+static constexpr Oid kInt8Oid = 20;
+static constexpr Oid kByteaOid = 17;
+static constexpr Oid kTextOid = 25;
+
+static void put_be32(std::string& out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<char>((v >> shift) & 0xff));
+}
+
+static void put_be64(char* out, uint64_t v) {
+    for (int i = 7; i >= 0; --i, v >>= 8) out[i] = static_cast<char>(v & 0xff);
+}
+
+static int64_t read_int8(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | static_cast<unsigned char>(p[i]);
+    return static_cast<int64_t>(v);
+}
+
+// Rows affected by an INSERT/UPDATE/DELETE, from the command tag digits.
+static int affected_rows(PGresult* r) {
+    int n = 0;
+    for (const char* t = PQcmdTuples(r); t && *t >= '0' && *t <= '9'; ++t) n = n * 10 + (*t - '0');
+    return n;
+}
+
+// Parameters of the kv_* statements: $1 the key, $2 the value (insert/update only).
+struct KvParams {
+    char key[8];
+    const char* values[2];
+    int lengths[2];
+    int formats[2]{1, 1};
+    int count;
+
+    KvParams(int64_t k, const std::string* value) : count(value ? 2 : 1) {
+        put_be64(key, static_cast<uint64_t>(k));
+        values[0] = key;
+        lengths[0] = 8;
+        values[1] = value ? value->data() : nullptr;
+        lengths[1] = value ? static_cast<int>(value->size()) : 0;
+    }
 };
 
-static std::string to_string_int(int v) {
-    return std::to_string(v);
+static PGresult* exec_kv(PGconn* conn, const char* stmt, int64_t key, const std::string* value = nullptr) {
+    KvParams p(key, value);
+    return PQexecPrepared(conn, stmt, p.count, p.values, p.lengths, p.formats, 1);
+}
+
+static bool send_kv(PGconn* conn, const char* stmt, int64_t key, const std::string* value = nullptr) {
+    KvParams p(key, value);
+    return PQsendQueryPrepared(conn, stmt, p.count, p.values, p.lengths, p.formats, 1) == 1;
+}
+
+// Binary array header: one dimension of n elements, no nulls.
+static std::string array_header(Oid elem, size_t n) {
+    std::string out;
+    put_be32(out, 1);
+    put_be32(out, 0);
+    put_be32(out, elem);
+    put_be32(out, static_cast<uint32_t>(n));
+    put_be32(out, 1);
+    return out;
+}
+
+static std::string int8_array(const std::vector<int64_t>& keys) {
+    std::string out = array_header(kInt8Oid, keys.size());
+    out.reserve(out.size() + keys.size() * 12);
+    char buf[8];
+    for (int64_t k : keys) {
+        put_be32(out, 8);
+        put_be64(buf, static_cast<uint64_t>(k));
+        out.append(buf, 8);
+    }
+    return out;
+}
+
+static std::string bytes_array(Oid elem, const std::vector<const std::string*>& values) {
+    size_t bytes = 0;
+    for (const std::string* v : values) bytes += 4 + v->size();
+    std::string out = array_header(elem, values.size());
+    out.reserve(out.size() + bytes);
+    for (const std::string* v : values) {
+        put_be32(out, static_cast<uint32_t>(v->size()));
+        out += *v;
+    }
+    return out;
 }
 
 PersistenceAdapter::PersistenceAdapter(const std::string &conninfo)
@@ -49,43 +197,122 @@ PersistenceAdapter::PersistenceAdapter(const std::string &conninfo)
         throw std::runtime_error("Failed to open database connection: " + err);
     }
 
+    // Value column type: bytea holds arbitrary bytes; databases created before sql/init_kv.sql converted it
+    // keep text, which still works in binary format but rejects NULs and invalid UTF-8.
+    auto value_type_of = [&](const char* table) {
+        std::string sql = std::string("SELECT format_type(atttypid, atttypmod) FROM pg_attribute "
+                                      "WHERE attrelid = to_regclass('") + table + "') AND attname = 'value';";
+        PGresult* r = PQexec(p_->conn, sql.c_str());
+        bool bytea = PQresultStatus(r) == PGRES_TUPLES_OK && PQntuples(r) == 1 &&
+                     std::string(PQgetvalue(r, 0, 0)) == "bytea";
+        PQclear(r);
+        return std::string(bytea ? "bytea" : "text");
+    };
+    const std::string vt = value_type_of("kv_store");
+    const std::string skey_vt = value_type_of("kv_store_bytes");
+    p_->value_oid = vt == "bytea" ? kByteaOid : kTextOid;
+
     // Prepare statements for better performance
-    const char* prep_insert =
-        "INSERT INTO kv_store (key, value) VALUES ($1::int, $2::text) "
+    const std::string prep_insert =
+        "INSERT INTO kv_store (key, value) VALUES ($1::bigint, $2::" + vt + ") "
         "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value, created_at = now();";
-    const char* prep_delete = "DELETE FROM kv_store WHERE key = $1::int;";
-    const char* prep_select = "SELECT value FROM kv_store WHERE key = $1::int;";
-    const char* prep_update = "UPDATE kv_store SET value = $2::text, created_at = now() WHERE key = $1::int;";
+    const std::string prep_delete = "DELETE FROM kv_store WHERE key = $1::bigint;";
+    const std::string prep_select = "SELECT value FROM kv_store WHERE key = $1::bigint;";
+    const std::string prep_update = "UPDATE kv_store SET value = $2::" + vt + ", created_at = now() WHERE key = $1::bigint;";
+    const std::string prep_multi_select = "SELECT key, value FROM kv_store WHERE key = ANY($1::bigint[]);";
+    // multi-row writes for group commit; one row per key within a statement
+    const std::string prep_batch[][2] = {
+        {"kv_batch_insert", "INSERT INTO kv_store (key, value) SELECT u.key, u.value "
+                            "FROM unnest($1::bigint[], $2::" + vt + "[]) AS u(key, value) "
+                            "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value, created_at = now();"},
+        {"kv_batch_update", "UPDATE kv_store AS k SET value = u.value, created_at = now() "
+                            "FROM unnest($1::bigint[], $2::" + vt + "[]) AS u(key, value) WHERE k.key = u.key RETURNING k.key;"},
+        {"kv_batch_delete", "DELETE FROM kv_store WHERE key = ANY($1::bigint[]) RETURNING key;"},
+    };
+    auto prepare_batch = [&](PGconn* c) {
+        for (const auto& stmt : prep_batch) {
+            PGresult* r = PQprepare(c, stmt[0].c_str(), stmt[1].c_str(), 0, nullptr);
+            bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
+            PQclear(r);
+            if (!ok) return false;
+        }
+        return true;
+    };
+    // string key space; keys are bytea, so any byte sequence round-trips
+    const std::string prep_skey[][2] = {
+        {"kv_skey_insert", "INSERT INTO kv_store_bytes (key, value) VALUES ($1::bytea, $2::" + skey_vt + ") "
+                           "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value, created_at = now();"},
+        {"kv_skey_delete", "DELETE FROM kv_store_bytes WHERE key = $1::bytea;"},
+        {"kv_skey_select", "SELECT value FROM kv_store_bytes WHERE key = $1::bytea;"},
+        {"kv_skey_update", "UPDATE kv_store_bytes SET value = $2::" + skey_vt + ", created_at = now() WHERE key = $1::bytea;"},
+    };
+    auto prepare_kv = [&](PGconn* c) {
+        const std::string stmts[][2] = {
+            {"kv_insert", prep_insert}, {"kv_delete", prep_delete}, {"kv_select", prep_select},
+            {"kv_update", prep_update}, {"kv_multi_select", prep_multi_select},
+        };
+        bool ok = true;
+        for (const auto& stmt : stmts) {
+            PGresult* r = PQprepare(c, stmt[0].c_str(), stmt[1].c_str(), 0, nullptr);
+            if (PQresultStatus(r) != PGRES_COMMAND_OK) ok = false;
+            PQclear(r);
+        }
+        return ok && prepare_batch(c);
+    };
+    auto prepare_string_keys = [&](PGconn* c) {
+        for (const auto& stmt : prep_skey) {
+            PGresult* r = PQprepare(c, stmt[0].c_str(), stmt[1].c_str(), 0, nullptr);
+            bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
+            PQclear(r);
+            if (!ok) return false;
+        }
+        return true;
+    };
 
-    PGresult* r1 = PQprepare(p_->conn, "kv_insert", prep_insert, 2, nullptr);
+    PGresult* r1 = PQprepare(p_->conn, "kv_insert", prep_insert.c_str(), 2, nullptr);
     if (PQresultStatus(r1) != PGRES_COMMAND_OK) {
         std::string err = PQerrorMessage(p_->conn);
         PQclear(r1);
         throw std::runtime_error("Prepare kv_insert failed: " + err);
     }
     PQclear(r1);
-    PGresult* r2 = PQprepare(p_->conn, "kv_delete", prep_delete, 1, nullptr);
+    PGresult* r2 = PQprepare(p_->conn, "kv_delete", prep_delete.c_str(), 1, nullptr);
     if (PQresultStatus(r2) != PGRES_COMMAND_OK) {
         std::string err = PQerrorMessage(p_->conn);
         PQclear(r2);
         throw std::runtime_error("Prepare kv_delete failed: " + err);
     }
     PQclear(r2);
-    PGresult* r3 = PQprepare(p_->conn, "kv_select", prep_select, 1, nullptr);
+    PGresult* r3 = PQprepare(p_->conn, "kv_select", prep_select.c_str(), 1, nullptr);
     if (PQresultStatus(r3) != PGRES_COMMAND_OK) {
         std::string err = PQerrorMessage(p_->conn);
         PQclear(r3);
         throw std::runtime_error("Prepare kv_select failed: " + err);
     }
     PQclear(r3);
-    PGresult* r4 = PQprepare(p_->conn, "kv_update", prep_update, 2, nullptr);
+    PGresult* r4 = PQprepare(p_->conn, "kv_update", prep_update.c_str(), 2, nullptr);
     if (PQresultStatus(r4) != PGRES_COMMAND_OK) {
         std::string err = PQerrorMessage(p_->conn);
         PQclear(r4);
         throw std::runtime_error("Prepare kv_update failed: " + err);
     }
     PQclear(r4);
+    PGresult* r5 = PQprepare(p_->conn, "kv_multi_select", prep_multi_select.c_str(), 1, nullptr);
+    if (PQresultStatus(r5) != PGRES_COMMAND_OK) {
+        std::string err = PQerrorMessage(p_->conn);
+        PQclear(r5);
+        throw std::runtime_error("Prepare kv_multi_select failed: " + err);
+    }
+    PQclear(r5);
+    if (!prepare_batch(p_->conn)) {
+        throw std::runtime_error(std::string("Prepare kv_batch_* failed: ") + PQerrorMessage(p_->conn));
+    }
     p_->prepared = true;
+    // the string key table is optional: without it the adapter still serves integer keys
+    p_->string_keys = prepare_string_keys(p_->conn);
+    if (!p_->string_keys) {
+        std::cerr << "Warning: string keys disabled (kv_store_bytes unavailable): " << PQerrorMessage(p_->conn);
+    }
 
     // Connection pool size from env or default
     int pool_size = 8;
@@ -112,20 +339,13 @@ PersistenceAdapter::PersistenceAdapter(const std::string &conninfo)
     // close and drop that connection to avoid runtime errors like "prepared statement ... does not exist".
     std::vector<PGconn*> good_conns;
     for (auto cptr : p_->pool_conns) {
-        bool ok = true;
         // If this is the original master connection and we already prepared earlier, skip re-preparing
         if (cptr == p_->conn && p_->prepared) {
             good_conns.push_back(cptr);
             continue;
         }
-        PGresult* r1 = PQprepare(cptr, "kv_insert", prep_insert, 2, nullptr);
-        if (PQresultStatus(r1) != PGRES_COMMAND_OK) ok = false; PQclear(r1);
-        PGresult* r2 = PQprepare(cptr, "kv_delete", prep_delete, 1, nullptr);
-        if (PQresultStatus(r2) != PGRES_COMMAND_OK) ok = false; PQclear(r2);
-        PGresult* r3 = PQprepare(cptr, "kv_select", prep_select, 1, nullptr);
-        if (PQresultStatus(r3) != PGRES_COMMAND_OK) ok = false; PQclear(r3);
-        PGresult* r4 = PQprepare(cptr, "kv_update", prep_update, 2, nullptr);
-        if (PQresultStatus(r4) != PGRES_COMMAND_OK) ok = false; PQclear(r4);
+        bool ok = prepare_kv(cptr);
+        if (ok && p_->string_keys) ok = prepare_string_keys(cptr);
         if (ok) good_conns.push_back(cptr);
         else {
             std::cerr << "Warning: dropping pool connection due to prepare failure: " << PQerrorMessage(cptr);
@@ -140,6 +360,46 @@ PersistenceAdapter::PersistenceAdapter(const std::string &conninfo)
         for (auto cptr : p_->pool_conns) p_->free_conns.push(cptr);
     }
 
+    if (const char* pipeline_env = std::getenv("DB_PIPELINE")) {
+        p_->pipeline.store(std::string(pipeline_env) != "0");
+    }
+
+    // Connections for the async engine: separate from the pool, since they stay in non-blocking pipeline mode
+    int async_conns = 4;
+    int io_threads = 1;
+    if (const char* env = std::getenv("DB_ASYNC_CONNS")) {
+        try { async_conns = std::stoi(env); } catch(...) {}
+        if (async_conns < 0) async_conns = 0;
+    }
+    if (const char* env = std::getenv("DB_IO_THREADS")) {
+        try { io_threads = std::stoi(env); } catch(...) {}
+        if (io_threads <= 0) io_threads = 1;
+    }
+    std::vector<PGconn*> engine_conns;
+    for (int i = 0; i < async_conns; ++i) {
+        PGconn* c = PQconnectdb(conninfo.c_str());
+        if (PQstatus(c) != CONNECTION_OK || !prepare_kv(c)) {
+            std::cerr << "Warning: async engine connection failed: " << PQerrorMessage(c);
+            PQfinish(c);
+            p_->total_conn_create_failures.fetch_add(1);
+            continue;
+        }
+        engine_conns.push_back(c);
+        p_->total_conn_creates.fetch_add(1);
+    }
+    if (!engine_conns.empty()) p_->startEngine(std::move(engine_conns), io_threads);
+
+    // group commit: DB_WRITE_BATCH_MAX writes (<= 1 disables) or DB_WRITE_BATCH_US after the first one
+    long batch_max = 128;
+    long batch_us = 200;
+    if (const char* env = std::getenv("DB_WRITE_BATCH_MAX")) {
+        try { batch_max = std::stol(env); } catch(...) {}
+    }
+    if (const char* env = std::getenv("DB_WRITE_BATCH_US")) {
+        try { batch_us = std::stol(env); } catch(...) {}
+    }
+    p_->startWriteBatcher(batch_max > 0 ? static_cast<size_t>(batch_max) : 0, std::chrono::microseconds(batch_us));
+
     // start worker threads
     int workers_n = 4;
     const char* workers_env = std::getenv("DB_WORKER_THREADS");
@@ -177,12 +437,18 @@ nlohmann::json PersistenceAdapter::poolMetrics() const {
     j["dropped_conns"] = p_->dropped_conns.load();
     j["total_conn_creates"] = p_->total_conn_creates.load();
     j["total_conn_create_failures"] = p_->total_conn_create_failures.load();
+    if (p_->engine) j["async_engine"] = p_->engineMetrics();
+    if (p_->batcher) j["write_batch"] = p_->batchMetrics();
     return j;
 }
 
 PersistenceAdapter::~PersistenceAdapter()
 {
     if (!p_) return;
+    // stop the async engine first: it hands reruns to the workers
+    p_->stopEngine();
+    // flush queued writes while the pool is still open
+    p_->stopWriteBatcher();
     // stop workers
     p_->stop_workers.store(true);
     p_->tasks_cv.notify_all();
@@ -196,9 +462,10 @@ PersistenceAdapter::~PersistenceAdapter()
     p_->conn = nullptr;
 }
 
-bool PersistenceAdapter::insert(int key, const std::string &value)
+bool PersistenceAdapter::insert(int64_t key, const std::string &value)
 {
     if (!p_) return false;
+    if (auto batched = p_->batchWrite(OpType::Insert, key, value)) return *batched;
     // borrow connection
     PGconn* conn = nullptr;
     {
@@ -208,9 +475,7 @@ bool PersistenceAdapter::insert(int key, const std::string &value)
     }
     bool ok = false;
     try {
-        std::string keyStr = to_string_int(key);
-        const char* params[2] = { keyStr.c_str(), value.c_str() };
-        PGresult* res = PQexecPrepared(conn, "kv_insert", 2, params, nullptr, nullptr, 0);
+        PGresult* res = exec_kv(conn, "kv_insert", key, &value);
         ok = PQresultStatus(res) == PGRES_COMMAND_OK;
         if (!ok) std::cerr << "insert() error: " << PQerrorMessage(conn);
         PQclear(res);
@@ -224,9 +489,10 @@ bool PersistenceAdapter::insert(int key, const std::string &value)
     return ok;
 }
 
-bool PersistenceAdapter::update(int key, const std::string &value)
+bool PersistenceAdapter::update(int64_t key, const std::string &value)
 {
     if (!p_) return false;
+    if (auto batched = p_->batchWrite(OpType::Update, key, value)) return *batched;
     PGconn* conn = nullptr;
     {
         std::unique_lock<std::mutex> lk(p_->pool_mtx);
@@ -236,13 +502,10 @@ bool PersistenceAdapter::update(int key, const std::string &value)
     bool ok = false;
     int affected = 0;
     try {
-        std::string keyStr = to_string_int(key);
-        const char* params[2] = { keyStr.c_str(), value.c_str() };
-        PGresult* res = PQexecPrepared(conn, "kv_update", 2, params, nullptr, nullptr, 0);
+        PGresult* res = exec_kv(conn, "kv_update", key, &value);
         ok = PQresultStatus(res) == PGRES_COMMAND_OK;
         if (ok) {
-            const char* tuples = PQcmdTuples(res);
-            affected = (tuples && *tuples) ? std::stoi(tuples) : 0;
+            affected = affected_rows(res);
         } else {
             std::cerr << "update() error: " << PQerrorMessage(conn);
         }
@@ -256,9 +519,10 @@ bool PersistenceAdapter::update(int key, const std::string &value)
     return affected > 0;
 }
 
-bool PersistenceAdapter::remove(int key)
+bool PersistenceAdapter::remove(int64_t key)
 {
     if (!p_) return false;
+    if (auto batched = p_->batchWrite(OpType::Remove, key, std::string())) return *batched;
     PGconn* conn = nullptr;
     {
         std::unique_lock<std::mutex> lk(p_->pool_mtx);
@@ -267,13 +531,10 @@ bool PersistenceAdapter::remove(int key)
     }
     bool ok = false; int affected = 0;
     try {
-        std::string keyStr = to_string_int(key);
-        const char* params[1] = { keyStr.c_str() };
-        PGresult* res = PQexecPrepared(conn, "kv_delete", 1, params, nullptr, nullptr, 0);
+        PGresult* res = exec_kv(conn, "kv_delete", key);
         ok = PQresultStatus(res) == PGRES_COMMAND_OK;
         if (ok) {
-            const char* tuples = PQcmdTuples(res);
-            affected = (tuples && *tuples) ? std::stoi(tuples) : 0;
+            affected = affected_rows(res);
         } else {
             std::cerr << "remove() error: " << PQerrorMessage(conn);
         }
@@ -287,7 +548,7 @@ bool PersistenceAdapter::remove(int key)
     return affected > 0;
 }
 
-std::unique_ptr<std::string> PersistenceAdapter::get(int key)
+std::unique_ptr<std::string> PersistenceAdapter::get(int64_t key)
 {
     if (!p_) return nullptr;
     // borrow a connection from pool
@@ -299,21 +560,19 @@ std::unique_ptr<std::string> PersistenceAdapter::get(int key)
     }
 
     std::unique_ptr<std::string> out;
+    std::string error;
     try {
-        std::string keyStr = to_string_int(key);
-        const char* params[1] = { keyStr.c_str() };
-        PGresult* res = PQexecPrepared(conn, "kv_select", 1, params, nullptr, nullptr, 0);
+        PGresult* res = exec_kv(conn, "kv_select", key);
         if (PQresultStatus(res) == PGRES_TUPLES_OK) {
             if (PQntuples(res) == 1 && PQnfields(res) == 1) {
-                char* val = PQgetvalue(res, 0, 0);
-                if (val) out = std::make_unique<std::string>(val);
+                out = std::make_unique<std::string>(PQgetvalue(res, 0, 0), PQgetlength(res, 0, 0));
             }
         } else {
-            std::cerr << "get() error: " << PQerrorMessage(conn);
+            error = PQerrorMessage(conn);
         }
         PQclear(res);
-    } catch(...) {
-        // swallow; return null
+    } catch (const std::exception& e) {
+        error = e.what();
     }
 
     // return connection to pool
@@ -322,178 +581,1332 @@ std::unique_ptr<std::string> PersistenceAdapter::get(int key)
         p_->free_conns.push(conn);
     }
     p_->pool_cv.notify_one();
+    if (!error.empty()) throw std::runtime_error("get() failed: " + error);
     return out;
 }
 
-PersistenceAdapter::TxResult PersistenceAdapter::runTransaction(const std::vector<Operation>& ops, TxMode mode)
+std::unordered_map<int64_t, std::string> PersistenceAdapter::multiGet(const std::vector<int64_t> &keys)
 {
-    TxResult result{true, {}};
-    if (!p_ || !p_->conn) {
-        result.success = false;
-        result.failures.push_back({Operation{OpType::Insert, 0, ""}, "no connection"});
-        return result;
+    std::unordered_map<int64_t, std::string> out;
+    if (!p_ || keys.empty()) return out;
+    std::string array = int8_array(keys);
+    const char* params[1] = { array.data() };
+    int lengths[1] = { static_cast<int>(array.size()) };
+    int formats[1] = { 1 };
+
+    PGconn* conn = p_->borrow();
+    PGresult* res = PQexecPrepared(conn, "kv_multi_select", 1, params, lengths, formats, 1);
+    bool failed = false;
+    std::string error;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQnfields(res) == 2) {
+        int rows = PQntuples(res);
+        out.reserve(static_cast<size_t>(rows));
+        for (int r = 0; r < rows; ++r) {
+            int64_t key = read_int8(PQgetvalue(res, r, 0));
+            out.emplace(key, std::string(PQgetvalue(res, r, 1), PQgetlength(res, r, 1)));
+        }
+    } else {
+        failed = true;
+        error = PQerrorMessage(conn);
     }
-    // borrow a connection for the transaction
-    PGconn* conn = nullptr;
-    {
-        std::unique_lock<std::mutex> lk(p_->pool_mtx);
-        p_->pool_cv.wait(lk, [this](){ return !p_->free_conns.empty(); });
-        conn = p_->free_conns.front(); p_->free_conns.pop();
+    PQclear(res);
+    p_->giveBack(conn);
+    if (failed) throw std::runtime_error("multiGet() failed: " + error);
+    return out;
+}
+
+// Incremental parser for `COPY ... TO STDOUT (FORMAT binary)` of (key bigint, value) rows: an 11-byte
+// signature, flags and a header extension, then per row a field count and length-prefixed fields, ended by
+// a -1 field count. CopyData messages need not align with rows, so unparsed bytes carry over to the next.
+class CopyRowReader {
+public:
+    // Feeds one CopyData message; calls sink per complete row. False once sink stops or the data is malformed.
+    bool feed(const char* data, size_t n, const PersistenceProvider::RowSink& sink) {
+        buf_.append(data, n);
+        size_t pos = 0;
+        bool go = true;
+        while (go && !done_) {
+            if (!header_) {
+                if (buf_.size() - pos < 19) break;
+                if (buf_.compare(pos, 11, "PGCOPY\n\377\r\n\0", 11) != 0) return fail();
+                size_t ext = be32(pos + 15);
+                if (buf_.size() - pos < 19 + ext) break;
+                pos += 19 + ext;
+                header_ = true;
+                continue;
+            }
+            if (buf_.size() - pos < 2) break;
+            int16_t fields = static_cast<int16_t>((static_cast<unsigned char>(buf_[pos]) << 8) | static_cast<unsigned char>(buf_[pos + 1]));
+            if (fields == -1) {
+                done_ = true;
+                break;
+            }
+            if (fields != 2) return fail();
+            // key: length 8 + int8; value: length + bytes
+            if (buf_.size() - pos < 2 + 4 + 8 + 4) break;
+            if (be32(pos + 2) != 8) return fail();
+            int64_t key = read_int8(buf_.data() + pos + 6);
+            uint32_t len = be32(pos + 14);
+            if (len == 0xffffffffu) return fail(); // value is NOT NULL
+            if (buf_.size() - pos < 18 + static_cast<size_t>(len)) break;
+            go = sink(key, std::string(buf_.data() + pos + 18, len));
+            pos += 18 + len;
+        }
+        buf_.erase(0, pos);
+        return go;
+    }
+
+    bool done() const { return done_; }
+    bool malformed() const { return malformed_; }
+
+private:
+    bool fail() {
+        malformed_ = true;
+        return false;
     }
 
-    auto exec_simple = [&](const char* sql) -> bool {
-        PGresult* r = PQexec(conn, sql);
-        bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-        if (!ok) std::cerr << "txn error: " << PQerrorMessage(conn);
+    uint32_t be32(size_t at) const {
+        uint32_t v = 0;
+        for (size_t i = 0; i < 4; ++i) v = (v << 8) | static_cast<unsigned char>(buf_[at + i]);
+        return v;
+    }
+
+    std::string buf_;
+    bool header_{false};
+    bool done_{false};
+    bool malformed_{false};
+};
+
+bool PersistenceAdapter::scanRange(int64_t from, int64_t to, const RowSink& sink)
+{
+    if (!p_) return false;
+    PGconn* conn = p_->borrow();
+    // COPY takes no parameters: the bounds are the only text formatting, once per range
+    std::string sql = "COPY (SELECT key, value FROM kv_store WHERE key BETWEEN " + std::to_string(from) +
+                      " AND " + std::to_string(to) + ") TO STDOUT (FORMAT binary);";
+    PGresult* res = PQexec(conn, sql.c_str());
+    bool ok = PQresultStatus(res) == PGRES_COPY_OUT;
+    PQclear(res);
+    if (!ok) {
+        std::cerr << "scanRange() error: " << PQerrorMessage(conn);
+        p_->giveBack(conn);
+        return false;
+    }
+    CopyRowReader reader;
+    bool stopped = false;
+    char* data = nullptr;
+    int n = 0;
+    while ((n = PQgetCopyData(conn, &data, 0)) > 0) {
+        if (!stopped && !reader.feed(data, static_cast<size_t>(n), sink)) {
+            // malformed rows fail the scan, a sink that stops does not; either way the rest is not needed
+            stopped = true;
+            ok = !reader.malformed();
+            if (PGcancel* cancel = PQgetCancel(conn)) {
+                char err[256];
+                PQcancel(cancel, err, sizeof(err));
+                PQfreeCancel(cancel);
+            }
+        }
+        PQfreemem(data);
+    }
+    // the COPY's final status; a cancelled one reports the cancellation
+    while (PGresult* r = PQgetResult(conn)) {
+        if (!stopped && PQresultStatus(r) != PGRES_COMMAND_OK) {
+            std::cerr << "scanRange() error: " << PQresultErrorMessage(r);
+            ok = false;
+        }
         PQclear(r);
-        return ok;
-    };
+    }
+    if (n == -2 || (!stopped && !reader.done())) ok = false;
+    p_->giveBack(conn);
+    return ok;
+}
 
-    if (!exec_simple("BEGIN")) {
-        result.success = false;
-        result.failures.push_back({Operation{OpType::Insert, 0, ""}, "BEGIN failed"});
-        return result;
+std::optional<std::pair<int64_t, int64_t>> PersistenceAdapter::keyBounds()
+{
+    if (!p_) return std::nullopt;
+    PGconn* conn = p_->borrow();
+    PGresult* res = PQexecParams(conn, "SELECT min(key), max(key) FROM kv_store;", 0, nullptr, nullptr, nullptr, nullptr, 1);
+    std::optional<std::pair<int64_t, int64_t>> out;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1 && !PQgetisnull(res, 0, 0)) {
+        out = std::make_pair(read_int8(PQgetvalue(res, 0, 0)), read_int8(PQgetvalue(res, 0, 1)));
+    } else if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        std::cerr << "keyBounds() error: " << PQerrorMessage(conn);
     }
+    PQclear(res);
+    p_->giveBack(conn);
+    return out;
+}
 
-    int idx = 0;
-    for (const auto& op : ops) {
-        ++idx;
-        auto fail_this = [&](const std::string& msg) {
-            result.failures.push_back({op, msg});
-        };
+std::optional<int64_t> PersistenceAdapter::versionNow()
+{
+    if (!p_) return std::nullopt;
+    PGconn* conn = p_->borrow();
+    PGresult* res = PQexecParams(conn, "SELECT (extract(epoch FROM clock_timestamp()) * 1000000)::bigint;",
+                                 0, nullptr, nullptr, nullptr, nullptr, 1);
+    std::optional<int64_t> out;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) out = read_int8(PQgetvalue(res, 0, 0));
+    else std::cerr << "versionNow() error: " << PQerrorMessage(conn);
+    PQclear(res);
+    p_->giveBack(conn);
+    return out;
+}
+
+std::vector<int64_t> PersistenceAdapter::unchangedSince(const std::vector<int64_t> &keys, int64_t version)
+{
+    std::vector<int64_t> out;
+    if (!p_ || keys.empty()) return out;
+    static constexpr size_t kChunk = 10000;
+    char since[8];
+    put_be64(since, static_cast<uint64_t>(version));
+    PGconn* conn = p_->borrow();
+    for (size_t begin = 0; begin < keys.size(); begin += kChunk) {
+        std::vector<int64_t> chunk(keys.begin() + static_cast<std::ptrdiff_t>(begin),
+                                   keys.begin() + static_cast<std::ptrdiff_t>(std::min(keys.size(), begin + kChunk)));
+        std::string array = int8_array(chunk);
+        const char* params[2] = { array.data(), since };
+        int lengths[2] = { static_cast<int>(array.size()), 8 };
+        int formats[2] = { 1, 1 };
+        PGresult* res = PQexecParams(conn,
+            "SELECT key FROM kv_store WHERE key = ANY($1::bigint[]) "
+            "AND created_at <= 'epoch'::timestamptz + $2::bigint * interval '1 microsecond';",
+            2, nullptr, params, lengths, formats, 1);
+        if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+            for (int r = 0; r < PQntuples(res); ++r) out.push_back(read_int8(PQgetvalue(res, r, 0)));
+        } else {
+            std::cerr << "unchangedSince() error: " << PQerrorMessage(conn);
+        }
+        PQclear(res);
+    }
+    p_->giveBack(conn);
+    return out;
+}
+
+// Run a kv_skey_* statement with the key and the optional value as raw bytes.
+static PGresult* exec_string_key(PGconn* conn, const char* stmt, const std::string& key, const std::string* value) {
+    const char* params[2] = { key.data(), value ? value->data() : nullptr };
+    int lengths[2] = { static_cast<int>(key.size()), value ? static_cast<int>(value->size()) : 0 };
+    int formats[2] = { 1, 1 };
+    return PQexecPrepared(conn, stmt, value ? 2 : 1, params, lengths, formats, 1);
+}
+
+bool PersistenceAdapter::insertStringKey(const std::string &key, const std::string &value)
+{
+    if (!p_ || !p_->string_keys) return false;
+    PGconn* conn = p_->borrow();
+    PGresult* res = exec_string_key(conn, "kv_skey_insert", key, &value);
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) std::cerr << "insertStringKey() error: " << PQerrorMessage(conn);
+    PQclear(res);
+    p_->giveBack(conn);
+    return ok;
+}
+
+bool PersistenceAdapter::updateStringKey(const std::string &key, const std::string &value)
+{
+    if (!p_ || !p_->string_keys) return false;
+    PGconn* conn = p_->borrow();
+    PGresult* res = exec_string_key(conn, "kv_skey_update", key, &value);
+    int affected = 0;
+    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+        affected = affected_rows(res);
+    } else {
+        std::cerr << "updateStringKey() error: " << PQerrorMessage(conn);
+    }
+    PQclear(res);
+    p_->giveBack(conn);
+    return affected > 0;
+}
+
+bool PersistenceAdapter::removeStringKey(const std::string &key)
+{
+    if (!p_ || !p_->string_keys) return false;
+    PGconn* conn = p_->borrow();
+    PGresult* res = exec_string_key(conn, "kv_skey_delete", key, nullptr);
+    int affected = 0;
+    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+        affected = affected_rows(res);
+    } else {
+        std::cerr << "removeStringKey() error: " << PQerrorMessage(conn);
+    }
+    PQclear(res);
+    p_->giveBack(conn);
+    return affected > 0;
+}
+
+std::unique_ptr<std::string> PersistenceAdapter::getStringKey(const std::string &key)
+{
+    if (!p_ || !p_->string_keys) return nullptr;
+    PGconn* conn = p_->borrow();
+    PGresult* res = exec_string_key(conn, "kv_skey_select", key, nullptr);
+    std::unique_ptr<std::string> out;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        if (PQntuples(res) == 1 && PQnfields(res) == 1) {
+            out = std::make_unique<std::string>(PQgetvalue(res, 0, 0), PQgetlength(res, 0, 0));
+        }
+    } else {
+        std::cerr << "getStringKey() error: " << PQerrorMessage(conn);
+    }
+    PQclear(res);
+    p_->giveBack(conn);
+    return out;
+}
+
+// ---- Transactions and pipelining ----
+// Statements of a transaction (and batches of gets) are sent in libpq pipeline mode: up to kPipelineChunk
+// statements go out back to back, closed by a sync point, and their results are read in one pass. Without
+// pipelining (DB_PIPELINE=0 or setPipelining(false)) every statement is its own round-trip.
+static constexpr size_t kPipelineChunk = 256;
+
+// Result of one operation inside a transaction.
+struct OpOutcome {
+    bool ok{false};
+    bool sql_error{false}; // the statement failed, as opposed to affecting no rows
+    bool no_rows{false};   // update/remove matched no row
+    std::string error;
+    std::unique_ptr<std::string> value; // Get only; null if the key does not exist
+};
+
+struct TxOutcome {
+    bool committed{false};
+    std::string error;          // BEGIN/COMMIT failure, empty otherwise
+    std::vector<OpOutcome> ops; // RollbackOnError: ends at the first failed operation
+};
+
+static const char* statement_for(PersistenceAdapter::OpType type) {
+    switch (type) {
+        case PersistenceAdapter::OpType::Insert: return "kv_insert";
+        case PersistenceAdapter::OpType::Update: return "kv_update";
+        case PersistenceAdapter::OpType::Remove: return "kv_delete";
+        case PersistenceAdapter::OpType::Get: break;
+    }
+    return "kv_select";
+}
+
+static const std::string* value_param(const PersistenceAdapter::Operation& op) {
+    bool has_value = op.type == PersistenceAdapter::OpType::Insert || op.type == PersistenceAdapter::OpType::Update;
+    return has_value ? &op.value : nullptr;
+}
+
+static PGresult* exec_op(PGconn* conn, const PersistenceAdapter::Operation& op) {
+    return exec_kv(conn, statement_for(op.type), op.key, value_param(op));
+}
+
+static bool send_op(PGconn* conn, const PersistenceAdapter::Operation& op) {
+    return send_kv(conn, statement_for(op.type), op.key, value_param(op));
+}
+
+static OpOutcome interpret_op(PGresult* r, PersistenceAdapter::OpType type) {
+    OpOutcome out;
+    ExecStatusType st = PQresultStatus(r);
+    if (type == PersistenceAdapter::OpType::Get) {
+        if (st == PGRES_TUPLES_OK) {
+            out.ok = true;
+            if (PQntuples(r) == 1 && PQnfields(r) == 1) {
+                out.value = std::make_unique<std::string>(PQgetvalue(r, 0, 0), PQgetlength(r, 0, 0));
+            }
+        }
+    } else if (st == PGRES_COMMAND_OK) {
+        out.ok = true;
+        if (type != PersistenceAdapter::OpType::Insert) {
+            if (affected_rows(r) == 0) {
+                out.ok = false;
+                out.no_rows = true;
+                out.error = "no rows affected";
+            }
+        }
+    }
+    if (!out.ok && out.error.empty()) {
+        out.sql_error = true;
+        if (!r) out.error = "connection lost";
+        else if (st == PGRES_PIPELINE_ABORTED) out.error = "aborted by an earlier failure in the pipeline";
+        else out.error = PQresultErrorMessage(r);
+    }
+    return out;
+}
+
+// Next result of a pipeline. Statement results are followed by a null marker, which is consumed here;
+// sync point results are not.
+static PGresult* next_pipeline_result(PGconn* conn) {
+    PGresult* r = PQgetResult(conn);
+    if (r && PQresultStatus(r) != PGRES_PIPELINE_SYNC) {
+        if (PGresult* extra = PQgetResult(conn)) PQclear(extra);
+    }
+    return r;
+}
+
+static bool exec_command(PGconn* conn, const std::string& sql) {
+    PGresult* r = PQexec(conn, sql.c_str());
+    bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
+    if (!ok) std::cerr << "txn error: " << PQerrorMessage(conn);
+    PQclear(r);
+    return ok;
+}
+
+// One round-trip per statement. Silent mode wraps every operation in a savepoint so a failed statement
+// does not abort the transaction.
+static TxOutcome run_transaction_sequential(PGconn* conn, const std::vector<PersistenceAdapter::Operation>& ops,
+                                            PersistenceAdapter::TxMode mode) {
+    TxOutcome tx;
+    const bool silent = mode == PersistenceAdapter::TxMode::Silent;
+    if (!exec_command(conn, "BEGIN")) {
+        tx.error = "BEGIN failed";
+        return tx;
+    }
+    for (size_t i = 0; i < ops.size(); ++i) {
+        std::string sp = "sp_" + std::to_string(i + 1);
+        if (silent && !exec_command(conn, "SAVEPOINT " + sp)) {
+            OpOutcome failed;
+            failed.error = "SAVEPOINT failed";
+            tx.ops.push_back(std::move(failed));
+            continue; // best effort
+        }
+        PGresult* r = exec_op(conn, ops[i]);
+        OpOutcome out = interpret_op(r, ops[i].type);
+        PQclear(r);
+        bool ok = out.ok;
+        tx.ops.push_back(std::move(out));
+        if (silent) {
+            if (!ok) exec_command(conn, "ROLLBACK TO SAVEPOINT " + sp);
+            exec_command(conn, "RELEASE SAVEPOINT " + sp);
+        } else if (!ok) {
+            exec_command(conn, "ROLLBACK");
+            return tx;
+        }
+    }
+    tx.committed = exec_command(conn, "COMMIT");
+    if (!tx.committed) tx.error = "COMMIT failed";
+    return tx;
+}
 
-        if (mode == TxMode::Silent) {
-            // savepoint per-op
-            std::ostringstream sp;
-            sp << "SAVEPOINT sp_" << idx;
-            if (!exec_simple(sp.str().c_str())) {
-                fail_this("SAVEPOINT failed");
-                continue; // best effort
+// BEGIN and the operations go out in pipelined chunks, then COMMIT or ROLLBACK as one more round-trip.
+// Operations that affect no rows leave no trace, so Silent mode needs no savepoints unless a statement
+// fails outright; then the transaction is rolled back and false is returned so the caller can rerun it
+// sequentially. Also returns false if the connection cannot enter pipeline mode.
+static bool run_transaction_pipelined(PGconn* conn, const std::vector<PersistenceAdapter::Operation>& ops,
+                                      PersistenceAdapter::TxMode mode, TxOutcome& tx) {
+    if (PQenterPipelineMode(conn) != 1) return false;
+    const bool silent = mode == PersistenceAdapter::TxMode::Silent;
+    bool began = false;
+    bool failed = false;   // roll back instead of committing
+    bool rerun = false;    // Silent mode hit a statement error
+    bool broken = false;   // the pipeline could not be sent or read
+    size_t next = 0;
+    for (bool first = true; !failed && !broken && (first || next < ops.size()); first = false) {
+        size_t end = std::min(ops.size(), next + kPipelineChunk);
+        bool sent = !first || PQsendQueryParams(conn, "BEGIN", 0, nullptr, nullptr, nullptr, nullptr, 0) == 1;
+        for (size_t i = next; sent && i < end; ++i) sent = send_op(conn, ops[i]);
+        if (!sent || PQpipelineSync(conn) != 1) {
+            std::cerr << "txn pipeline error: " << PQerrorMessage(conn);
+            broken = true;
+            break;
+        }
+        if (first) {
+            PGresult* r = next_pipeline_result(conn);
+            began = PQresultStatus(r) == PGRES_COMMAND_OK;
+            PQclear(r);
+            failed = !began;
+        }
+        for (size_t i = next; i < end; ++i) {
+            PGresult* r = next_pipeline_result(conn);
+            OpOutcome out = interpret_op(r, ops[i].type);
+            PQclear(r);
+            if (!r) broken = true;
+            if (failed) continue; // drain results after the first failure
+            if (!out.ok && (!silent || out.sql_error)) {
+                failed = true;
+                rerun = silent;
             }
+            if (!rerun) tx.ops.push_back(std::move(out));
+        }
+        PGresult* sync = broken ? nullptr : PQgetResult(conn);
+        if (sync) PQclear(sync);
+        next = end;
+    }
+    PQexitPipelineMode(conn);
+    if (!began) {
+        tx.error = "BEGIN failed";
+        if (broken) exec_command(conn, "ROLLBACK");
+        return true;
+    }
+    if (failed || broken) {
+        exec_command(conn, "ROLLBACK");
+        if (broken && !rerun) tx.error = "pipeline failed";
+        if (rerun) tx.ops.clear();
+        return !rerun;
+    }
+    tx.committed = exec_command(conn, "COMMIT");
+    if (!tx.committed) tx.error = "COMMIT failed";
+    return true;
+}
+
+static TxOutcome run_transaction_on(PGconn* conn, const std::vector<PersistenceAdapter::Operation>& ops,
+                                    PersistenceAdapter::TxMode mode, bool pipeline) {
+    if (pipeline) {
+        TxOutcome tx;
+        if (run_transaction_pipelined(conn, ops, mode, tx)) return tx;
+    }
+    return run_transaction_sequential(conn, ops, mode);
+}
+
+// Run kv_select for every key in one pipeline; falls back to one round-trip per key. Keys whose result
+// was never read (the pipeline broke) are left failed.
+static std::vector<OpOutcome> get_pipelined(PGconn* conn, const std::vector<int64_t>& keys) {
+    std::vector<OpOutcome> out(keys.size());
+    PersistenceAdapter::Operation op{PersistenceAdapter::OpType::Get, 0, ""};
+    bool pipelined = PQenterPipelineMode(conn) == 1;
+    if (pipelined) {
+        bool sent = true;
+        for (size_t i = 0; sent && i < keys.size(); ++i) {
+            op.key = keys[i];
+            sent = send_op(conn, op);
+        }
+        bool broken = !sent || PQpipelineSync(conn) != 1;
+        for (size_t i = 0; !broken && i < keys.size(); ++i) {
+            PGresult* r = next_pipeline_result(conn);
+            out[i] = interpret_op(r, op.type);
+            broken = !r;
+            PQclear(r);
+        }
+        if (!broken) {
+            if (PGresult* sync = PQgetResult(conn)) PQclear(sync);
+        } else {
+            std::string error = PQerrorMessage(conn);
+            for (OpOutcome& o : out) {
+                if (!o.ok && o.error.empty()) o.error = error.empty() ? "connection lost" : error;
+            }
+        }
+        PQexitPipelineMode(conn);
+        return out;
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        op.key = keys[i];
+        PGresult* r = exec_op(conn, op);
+        out[i] = interpret_op(r, op.type);
+        PQclear(r);
+    }
+    return out;
+}
+
+// JSON report of a transaction (shape documented on runTransactionJson).
+static nlohmann::json tx_report(const std::vector<PersistenceAdapter::Operation>& ops, PersistenceAdapter::TxMode mode,
+                                const TxOutcome& tx) {
+    using OpType = PersistenceAdapter::OpType;
+    nlohmann::json report;
+    report["mode"] = (mode == PersistenceAdapter::TxMode::Silent) ? "silent" : "rollback";
+    report["success"] = tx.committed;
+    report["results"] = nlohmann::json::array();
+
+    auto push_result = [&](OpType type, int64_t key, const char* status, const std::string& error, const nlohmann::json& value) {
+        nlohmann::json item;
+        item["op"] = (type == OpType::Insert) ? "insert" : (type == OpType::Update) ? "update" : (type == OpType::Remove) ? "remove" : "get";
+        item["key"] = key;
+        item["status"] = status;
+        if (!error.empty()) item["error"] = error;
+        if (type == OpType::Get) item["value"] = value; // may be string or null
+        report["results"].push_back(std::move(item));
+    };
+
+    for (size_t i = 0; i < tx.ops.size() && i < ops.size(); ++i) {
+        const OpOutcome& out = tx.ops[i];
+        nlohmann::json value = nullptr;
+        if (out.value) value = *out.value;
+        push_result(ops[i].type, ops[i].key, out.ok ? "ok" : "failed", out.error, value);
+    }
+    if (!tx.error.empty()) push_result(OpType::Insert, 0, "failed", tx.error, nullptr);
+    return report;
+}
+
+// ---- Event-driven async engine ----
+// getAsync and runTransactionJsonAsync run on dedicated connections that stay in non-blocking pipeline mode.
+// Each connection belongs to one epoll loop thread, which sends queries with PQsendQueryPrepared as soon as
+// they are submitted, flushes on EPOLLOUT, and reads with PQconsumeInput/PQgetResult on EPOLLIN, matching
+// results to requests in send order. A loop keeps up to kEngineInFlight statements outstanding per
+// connection, so a few threads drive hundreds of concurrent queries.
+//  - Every get is followed by its own sync point, so one failing statement cannot abort its neighbours.
+//  - A transaction sends BEGIN and its operations back to back, then COMMIT or ROLLBACK once the results are
+//    in. Between BEGIN and that decision nothing else is sent on the connection; gets queue up behind it.
+//  - Silent transactions with a statement error are rolled back and rerun with savepoints through rerun.
+//  - A broken connection fails its outstanding requests (null value, "connection lost") and is closed; when
+//    no connection is left, submissions are refused and callers use the worker pool.
+static constexpr size_t kEngineInFlight = 2 * kPipelineChunk;
 
-            auto release_sp = [&]() {
-                std::ostringstream rel; rel << "RELEASE SAVEPOINT sp_" << idx; exec_simple(rel.str().c_str());
-            };
-            auto rollback_sp = [&]() {
-                std::ostringstream rb; rb << "ROLLBACK TO SAVEPOINT sp_" << idx; exec_simple(rb.str().c_str());
-                // release after rollback to clear savepoint
-                std::ostringstream rel; rel << "RELEASE SAVEPOINT sp_" << idx; exec_simple(rel.str().c_str());
-            };
-
-            bool ok = false;
-            int affected = 0;
-            // execute op
-            if (op.type == OpType::Insert) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[2] = { keyStr.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_insert", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (!ok) fail_this(PQerrorMessage(p_->conn));
-                else {
-                    const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 1; // treat insert as success even if 0 reported
+#if defined(__linux__)
+class AsyncEngine {
+public:
+    using GetPromise = std::shared_ptr<std::promise<std::unique_ptr<std::string>>>;
+    using TxPromise = std::shared_ptr<std::promise<nlohmann::json>>;
+    using Rerun = std::function<void(const std::vector<PersistenceAdapter::Operation>&, PersistenceAdapter::TxMode, TxPromise)>;
+
+    AsyncEngine(std::vector<PGconn*> conns, int io_threads, Rerun rerun) : rerun_(std::move(rerun)) {
+        size_t loops = std::min(conns.size(), static_cast<size_t>(io_threads > 0 ? io_threads : 1));
+        for (size_t i = 0; i < loops; ++i) loops_.push_back(std::make_unique<Loop>());
+        for (size_t i = 0; i < conns.size(); ++i) {
+            auto c = std::make_unique<Conn>();
+            c->pg = conns[i];
+            c->fd = PQsocket(conns[i]);
+            loops_[i % loops]->conns.push_back(std::move(c));
+        }
+        live_.store(static_cast<int>(conns.size()));
+        for (auto& loop : loops_) {
+            Loop* l = loop.get();
+            l->epfd = epoll_create1(EPOLL_CLOEXEC);
+            l->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr;
+            epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->wakefd, &ev);
+            for (auto& c : l->conns) {
+                if (PQsetnonblocking(c->pg, 1) != 0 || PQenterPipelineMode(c->pg) != 1) {
+                    std::cerr << "async engine: cannot enter pipeline mode: " << PQerrorMessage(c->pg);
+                    close(*l, *c);
+                    continue;
                 }
-                PQclear(r);
-            } else if (op.type == OpType::Update) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[2] = { keyStr.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_update", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) {
-                    const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0;
-                    if (affected == 0) { ok = false; fail_this("no rows affected"); }
-                } else {
-                    fail_this(PQerrorMessage(p_->conn));
+                ev.events = EPOLLIN;
+                ev.data.ptr = c.get();
+                epoll_ctl(l->epfd, EPOLL_CTL_ADD, c->fd, &ev);
+            }
+            l->thread = std::thread([this, l]() { run(*l); });
+        }
+    }
+
+    ~AsyncEngine() {
+        for (auto& loop : loops_) {
+            {
+                std::lock_guard<std::mutex> lk(loop->mtx);
+                loop->stop = true;
+            }
+            wake(*loop);
+        }
+        for (auto& loop : loops_) {
+            if (loop->thread.joinable()) loop->thread.join();
+            ::close(loop->epfd);
+            ::close(loop->wakefd);
+        }
+    }
+
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    // Both return false (and leave the promise alone) when no connection is left.
+    bool submitGet(int64_t key, GetPromise promise) {
+        auto job = std::make_shared<Job>();
+        job->key = key;
+        job->get_promise = std::move(promise);
+        return submit(std::move(job));
+    }
+
+    bool submitTransaction(const std::vector<PersistenceAdapter::Operation>& ops, PersistenceAdapter::TxMode mode,
+                           TxPromise promise) {
+        auto job = std::make_shared<Job>();
+        job->txn = true;
+        job->ops = ops;
+        job->mode = mode;
+        job->tx_promise = std::move(promise);
+        return submit(std::move(job));
+    }
+
+    nlohmann::json metrics() const {
+        nlohmann::json j;
+        j["connections"] = live_.load();
+        j["io_threads"] = static_cast<int>(loops_.size());
+        j["in_flight"] = in_flight_.load();
+        j["completed"] = completed_.load();
+        return j;
+    }
+
+private:
+    struct Job {
+        bool txn{false};
+        bool done{false};
+        // get
+        int64_t key{0};
+        GetPromise get_promise;
+        // transaction
+        std::vector<PersistenceAdapter::Operation> ops;
+        PersistenceAdapter::TxMode mode{PersistenceAdapter::TxMode::RollbackOnError};
+        TxPromise tx_promise;
+        TxOutcome tx;
+        bool began{false};
+        bool failed{false};
+        bool rerun{false};
+        bool committing{false};
+    };
+
+    // One expected result on a connection, in send order.
+    struct Expect {
+        enum Kind { Get, Sync, Begin, Op, TxSync, End } kind;
+        std::shared_ptr<Job> job;
+        size_t index{0};
+    };
+
+    struct Conn {
+        PGconn* pg{nullptr};
+        int fd{-1};
+        std::deque<Expect> expected;
+        bool exclusive{false};     // a transaction awaits its COMMIT/ROLLBACK decision
+        bool awaiting_null{false}; // a statement result was read; its null terminator comes next
+        bool writing{false};       // EPOLLOUT registered
+    };
+
+    struct Loop {
+        std::vector<std::unique_ptr<Conn>> conns;
+        std::thread thread;
+        int epfd{-1};
+        int wakefd{-1};
+        std::mutex mtx;
+        std::vector<std::shared_ptr<Job>> incoming; // guarded by mtx
+        bool stop{false};                            // guarded by mtx
+        std::deque<std::shared_ptr<Job>> waiting;    // loop thread only
+    };
+
+    bool submit(std::shared_ptr<Job> job) {
+        if (live_.load() == 0) return false;
+        in_flight_.fetch_add(1);
+        Loop& loop = *loops_[next_loop_.fetch_add(1) % loops_.size()];
+        {
+            std::lock_guard<std::mutex> lk(loop.mtx);
+            loop.incoming.push_back(std::move(job));
+        }
+        wake(loop);
+        return true;
+    }
+
+    static void wake(Loop& loop) {
+        uint64_t one = 1;
+        ssize_t n = ::write(loop.wakefd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void run(Loop& loop) {
+        epoll_event events[64];
+        for (;;) {
+            int n = epoll_wait(loop.epfd, events, 64, -1);
+            if (n < 0 && errno != EINTR) break;
+            for (int i = 0; i < n; ++i) {
+                if (!events[i].data.ptr) {
+                    uint64_t count;
+                    ssize_t r = ::read(loop.wakefd, &count, sizeof(count));
+                    (void)r;
+                    continue;
                 }
-                PQclear(r);
-            } else if (op.type == OpType::Remove) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[1] = { keyStr.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_delete", 1, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) {
-                    const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0;
-                    if (affected == 0) { ok = false; fail_this("no rows affected"); }
-                } else {
-                    fail_this(PQerrorMessage(p_->conn));
+                Conn& c = *static_cast<Conn*>(events[i].data.ptr);
+                if (!c.pg) continue;
+                if (events[i].events & EPOLLOUT) flush(loop, c);
+                if (c.pg && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+                    if (PQconsumeInput(c.pg) != 1) {
+                        broken(loop, c);
+                        continue;
+                    }
+                    drain(loop, c);
                 }
-                PQclear(r);
             }
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lk(loop.mtx);
+                for (auto& job : loop.incoming) loop.waiting.push_back(std::move(job));
+                loop.incoming.clear();
+                stop = loop.stop;
+            }
+            if (stop) break;
+            dispatch(loop);
+        }
+        for (auto& job : loop.waiting) fail(job);
+        loop.waiting.clear();
+        for (auto& c : loop.conns) {
+            if (c->pg) close(loop, *c);
+        }
+    }
 
-            if (!ok) {
-                rollback_sp();
-                continue; // continue with next op
-            } else {
-                release_sp();
+    // Send waiting jobs, oldest first, each to the open connection with the fewest outstanding results.
+    void dispatch(Loop& loop) {
+        while (!loop.waiting.empty()) {
+            std::shared_ptr<Job> job = loop.waiting.front();
+            Conn* best = nullptr;
+            bool any_live = false;
+            for (auto& c : loop.conns) {
+                if (!c->pg) continue;
+                any_live = true;
+                if (c->exclusive || c->expected.size() >= kEngineInFlight) continue;
+                if (!best || c->expected.size() < best->expected.size()) best = c.get();
+            }
+            if (!any_live) {
+                for (auto& j : loop.waiting) fail(j);
+                loop.waiting.clear();
+                return;
+            }
+            if (!best) return; // resumes when results free a connection
+            loop.waiting.pop_front();
+            bool sent = job->txn ? sendTransaction(*best, job) : sendGet(*best, job);
+            if (!sent) {
+                std::cerr << "async engine: send failed: " << PQerrorMessage(best->pg);
+                broken(loop, *best);
+                continue;
             }
+            flush(loop, *best);
+        }
+    }
+
+    static bool sendGet(Conn& c, const std::shared_ptr<Job>& job) {
+        c.expected.push_back({Expect::Get, job, 0});
+        c.expected.push_back({Expect::Sync, nullptr, 0});
+        PersistenceAdapter::Operation op{PersistenceAdapter::OpType::Get, job->key, ""};
+        return send_op(c.pg, op) && PQpipelineSync(c.pg) == 1;
+    }
+
+    static bool sendTransaction(Conn& c, const std::shared_ptr<Job>& job) {
+        c.exclusive = true;
+        c.expected.push_back({Expect::Begin, job, 0});
+        for (size_t i = 0; i < job->ops.size(); ++i) c.expected.push_back({Expect::Op, job, i});
+        c.expected.push_back({Expect::TxSync, job, 0});
+        bool sent = PQsendQueryParams(c.pg, "BEGIN", 0, nullptr, nullptr, nullptr, nullptr, 0) == 1;
+        for (size_t i = 0; sent && i < job->ops.size(); ++i) sent = send_op(c.pg, job->ops[i]);
+        return sent && PQpipelineSync(c.pg) == 1;
+    }
 
-        } else { // RollbackOnError
-            bool ok = true; int affected = 0;
-            if (op.type == OpType::Insert) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[2] = { keyStr.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_insert", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (!ok) fail_this(PQerrorMessage(p_->conn));
+    void flush(Loop& loop, Conn& c) {
+        int rc = PQflush(c.pg);
+        if (rc < 0) {
+            broken(loop, c);
+            return;
+        }
+        bool want = rc == 1;
+        if (want == c.writing) return;
+        c.writing = want;
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want ? EPOLLOUT : 0u);
+        ev.data.ptr = &c;
+        epoll_ctl(loop.epfd, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+
+    // Read every result that is complete without blocking.
+    void drain(Loop& loop, Conn& c) {
+        while (c.pg && !PQisBusy(c.pg)) {
+            PGresult* r = PQgetResult(c.pg);
+            if (!r) {
+                if (!c.awaiting_null) break;
+                c.awaiting_null = false;
+                continue;
+            }
+            if (c.expected.empty()) {
                 PQclear(r);
-            } else if (op.type == OpType::Update) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[2] = { keyStr.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_update", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) {
-                    const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0;
-                    if (affected == 0) { ok = false; fail_this("no rows affected"); }
-                } else {
-                    fail_this(PQerrorMessage(p_->conn));
+                continue;
+            }
+            Expect e = std::move(c.expected.front());
+            c.expected.pop_front();
+            if (PQresultStatus(r) != PGRES_PIPELINE_SYNC) c.awaiting_null = true;
+            handle(loop, c, e, r);
+            PQclear(r);
+        }
+        if (c.pg && PQstatus(c.pg) == CONNECTION_BAD) broken(loop, c);
+    }
+
+    void handle(Loop& loop, Conn& c, const Expect& e, PGresult* r) {
+        if (e.kind == Expect::Sync) return;
+        Job& job = *e.job;
+        switch (e.kind) {
+            case Expect::Sync:
+                break;
+            case Expect::Get:
+                completeGet(job, interpret_op(r, PersistenceAdapter::OpType::Get));
+                break;
+            case Expect::Begin:
+                job.began = PQresultStatus(r) == PGRES_COMMAND_OK;
+                job.failed = !job.began;
+                break;
+            case Expect::Op: {
+                OpOutcome out = interpret_op(r, job.ops[e.index].type);
+                if (job.failed) break; // drain results after the first failure
+                const bool silent = job.mode == PersistenceAdapter::TxMode::Silent;
+                if (!out.ok && (!silent || out.sql_error)) {
+                    job.failed = true;
+                    job.rerun = silent;
                 }
-                PQclear(r);
-            } else if (op.type == OpType::Remove) {
-                std::string keyStr = std::to_string(op.key);
-                const char* params[1] = { keyStr.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_delete", 1, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) {
-                    const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0;
-                    if (affected == 0) { ok = false; fail_this("no rows affected"); }
-                } else {
-                    fail_this(PQerrorMessage(p_->conn));
+                if (!job.rerun) job.tx.ops.push_back(std::move(out));
+                break;
+            }
+            case Expect::TxSync: {
+                job.committing = job.began && !job.failed;
+                c.expected.push_back({Expect::End, e.job, 0});
+                c.expected.push_back({Expect::Sync, nullptr, 0});
+                const char* sql = job.committing ? "COMMIT" : "ROLLBACK";
+                bool sent = PQsendQueryParams(c.pg, sql, 0, nullptr, nullptr, nullptr, nullptr, 0) == 1 &&
+                            PQpipelineSync(c.pg) == 1;
+                c.exclusive = false;
+                if (sent) flush(loop, c);
+                else broken(loop, c);
+                break;
+            }
+            case Expect::End:
+                if (job.committing) {
+                    job.tx.committed = PQresultStatus(r) == PGRES_COMMAND_OK;
+                    if (!job.tx.committed) job.tx.error = "COMMIT failed";
+                } else if (job.rerun) {
+                    job.done = true;
+                    finished();
+                    rerun_(job.ops, job.mode, job.tx_promise);
+                    break;
+                } else if (!job.began) {
+                    job.tx.error = "BEGIN failed";
                 }
-                PQclear(r);
+                completeTransaction(job);
+                break;
+        }
+    }
+
+    void completeGet(Job& job, OpOutcome out) {
+        if (job.done) return;
+        job.done = true;
+        finished();
+        if (out.ok) job.get_promise->set_value(std::move(out.value));
+        else job.get_promise->set_exception(std::make_exception_ptr(std::runtime_error("get() failed: " + out.error)));
+    }
+
+    void completeTransaction(Job& job) {
+        if (job.done) return;
+        job.done = true;
+        finished();
+        job.tx_promise->set_value(tx_report(job.ops, job.mode, job.tx));
+    }
+
+    void fail(const std::shared_ptr<Job>& job) {
+        if (!job || job->done) return;
+        if (!job->txn) {
+            OpOutcome lost;
+            lost.error = "connection lost";
+            completeGet(*job, std::move(lost));
+            return;
+        }
+        job->tx.committed = false;
+        job->tx.error = "connection lost";
+        completeTransaction(*job);
+    }
+
+    void finished() {
+        in_flight_.fetch_sub(1);
+        completed_.fetch_add(1);
+    }
+
+    // Fail everything outstanding on the connection and close it.
+    void broken(Loop& loop, Conn& c) {
+        if (!c.pg) return;
+        std::cerr << "async engine: dropping connection: " << PQerrorMessage(c.pg);
+        std::deque<Expect> pending;
+        pending.swap(c.expected);
+        close(loop, c);
+        for (auto& e : pending) fail(e.job);
+    }
+
+    void close(Loop& loop, Conn& c) {
+        for (auto& e : c.expected) fail(e.job);
+        c.expected.clear();
+        epoll_ctl(loop.epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+        PQfinish(c.pg);
+        c.pg = nullptr;
+        c.exclusive = false;
+        live_.fetch_sub(1);
+    }
+
+    Rerun rerun_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::atomic<size_t> next_loop_{0};
+    std::atomic<int> live_{0};
+    std::atomic<int64_t> in_flight_{0};
+    std::atomic<uint64_t> completed_{0};
+};
+
+#else
+// epoll is Linux-only: elsewhere the engine refuses every submission and the worker pool serves async calls.
+class AsyncEngine {
+public:
+    using TxPromise = std::shared_ptr<std::promise<nlohmann::json>>;
+    using Rerun = std::function<void(const std::vector<PersistenceAdapter::Operation>&, PersistenceAdapter::TxMode, TxPromise)>;
+
+    AsyncEngine(std::vector<PGconn*> conns, int, Rerun) {
+        for (PGconn* c : conns) PQfinish(c);
+    }
+    bool submitGet(int64_t, std::shared_ptr<std::promise<std::unique_ptr<std::string>>>) { return false; }
+    bool submitTransaction(const std::vector<PersistenceAdapter::Operation>&, PersistenceAdapter::TxMode, TxPromise) {
+        return false;
+    }
+    nlohmann::json metrics() const { return nlohmann::json{{"connections", 0}}; }
+};
+#endif
+
+PersistenceAdapter::Impl::Impl() = default;
+PersistenceAdapter::Impl::~Impl() = default;
+
+void PersistenceAdapter::Impl::startEngine(std::vector<PGconn*> conns, int io_threads) {
+    // Silent transactions that hit a statement error finish on the worker pool with savepoints.
+    auto rerun = [this](const std::vector<Operation>& ops, TxMode mode, AsyncEngine::TxPromise promise) {
+        {
+            std::lock_guard<std::mutex> lg(tasks_mtx);
+            tasks.emplace([this, ops, mode, promise]() {
+                PGconn* c = borrow();
+                TxOutcome tx = run_transaction_sequential(c, ops, mode);
+                giveBack(c);
+                promise->set_value(tx_report(ops, mode, tx));
+            });
+        }
+        tasks_cv.notify_one();
+    };
+    engine = std::make_unique<AsyncEngine>(std::move(conns), io_threads, rerun);
+}
+
+void PersistenceAdapter::Impl::stopEngine() {
+    engine.reset();
+}
+
+nlohmann::json PersistenceAdapter::Impl::engineMetrics() const {
+    return engine ? engine->metrics() : nlohmann::json::object();
+}
+
+// ---- Write batching (group commit) ----
+// insert/update/remove calls that arrive together are committed in one transaction, so PostgreSQL flushes
+// its WAL once per batch instead of once per write. A batch closes after the window (measured from its first
+// write) or at max_ops writes, and is cut into runs of one operation type with distinct keys; each run is one
+// multi-row statement over unnest/ANY arrays, and every caller gets its own outcome: inserts succeed with
+// their statement, updates and removes succeed if RETURNING lists their key. Runs keep arrival order, so
+// writes to the same key apply in the order they were submitted. If a statement fails, the transaction is
+// rolled back and the batch replays one autocommit statement per write, so one bad write fails alone.
+
+class WriteBatcher {
+public:
+    using OpType = PersistenceAdapter::OpType;
+
+    WriteBatcher(size_t max_ops, std::chrono::microseconds window, const std::atomic<bool>& pipeline, Oid value_oid,
+                 std::function<PGconn*()> borrow, std::function<void(PGconn*)> give_back)
+        : pipeline_(pipeline), value_oid_(value_oid), borrow_(std::move(borrow)), give_back_(std::move(give_back)) {
+        configure(max_ops, window);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    // Flushes writes still queued before returning.
+    ~WriteBatcher() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    WriteBatcher(const WriteBatcher&) = delete;
+    WriteBatcher& operator=(const WriteBatcher&) = delete;
+
+    void configure(size_t max_ops, std::chrono::microseconds window) {
+        max_ops_.store(max_ops);
+        window_us_.store(window.count() > 0 ? window.count() : 0);
+        cv_.notify_one();
+    }
+
+    bool enabled() const { return max_ops_.load() > 1; }
+
+    std::future<bool> submit(OpType type, int64_t key, const std::string& value) {
+        Write w{type, key, value, std::promise<bool>()};
+        std::future<bool> fut = w.done.get_future();
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            queue_.push_back(std::move(w));
+        }
+        cv_.notify_one();
+        return fut;
+    }
+
+    nlohmann::json metrics() const {
+        nlohmann::json j;
+        j["max_ops"] = max_ops_.load();
+        j["window_us"] = window_us_.load();
+        j["batches"] = batches_.load();
+        j["writes"] = writes_.load();
+        j["fallbacks"] = fallbacks_.load();
+        return j;
+    }
+
+private:
+    struct Write {
+        OpType type;
+        int64_t key;
+        std::string value;
+        std::promise<bool> done;
+    };
+
+    // Consecutive writes [begin, end) of one type with distinct keys.
+    struct Run {
+        OpType type;
+        size_t begin;
+        size_t end;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mtx_);
+        for (;;) {
+            cv_.wait(lk, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return; // stopping with nothing left
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(window_us_.load());
+            cv_.wait_until(lk, deadline, [this]() { return stop_ || queue_.size() >= std::max<size_t>(max_ops_.load(), 1); });
+            size_t n = std::min(queue_.size(), std::max<size_t>(max_ops_.load(), 1));
+            std::vector<Write> batch(std::make_move_iterator(queue_.begin()),
+                                     std::make_move_iterator(queue_.begin() + static_cast<std::ptrdiff_t>(n)));
+            queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(n));
+            lk.unlock();
+            execute(batch);
+            lk.lock();
+        }
+    }
+
+    void execute(std::vector<Write>& batch) {
+        std::vector<Run> runs;
+        std::unordered_set<int64_t> run_keys;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (runs.empty() || runs.back().type != batch[i].type || !run_keys.insert(batch[i].key).second) {
+                runs.push_back(Run{batch[i].type, i, i});
+                run_keys.clear();
+                run_keys.insert(batch[i].key);
             }
+            runs.back().end = i + 1;
+        }
 
-            if (!ok) {
-                exec_simple("ROLLBACK");
-                result.success = false;
-                return result;
+        std::vector<char> ok(batch.size(), 0);
+        PGconn* conn = borrow_();
+        bool committed = false;
+        try {
+            committed = commitRuns(conn, batch, runs, ok);
+            if (!committed) {
+                fallbacks_.fetch_add(1);
+                std::fill(ok.begin(), ok.end(), 0);
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    PGresult* r = exec_op(conn, PersistenceAdapter::Operation{batch[i].type, batch[i].key, batch[i].value});
+                    ok[i] = interpret_op(r, batch[i].type).ok;
+                    PQclear(r);
+                }
             }
+        } catch (...) {}
+        give_back_(conn);
+        batches_.fetch_add(1);
+        writes_.fetch_add(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) batch[i].done.set_value(ok[i] != 0);
+    }
+
+    static const char* statementFor(OpType type) {
+        return type == OpType::Insert ? "kv_batch_insert" : type == OpType::Update ? "kv_batch_update" : "kv_batch_delete";
+    }
+
+    // Binary array parameters of a run: keys, plus values for inserts and updates.
+    std::vector<std::string> runParams(const std::vector<Write>& batch, const Run& run) const {
+        std::vector<int64_t> keys;
+        std::vector<const std::string*> values;
+        for (size_t i = run.begin; i < run.end; ++i) {
+            keys.push_back(batch[i].key);
+            values.push_back(&batch[i].value);
         }
+        std::vector<std::string> params{int8_array(keys)};
+        if (run.type != OpType::Remove) params.push_back(bytes_array(value_oid_, values));
+        return params;
     }
 
-    if (!exec_simple("COMMIT")) {
+    // Per-write outcomes of one run's statement; false if the statement failed.
+    static bool applyResult(PGresult* r, const std::vector<Write>& batch, const Run& run, std::vector<char>& ok) {
+        ExecStatusType st = PQresultStatus(r);
+        if (run.type == OpType::Insert) {
+            if (st != PGRES_COMMAND_OK) return false;
+            std::fill(ok.begin() + static_cast<std::ptrdiff_t>(run.begin), ok.begin() + static_cast<std::ptrdiff_t>(run.end), 1);
+            return true;
+        }
+        if (st != PGRES_TUPLES_OK) return false;
+        std::unordered_set<int64_t> touched;
+        for (int row = 0; row < PQntuples(r); ++row) touched.insert(read_int8(PQgetvalue(r, row, 0)));
+        for (size_t i = run.begin; i < run.end; ++i) ok[i] = touched.count(batch[i].key) ? 1 : 0;
+        return true;
+    }
+
+    // BEGIN, one statement per run and COMMIT: one pipeline when pipelining is on, one round-trip each
+    // otherwise. Returns false (after rolling back) if any of them failed.
+    bool commitRuns(PGconn* conn, const std::vector<Write>& batch, const std::vector<Run>& runs, std::vector<char>& ok) {
+        std::vector<std::vector<std::string>> params;
+        params.reserve(runs.size());
+        for (const Run& run : runs) params.push_back(runParams(batch, run));
+        struct Bound {
+            std::array<const char*, 2> values{};
+            std::array<int, 2> lengths{};
+            std::array<int, 2> formats{1, 1};
+        };
+        auto bind = [](const std::vector<std::string>& p) {
+            Bound b;
+            for (size_t k = 0; k < p.size(); ++k) {
+                b.values[k] = p[k].data();
+                b.lengths[k] = static_cast<int>(p[k].size());
+            }
+            return b;
+        };
+
+        bool good = true;
+        if (pipeline_.load() && PQenterPipelineMode(conn) == 1) {
+            bool sent = PQsendQueryParams(conn, "BEGIN", 0, nullptr, nullptr, nullptr, nullptr, 0) == 1;
+            for (size_t i = 0; sent && i < runs.size(); ++i) {
+                Bound b = bind(params[i]);
+                sent = PQsendQueryPrepared(conn, statementFor(runs[i].type), static_cast<int>(params[i].size()),
+                                           b.values.data(), b.lengths.data(), b.formats.data(), 1) == 1;
+            }
+            sent = sent && PQsendQueryParams(conn, "COMMIT", 0, nullptr, nullptr, nullptr, nullptr, 0) == 1;
+            if (sent && PQpipelineSync(conn) == 1) {
+                for (size_t i = 0; i < runs.size() + 2; ++i) {
+                    PGresult* r = next_pipeline_result(conn);
+                    if (!r) {
+                        good = false;
+                        break;
+                    }
+                    if (i == 0 || i == runs.size() + 1) good = good && PQresultStatus(r) == PGRES_COMMAND_OK;
+                    else good = good && applyResult(r, batch, runs[i - 1], ok);
+                    PQclear(r);
+                }
+                if (PGresult* sync = PQgetResult(conn)) PQclear(sync);
+            } else {
+                good = false;
+            }
+            if (!good) std::cerr << "write batch error: " << PQerrorMessage(conn);
+            PQexitPipelineMode(conn);
+        } else {
+            good = exec_command(conn, "BEGIN");
+            for (size_t i = 0; good && i < runs.size(); ++i) {
+                Bound b = bind(params[i]);
+                PGresult* r = PQexecPrepared(conn, statementFor(runs[i].type), static_cast<int>(params[i].size()),
+                                             b.values.data(), b.lengths.data(), b.formats.data(), 1);
+                good = applyResult(r, batch, runs[i], ok);
+                if (!good) std::cerr << "write batch error: " << PQerrorMessage(conn);
+                PQclear(r);
+            }
+            good = good && exec_command(conn, "COMMIT");
+        }
+        if (!good && PQtransactionStatus(conn) != PQTRANS_IDLE) exec_command(conn, "ROLLBACK");
+        return good;
+    }
+
+    const std::atomic<bool>& pipeline_;
+    const Oid value_oid_;
+    std::function<PGconn*()> borrow_;
+    std::function<void(PGconn*)> give_back_;
+    std::atomic<size_t> max_ops_{0};
+    std::atomic<int64_t> window_us_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> fallbacks_{0};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Write> queue_; // guarded by mtx_
+    bool stop_{false};         // guarded by mtx_
+    std::thread thread_;
+};
+
+void PersistenceAdapter::Impl::startWriteBatcher(size_t max_ops, std::chrono::microseconds window) {
+    batcher = std::make_unique<WriteBatcher>(max_ops, window, pipeline, value_oid, [this]() { return borrow(); },
+                                             [this](PGconn* c) { giveBack(c); });
+}
+
+void PersistenceAdapter::Impl::stopWriteBatcher() {
+    batcher.reset();
+}
+
+std::optional<bool> PersistenceAdapter::Impl::batchWrite(OpType type, int64_t key, const std::string& value) {
+    if (!batcher || !batcher->enabled()) return std::nullopt;
+    return batcher->submit(type, key, value).get();
+}
+
+nlohmann::json PersistenceAdapter::Impl::batchMetrics() const {
+    return batcher ? batcher->metrics() : nlohmann::json::object();
+}
+
+void PersistenceAdapter::setWriteBatching(size_t max_ops, std::chrono::microseconds window) {
+    if (p_ && p_->batcher) p_->batcher->configure(max_ops, window);
+}
+
+bool PersistenceAdapter::binaryValues() const {
+    return p_ && p_->value_oid == kByteaOid;
+}
+
+PersistenceAdapter::TxResult PersistenceAdapter::runTransaction(const std::vector<Operation>& ops, TxMode mode)
+{
+    TxResult result{true, {}};
+    if (!p_ || !p_->conn) {
         result.success = false;
-        result.failures.push_back({Operation{OpType::Insert, 0, ""}, "COMMIT failed"});
+        result.failures.push_back({Operation{OpType::Insert, 0, ""}, "no connection"});
+        return result;
     }
+    // borrow a connection for the transaction
+    PGconn* conn = p_->borrow();
+    TxOutcome tx = run_transaction_on(conn, ops, mode, p_->pipeline.load());
+    p_->giveBack(conn);
 
-    // return transaction connection
-    {
-        std::lock_guard<std::mutex> lg(p_->pool_mtx);
-        p_->free_conns.push(conn);
+    for (size_t i = 0; i < tx.ops.size() && i < ops.size(); ++i) {
+        if (!tx.ops[i].ok) result.failures.push_back({ops[i], tx.ops[i].error, tx.ops[i].no_rows});
     }
-    p_->pool_cv.notify_one();
+    if (!tx.error.empty()) result.failures.push_back({Operation{OpType::Insert, 0, ""}, tx.error});
+    result.success = tx.committed;
     return result;
 }
 
-std::future<std::unique_ptr<std::string>> PersistenceAdapter::getAsync(int key) {
+void PersistenceAdapter::setPipelining(bool enable) {
+    if (p_) p_->pipeline.store(enable);
+}
+
+bool PersistenceAdapter::pipelining() const {
+    return p_ && p_->pipeline.load();
+}
+
+std::future<std::unique_ptr<std::string>> PersistenceAdapter::getAsync(int64_t key) {
     if (!p_) return std::async(std::launch::deferred, [](){ return std::unique_ptr<std::string>(nullptr); });
     auto prom = std::make_shared<std::promise<std::unique_ptr<std::string>>>();
     auto fut = prom->get_future();
+    if (p_->pipeline.load() && p_->engine && p_->engine->submitGet(key, prom)) return fut;
+    if (!p_->pipeline.load()) {
+        {
+            std::lock_guard<std::mutex> lg(p_->tasks_mtx);
+            p_->tasks.emplace([this, key, prom]() {
+                try {
+                    auto res = this->get(key);
+                    prom->set_value(std::move(res));
+                } catch (...) { prom->set_exception(std::current_exception()); }
+            });
+        }
+        p_->tasks_cv.notify_one();
+        return fut;
+    }
+    // Queue the key; the worker that picks up a drain task sends every get queued by then in one pipeline,
+    // so concurrent misses from many requests share a round-trip. Drains finding the queue empty are no-ops.
     {
         std::lock_guard<std::mutex> lg(p_->tasks_mtx);
-        p_->tasks.emplace([this, key, prom]() {
+        p_->pending_gets.push_back({key, prom});
+        p_->tasks.emplace([this]() {
+            std::vector<Impl::PendingGet> batch;
+            {
+                std::lock_guard<std::mutex> lk(p_->tasks_mtx);
+                size_t n = std::min(p_->pending_gets.size(), kPipelineChunk);
+                batch.assign(std::make_move_iterator(p_->pending_gets.begin()),
+                             std::make_move_iterator(p_->pending_gets.begin() + static_cast<std::ptrdiff_t>(n)));
+                p_->pending_gets.erase(p_->pending_gets.begin(), p_->pending_gets.begin() + static_cast<std::ptrdiff_t>(n));
+            }
+            if (batch.empty()) return;
+            std::vector<int64_t> keys;
+            keys.reserve(batch.size());
+            for (const auto& g : batch) keys.push_back(g.key);
+            std::vector<OpOutcome> values;
             try {
-                auto res = this->get(key);
-                prom->set_value(std::move(res));
-            } catch (...) { prom->set_value(nullptr); }
+                PGconn* conn = p_->borrow();
+                values = get_pipelined(conn, keys);
+                p_->giveBack(conn);
+            } catch (const std::exception& e) {
+                values.clear();
+                values.resize(batch.size());
+                for (OpOutcome& o : values) o.error = e.what();
+            }
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (values[i].ok) {
+                    batch[i].promise->set_value(std::move(values[i].value));
+                } else {
+                    batch[i].promise->set_exception(
+                        std::make_exception_ptr(std::runtime_error("get() failed: " + values[i].error)));
+                }
+            }
         });
     }
     p_->tasks_cv.notify_one();
@@ -504,6 +1917,7 @@ std::future<nlohmann::json> PersistenceAdapter::runTransactionJsonAsync(const st
     if (!p_) return std::async(std::launch::deferred, [](){ return nlohmann::json(); });
     auto prom = std::make_shared<std::promise<nlohmann::json>>();
     auto fut = prom->get_future();
+    if (p_->pipeline.load() && p_->engine && p_->engine->submitTransaction(ops, mode, prom)) return fut;
     {
         std::lock_guard<std::mutex> lg(p_->tasks_mtx);
         p_->tasks.emplace([this, ops, mode, prom]() {
@@ -519,149 +1933,14 @@ std::future<nlohmann::json> PersistenceAdapter::runTransactionJsonAsync(const st
 
 nlohmann::json PersistenceAdapter::runTransactionJson(const std::vector<Operation>& ops, TxMode mode)
 {
-    nlohmann::json report;
-    report["mode"] = (mode == TxMode::Silent) ? "silent" : "rollback";
-    report["success"] = true;
-    report["results"] = nlohmann::json::array();
-
-    auto push_result = [&](OpType type, int key, const char* status, const std::string& error = std::string(), const nlohmann::json& value = nullptr) {
-        nlohmann::json item;
-        item["op"] = (type == OpType::Insert) ? "insert" : (type == OpType::Update) ? "update" : (type == OpType::Remove) ? "remove" : "get";
-        item["key"] = key;
-        item["status"] = status;
-        if (!error.empty()) item["error"] = error;
-        if (type == OpType::Get) item["value"] = value; // may be string or null
-        report["results"].push_back(std::move(item));
-    };
-
+    TxOutcome tx;
     if (!p_ || !p_->conn) {
-        report["success"] = false;
-        push_result(OpType::Insert, 0, "failed", "no connection");
-        return report;
+        tx.error = "no connection";
+        return tx_report(ops, mode, tx);
     }
 
-    auto exec_simple = [&](const char* sql) -> bool {
-        PGresult* r = PQexec(p_->conn, sql);
-        bool ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-        if (!ok) std::cerr << "txn error: " << PQerrorMessage(p_->conn);
-        PQclear(r);
-        return ok;
-    };
-
-    if (!exec_simple("BEGIN")) {
-        report["success"] = false;
-        push_result(OpType::Insert, 0, "failed", "BEGIN failed");
-        return report;
-    }
-
-    int idx = 0;
-    for (const auto& op : ops) {
-        ++idx;
-        if (mode == TxMode::Silent) {
-            // savepoint per op
-            std::ostringstream sp; sp << "SAVEPOINT sp_" << idx;
-            if (!exec_simple(sp.str().c_str())) { push_result(op.type, op.key, "failed", "SAVEPOINT failed"); continue; }
-            auto release_sp = [&]() { std::ostringstream rel; rel << "RELEASE SAVEPOINT sp_" << idx; exec_simple(rel.str().c_str()); };
-            auto rollback_sp = [&]() { std::ostringstream rb; rb << "ROLLBACK TO SAVEPOINT sp_" << idx; exec_simple(rb.str().c_str()); std::ostringstream rel; rel << "RELEASE SAVEPOINT sp_" << idx; exec_simple(rel.str().c_str()); };
-
-            bool ok = true; int affected = 0;
-            if (op.type == OpType::Insert) {
-                std::string k = std::to_string(op.key);
-                const char* params[2] = { k.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_insert", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (!ok) push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn));
-                else push_result(op.type, op.key, "ok");
-                PQclear(r);
-            } else if (op.type == OpType::Update) {
-                std::string k = std::to_string(op.key);
-                const char* params[2] = { k.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_update", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) { const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0; if (affected == 0) { ok = false; push_result(op.type, op.key, "failed", "no rows affected"); } }
-                else { push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn)); }
-                if (ok) push_result(op.type, op.key, "ok");
-                PQclear(r);
-            } else if (op.type == OpType::Remove) {
-                std::string k = std::to_string(op.key);
-                const char* params[1] = { k.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_delete", 1, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) { const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0; if (affected == 0) { ok = false; push_result(op.type, op.key, "failed", "no rows affected"); } }
-                else { push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn)); }
-                if (ok) push_result(op.type, op.key, "ok");
-                PQclear(r);
-            } else if (op.type == OpType::Get) {
-                std::string k = std::to_string(op.key);
-                const char* params[1] = { k.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_select", 1, params, nullptr, nullptr, 0);
-                ok = (PQresultStatus(r) == PGRES_TUPLES_OK);
-                if (!ok) {
-                    push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn), nullptr);
-                } else {
-                    if (PQntuples(r) == 1 && PQnfields(r) == 1) {
-                        char* val = PQgetvalue(r, 0, 0);
-                        push_result(op.type, op.key, "ok", "", std::string(val ? val : ""));
-                    } else {
-                        // not found -> value null in silent mode
-                        push_result(op.type, op.key, "ok", "", nullptr);
-                    }
-                }
-                PQclear(r);
-            }
-
-            if (!ok) { rollback_sp(); } else { release_sp(); }
-
-        } else { // RollbackOnError
-            bool ok = true; int affected = 0;
-            if (op.type == OpType::Insert) {
-                std::string k = std::to_string(op.key);
-                const char* params[2] = { k.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_insert", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) push_result(op.type, op.key, "ok"); else push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn));
-                PQclear(r);
-            } else if (op.type == OpType::Update) {
-                std::string k = std::to_string(op.key);
-                const char* params[2] = { k.c_str(), op.value.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_update", 2, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) { const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0; if (affected == 0) { ok = false; push_result(op.type, op.key, "failed", "no rows affected"); } }
-                else { push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn)); }
-                if (ok) push_result(op.type, op.key, "ok");
-                PQclear(r);
-            } else if (op.type == OpType::Remove) {
-                std::string k = std::to_string(op.key);
-                const char* params[1] = { k.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_delete", 1, params, nullptr, nullptr, 0);
-                ok = PQresultStatus(r) == PGRES_COMMAND_OK;
-                if (ok) { const char* t = PQcmdTuples(r); affected = (t && *t) ? std::stoi(t) : 0; if (affected == 0) { ok = false; push_result(op.type, op.key, "failed", "no rows affected"); } }
-                else { push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn)); }
-                if (ok) push_result(op.type, op.key, "ok");
-                PQclear(r);
-            } else if (op.type == OpType::Get) {
-                std::string k = std::to_string(op.key);
-                const char* params[1] = { k.c_str() };
-                PGresult* r = PQexecPrepared(p_->conn, "kv_select", 1, params, nullptr, nullptr, 0);
-                ok = (PQresultStatus(r) == PGRES_TUPLES_OK);
-                if (!ok) {
-                    push_result(op.type, op.key, "failed", PQerrorMessage(p_->conn), nullptr);
-                } else {
-                    if (PQntuples(r) == 1 && PQnfields(r) == 1) {
-                        char* val = PQgetvalue(r, 0, 0);
-                        push_result(op.type, op.key, "ok", "", std::string(val ? val : ""));
-                    } else {
-                        // not found -> ok with null value
-                        push_result(op.type, op.key, "ok", "", nullptr);
-                    }
-                }
-                PQclear(r);
-            }
-
-            if (!ok) { exec_simple("ROLLBACK"); report["success"] = false; return report; }
-        }
-    }
-
-    if (!exec_simple("COMMIT")) { report["success"] = false; push_result(OpType::Insert, 0, "failed", "COMMIT failed"); }
-    return report;
-}
\ No newline at end of file
+    PGconn* conn = p_->borrow();
+    tx = run_transaction_on(conn, ops, mode, p_->pipeline.load());
+    p_->giveBack(conn);
+    return tx_report(ops, mode, tx);
+}
@@ -12,6 +12,7 @@
 #include <thread>
 #include <mutex>
 #include <map>
+#include <unordered_set>
 #include <fstream>
 #include <filesystem>
 
@@ -20,21 +21,490 @@ const std::vector<KeyValueServer::RouteDescriptor> KeyValueServer::routes_json =
     {"GET", "/home", "Formatted documentation for available routes"},
     {"GET", "/get_key/:key_id", "Return the value for the provided numeric key caching it if not present in cache"},
     {"PATCH", "/bulk_query", "Retrieve multiple keys in one request; missing keys noted in response, always return success response with error appended to the response"},
-    {"POST", "/insert/:key/:value", "Insert a key/value pair; conflicts return 409 with existing value, writes both to cache and persistence layer (note that we are using write-through type of cache)"},
+    {"POST", "/insert/:key/:value", "Insert a key/value pair; conflicts return 409 with existing value, writes both to cache and persistence layer (write-through, or queued for asynchronous persistence with --write-mode=behind); optional ?ttl_ms= expires the cached copy"},
     {"POST", "/bulk_update", "Transactional Commit pipeline for create/get/insert/update operations, rollbacks in case of failure and retuns failure response"},
     {"DELETE", "/delete_key/:key", "Remove the provided key from both the cache and persistence layer"},
-    {"PUT", "/update_key/:key/:value", "Update an existing key with a new value to both the cache and persistence layer"},
+    {"PUT", "/update_key/:key/:value", "Update an existing key with a new value to both the cache and persistence layer; optional ?ttl_ms= expires the cached copy"},
+    {"GET", "/get_skey/:key", "Return the value for a string key (up to 31 bytes), caching it if not present in cache"},
+    {"POST", "/insert_skey/:key/:value", "Insert a string key/value pair; conflicts return 409; optional ?ttl_ms= expires the cached copy"},
+    {"PUT", "/update_skey/:key/:value", "Update an existing string key in cache and persistence; optional ?ttl_ms= expires the cached copy"},
+    {"DELETE", "/delete_skey/:key", "Remove a string key from both the cache and persistence layer"},
     {"GET", "/health", "Report service health and uptime"},
     {"GET", "/metrics", "Expose cache metrics including hit/miss counts"},
     {"GET", "/stop", "Gracefully stop the server (testing/debug only), shouldn't be available in prod environment"}
 };
 
-KeyValueServer::KeyValueServer(const std::string& host, int port, InlineCache::Policy policy, bool json_logging)
-    : host_(host), port_(port), inline_cache(policy, 1ULL * 1024 * 1024 * 1024), json_logging_enabled(json_logging) {
+KeyValueServer::KeyValueServer(const std::string& host, int port, InlineCache::Policy policy, bool json_logging, size_t cache_shards,
+                               InlineCache::Storage cache_storage, InlineCache::Admission cache_admission, size_t cache_cores)
+    : host_(host), port_(port),
+      inline_cache(policy, cache_max_bytes, 1031, cache_shards, cache_storage, cache_admission, cache_cores),
+      string_cache(policy, 256ULL * 1024 * 1024, 1031, cache_shards, cache_storage, cache_admission),
+      negative_cache(InlineCache::Policy::Clock, negative_cache_bytes, 1031, cache_shards, cache_storage),
+      json_logging_enabled(json_logging) {
     server_boot_time = std::chrono::steady_clock::now();
 }
 
-KeyValueServer::~KeyValueServer() = default;
+KeyValueServer::~KeyValueServer() {
+    stopHotKeyPreload();
+    stopHotKeySaver();
+    stopSnapshotter();
+    stopTtlSweeper();
+    stopWalCheckpointer();
+}
+
+bool KeyValueServer::knownAbsent(int64_t key) {
+    return negative_cache_ttl.count() > 0 && negative_cache.get(key).has_value();
+}
+
+void KeyValueServer::rememberAbsent(int64_t key, uint64_t epoch) {
+    if (negative_cache_ttl.count() <= 0) return;
+    negative_cache.update_or_insert(key, 1, negative_cache_ttl);
+    // a write that created a key after our snapshot may already have run forgetAbsent()
+    if (absent_epoch.load() != epoch) negative_cache.erase(key);
+}
+
+void KeyValueServer::forgetAbsent(int64_t key) {
+    absent_epoch.fetch_add(1);
+    negative_cache.erase(key);
+}
+
+std::optional<WriteBehindQueue::Write> KeyValueServer::pendingWrite(int64_t key) const {
+    if (!write_behind) return std::nullopt;
+    return write_behind->pending(key);
+}
+
+void KeyValueServer::flushWriteBehind(const std::vector<WriteBehindQueue::Write>& batch, std::vector<char>& ok) {
+    if (auto* ada = dynamic_cast<PersistenceAdapter*>(persistence_adapter.get())) {
+        // one transaction per batch; Silent mode so one failing write does not hold back the others
+        std::vector<PersistenceAdapter::Operation> ops;
+        ops.reserve(batch.size());
+        std::unordered_map<int64_t, size_t> index;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            bool upsert = batch[i].op == WriteBehindQueue::Op::Upsert;
+            ops.push_back({upsert ? PersistenceAdapter::OpType::Insert : PersistenceAdapter::OpType::Remove, batch[i].key,
+                           batch[i].value});
+            index[batch[i].key] = i;
+        }
+        auto result = ada->runTransaction(ops, PersistenceAdapter::TxMode::Silent);
+        if (!result.success) return;
+        std::fill(ok.begin(), ok.end(), 1);
+        for (const auto& failure : result.failures) {
+            // removing a key that is already gone is fine
+            if (failure.op.type == PersistenceAdapter::OpType::Remove && failure.no_rows) continue;
+            auto it = index.find(failure.op.key);
+            if (it != index.end()) ok[it->second] = 0;
+        }
+        return;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].op == WriteBehindQueue::Op::Upsert) {
+            ok[i] = persistence_adapter->insert(batch[i].key, batch[i].value);
+        } else {
+            // false is either "already gone" or a failed write: only the first may leave the queue
+            try {
+                ok[i] = persistence_adapter->remove(batch[i].key) || !persistence_adapter->get(batch[i].key);
+            } catch (const std::exception&) {
+                ok[i] = 0;
+            }
+        }
+    }
+}
+
+bool KeyValueServer::queueWrite(int64_t key, WriteBehindQueue::Op op, const std::string& value) {
+    if (!recovery_log) {
+        write_behind->put(key, op, value);
+        return true;
+    }
+    if (wal_degraded.load()) return false;
+    return recovery_log->append({WriteBehindQueue::Write{key, op, value}}, [&] { write_behind->put(key, op, value); });
+}
+
+std::shared_lock<std::shared_mutex> KeyValueServer::holdKey(int64_t key) {
+    if (!write_behind) return {};
+    return std::shared_lock<std::shared_mutex>(write_stripes[static_cast<uint64_t>(key) % write_stripe_count]);
+}
+
+std::vector<std::unique_lock<std::shared_mutex>> KeyValueServer::holdKeys(const std::vector<int64_t>& keys) {
+    std::vector<std::unique_lock<std::shared_mutex>> held;
+    if (!write_behind) return held;
+    // ascending stripe order, so concurrent bulk updates cannot deadlock
+    std::vector<size_t> stripes;
+    stripes.reserve(keys.size());
+    for (int64_t key : keys) stripes.push_back(static_cast<uint64_t>(key) % write_stripe_count);
+    std::sort(stripes.begin(), stripes.end());
+    stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+    held.reserve(stripes.size());
+    for (size_t stripe : stripes) held.emplace_back(write_stripes[stripe]);
+    return held;
+}
+
+KeyValueServer::Hydration KeyValueServer::hydrateFromPersistence(int64_t key, bool& coalesced) {
+    return miss_flight.run(key, [&] {
+        Hydration h;
+        uint64_t epoch = absentEpoch();
+        // write-behind: the queue is newer than persistence
+        if (auto pending = pendingWrite(key)) {
+            if (pending->op == WriteBehindQueue::Op::Upsert) {
+                h.value = pending->value;
+                h.cache_populated = inline_cache.insert_if_admitted(key, *h.value);
+            }
+            return h;
+        }
+        std::unique_ptr<std::string> persisted;
+        // if underlying adapter supports async get, offload DB work to its worker pool
+        if (auto* ada = dynamic_cast<PersistenceAdapter*>(persistence_adapter.get())) {
+            persisted = ada->getAsync(key).get();
+        } else {
+            persisted = persistence_adapter->get(key);
+        }
+        if (persisted) h.value = std::move(*persisted);
+        if (h.value) {
+            h.cache_populated = inline_cache.insert_if_admitted(key, *h.value);
+        } else {
+            rememberAbsent(key, epoch);
+        }
+        return h;
+    }, &coalesced);
+}
+
+std::unordered_map<int64_t, KeyValueServer::Hydration> KeyValueServer::hydrateBatchFromPersistence(std::vector<int64_t> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    uint64_t epoch = absentEpoch();
+    std::unordered_map<int64_t, Hydration> out;
+    out.reserve(keys.size());
+    if (write_behind) {
+        // keys with an unpersisted write are answered from the queue
+        keys.erase(std::remove_if(keys.begin(), keys.end(), [&](int64_t key) {
+            auto pending = write_behind->pending(key);
+            if (!pending) return false;
+            Hydration& h = out[key];
+            if (pending->op == WriteBehindQueue::Op::Upsert) {
+                h.value = pending->value;
+                h.cache_populated = inline_cache.insert_if_admitted(key, *h.value);
+            }
+            return true;
+        }), keys.end());
+    }
+    auto found = persistence_adapter->multiGet(keys);
+    for (int64_t key : keys) {
+        Hydration& h = out[key];
+        auto it = found.find(key);
+        if (it != found.end()) {
+            h.cache_populated = inline_cache.insert_if_admitted(key, it->second);
+            h.value = std::move(it->second);
+        } else {
+            rememberAbsent(key, epoch);
+        }
+    }
+    return out;
+}
+
+void KeyValueServer::startTtlSweeper() {
+    {
+        std::lock_guard<std::mutex> lk(sweeper_mtx);
+        sweeper_stop = false;
+    }
+    ttl_sweeper = std::thread([this] {
+        std::unique_lock<std::mutex> lk(sweeper_mtx);
+        while (!sweeper_stop) {
+            lk.unlock();
+            bool more = inline_cache.expire(ttl_sweep_budget) >= ttl_sweep_budget;
+            more |= string_cache.expire(ttl_sweep_budget) >= ttl_sweep_budget;
+            more |= negative_cache.expire(ttl_sweep_budget) >= ttl_sweep_budget;
+            lk.lock();
+            // a full budget means more entries are due: keep going without sleeping
+            if (!more) {
+                sweeper_cv.wait_for(lk, ttl_sweep_interval, [this] { return sweeper_stop; });
+            }
+        }
+    });
+}
+
+void KeyValueServer::stopTtlSweeper() {
+    {
+        std::lock_guard<std::mutex> lk(sweeper_mtx);
+        sweeper_stop = true;
+    }
+    sweeper_cv.notify_all();
+    if (ttl_sweeper.joinable()) ttl_sweeper.join();
+}
+
+void KeyValueServer::startSnapshotter() {
+    if (snapshot_path.empty() || snapshot_interval.count() <= 0) return;
+    {
+        std::lock_guard<std::mutex> lk(snapshotter_mtx);
+        snapshotter_stop = false;
+    }
+    snapshotter = std::thread([this] {
+        std::unique_lock<std::mutex> lk(snapshotter_mtx);
+        while (!snapshotter_cv.wait_for(lk, snapshot_interval, [this] { return snapshotter_stop; })) {
+            lk.unlock();
+            writeSnapshot();
+            lk.lock();
+        }
+    });
+}
+
+void KeyValueServer::stopSnapshotter() {
+    {
+        std::lock_guard<std::mutex> lk(snapshotter_mtx);
+        snapshotter_stop = true;
+    }
+    snapshotter_cv.notify_all();
+    if (snapshotter.joinable()) snapshotter.join();
+}
+
+KeyValueServer::WalReplay KeyValueServer::replayWal() {
+    WalReplay summary;
+    auto started = std::chrono::steady_clock::now();
+    auto log = std::make_unique<RecoveryLog>();
+    if (!log->open(wal_dir, wal_options, summary.error)) return summary;
+    RecoveryLog::Replay replay = log->replay();
+    summary.files = replay.files;
+    summary.records = replay.records;
+    summary.writes = replay.writes.size();
+    // persistence first: the files are only deleted once it has every write
+    for (size_t i = 0; i < replay.writes.size(); i += write_behind_batch) {
+        std::vector<WriteBehindQueue::Write> batch(replay.writes.begin() + i,
+                                                   replay.writes.begin() + std::min(replay.writes.size(), i + write_behind_batch));
+        std::vector<char> ok(batch.size(), 0);
+        try {
+            flushWriteBehind(batch, ok);
+        } catch (const std::exception& e) {
+            summary.error = std::string("persistence error: ") + e.what();
+            return summary;
+        }
+        if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+            summary.error = "persistence rejected replayed writes";
+            return summary;
+        }
+    }
+    for (const auto& w : replay.writes) {
+        if (w.op == WriteBehindQueue::Op::Upsert) {
+            inline_cache.update_or_insert(w.key, w.value);
+        } else {
+            inline_cache.erase(w.key);
+        }
+    }
+    log->retire(log->stats().generation);
+    recovery_log = std::move(log);
+    summary.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
+
+bool KeyValueServer::checkpointWal(std::chrono::steady_clock::time_point deadline) {
+    std::lock_guard<std::mutex> checkpoint(wal_checkpoint_mtx);
+    const bool clears_degraded = wal_degraded.load(); // records it is about are in the files this one retires
+    uint64_t ticket = 0;
+    std::string error;
+    const uint64_t first_kept = recovery_log->rotate([&] { ticket = write_behind->stats().enqueued; }, error);
+    if (first_kept == 0) {
+        if (logging_enabled) std::cerr << "WAL checkpoint failed: " << error << "\n";
+        return false;
+    }
+    // the older files only hold writes queued up to ticket
+    while (!write_behind->wait_persisted(ticket, wal_checkpoint_poll)) {
+        std::lock_guard<std::mutex> lk(wal_checkpointer_mtx);
+        if (wal_checkpointer_stop) return false; // shutdown drains the queue and retires them
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+    }
+    recovery_log->retire(first_kept);
+    wal_checkpoints.fetch_add(1);
+    if (clears_degraded) wal_degraded.store(false);
+    return true;
+}
+
+void KeyValueServer::startWalCheckpointer() {
+    if (!recovery_log || !write_behind) return;
+    {
+        std::lock_guard<std::mutex> lk(wal_checkpointer_mtx);
+        wal_checkpointer_stop = false;
+    }
+    wal_checkpointer = std::thread([this] {
+        std::unique_lock<std::mutex> lk(wal_checkpointer_mtx);
+        while (!wal_checkpointer_cv.wait_for(lk, wal_checkpoint_poll, [this] { return wal_checkpointer_stop; })) {
+            if (recovery_log->stats().bytes < wal_checkpoint_bytes && !wal_degraded.load()) continue;
+            lk.unlock();
+            checkpointWal();
+            lk.lock();
+        }
+    });
+}
+
+void KeyValueServer::stopWalCheckpointer() {
+    {
+        std::lock_guard<std::mutex> lk(wal_checkpointer_mtx);
+        wal_checkpointer_stop = true;
+    }
+    wal_checkpointer_cv.notify_all();
+    if (wal_checkpointer.joinable()) wal_checkpointer.join();
+}
+
+bool KeyValueServer::writeSnapshot() {
+    std::lock_guard<std::mutex> guard(snapshot_write_mtx);
+    auto started = std::chrono::steady_clock::now();
+    int64_t version = CacheSnapshot::kNoVersion;
+    try {
+        if (persistence_adapter) {
+            if (auto now = persistence_adapter->versionNow()) {
+                version = *now - std::chrono::duration_cast<std::chrono::microseconds>(snapshot_version_slack).count();
+            }
+        }
+    } catch (const std::exception& e) {
+        if (logging_enabled) std::cerr << "Snapshot: persistence version unavailable: " << e.what() << "\n";
+    }
+    CacheSnapshot::Writer writer;
+    bool ok = writer.open(snapshot_path);
+    if (ok) {
+        inline_cache.for_each_entry([&](int64_t key, std::string_view value, bool referenced) {
+            // acknowledged but not persisted: validation at restart could not vouch for it
+            if (write_behind && write_behind->pending(key)) return;
+            writer.add(key, value, referenced);
+        });
+        auto written_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        ok = writer.commit(static_cast<uint32_t>(inline_cache.policy()), version, written_ms);
+    }
+    if (logging_enabled) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        if (ok) {
+            std::cout << "Snapshot: wrote " << writer.entries() << " entries to " << snapshot_path << " in "
+                      << static_cast<long long>(ms) << " ms\n";
+        } else {
+            std::cerr << "Snapshot: writing " << snapshot_path << " failed\n";
+        }
+    }
+    return ok;
+}
+
+KeyValueServer::SnapshotRestore KeyValueServer::restoreSnapshot() {
+    SnapshotRestore out;
+    auto started = std::chrono::steady_clock::now();
+    CacheSnapshot::Reader reader;
+    if (reader.open(snapshot_path, out.error)) {
+        out.entries = static_cast<size_t>(reader.header().entries);
+        const int64_t version = reader.header().version;
+        bool by_version = false;
+        try {
+            by_version = version != CacheSnapshot::kNoVersion && persistence_adapter->versionNow().has_value();
+        } catch (...) {}
+
+        struct Record {
+            int64_t key;
+            std::string_view value;
+            bool referenced;
+        };
+        std::vector<Record> chunk;
+        chunk.reserve(snapshot_validate_chunk);
+        // Keys whose row still exists unchanged since the dump: by write version when persistence keeps
+        // one, otherwise by comparing the values themselves.
+        auto flush = [&]() {
+            std::vector<int64_t> keys;
+            keys.reserve(chunk.size());
+            for (const Record& r : chunk) keys.push_back(r.key);
+            std::unordered_set<int64_t> current;
+            try {
+                if (by_version) {
+                    for (int64_t k : persistence_adapter->unchangedSince(keys, version)) current.insert(k);
+                } else {
+                    auto values = persistence_adapter->multiGet(keys);
+                    for (const Record& r : chunk) {
+                        auto it = values.find(r.key);
+                        if (it != values.end() && it->second == r.value) current.insert(r.key);
+                    }
+                }
+            } catch (const std::exception& e) {
+                if (logging_enabled) std::cerr << "Snapshot: validation failed: " << e.what() << "\n";
+            }
+            for (const Record& r : chunk) {
+                if (current.count(r.key) && inline_cache.restore_entry(r.key, r.value, r.referenced)) ++out.restored;
+            }
+            chunk.clear();
+        };
+        reader.for_each([&](int64_t key, std::string_view value, bool referenced) {
+            chunk.push_back(Record{key, value, referenced});
+            if (chunk.size() == snapshot_validate_chunk) flush();
+        });
+        if (!chunk.empty()) flush();
+    }
+    out.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return out;
+}
+
+void KeyValueServer::startHotKeyPreload(std::vector<int64_t> keys) {
+    hot_preload_keys.store(keys.size());
+    hot_preload_loaded.store(0);
+    hot_preload_stop.store(false);
+    hot_preload_done.store(keys.empty());
+    if (keys.empty() || !persistence_adapter) return;
+    hot_preloader = std::thread([this, keys = std::move(keys)]() {
+        auto started = std::chrono::steady_clock::now();
+        const size_t budget = cache_max_bytes - cache_max_bytes / 16;
+        size_t read = 0;
+        for (size_t from = 0; from < keys.size() && !hot_preload_stop.load(); from += hot_key_preload_chunk) {
+            if (inline_cache.stats().bytes_estimated >= budget) break;
+            std::vector<int64_t> chunk(keys.begin() + from, keys.begin() + std::min(keys.size(), from + hot_key_preload_chunk));
+            if (write_behind) {
+                chunk.erase(std::remove_if(chunk.begin(), chunk.end(),
+                                           [&](int64_t key) { return write_behind->pending(key).has_value(); }),
+                            chunk.end());
+            }
+            try {
+                for (auto& [key, value] : persistence_adapter->multiGet(chunk)) {
+                    if (inline_cache.insert_if_absent(key, value)) hot_preload_loaded.fetch_add(1);
+                }
+            } catch (const std::exception& e) {
+                if (logging_enabled) std::cerr << "Hot-key preload error: " << e.what() << "\n";
+                break;
+            }
+            read += chunk.size();
+        }
+        hot_preload_done.store(true);
+        if (logging_enabled) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+            std::cout << "Hot-key preload: read=" << read << " of " << keys.size() << " loaded=" << hot_preload_loaded.load()
+                      << " ms=" << static_cast<long long>(ms) << "\n";
+        }
+    });
+}
+
+void KeyValueServer::stopHotKeyPreload() {
+    hot_preload_stop.store(true);
+    if (hot_preloader.joinable()) hot_preloader.join();
+}
+
+void KeyValueServer::startHotKeySaver() {
+    if (!hot_keys || hot_key_save_interval.count() <= 0) return;
+    {
+        std::lock_guard<std::mutex> lk(hot_key_saver_mtx);
+        hot_key_saver_stop = false;
+    }
+    hot_key_saver = std::thread([this] {
+        std::unique_lock<std::mutex> lk(hot_key_saver_mtx);
+        while (!hot_key_saver_cv.wait_for(lk, hot_key_save_interval, [this] { return hot_key_saver_stop; })) {
+            lk.unlock();
+            saveHotKeys();
+            hot_keys->decay();
+            lk.lock();
+        }
+    });
+}
+
+void KeyValueServer::stopHotKeySaver() {
+    {
+        std::lock_guard<std::mutex> lk(hot_key_saver_mtx);
+        hot_key_saver_stop = true;
+    }
+    hot_key_saver_cv.notify_all();
+    if (hot_key_saver.joinable()) hot_key_saver.join();
+}
+
+bool KeyValueServer::saveHotKeys() {
+    bool ok = hot_keys->save(hot_key_path);
+    if (!ok && logging_enabled) std::cerr << "Hot-key profile: writing " << hot_key_path << " failed\n";
+    return ok;
+}
 
 void KeyValueServer::logRequest(const httplib::Request& req) {
     if (!logging_enabled) return;
@@ -60,7 +530,7 @@ void KeyValueServer::logResponse(const httplib::Response& res, std::chrono::stea
     if (!logging_enabled) return;
     if (json_logging_enabled) {
         nlohmann::json j{{"type","response"},{"status",res.status},{"reason",res.reason},
-                         {"content_type",res.get_header_value("Content-Type")},{"bytes",res.body.size()},
+                         {"content_type",res.get_header_value("Content-Type")},{"bytes",res.body.empty() ? res.content_length_ : res.body.size()},
                          {"duration_ms",ms}};
         // If the response body looks like JSON, attempt to include any 'reason' field present for observability
         try {
@@ -76,7 +546,7 @@ void KeyValueServer::logResponse(const httplib::Response& res, std::chrono::stea
     } else {
         std::cout << "[RESPONSE] status=" << res.status << " reason=" << res.reason
                   << " ct=" << res.get_header_value("Content-Type")
-                  << " bytes=" << res.body.size()
+                  << " bytes=" << (res.body.empty() ? res.content_length_ : res.body.size())
                   << " duration_ms=" << ms << "\n";
     }
 }
@@ -106,6 +576,25 @@ static bool validate_path_params(const httplib::Request& req, const std::vector<
     return true;
 }
 
+// Parse the optional `ttl_ms` query parameter (cache TTL in milliseconds, 0 = none). Returns false with
+// out/reason_msg filled in when it is present but not a non-negative integer.
+static bool parse_ttl_param(const httplib::Request& req, std::chrono::milliseconds& ttl, nlohmann::json& out, std::string& reason_msg) {
+    ttl = InlineCache::kNoTtl;
+    if (!req.has_param("ttl_ms")) return true;
+    const std::string raw = req.get_param_value("ttl_ms");
+    bool ok = !raw.empty() && raw.size() <= 12 &&
+              std::all_of(raw.begin(), raw.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
+    if (!ok) {
+        reason_msg = "invalid_ttl";
+        out["error"] = "invalid ttl";
+        out["reason"] = "query parameter 'ttl_ms' must be a non-negative integer number of milliseconds";
+        return false;
+    }
+    ttl = std::chrono::milliseconds(std::stoll(raw));
+    if (ttl.count() > 0) out["ttl_ms"] = ttl.count();
+    return true;
+}
+
 void KeyValueServer::homeHandler(const httplib::Request& req, httplib::Response& res) {
     auto start = std::chrono::steady_clock::now();
     logRequest(req);
@@ -201,53 +690,52 @@ void KeyValueServer::getKeyHandler(const httplib::Request& req, httplib::Respons
     }
     if (req.has_param("key_id")) id = req.get_param_value("key_id");
     else if (req.path_params.count("key_id")) id = req.path_params.at("key_id");
-    int key;
+    int64_t key;
     out["query_key"] = id;
-    if (!parse_int(id, key)) {
+    if (!parse_key(id, key)) {
         out["error"] = "invalid key format";
         out["reason"] = "path parameter 'key_id' must be an integer";
         json_response(res, 400, out, "invalid_key_format");
         logResponse(res, std::chrono::steady_clock::now() - start);
         return;
     }
-    auto v = inline_cache.get(key);
+    if (hot_keys) hot_keys->record(key);
+    auto v = inline_cache.get_handle(key);
     if (v) {
         out["found"] = true;
-        out["value"] = *v;
-        json_response(res, 200, out, "ok");
+        json_response_with_value(res, 200, out, std::move(*v), "ok");
+    } else if (knownAbsent(key)) {
+        out["found"] = false;
+        out["reason"] = "key recently found absent from persistence";
+        out["persistence_checked"] = true;
+        out["negative_cache"] = true;
+        json_response(res, 404, out, "not_found");
     } else {
         bool persistence_checked = false;
         if (persistence_adapter) {
             persistence_checked = true;
-            // if underlying adapter supports async get, offload DB work to its worker pool
-            if (auto* ada = dynamic_cast<PersistenceAdapter*>(persistence_adapter.get())) {
-                try {
-                    auto fut = ada->getAsync(key);
-                    auto persisted = fut.get();
-                    if (persisted) {
-                        out["found"] = true;
-                        out["value"] = *persisted;
-                        out["source"] = "persistence";
-                        bool inserted_cache = inline_cache.update_or_insert(key, *persisted);
-                        out["cache_populated"] = inserted_cache;
-                        json_response(res, 200, out, "ok");
-                        logResponse(res, std::chrono::steady_clock::now() - start);
-                        return;
-                    }
-                } catch (...) {
-                    // fall back to synchronous call below
-                }
-            } else {
-                if (auto persisted = persistence_adapter->get(key)) {
+            try {
+                bool coalesced = false;
+                Hydration h = hydrateFromPersistence(key, coalesced);
+                if (coalesced) out["coalesced"] = true;
+                if (h.value) {
                     out["found"] = true;
-                    out["value"] = *persisted;
+                    out["value"] = *h.value;
                     out["source"] = "persistence";
-                    bool inserted_cache = inline_cache.update_or_insert(key, *persisted);
-                    out["cache_populated"] = inserted_cache;
+                    out["cache_populated"] = h.cache_populated;
                     json_response(res, 200, out, "ok");
                     logResponse(res, std::chrono::steady_clock::now() - start);
                     return;
                 }
+            } catch (const std::exception& e) {
+                // the key may exist: a failed read is not a miss
+                out["found"] = false;
+                out["error"] = "persistence_failure";
+                out["reason"] = std::string("database read failed: ") + e.what();
+                out["persistence_checked"] = true;
+                json_response(res, 500, out, "persistence_error");
+                logResponse(res, std::chrono::steady_clock::now() - start);
+                return;
             }
         }
         out["found"] = false;
@@ -275,6 +763,12 @@ void KeyValueServer::bulkQueryHandler(const httplib::Request& req, httplib::Resp
     };
 
     size_t hit_cache = 0, hit_persistence = 0, miss = 0, type_mismatch = 0;
+    // cache misses awaiting the batched persistence read: position in results and key
+    struct PendingMiss {
+        size_t index;
+        int64_t key;
+    };
+    std::vector<PendingMiss> pending;
 
     if (req.body.empty()) {
         push_error("empty_body", "request body must include a JSON object with a 'data' array of integer keys");
@@ -306,48 +800,75 @@ void KeyValueServer::bulkQueryHandler(const httplib::Request& req, httplib::Resp
                         continue;
                     }
 
-                    int key = el.get<int>();
+                    int64_t key = el.get<int64_t>();
                     item["key"] = key;
-                    if (auto cached = inline_cache.get(key)) {
+                    if (hot_keys) hot_keys->record(key);
+                    if (auto cached = inline_cache.get_handle(key)) {
                         item["status"] = "hit_cache";
                         item["found"] = true;
-                        item["value"] = *cached;
+                        item["value"] = cached->str(); // one copy, moved into the JSON document
                         item["source"] = "cache";
                         item["reason"] = "value served from cache";
                         ++hit_cache;
+                    } else if (knownAbsent(key)) {
+                        item["status"] = "miss";
+                        item["found"] = false;
+                        item["value"] = nullptr;
+                        item["reason"] = "key recently found absent from persistence";
+                        item["persistence_checked"] = true;
+                        item["negative_cache"] = true;
+                        ++miss;
+                    } else if (persistence_adapter) {
+                        // resolved below with one batched persistence read for all misses
+                        item["persistence_checked"] = true;
+                        pending.push_back({results.size(), key});
                     } else {
-                        bool persistence_checked = false;
-                        if (persistence_adapter) {
-                            persistence_checked = true;
-                            if (auto persisted = persistence_adapter->get(key)) {
-                                inline_cache.update_or_insert(key, *persisted);
-                                item["status"] = "hit_persistence";
-                                item["found"] = true;
-                                item["value"] = *persisted;
-                                item["source"] = "persistence";
-                                item["reason"] = "value hydrated from persistence";
-                                item["cache_populated"] = true;
-                                ++hit_persistence;
-                            } else {
-                                item["status"] = "miss";
-                                item["found"] = false;
-                                item["value"] = nullptr;
-                                item["reason"] = "key not present in cache or persistence";
-                                ++miss;
-                            }
+                        item["status"] = "miss";
+                        item["found"] = false;
+                        item["value"] = nullptr;
+                        item["reason"] = "key not present in cache";
+                        ++miss;
+                    }
+
+                    results.push_back(item);
+                }
+
+                if (!pending.empty()) {
+                    std::vector<int64_t> keys;
+                    keys.reserve(pending.size());
+                    for (const auto& p : pending) keys.push_back(p.key);
+                    std::unordered_map<int64_t, Hydration> fetched;
+                    bool fetch_failed = false;
+                    try {
+                        fetched = hydrateBatchFromPersistence(std::move(keys));
+                    } catch (const std::exception& e) {
+                        fetch_failed = true;
+                        push_error("persistence_error", std::string("database read failed: ") + e.what());
+                    }
+                    for (const auto& p : pending) {
+                        auto& item = results[p.index];
+                        const Hydration& h = fetched[p.key];
+                        if (fetch_failed) {
+                            item["status"] = "error";
+                            item["found"] = false;
+                            item["value"] = nullptr;
+                            item["reason"] = "persistence read failed";
+                        } else if (h.value) {
+                            item["status"] = "hit_persistence";
+                            item["found"] = true;
+                            item["value"] = *h.value;
+                            item["source"] = "persistence";
+                            item["reason"] = "value hydrated from persistence";
+                            item["cache_populated"] = h.cache_populated;
+                            ++hit_persistence;
                         } else {
                             item["status"] = "miss";
                             item["found"] = false;
                             item["value"] = nullptr;
-                            item["reason"] = "key not present in cache";
+                            item["reason"] = "key not present in cache or persistence";
                             ++miss;
                         }
-                        if (persistence_adapter) {
-                            item["persistence_checked"] = true;
-                        }
                     }
-
-                    results.push_back(item);
                 }
             }
         } catch (const std::exception& e) {
@@ -389,15 +910,22 @@ void KeyValueServer::insertionHandler(const httplib::Request& req, httplib::Resp
     if (req.path_params.count("value")) value_str = req.path_params.at("value");
     out["key"] = key_str;
     out["value"] = value_str;
-    int key;
-    if (!parse_int(key_str, key)) {
+    int64_t key;
+    if (!parse_key(key_str, key)) {
         out["error"] = "invalid key format";
         out["reason"] = "path parameter 'key' must be an integer";
         json_response(res, 400, out, "invalid_key_format");
         logResponse(res, std::chrono::steady_clock::now() - start);
         return;
     }
-    bool inserted = inline_cache.insert_if_absent(key, value_str);
+    std::chrono::milliseconds ttl;
+    if (!parse_ttl_param(req, ttl, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    auto held_key = holdKey(key);
+    bool inserted = inline_cache.insert_if_absent(key, value_str, ttl);
     if (!inserted) {
         out["error"] = "key exists";
         out["existing_value"] = inline_cache.get(key).value_or("");
@@ -405,17 +933,22 @@ void KeyValueServer::insertionHandler(const httplib::Request& req, httplib::Resp
         json_response(res, 409, out, "conflict_key_exists");
     } else {
         bool persist_ok = true;
-        if (persistence_adapter) {
+        if (write_behind) {
+            persist_ok = queueWrite(key, WriteBehindQueue::Op::Upsert, value_str);
+            forgetAbsent(key);
+        } else if (persistence_adapter) {
             persist_ok = persistence_adapter->insert(key, value_str);
+            forgetAbsent(key);
         }
         if (!persist_ok) {
             inline_cache.erase(key);
             out["error"] = "persistence_failure";
-            out["reason"] = "database insert failed";
+            out["reason"] = write_behind ? "write-ahead log append failed" : "database insert failed";
             json_response(res, 500, out, "persistence_error");
         } else {
             out["created"] = true;
-            out["persisted"] = static_cast<bool>(persistence_adapter);
+            out["persisted"] = static_cast<bool>(persistence_adapter) && !write_behind;
+            if (write_behind) out["write_behind"] = true;
             json_response(res, 201, out, "created");
         }
     }
@@ -549,7 +1082,7 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
             push_error("invalid_key", "operation must include integer field 'key'", {{"index", idx}});
             continue;
         }
-        int key = item["key"].get<int>();
+        int64_t key = item["key"].get<int64_t>();
 
         std::string value;
         bool requires_value = (op_type == PersistenceAdapter::OpType::Insert) || (op_type == PersistenceAdapter::OpType::Update);
@@ -583,6 +1116,21 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
         tx_ops.push_back(parsed.op);
     }
 
+    // write-behind: the transaction must see, and must not be overwritten by, queued writes to its keys; no
+    // single-key write to them is taken until the committed ops are logged and cached (see holdKey())
+    std::vector<std::unique_lock<std::shared_mutex>> held_keys;
+    if (write_behind) {
+        std::vector<int64_t> keys;
+        keys.reserve(tx_ops.size());
+        for (const auto& op : tx_ops) keys.push_back(op.key);
+        held_keys = holdKeys(keys);
+        if (!write_behind->wait_flushed(keys, write_behind_drain_timeout)) {
+            push_error("write_behind_pending", "queued writes to these keys could not be persisted in time");
+            finalize(false, requested, 0, 0, "not_executed", nlohmann::json::array(), "write-behind queue not flushed");
+            return;
+        }
+    }
+
     size_t processed = 0;
     size_t succeeded = 0;
     bool tx_success = false;
@@ -644,9 +1192,18 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
 
             bool ok = true;
             std::string error_msg;
+            // every operation reads the current row first: the undo step of a write, or the Get result
+            std::unique_ptr<std::string> previous;
+            try {
+                previous = provider->get(parsed.op.key);
+            } catch (const std::exception& e) {
+                ok = false;
+                error_msg = std::string("database read failed: ") + e.what();
+            }
 
-            if (parsed.op.type == PersistenceAdapter::OpType::Insert) {
-                auto previous = provider->get(parsed.op.key);
+            if (!ok) {
+                // ends the transaction below, like a failed write
+            } else if (parsed.op.type == PersistenceAdapter::OpType::Insert) {
                 if (!provider->insert(parsed.op.key, parsed.op.value)) {
                     ok = false;
                     error_msg = "insert failed";
@@ -662,7 +1219,6 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
                     });
                 }
             } else if (parsed.op.type == PersistenceAdapter::OpType::Update) {
-                auto previous = provider->get(parsed.op.key);
                 if (!previous) {
                     ok = false;
                     error_msg = "key not present";
@@ -676,7 +1232,6 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
                     });
                 }
             } else if (parsed.op.type == PersistenceAdapter::OpType::Remove) {
-                auto previous = provider->get(parsed.op.key);
                 if (!previous) {
                     ok = false;
                     error_msg = "key not present";
@@ -690,8 +1245,7 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
                     });
                 }
             } else {
-                auto value = provider->get(parsed.op.key);
-                entry["value"] = value ? nlohmann::json(*value) : nlohmann::json(nullptr);
+                entry["value"] = previous ? nlohmann::json(*previous) : nlohmann::json(nullptr);
             }
 
             entry["status"] = ok ? "ok" : "failed";
@@ -732,6 +1286,35 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
 
     bool overall_success = tx_success && !has_failed_result && errors.empty();
 
+    // clear every inserted key whatever the outcome: when the transaction future throws we cannot tell whether
+    // it committed, and forgetting a key that is still absent only costs one extra read
+    for (const auto& parsed : parsed_ops) {
+        if (parsed.op.type == PersistenceAdapter::OpType::Insert) forgetAbsent(parsed.op.key);
+    }
+
+    // write-ahead log: a replay must not resurrect an older logged write to these keys over the committed ones
+    if (overall_success && recovery_log) {
+        std::vector<WriteBehindQueue::Write> committed;
+        for (const auto& parsed : parsed_ops) {
+            if (parsed.op.type == PersistenceAdapter::OpType::Get) continue;
+            bool remove = parsed.op.type == PersistenceAdapter::OpType::Remove;
+            committed.push_back({parsed.op.key, remove ? WriteBehindQueue::Op::Remove : WriteBehindQueue::Op::Upsert,
+                                 remove ? std::string() : parsed.op.value});
+        }
+        if (!committed.empty() && !recovery_log->append(committed)) {
+            // unretired files may still hold older writes to these keys, which a replay would put back over the
+            // committed values: checkpoint now so they are persisted and deleted
+            if (logging_enabled) std::cerr << "WAL: append of a committed bulk update failed, checkpointing\n";
+            if (!checkpointWal(std::chrono::steady_clock::now() + write_behind_drain_timeout)) {
+                wal_degraded.store(true);
+                push_error("wal_append_failed",
+                           "operations were committed but could not be recorded in the write-ahead log; single-key "
+                           "writes are refused until a checkpoint succeeds");
+                failure_reason = "write-ahead log append failed after commit";
+            }
+        }
+    }
+
     if (overall_success) {
         for (size_t i = 0; i < parsed_ops.size(); ++i) {
             const auto& parsed = parsed_ops[i];
@@ -744,7 +1327,12 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
                     inline_cache.erase(parsed.op.key);
                     break;
                 case PersistenceAdapter::OpType::Get: {
-                    auto fresh = persistence_adapter->get(parsed.op.key);
+                    std::unique_ptr<std::string> fresh;
+                    try {
+                        fresh = persistence_adapter->get(parsed.op.key);
+                    } catch (const std::exception&) {
+                        // unknown: drop the cached copy, the next read hydrates it again
+                    }
                     if (fresh) {
                         inline_cache.update_or_insert(parsed.op.key, *fresh);
                     } else {
@@ -755,6 +1343,7 @@ void KeyValueServer::bulkUpdateHandler(const httplib::Request& req, httplib::Res
             }
         }
     }
+    held_keys.clear();
 
     finalize(overall_success, requested, processed, succeeded, transaction_mode, results, failure_reason);
 }
@@ -772,21 +1361,46 @@ void KeyValueServer::deletionHandler(const httplib::Request& req, httplib::Respo
     }
     if (req.path_params.count("key")) key_str = req.path_params.at("key");
     out["key"] = key_str;
-    int key;
-    if (!parse_int(key_str, key)) {
+    int64_t key;
+    if (!parse_key(key_str, key)) {
         out["error"] = "invalid key format";
         out["reason"] = "path parameter 'key' must be an integer";
         json_response(res, 400, out, "invalid_key_format");
         logResponse(res, std::chrono::steady_clock::now() - start);
         return;
     }
+    auto held_key = holdKey(key);
     std::optional<std::string> previous = inline_cache.get(key);
     bool cache_removed = inline_cache.erase(key);
     bool persistence_checked = false;
     bool persistence_removed = false;
     bool persistence_failure = false;
+    bool read_failed = false;
 
-    if (persistence_adapter) {
+    if (write_behind) {
+        // queue the removal only if the key exists somewhere: cache, queue or persistence
+        persistence_checked = true;
+        bool exists = cache_removed;
+        if (!exists) {
+            if (auto pending = write_behind->pending(key)) {
+                exists = pending->op == WriteBehindQueue::Op::Upsert;
+            } else {
+                try {
+                    exists = persistence_adapter->get(key) != nullptr;
+                } catch (const std::exception&) {
+                    read_failed = true;
+                }
+            }
+        }
+        if (read_failed) {
+            persistence_failure = true;
+        } else if (exists && !queueWrite(key, WriteBehindQueue::Op::Remove)) {
+            persistence_failure = true;
+        } else if (exists) {
+            out["write_behind"] = true;
+        }
+        persistence_removed = exists;
+    } else if (persistence_adapter) {
         persistence_checked = true;
         persistence_removed = persistence_adapter->remove(key);
         if (!persistence_removed && cache_removed) {
@@ -797,7 +1411,8 @@ void KeyValueServer::deletionHandler(const httplib::Request& req, httplib::Respo
     if (persistence_failure) {
         if (previous.has_value()) inline_cache.update_or_insert(key, previous.value());
         out["error"] = "persistence_failure";
-        out["reason"] = "database delete failed";
+        if (read_failed) out["reason"] = "database read failed";
+        else out["reason"] = write_behind ? "write-ahead log append failed" : "database delete failed";
         if (persistence_checked) out["persistence_checked"] = true;
         json_response(res, 500, out, "persistence_error");
         logResponse(res, std::chrono::steady_clock::now() - start);
@@ -831,20 +1446,42 @@ void KeyValueServer::updationHandler(const httplib::Request& req, httplib::Respo
     if (req.path_params.count("value")) value_str = req.path_params.at("value");
     out["key"] = key_str;
     out["value"] = value_str;
-    int key;
-    if (!parse_int(key_str, key)) {
+    int64_t key;
+    if (!parse_key(key_str, key)) {
         out["error"] = "invalid key format";
         out["reason"] = "path parameter 'key' must be an integer";
         json_response(res, 400, out, "invalid_key_format");
         logResponse(res, std::chrono::steady_clock::now() - start);
         return;
     }
+    std::chrono::milliseconds ttl;
+    if (!parse_ttl_param(req, ttl, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    auto held_key = holdKey(key);
     std::optional<std::string> previous = inline_cache.get(key);
     bool hydrated = false;
     bool persistence_checked = false;
     if (!previous && persistence_adapter) {
         persistence_checked = true;
-        if (auto persisted = persistence_adapter->get(key)) {
+        std::unique_ptr<std::string> persisted;
+        if (auto pending = pendingWrite(key)) {
+            if (pending->op == WriteBehindQueue::Op::Upsert) persisted = std::make_unique<std::string>(pending->value);
+        } else {
+            try {
+                persisted = persistence_adapter->get(key);
+            } catch (const std::exception& e) {
+                out["error"] = "persistence_failure";
+                out["reason"] = std::string("database read failed: ") + e.what();
+                out["persistence_checked"] = true;
+                json_response(res, 500, out, "persistence_error");
+                logResponse(res, std::chrono::steady_clock::now() - start);
+                return;
+            }
+        }
+        if (persisted) {
             inline_cache.update_or_insert(key, *persisted);
             previous = inline_cache.get(key);
             hydrated = true;
@@ -860,7 +1497,7 @@ void KeyValueServer::updationHandler(const httplib::Request& req, httplib::Respo
         return;
     }
 
-    bool cache_updated = inline_cache.update(key, value_str);
+    bool cache_updated = inline_cache.update(key, value_str, ttl);
     if (!cache_updated) {
         out["error"] = "not found";
         out["reason"] = "key not present in cache";
@@ -871,7 +1508,10 @@ void KeyValueServer::updationHandler(const httplib::Request& req, httplib::Respo
     }
 
     bool persist_ok = true;
-    if (persistence_adapter) {
+    if (write_behind) {
+        persist_ok = queueWrite(key, WriteBehindQueue::Op::Upsert, value_str);
+        if (persist_ok) out["write_behind"] = true;
+    } else if (persistence_adapter) {
         persistence_checked = true;
     persist_ok = persistence_adapter->update(key, value_str);
     }
@@ -879,12 +1519,12 @@ void KeyValueServer::updationHandler(const httplib::Request& req, httplib::Respo
     if (!persist_ok) {
         if (previous.has_value()) inline_cache.update(key, previous.value());
         out["error"] = "persistence_failure";
-        out["reason"] = "database update failed";
+        out["reason"] = write_behind ? "write-ahead log append failed" : "database update failed";
         if (persistence_checked) out["persistence_checked"] = true;
         json_response(res, 500, out, "persistence_error");
     } else {
         out["updated"] = true;
-        if (persistence_adapter) out["persisted"] = true;
+        if (persistence_adapter && !write_behind) out["persisted"] = true;
         if (hydrated) out["hydrated_from_persistence"] = true;
         if (persistence_checked) out["persistence_checked"] = true;
         json_response(res, 200, out, "updated");
@@ -892,6 +1532,148 @@ void KeyValueServer::updationHandler(const httplib::Request& req, httplib::Respo
     logResponse(res, std::chrono::steady_clock::now() - start);
 }
 
+bool KeyValueServer::parse_string_key(const httplib::Request& req, httplib::Response& res, nlohmann::json& out, StringKey& key,
+                                      std::chrono::steady_clock::time_point start) {
+    std::string key_str = req.path_params.count("key") ? req.path_params.at("key") : std::string();
+    out["key"] = key_str;
+    if (key_str.empty() || !StringKey::from(key_str, key)) {
+        out["error"] = "invalid key format";
+        out["reason"] = "path parameter 'key' must be 1 to " + std::to_string(StringKey::kMaxBytes) + " bytes";
+        json_response(res, 400, out, "invalid_key_format");
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return false;
+    }
+    return true;
+}
+
+void KeyValueServer::getStringKeyHandler(const httplib::Request& req, httplib::Response& res) {
+    auto start = std::chrono::steady_clock::now();
+    logRequest(req);
+    nlohmann::json out;
+    std::string reason_msg;
+    StringKey key;
+    if (!validate_path_params(req, {"key"}, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    if (!parse_string_key(req, res, out, key, start)) return;
+    if (auto v = string_cache.get_handle(key)) {
+        out["found"] = true;
+        json_response_with_value(res, 200, out, std::move(*v), "ok");
+    } else if (auto persisted = persistence_adapter ? persistence_adapter->getStringKey(std::string(key.view())) : nullptr) {
+        out["found"] = true;
+        out["value"] = *persisted;
+        out["source"] = "persistence";
+        out["cache_populated"] = string_cache.insert_if_admitted(key, *persisted);
+        json_response(res, 200, out, "ok");
+    } else {
+        out["found"] = false;
+        out["reason"] = persistence_adapter ? "key not present in cache or persistence" : "key not present in cache";
+        json_response(res, 404, out, "not_found");
+    }
+    logResponse(res, std::chrono::steady_clock::now() - start);
+}
+
+void KeyValueServer::insertStringKeyHandler(const httplib::Request& req, httplib::Response& res) {
+    auto start = std::chrono::steady_clock::now();
+    logRequest(req);
+    nlohmann::json out;
+    std::string reason_msg;
+    StringKey key;
+    if (!validate_path_params(req, {"key","value"}, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    if (!parse_string_key(req, res, out, key, start)) return;
+    std::string value_str = req.path_params.at("value");
+    out["value"] = value_str;
+    std::chrono::milliseconds ttl;
+    if (!parse_ttl_param(req, ttl, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    if (!string_cache.insert_if_absent(key, value_str, ttl)) {
+        out["error"] = "key exists";
+        out["existing_value"] = string_cache.get(key).value_or("");
+        out["reason"] = "insert rejected because key already exists";
+        json_response(res, 409, out, "conflict_key_exists");
+    } else if (persistence_adapter && !persistence_adapter->insertStringKey(std::string(key.view()), value_str)) {
+        string_cache.erase(key);
+        out["error"] = "persistence_failure";
+        out["reason"] = "database insert failed";
+        json_response(res, 500, out, "persistence_error");
+    } else {
+        out["created"] = true;
+        out["persisted"] = static_cast<bool>(persistence_adapter);
+        json_response(res, 201, out, "created");
+    }
+    logResponse(res, std::chrono::steady_clock::now() - start);
+}
+
+void KeyValueServer::updateStringKeyHandler(const httplib::Request& req, httplib::Response& res) {
+    auto start = std::chrono::steady_clock::now();
+    logRequest(req);
+    nlohmann::json out;
+    std::string reason_msg;
+    StringKey key;
+    if (!validate_path_params(req, {"key","value"}, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    if (!parse_string_key(req, res, out, key, start)) return;
+    std::string value_str = req.path_params.at("value");
+    out["value"] = value_str;
+    std::chrono::milliseconds ttl;
+    if (!parse_ttl_param(req, ttl, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    // persistence decides whether the key exists; the cache follows it
+    bool updated = persistence_adapter ? persistence_adapter->updateStringKey(std::string(key.view()), value_str)
+                                       : string_cache.update(key, value_str, ttl);
+    if (!updated) {
+        string_cache.erase(key);
+        out["error"] = "not found";
+        out["reason"] = persistence_adapter ? "key not present in persistence" : "key not present in cache";
+        json_response(res, 404, out, "not_found");
+    } else {
+        if (persistence_adapter) string_cache.update_or_insert(key, value_str, ttl);
+        out["updated"] = true;
+        out["persisted"] = static_cast<bool>(persistence_adapter);
+        json_response(res, 200, out, "updated");
+    }
+    logResponse(res, std::chrono::steady_clock::now() - start);
+}
+
+void KeyValueServer::deleteStringKeyHandler(const httplib::Request& req, httplib::Response& res) {
+    auto start = std::chrono::steady_clock::now();
+    logRequest(req);
+    nlohmann::json out;
+    std::string reason_msg;
+    StringKey key;
+    if (!validate_path_params(req, {"key"}, out, reason_msg)) {
+        json_response(res, 400, out, reason_msg.c_str());
+        logResponse(res, std::chrono::steady_clock::now() - start);
+        return;
+    }
+    if (!parse_string_key(req, res, out, key, start)) return;
+    bool cache_removed = string_cache.erase(key);
+    bool persistence_removed = persistence_adapter && persistence_adapter->removeStringKey(std::string(key.view()));
+    if (cache_removed || persistence_removed) {
+        json_response(res, 204, out, "deleted");
+    } else {
+        out["error"] = "not found";
+        out["reason"] = persistence_adapter ? "key not present in cache or persistence" : "key not present in cache";
+        json_response(res, 404, out, "not_found");
+    }
+    logResponse(res, std::chrono::steady_clock::now() - start);
+}
+
 void KeyValueServer::setupRoutes() {
     server_.Get("/", [this](const auto& r, auto& s) { indexHandler(r, s); });
     server_.Get("/home", [this](const auto& r, auto& s) { homeHandler(r, s); });
@@ -901,11 +1683,32 @@ void KeyValueServer::setupRoutes() {
     server_.Post("/bulk_update", [this](const auto& r, auto& s) { bulkUpdateHandler(r, s); });
     server_.Delete("/delete_key/:key", [this](const auto& r, auto& s) { deletionHandler(r, s); });
     server_.Put("/update_key/:key/:value", [this](const auto& r, auto& s) { updationHandler(r, s); });
+    server_.Get("/get_skey/:key", [this](const auto& r, auto& s) { getStringKeyHandler(r, s); });
+    server_.Post("/insert_skey/:key/:value", [this](const auto& r, auto& s) { insertStringKeyHandler(r, s); });
+    server_.Put("/update_skey/:key/:value", [this](const auto& r, auto& s) { updateStringKeyHandler(r, s); });
+    server_.Delete("/delete_skey/:key", [this](const auto& r, auto& s) { deleteStringKeyHandler(r, s); });
     server_.Get("/health", [this](const auto& r, auto& s) { healthHandler(r, s); });
     server_.Get("/metrics", [this](const auto& r, auto& s) { metricsHandler(r, s); });
     server_.Get("/stop", [this](const auto& r, auto& s) { stopHandler(r, s); });
 }
 
+static const char* policy_label(InlineCache::Policy policy) {
+    switch (policy) {
+        case InlineCache::Policy::LRU: return "LRU";
+        case InlineCache::Policy::FIFO: return "FIFO";
+        case InlineCache::Policy::Clock: return "CLOCK";
+        default: return "Random";
+    }
+}
+
+static const char* storage_label(InlineCache::Storage storage) {
+    return storage == InlineCache::Storage::OpenAddressing ? "open" : "chained";
+}
+
+static const char* admission_label(InlineCache::Admission admission) {
+    return admission == InlineCache::Admission::TinyLFU ? "tinylfu" : "none";
+}
+
 bool KeyValueServer::start() {
     auto emit_startup_log = [&](bool success, const std::string& message) {
             if (!logging_enabled) return;
@@ -915,11 +1718,11 @@ bool KeyValueServer::start() {
             nlohmann::json j;
             j["type"] = "startup";
             j["start_time_ms"] = ms;
-            switch (inline_cache.policy()) {
-                case InlineCache::Policy::LRU: j["cache_policy"] = "LRU"; break;
-                case InlineCache::Policy::FIFO: j["cache_policy"] = "FIFO"; break;
-                default: j["cache_policy"] = "Random"; break;
-            }
+            j["cache_policy"] = policy_label(inline_cache.policy());
+            j["cache_shards"] = inline_cache.shard_count();
+            j["cache_cores"] = inline_cache.core_count();
+            j["cache_storage"] = storage_label(inline_cache.storage());
+            j["cache_admission"] = admission_label(inline_cache.admission());
             j["db_connection_status"] = db_connection_status;
             j["json_logging_enabled"] = json_logging_enabled;
             j["listen"] = { {"host", host_}, {"port", port_} };
@@ -933,7 +1736,11 @@ bool KeyValueServer::start() {
             } else {
                 if (success) {
                     std::cout << "Http server listening at " << host_ << ":" << port_
-                              << " policy=" << (inline_cache.policy() == InlineCache::Policy::LRU ? "LRU" : inline_cache.policy() == InlineCache::Policy::FIFO ? "FIFO" : "Random")
+                              << " policy=" << policy_label(inline_cache.policy())
+                              << " cache_shards=" << inline_cache.shard_count()
+                              << " cache_cores=" << inline_cache.core_count()
+                              << " cache_storage=" << storage_label(inline_cache.storage())
+                              << " cache_admission=" << admission_label(inline_cache.admission())
                               << " db_status=" << db_connection_status
                               << " json_logs=" << (json_logging_enabled?"1":"0");
                     if (!message.empty()) {
@@ -953,10 +1760,9 @@ bool KeyValueServer::start() {
         return false;
     };
 
-    /* uncomment this for compiling test file, also in prod environment make sure USE_PG flag is set true in build*/
-    // Attempt to initialize persistence adapter. Startup is aborted if persistence is unavailable.
-    // if (!persistence_adapter) {
-// #if defined(USE_PG)
+    // Attempt to initialize persistence adapter unless one was injected (tests, embedding).
+    // Startup is aborted if persistence is unavailable.
+    if (!persistence_adapter) {
         try {
             std::string conn = load_conninfo();
             persistence_adapter = std::make_unique<PersistenceAdapter>(conn);
@@ -965,50 +1771,157 @@ bool KeyValueServer::start() {
         } catch (const std::exception &e) {
             return abort_startup(std::string("failed: ") + e.what(), std::string("unable to connect to persistence backend: ") + e.what());
         }
-// #else
-//         return abort_startup("unavailable", "persistence adapter required but binary built without USE_PG support");
-// #endif
-//     } else if (persistence_injected && db_connection_status.empty()) {
-//         db_connection_status = "injected";
-//     }
-
-    // if (!persistence_adapter) {
-    //     return abort_startup("uninitialized", "persistence adapter could not be initialized");
-    // }
-
-    // Preload cache from persistence for keys 1..1000 before accepting connections (unless disabled).
-    size_t preload_attempts = 0;
-    size_t preload_loaded = 0;
-    if (!skip_preload && persistence_adapter) {
-        // iterate and try to load; do not abort startup on missing keys — only log progress
-        const int preload_start = 1;
-        const int preload_end = 1000;
-        for (int k = preload_start; k <= preload_end; ++k) {
-            try {
-                auto vptr = persistence_adapter->get(k);
-                ++preload_attempts;
-                if (vptr && !vptr->empty()) {
-                    // insert into inline cache (insert_if_absent keeps existing entries)
-                    inline_cache.insert_if_absent(k, *vptr);
-                    ++preload_loaded;
-                }
-                if (preload_attempts % 100 == 0) {
-                    if (logging_enabled) {
-                        std::cout << "Preload progress: attempted=" << preload_attempts << " loaded=" << preload_loaded << "\n";
-                    }
-                }
-            } catch (const std::exception &e) {
-                // log and continue
-                if (logging_enabled) std::cerr << "Preload error for key=" << k << " : " << e.what() << "\n";
-            }
+    }
+
+    // Writes acknowledged by an earlier run but maybe never persisted come back from the write-ahead log first.
+    if (!wal_dir.empty() && write_mode == WriteMode::Behind && persistence_adapter) {
+        wal_replay = replayWal();
+        if (!wal_replay.error.empty()) {
+            return abort_startup(db_connection_status, "write-ahead log replay failed: " + wal_replay.error);
         }
     }
 
-    // emit startup log with preload summary
+    // Warm restart from the snapshot, then preload the cache from persistence before accepting connections
+    // (unless disabled, or the snapshot already warmed it).
+    SnapshotRestore snapshot;
+    if (!snapshot_path.empty() && persistence_adapter) snapshot = restoreSnapshot();
+    // A saved hot-key profile replaces the range preload: its keys are read in the background once listening.
+    std::vector<int64_t> hot_preload;
+    if (hot_keys) {
+        hot_keys->load(hot_key_path);
+        if (!skip_preload && persistence_adapter && snapshot.restored == 0) {
+            for (const auto& e : hot_keys->top(hot_keys->capacity())) hot_preload.push_back(e.key);
+        }
+    }
+    PreloadSummary preload;
+    if (!skip_preload && persistence_adapter && snapshot.restored == 0 && hot_preload.empty()) preload = preloadCache();
+
+    // emit startup log with snapshot and preload summary
     std::ostringstream startup_message;
-    startup_message << "preload_attempts=" << preload_attempts << " preload_loaded=" << preload_loaded;
+    if (!snapshot_path.empty()) {
+        startup_message << "snapshot_entries=" << snapshot.entries << " snapshot_restored=" << snapshot.restored
+                        << " snapshot_ms=" << static_cast<long long>(snapshot.ms);
+        if (!snapshot.error.empty()) startup_message << " snapshot_error=\"" << snapshot.error << "\"";
+        startup_message << ' ';
+    }
+    startup_message << "preload_rows=" << preload.rows << " preload_loaded=" << preload.loaded
+                    << " preload_partitions=" << preload.partitions << " preload_ms=" << static_cast<long long>(preload.ms);
+    if (preload.budget_full) startup_message << " preload_budget_full=1";
+    if (hot_keys) startup_message << " hot_keys_tracked=" << hot_keys->size() << " hot_keys_preload=" << hot_preload.size();
+    if (write_mode == WriteMode::Behind && persistence_adapter) {
+        startup_message << " write_mode=behind";
+        // the server drains the queue itself when listening ends, so the destructor does not wait again
+        write_behind = std::make_unique<WriteBehindQueue>(
+            [this](const std::vector<WriteBehindQueue::Write>& batch, std::vector<char>& ok) { flushWriteBehind(batch, ok); },
+            write_behind_max_depth, write_behind_batch, WriteBehindQueue::default_retry_interval,
+            std::chrono::milliseconds(0));
+        if (recovery_log) {
+            startup_message << " wal_replayed=" << wal_replay.records << " wal_writes=" << wal_replay.writes
+                            << " wal_ms=" << static_cast<long long>(wal_replay.ms);
+        }
+    }
     emit_startup_log(true, startup_message.str());
-    return server_.listen(host_, port_);
+    startWalCheckpointer();
+    startTtlSweeper();
+    startSnapshotter();
+    startHotKeySaver();
+    startHotKeyPreload(std::move(hot_preload));
+    bool listened = server_.listen(host_, port_);
+    stopHotKeyPreload();
+    stopHotKeySaver();
+    stopSnapshotter();
+    stopTtlSweeper();
+    stopWalCheckpointer();
+    if (write_behind) {
+        // no handler runs any more: persist everything acknowledged so far
+        bool drained = write_behind->drain(write_behind_drain_timeout);
+        if (!drained && logging_enabled) {
+            std::cerr << "write-behind: " << write_behind->stats().depth << " writes not persisted at shutdown\n";
+        }
+        // all persisted: leave nothing to replay (otherwise the next start replays the log)
+        std::string error;
+        if (drained && recovery_log) {
+            if (uint64_t id = recovery_log->rotate(nullptr, error)) recovery_log->retire(id);
+        }
+        write_behind.reset();
+    }
+    recovery_log.reset();
+    if (!snapshot_path.empty() && persistence_adapter) writeSnapshot();
+    if (hot_keys) saveHotKeys();
+    return listened;
+}
+
+KeyValueServer::PreloadSummary KeyValueServer::preloadCache() {
+    PreloadSummary summary;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&]() {
+        summary.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        return summary;
+    };
+    std::optional<std::pair<int64_t, int64_t>> bounds;
+    try {
+        bounds = persistence_adapter->keyBounds();
+    } catch (const std::exception& e) {
+        if (logging_enabled) std::cerr << "Preload key bounds failed: " << e.what() << "\n";
+    }
+    if (!bounds) {
+        std::vector<int64_t> keys;
+        keys.reserve(1000);
+        for (int64_t k = 1; k <= 1000; ++k) keys.push_back(k);
+        try {
+            for (auto& [key, value] : persistence_adapter->multiGet(keys)) {
+                ++summary.rows;
+                if (inline_cache.insert_if_absent(key, value)) ++summary.loaded;
+            }
+        } catch (const std::exception& e) {
+            if (logging_enabled) std::cerr << "Preload error: " << e.what() << "\n";
+        }
+        return finish();
+    }
+
+    // Equal-width key ranges: offsets from the smallest key in unsigned arithmetic, so any bigint span works.
+    // Stop a little short of the budget: the budget is split across shards, and one that fills first would
+    // evict rows preloaded a moment earlier.
+    const uint64_t span = static_cast<uint64_t>(bounds->second) - static_cast<uint64_t>(bounds->first);
+    const uint64_t parts = span < preload_threads - 1 ? span + 1 : preload_threads;
+    const uint64_t width = span / parts + 1;
+    const size_t budget = cache_max_bytes - cache_max_bytes / 16;
+    std::atomic<size_t> rows{0};
+    std::atomic<size_t> loaded{0};
+    std::atomic<bool> full{false};
+    std::vector<std::thread> scans;
+    for (uint64_t i = 0; i < parts && i * width <= span; ++i) {
+        const uint64_t last = (span - i * width) < width ? span : i * width + width - 1;
+        const int64_t lo = static_cast<int64_t>(static_cast<uint64_t>(bounds->first) + i * width);
+        const int64_t hi = static_cast<int64_t>(static_cast<uint64_t>(bounds->first) + last);
+        scans.emplace_back([this, lo, hi, budget, &rows, &loaded, &full]() {
+            size_t my_rows = 0;
+            size_t my_loaded = 0;
+            bool ok = false;
+            try {
+                ok = persistence_adapter->scanRange(lo, hi, [&](int64_t key, std::string&& value) {
+                    ++my_rows;
+                    if (inline_cache.insert_if_absent(key, value)) ++my_loaded;
+                    if (my_rows % 1024 == 0 && inline_cache.stats().bytes_estimated >= budget) full.store(true);
+                    return !full.load(std::memory_order_relaxed);
+                });
+            } catch (const std::exception& e) {
+                if (logging_enabled) std::cerr << "Preload error for keys " << lo << ".." << hi << ": " << e.what() << "\n";
+            }
+            rows.fetch_add(my_rows);
+            loaded.fetch_add(my_loaded);
+            if (logging_enabled) {
+                std::cout << "Preload keys " << lo << ".." << hi << ": rows=" << my_rows << " loaded=" << my_loaded
+                          << (ok ? "" : " (scan failed)") << "\n";
+            }
+        });
+    }
+    for (auto& t : scans) t.join();
+    summary.rows = rows.load();
+    summary.loaded = loaded.load();
+    summary.partitions = scans.size();
+    summary.budget_full = full.load();
+    return finish();
 }
 
 void KeyValueServer::stop() { server_.stop(); }
@@ -1038,9 +1951,51 @@ void KeyValueServer::json_response(httplib::Response& res, int status, const nlo
     }
 }
 
-bool KeyValueServer::parse_int(const std::string& s, int& out) {
+void KeyValueServer::json_response_with_value(httplib::Response& res, int status, const nlohmann::json& j, ValueHandle value,
+                                              const char* reason) {
+    // Values that need JSON escaping (quotes, backslashes, control or non-ASCII bytes) go through nlohmann.
+    std::string_view bytes = value.view();
+    bool plain = true;
+    for (unsigned char c : bytes) {
+        if (c < 0x20 || c >= 0x7F || c == '"' || c == '\\') {
+            plain = false;
+            break;
+        }
+    }
+    if (!plain) {
+        nlohmann::json copy = j;
+        copy["value"] = value.str();
+        json_response(res, status, copy, reason);
+        return;
+    }
+    // Otherwise write <j without its closing brace>,"value":"<bytes>"} straight from the shared block.
+    std::string prefix = j.dump();
+    prefix.pop_back();
+    prefix += prefix.size() > 1 ? ",\"value\":\"" : "\"value\":\"";
+    static const std::string suffix = "\"}";
+    size_t total = prefix.size() + bytes.size() + suffix.size();
+    res.status = status;
+    res.set_content_provider(total, "application/json",
+        [prefix = std::move(prefix), value = std::move(value)](size_t offset, size_t length, httplib::DataSink& sink) {
+            const std::string_view parts[] = {prefix, value.view(), suffix};
+            size_t end = offset + length;
+            size_t base = 0;
+            for (const auto& part : parts) {
+                size_t lo = std::max(offset, base);
+                size_t hi = std::min(end, base + part.size());
+                if (lo < hi && !sink.write(part.data() + (lo - base), hi - lo)) return false;
+                base += part.size();
+            }
+            return true;
+        });
+    if (reason) {
+        res.reason = reason;
+    }
+}
+
+bool KeyValueServer::parse_key(const std::string& s, int64_t& out) {
     try {
-        size_t idx=0; int v = std::stoi(s, &idx); if (idx != s.size()) return false; out = v; return true;
+        size_t idx=0; long long v = std::stoll(s, &idx); if (idx != s.size()) return false; out = v; return true;
     } catch (...) { return false; }
 }
 
@@ -1065,12 +2020,62 @@ void KeyValueServer::metricsHandler(const httplib::Request& req, httplib::Respon
         return;
     }
     auto st = inline_cache.stats();
-    nlohmann::json out{{"entries",st.size_entries},{"bytes",st.bytes_estimated},{"hits",st.hits},{"misses",st.misses},{"evictions",st.evictions}};
+    nlohmann::json out{{"entries",st.size_entries},{"bytes",st.bytes_estimated},{"bytes_reserved",st.bytes_reserved},{"hits",st.hits},{"misses",st.misses},{"evictions",st.evictions},{"expirations",st.expirations},{"cache_cores",inline_cache.core_count()}};
+    {
+        auto fst = miss_flight.stats();
+        out["miss_coalescing"] = {{"persistence_reads", fst.executions}, {"coalesced", fst.coalesced},
+                                  {"in_flight", miss_flight.in_flight()}};
+        auto nst = negative_cache.stats();
+        out["negative_cache"] = {{"enabled", negative_cache_ttl.count() > 0}, {"ttl_ms", negative_cache_ttl.count()},
+                                 {"entries", nst.size_entries}, {"hits", nst.hits}, {"evictions", nst.evictions},
+                                 {"expirations", nst.expirations}};
+        size_t lookups = st.hits + st.misses;
+        out["hit_ratio"] = lookups ? static_cast<double>(st.hits) / static_cast<double>(lookups) : 0.0;
+        out["admission"] = {{"policy", admission_label(inline_cache.admission())},
+                            {"admitted", st.admitted},
+                            {"rejected", st.rejected}};
+        if (write_behind) {
+            auto wst = write_behind->stats();
+            out["write_behind"] = {{"mode", "behind"}, {"queue_depth", wst.depth}, {"in_flight", wst.in_flight},
+                                   {"enqueued", wst.enqueued}, {"coalesced", wst.coalesced},
+                                   {"coalescing_ratio", wst.enqueued ? static_cast<double>(wst.coalesced) / static_cast<double>(wst.enqueued) : 0.0},
+                                   {"flushed", wst.flushed}, {"failed_attempts", wst.failed}, {"batches", wst.batches},
+                                   {"flush_latency_ms", {{"avg", wst.flush_latency_ms_avg}, {"max", wst.flush_latency_ms_max}}}};
+        } else {
+            out["write_behind"] = {{"mode", "through"}};
+        }
+        if (recovery_log) {
+            auto lst = recovery_log->stats();
+            out["wal"] = {{"enabled", true}, {"dir", recovery_log->dir()}, {"file", lst.generation}, {"file_bytes", lst.bytes},
+                          {"records", lst.records}, {"fsyncs", lst.syncs},
+                          {"records_per_fsync", lst.syncs ? static_cast<double>(lst.records) / static_cast<double>(lst.syncs) : 0.0},
+                          {"checkpoints", wal_checkpoints.load()}, {"degraded", wal_degraded.load()},
+                          {"replayed", {{"files", wal_replay.files}, {"records", wal_replay.records}, {"writes", wal_replay.writes}}}};
+        } else {
+            out["wal"] = {{"enabled", false}};
+        }
+        if (hot_keys) {
+            out["hot_keys"] = {{"enabled", true}, {"tracked", hot_keys->size()}, {"sampled", hot_keys->sampled()},
+                               {"preload", {{"keys", hot_preload_keys.load()}, {"loaded", hot_preload_loaded.load()},
+                                            {"done", hot_preload_done.load()}}}};
+        } else {
+            out["hot_keys"] = {{"enabled", false}};
+        }
+        auto sst = string_cache.stats();
+        out["string_keys"] = {{"entries", sst.size_entries}, {"bytes", sst.bytes_estimated}, {"hits", sst.hits},
+                              {"misses", sst.misses}, {"evictions", sst.evictions}, {"expirations", sst.expirations}};
+    }
     // attach persistence adapter pool metrics if available
     if (auto* ada = dynamic_cast<PersistenceAdapter*>(persistence_adapter.get())) {
         try {
             out["persistence_pool"] = ada->poolMetrics();
         } catch (...) {}
+    } else if (persistence_adapter) {
+        // storage-engine counters of other providers (LocalStore)
+        try {
+            auto store = persistence_adapter->metrics();
+            if (!store.is_null()) out["persistence_store"] = std::move(store);
+        } catch (...) {}
     }
 
     // System metrics (Linux-specific: /proc and /sys). We compute deltas since the last sample
@@ -1341,6 +2346,7 @@ void KeyValueServer::stopHandler(const httplib::Request& req, httplib::Response&
     auto start = std::chrono::steady_clock::now();
     logRequest(req);
     nlohmann::json out{{"stopping",true}};
+    if (write_behind) out["write_behind_pending"] = write_behind->stats().depth; // drained before start() returns
     json_response(res, 200, out, "ok");
     logResponse(res, std::chrono::steady_clock::now() - start);
     stop();
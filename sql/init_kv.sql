@@ -1,13 +1,36 @@
 -- SQL init script for persistent key-value store
--- Creates table, inserts test rows, and selects them for verification
+-- Creates tables, inserts test rows, and selects them for verification
 CREATE TABLE IF NOT EXISTS kv_store (
-    key integer PRIMARY KEY,
-    value text NOT NULL,
+    key bigint PRIMARY KEY,
+    value bytea NOT NULL,
     created_at timestamptz NOT NULL DEFAULT now()
 );
 
+-- Databases created before keys were widened to 64 bits (no-op when the column is already bigint)
+ALTER TABLE kv_store ALTER COLUMN key TYPE bigint;
+
+-- String key space (/get_skey, /insert_skey, ...); keys are raw bytes
+CREATE TABLE IF NOT EXISTS kv_store_bytes (
+    key bytea PRIMARY KEY,
+    value bytea NOT NULL,
+    created_at timestamptz NOT NULL DEFAULT now()
+);
+
+-- Values are raw bytes (sent in binary format, may contain NULs); convert text columns of older databases
+DO $$
+BEGIN
+    IF (SELECT data_type FROM information_schema.columns
+        WHERE table_name = 'kv_store' AND column_name = 'value') = 'text' THEN
+        ALTER TABLE kv_store ALTER COLUMN value TYPE bytea USING convert_to(value, 'UTF8');
+    END IF;
+    IF (SELECT data_type FROM information_schema.columns
+        WHERE table_name = 'kv_store_bytes' AND column_name = 'value') = 'text' THEN
+        ALTER TABLE kv_store_bytes ALTER COLUMN value TYPE bytea USING convert_to(value, 'UTF8');
+    END IF;
+END $$;
+
 INSERT INTO kv_store (key, value) VALUES (1, 'foo') ON CONFLICT (key) DO NOTHING;
 INSERT INTO kv_store (key, value) VALUES (2, 'bar') ON CONFLICT (key) DO NOTHING;
 
 -- Show a few rows for verification
-SELECT * FROM kv_store LIMIT 10;
\ No newline at end of file
+SELECT key, convert_from(value, 'UTF8') AS value, created_at FROM kv_store LIMIT 10;
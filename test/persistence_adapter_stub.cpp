@@ -6,10 +6,20 @@ struct PersistenceAdapter::Impl { };
 PersistenceAdapter::PersistenceAdapter(const std::string &conninfo) : p_(nullptr) {}
 PersistenceAdapter::~PersistenceAdapter() {}
 
-bool PersistenceAdapter::insert(int, const std::string&) { return true; }
-bool PersistenceAdapter::update(int, const std::string&) { return true; }
-bool PersistenceAdapter::remove(int) { return true; }
-std::unique_ptr<std::string> PersistenceAdapter::get(int) { return nullptr; }
+bool PersistenceAdapter::insert(int64_t, const std::string&) { return true; }
+bool PersistenceAdapter::update(int64_t, const std::string&) { return true; }
+bool PersistenceAdapter::remove(int64_t) { return true; }
+std::unique_ptr<std::string> PersistenceAdapter::get(int64_t) { return nullptr; }
+std::unordered_map<int64_t, std::string> PersistenceAdapter::multiGet(const std::vector<int64_t>&) { return {}; }
+bool PersistenceAdapter::scanRange(int64_t, int64_t, const RowSink&) { return false; }
+std::optional<std::pair<int64_t, int64_t>> PersistenceAdapter::keyBounds() { return std::nullopt; }
+std::optional<int64_t> PersistenceAdapter::versionNow() { return std::nullopt; }
+std::vector<int64_t> PersistenceAdapter::unchangedSince(const std::vector<int64_t>&, int64_t) { return {}; }
+
+bool PersistenceAdapter::insertStringKey(const std::string&, const std::string&) { return true; }
+bool PersistenceAdapter::updateStringKey(const std::string&, const std::string&) { return true; }
+bool PersistenceAdapter::removeStringKey(const std::string&) { return true; }
+std::unique_ptr<std::string> PersistenceAdapter::getStringKey(const std::string&) { return nullptr; }
 
 PersistenceAdapter::TxResult PersistenceAdapter::runTransaction(const std::vector<Operation>& ops, TxMode mode) {
     TxResult r; r.success = true; return r;
@@ -21,7 +31,7 @@ nlohmann::json PersistenceAdapter::runTransactionJson(const std::vector<Operatio
     return j;
 }
 
-std::future<std::unique_ptr<std::string>> PersistenceAdapter::getAsync(int key) {
+std::future<std::unique_ptr<std::string>> PersistenceAdapter::getAsync(int64_t key) {
     std::promise<std::unique_ptr<std::string>> p; p.set_value(nullptr);
     return p.get_future();
 }
@@ -31,5 +41,9 @@ std::future<nlohmann::json> PersistenceAdapter::runTransactionJsonAsync(const st
     return p.get_future();
 }
 
+void PersistenceAdapter::setPipelining(bool) {}
+bool PersistenceAdapter::pipelining() const { return false; }
+void PersistenceAdapter::setWriteBatching(size_t, std::chrono::microseconds) {}
+bool PersistenceAdapter::binaryValues() const { return false; }
 int PersistenceAdapter::droppedPoolConnections() const { return 0; }
 nlohmann::json PersistenceAdapter::poolMetrics() const { return nlohmann::json::object(); }
@@ -1,9 +1,23 @@
 #include "inline_cache.h"
+#include "core_affinity_cache.h"
+#include "single_flight.h"
+#include "cache_snapshot.h"
+#include "hot_key_profile.h"
+#include "recovery_log.h"
 #include <iostream>
 #include <string>
+#include <optional>
 #include <vector>
 #include <thread>
+#include <atomic>
 #include <chrono>
+#include <unordered_map>
+#include <random>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
 
 static bool expect(bool cond, const char* msg) {
     if (!cond) std::cerr << "ASSERT FAILED: " << msg << "\n";
@@ -83,6 +97,45 @@ int main() {
         }
     }
 
+    // FIFO tombstones: erased keys leave stale ring entries that must be skipped, even when their slot is reused
+    {
+        std::string val = "f";
+        size_t per = estimate_entry_bytes(val);
+        InlineCache cache{InlineCache::Policy::FIFO, per * 2 + 16};
+        cache.update_or_insert(31, val);
+        cache.update_or_insert(32, val);
+        cache.erase(31);
+        cache.update_or_insert(33, val); // reuses 31's slot, no eviction needed
+        failures += !expect(cache.stats().evictions == 0, "FIFO: no eviction while under budget");
+        cache.update_or_insert(34, val); // oldest live insertion is 32
+        failures += !expect(!cache.get(32).has_value(), "FIFO: oldest live key evicted, tombstone skipped");
+        failures += !expect(cache.get(33).has_value() && cache.get(34).has_value(), "FIFO: newer keys remain");
+        cache.update_or_insert(35, val);
+        failures += !expect(!cache.get(33).has_value() && cache.get(35).has_value(), "FIFO: recycled slot keeps its own insertion order");
+        // heavy erase churn must not grow eviction cost or lose order
+        for (int k = 1000; k < 5000; ++k) { cache.update_or_insert(k, val); cache.erase(k); }
+        cache.update_or_insert(36, val);
+        failures += !expect(!cache.get(34).has_value() && cache.get(35).has_value() && cache.get(36).has_value(), "FIFO: order preserved across ring compaction");
+    }
+
+    // CLOCK eviction: a referenced entry gets a second chance, the unreferenced one is the victim
+    {
+        std::string val = "c";
+        size_t per = estimate_entry_bytes(val);
+        InlineCache cache{InlineCache::Policy::Clock, per * 2 + 16};
+        cache.update_or_insert(21, val);
+        cache.update_or_insert(22, val);
+        (void)cache.get(21); // sets reference bit of 21
+        cache.update_or_insert(23, val);
+        failures += !expect(cache.stats().evictions == 1, "CLOCK: exactly one eviction expected");
+        failures += !expect(cache.get(21).has_value(), "CLOCK: referenced key survives");
+        failures += !expect(!cache.get(22).has_value(), "CLOCK: unreferenced key evicted");
+        failures += !expect(cache.get(23).has_value(), "CLOCK: new key present");
+        // slots freed by eviction are reused
+        for (int k = 24; k < 64; ++k) cache.update_or_insert(k, val);
+        failures += !expect(cache.stats().size_entries == 2, "CLOCK: size bounded by budget");
+    }
+
     // RANDOM eviction: ensure evictions occur and size bounded
     {
         std::string val(32, 'z');
@@ -95,6 +148,428 @@ int main() {
         failures += !expect(st.bytes_estimated <= (per * 4 + 16), "Random: bytes should be <= budget");
     }
 
+    // Sharded LRU: each shard owns a slice of the budget, so filling one shard never evicts another shard's keys
+    {
+        std::string val = "s";
+        size_t per = estimate_entry_bytes(val);
+        InlineCache cache{InlineCache::Policy::LRU, (per * 2 + 16) * 4, 1031, 4};
+        failures += !expect(cache.shard_count() == 4, "Sharded: shard_count should report 4");
+        cache.update_or_insert(1, val);                               // shard 1
+        for (int k = 0; k < 40; k += 4) cache.update_or_insert(k, val); // all land in shard 0
+        failures += !expect(cache.get(1).has_value(), "Sharded: key in untouched shard must survive");
+        failures += !expect(cache.get(36).has_value(), "Sharded: most recent key in busy shard present");
+        failures += !expect(!cache.get(0).has_value(), "Sharded: oldest key in busy shard evicted");
+        failures += !expect(cache.stats().evictions > 0, "Sharded: busy shard should evict");
+    }
+
+    // Open-addressing storage: same API and eviction behaviour as the chained index
+    {
+        using S = InlineCache::Storage;
+        InlineCache cache{InlineCache::Policy::LRU, 10 * 1024 * 1024, 1031, 4, S::OpenAddressing};
+        failures += !expect(cache.storage() == S::OpenAddressing, "Open: storage() should report OpenAddressing");
+        failures += !expect(cache.insert_if_absent(10, "a"), "Open: insert_if_absent should insert new");
+        failures += !expect(!cache.insert_if_absent(10, "b"), "Open: insert_if_absent should not overwrite");
+        failures += !expect(cache.get(10).value_or("") == "a", "Open: get returns inserted value");
+        failures += !expect(cache.update(10, "c") && cache.get(10).value_or("") == "c", "Open: update replaces value");
+        failures += !expect(!cache.update(11, "x"), "Open: update of missing key fails");
+        failures += !expect(cache.erase(10) && !cache.get(10).has_value(), "Open: erase removes key");
+        failures += !expect(!cache.erase(10), "Open: second erase returns false");
+
+        std::string val = "v";
+        size_t per = estimate_entry_bytes(val);
+        InlineCache small{InlineCache::Policy::LRU, per * 2 + 16, 1031, 1, S::OpenAddressing};
+        small.update_or_insert(1, val);
+        small.update_or_insert(2, val);
+        (void)small.get(1);
+        small.update_or_insert(3, val);
+        failures += !expect(small.get(1).has_value() && !small.get(2).has_value(), "Open: LRU evicts least recent");
+    }
+
+    // Open-addressing churn: random inserts/erases against a reference map, crossing several
+    // index rebuilds (growth and tombstone purges)
+    {
+        InlineCache cache{InlineCache::Policy::FIFO, SIZE_MAX / 2, 16, 2, InlineCache::Storage::OpenAddressing};
+        std::unordered_map<int, std::string> ref;
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> keyDist(-5000, 5000);
+        for (int i = 0; i < 50000; ++i) {
+            int k = keyDist(rng);
+            if (rng() % 3 == 0) {
+                bool had = ref.erase(k) > 0;
+                if (cache.erase(k) != had) { failures += !expect(false, "Open churn: erase result mismatch"); break; }
+            } else {
+                std::string v = std::to_string(i);
+                ref[k] = v;
+                cache.update_or_insert(k, v);
+            }
+        }
+        bool allMatch = cache.stats().size_entries == ref.size();
+        for (const auto& kv : ref) allMatch = allMatch && cache.get(kv.first).value_or("") == kv.second;
+        for (int k = 5001; k < 5100; ++k) allMatch = allMatch && !cache.get(k).has_value();
+        failures += !expect(allMatch, "Open churn: contents match reference map");
+    }
+
+    // Slab-backed values: inline, size-classed and large values round-trip, updates change size class,
+    // and steady-state churn reuses freed blocks instead of growing the arena
+    {
+        InlineCache cache{InlineCache::Policy::LRU, 64 * 1024 * 1024};
+        const size_t sizes[] = {0, 1, 24, 25, 100, 1000, 5000, 40000, 100000};
+        bool roundTrip = true;
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            std::string v(sizes[i], static_cast<char>('a' + i));
+            if (!v.empty()) v.back() = '\0'; // embedded NULs are preserved
+            cache.update_or_insert(static_cast<int>(i), v);
+            roundTrip = roundTrip && cache.get(static_cast<int>(i)).value_or("?") == v;
+        }
+        failures += !expect(roundTrip, "Arena: values of every size class round-trip");
+
+        // a freed block keeps refs == 0 for stale optimistic readers, and its free-list link stays intact
+        SlabArena arena;
+        const size_t blockSize = sizeof(ValueBlock) + 100;
+        std::vector<ValueBlock*> freed;
+        uint8_t cls = 0;
+        for (int i = 0; i < 3; ++i) {
+            ValueBlock* b = new (arena.allocate(blockSize, cls)) ValueBlock;
+            b->refs.store(0);
+            b->length = 100;
+            freed.push_back(b);
+        }
+        for (ValueBlock* b : freed) arena.deallocate(reinterpret_cast<char*>(b), cls, blockSize);
+        bool zero = true;
+        for (ValueBlock* b : freed) zero = zero && b->refs.load() == 0 && !b->tryRetain();
+        failures += !expect(zero, "Arena: free blocks keep a zero refcount");
+        bool reused = true;
+        for (int i = 2; i >= 0; --i) reused = reused && arena.allocate(blockSize, cls) == reinterpret_cast<char*>(freed[i]);
+        failures += !expect(reused, "Arena: free list intact after reads of freed headers");
+
+        std::string grown(3000, 'g'), shrunk(10, 's'), same(99, 'x');
+        failures += !expect(cache.update(4, same) && cache.get(4).value_or("") == same, "Arena: in-place update within class");
+        failures += !expect(cache.update(4, grown) && cache.get(4).value_or("") == grown, "Arena: update grows to larger class");
+        failures += !expect(cache.update(4, shrunk) && cache.get(4).value_or("") == shrunk, "Arena: update shrinks to inline");
+
+        InlineCache fresh{InlineCache::Policy::LRU, 64 * 1024 * 1024};
+        fresh.update_or_insert(1, std::string(100, 'p'));
+        size_t single = fresh.stats().bytes_estimated;
+        fresh.update_or_insert(2, std::string(100, 'q'));
+        failures += !expect(fresh.stats().bytes_estimated == 2 * single, "Arena: each entry charged slot + block");
+        failures += !expect(fresh.stats().bytes_reserved >= fresh.stats().bytes_estimated, "Arena: reserved covers live bytes");
+
+        InlineCache churn{InlineCache::Policy::FIFO, 200 * 1024};
+        for (int k = 0; k < 2000; ++k) churn.update_or_insert(k, std::string(100 + k % 200, 'c'));
+        size_t reserved = churn.stats().bytes_reserved;
+        for (int k = 2000; k < 20000; ++k) churn.update_or_insert(k, std::string(100 + k % 200, 'c'));
+        failures += !expect(churn.stats().bytes_reserved == reserved, "Arena: steady-state churn allocates nothing");
+        failures += !expect(churn.stats().bytes_estimated <= 200 * 1024, "Arena: budget holds real bytes");
+    }
+
+    // Value handles: share the cached block, stay valid and unchanged after the entry is updated, erased or
+    // evicted, and hand their block back to the shard once dropped
+    {
+        InlineCache cache{InlineCache::Policy::LRU, 64 * 1024 * 1024};
+        std::string big(1000, 'h'), small = "tiny";
+        cache.update_or_insert(1, big);
+        cache.update_or_insert(2, small);
+        auto h1 = cache.get_handle(1);
+        auto h2 = cache.get_handle(2);
+        failures += !expect(h1 && h1->view() == big && h2 && h2->view() == small, "Handle: views match cached values");
+        failures += !expect(!cache.get_handle(3).has_value(), "Handle: miss returns nullopt");
+        auto copy = *h1;
+        cache.update(1, std::string(1000, 'u')); // same size class, but shared: must not be rewritten in place
+        failures += !expect(h1->view() == big && copy.view() == big, "Handle: held value immutable across update");
+        failures += !expect(cache.get(1).value_or("") == std::string(1000, 'u'), "Handle: cache sees new value");
+        cache.erase(1);
+        failures += !expect(h1->view() == big, "Handle: value outlives erased entry");
+
+        size_t before = 0;
+        for (int round = 0; round < 200; ++round) {
+            if (round == 1) before = cache.stats().bytes_reserved; // first round allocates the class slab
+            cache.update_or_insert(10, std::string(500, static_cast<char>('a' + round % 26)));
+            auto held = cache.get_handle(10); // dropped at end of round, after the entry moved on
+            cache.update_or_insert(10, std::string(500, 'z'));
+        }
+        failures += !expect(cache.stats().bytes_reserved == before, "Handle: released blocks are recycled");
+    }
+
+    // Frequency sketch: counts saturate at 15 and are halved by aging
+    {
+        FrequencySketch sketch{64};
+        for (int i = 0; i < 5; ++i) sketch.increment(7);
+        failures += !expect(sketch.frequency(7) >= 5, "Sketch: frequency counts increments");
+        failures += !expect(sketch.frequency(8) <= 1, "Sketch: unseen key has (near) zero frequency");
+        for (int i = 0; i < 40; ++i) sketch.increment(9);
+        failures += !expect(sketch.frequency(9) == FrequencySketch::kMaxCount, "Sketch: counters saturate");
+        for (int k = 1000; sketch.resets() == 0 && k < 3000; ++k) sketch.increment(k);
+        failures += !expect(sketch.resets() == 1, "Sketch: aging runs after sample size increments");
+        failures += !expect(sketch.frequency(9) <= 8, "Sketch: aging halves counters");
+    }
+
+    // TinyLFU admission: a one-off key cannot displace a frequently read one; a popular key can
+    {
+        std::string val = "t";
+        size_t per = estimate_entry_bytes(val);
+        InlineCache cache{InlineCache::Policy::LRU, per * 2 + 16, 1031, 1, InlineCache::Storage::Chained,
+                          InlineCache::Admission::TinyLFU};
+        failures += !expect(cache.insert_if_admitted(1, val) && cache.insert_if_admitted(2, val), "Admission: fills free space");
+        for (int i = 0; i < 4; ++i) { (void)cache.get(1); (void)cache.get(2); }
+        (void)cache.get(3); // single miss
+        failures += !expect(!cache.insert_if_admitted(3, val), "Admission: cold key rejected");
+        failures += !expect(cache.get(1).has_value() && cache.get(2).has_value(), "Admission: hot keys kept");
+        for (int i = 0; i < 10; ++i) (void)cache.get(4);
+        failures += !expect(cache.insert_if_admitted(4, val), "Admission: popular key admitted");
+        failures += !expect(cache.get(4).has_value() && cache.stats().size_entries == 2, "Admission: victim displaced");
+        auto st = cache.stats();
+        failures += !expect(st.admitted == 1 && st.rejected == 1, "Admission: admit/reject counters");
+        failures += !expect(cache.update_or_insert(5, val) && cache.get(5).has_value(), "Admission: plain inserts bypass filter");
+    }
+
+    // Key/value specializations: 64-bit keys past 2^31, inline short-string keys and fixed-width values
+    // behave like the int/string cache on both engines and keep one 64-byte slot per entry
+    for (auto storage : {InlineCache::Storage::Chained, InlineCache::Storage::OpenAddressing}) {
+        BasicInlineCache<int64_t> wide{InlineCache::Policy::LRU, 1 << 20, 64, 4, storage};
+        const int64_t big = (int64_t{1} << 40) + 3;
+        failures += !expect(wide.update_or_insert(big, "far") && wide.update_or_insert(3, "near"), "Int64 keys: insert");
+        failures += !expect(wide.get(big) == std::string("far") && wide.get(3) == std::string("near"),
+                            "Int64 keys: keys equal modulo 2^32 stay distinct");
+        failures += !expect(wide.erase(big) && !wide.get(big) && wide.get(3), "Int64 keys: erase");
+
+        BasicInlineCache<ShortKey<15>> named{InlineCache::Policy::LRU, 1 << 20, 64, 2, storage};
+        ShortKey<15> user, other, tooLong;
+        failures += !expect(ShortKey<15>::from("user:42", user) && ShortKey<15>::from("user:4", other),
+                            "Short keys: build from strings");
+        failures += !expect(!ShortKey<15>::from("a-key-longer-than-15", tooLong), "Short keys: overlong key rejected");
+        named.update_or_insert(user, std::string(100, 'u'));
+        named.update_or_insert(other, "o");
+        failures += !expect(named.get(user) == std::string(100, 'u') && named.get(other) == std::string("o"),
+                            "Short keys: lookup by value");
+        failures += !expect(named.stats().bytes_estimated == 2 * 64 + SlabArena::block_bytes(sizeof(ValueBlock) + 100),
+                            "Short keys: 64-byte entries, long values in slabs");
+
+        BasicInlineCache<int64_t, uint64_t> counters{InlineCache::Policy::LRU, 1 << 20, 64, 1, storage};
+        for (int64_t k = 0; k < 500; ++k) counters.update_or_insert(k, static_cast<uint64_t>(k * k));
+        bool allMatch = true;
+        for (int64_t k = 0; k < 500; ++k) allMatch = allMatch && counters.get(k) == static_cast<uint64_t>(k * k);
+        failures += !expect(allMatch, "Fixed-width values: round-trip");
+        auto st = counters.stats();
+        failures += !expect(st.bytes_estimated == 500 * 64, "Fixed-width values: stored inline, 64 bytes per entry");
+    }
+
+    // Timing wheel: only due timers fire, a budget interrupts and resumes a walk, and deadlines more than one
+    // revolution out wait for their round
+    {
+        TimingWheel wheel;
+        uint64_t base = 1000000;
+        uint64_t far = base + TimingWheel::kSlots * TimingWheel::kTickMs + 5;
+        wheel.advance(base, 0, [](uint32_t, uint64_t) {});
+        for (uint32_t id = 0; id < 10; ++id) wheel.schedule(id, base + 20);
+        wheel.schedule(10, far);
+        std::vector<uint32_t> fired;
+        auto collect = [&](uint32_t id, uint64_t) { fired.push_back(id); };
+        failures += !expect(wheel.advance(base + 10, 100, collect) == 0, "Wheel: nothing due early");
+        failures += !expect(wheel.advance(base + 20, 4, collect) == 4, "Wheel: budget bounds a walk");
+        failures += !expect(wheel.advance(base + 20, 100, collect) == 6, "Wheel: interrupted walk resumes");
+        failures += !expect(wheel.advance(far - 1, 100, collect) == 0 && wheel.size() == 1, "Wheel: later round kept");
+        failures += !expect(wheel.advance(far, 100, collect) == 1 && fired.size() == 11 && fired.back() == 10,
+                            "Wheel: far deadline fires on its round");
+    }
+
+    // TTL: expired entries read as misses, writers treat them as absent, expire() reclaims them, and a write
+    // without a TTL clears one; for both engines
+    for (auto storage : {InlineCache::Storage::Chained, InlineCache::Storage::OpenAddressing}) {
+        using std::chrono::milliseconds;
+        InlineCache cache{InlineCache::Policy::LRU, 1 << 20, 64, 2, storage};
+        std::string big(100, 'x');
+        failures += !expect(cache.insert_if_absent(1, "short", milliseconds(40)), "TTL: insert with ttl");
+        failures += !expect(cache.update_or_insert(2, big, milliseconds(40)), "TTL: slab value with ttl");
+        cache.update_or_insert(3, "kept", milliseconds(40));
+        cache.update_or_insert(3, "kept");                      // rewrite without ttl clears it
+        cache.update_or_insert(4, "forever");
+        cache.update_or_insert(5, "rearmed", milliseconds(40));
+        cache.update_or_insert(5, "rearmed", milliseconds(60000)); // old timer is superseded
+        failures += !expect(cache.get(1) == std::string("short") && cache.get(2) == big, "TTL: live before deadline");
+        std::this_thread::sleep_for(milliseconds(80));
+        failures += !expect(!cache.get(1) && !cache.get_handle(2), "TTL: expired entries miss");
+        failures += !expect(cache.stats().size_entries == 5, "TTL: readers leave expired entries in place");
+        failures += !expect(cache.insert_if_absent(1, "again"), "TTL: insert_if_absent replaces an expired entry");
+        failures += !expect(cache.expire() == 1, "TTL: expire() removes the remaining due entry");
+        auto st = cache.stats();
+        failures += !expect(st.expirations == 2 && st.size_entries == 4, "TTL: expirations counted");
+        failures += !expect(cache.get(3) && cache.get(4) && cache.get(5) && cache.get(1) == std::string("again"),
+                            "TTL: untimed, cleared and re-armed entries survive");
+        failures += !expect(cache.expire() == 0, "TTL: nothing left to expire");
+        failures += !expect(st.bytes_estimated == 4 * estimate_entry_bytes("kept"), "TTL: expired bytes released");
+    }
+
+    // Warm restart: for_each_entry visits the LRU list coldest first with reference bits and skips TTL entries;
+    // restoring the visit through a snapshot file rebuilds list and bits, and a damaged snapshot is refused
+    for (auto storage : {InlineCache::Storage::Chained, InlineCache::Storage::OpenAddressing}) {
+        InlineCache cache{InlineCache::Policy::LRU, 1 << 20, 64, 1, storage};
+        for (int k = 1; k <= 4; ++k) cache.update_or_insert(k, "v" + std::to_string(k));
+        cache.update_or_insert(9, "timed", std::chrono::milliseconds(60000));
+        cache.get(1); // list stays 1 2 3 4 (coldest first); the hit only sets 1's reference bit
+        const std::string path = "/tmp/kv_test_cache_snapshot.bin";
+        CacheSnapshot::Writer writer;
+        failures += !expect(writer.open(path), "Snapshot: writer opens");
+        std::vector<int> visited, referenced_keys;
+        cache.for_each_entry([&](int key, std::string_view value, bool referenced) {
+            visited.push_back(key);
+            if (referenced) referenced_keys.push_back(key);
+            writer.add(key, value, referenced);
+        });
+        failures += !expect(visited == std::vector<int>({1, 2, 3, 4}), "Snapshot: LRU visited coldest first, TTL skipped");
+        failures += !expect(referenced_keys == std::vector<int>({1}), "Snapshot: reference bits visited");
+        failures += !expect(writer.commit(static_cast<uint32_t>(cache.policy()), 42, 0), "Snapshot: commit");
+
+        CacheSnapshot::Reader reader;
+        std::string error;
+        failures += !expect(reader.open(path, error), "Snapshot: reader verifies the file");
+        failures += !expect(reader.header().entries == 4 && reader.header().version == 42, "Snapshot: header");
+        InlineCache restored{InlineCache::Policy::LRU, 1 << 20, 64, 1, storage};
+        restored.update_or_insert(3, "newer"); // already cached: restore leaves it alone
+        size_t inserted = 0;
+        reader.for_each([&](int64_t key, std::string_view value, bool referenced) {
+            inserted += restored.restore_entry(static_cast<int>(key), value, referenced);
+        });
+        failures += !expect(inserted == 3, "Snapshot: restore skips keys already cached");
+        std::vector<int> order;
+        referenced_keys.clear();
+        restored.for_each_entry([&](int key, std::string_view, bool referenced) {
+            order.push_back(key);
+            if (referenced) referenced_keys.push_back(key);
+        });
+        failures += !expect(order == std::vector<int>({3, 1, 2, 4}) && referenced_keys == std::vector<int>({1}),
+                            "Snapshot: restored LRU order and reference bits");
+        failures += !expect(restored.get(1) == std::string("v1") && restored.get(3) == std::string("newer"),
+                            "Snapshot: restored values");
+
+        { // flip one value byte
+            std::FILE* f = std::fopen(path.c_str(), "r+b");
+            std::fseek(f, sizeof(CacheSnapshot::Header) + 13, SEEK_SET);
+            std::fputc('X', f);
+            std::fclose(f);
+        }
+        CacheSnapshot::Reader damaged;
+        failures += !expect(!damaged.open(path, error) && error == "checksum mismatch", "Snapshot: corruption detected");
+        std::remove(path.c_str());
+    }
+
+    // Hot-key profile: heavy hitters survive a stream of one-off keys, decay halves counts, and a saved profile
+    // loads back hottest first
+    {
+        HotKeyProfile profile(8, 1);
+        for (int round = 0; round < 200; ++round) {
+            profile.record(1);
+            if (round % 2 == 0) profile.record(2);
+            profile.record(1000 + round); // noise: every key seen once
+        }
+        auto top = profile.top(2);
+        failures += !expect(top.size() == 2 && top[0].key == 1 && top[1].key == 2, "HotKeys: heavy hitters ranked first");
+        failures += !expect(profile.size() == 8 && profile.sampled() == 500, "HotKeys: fixed counters, every call sampled");
+        const uint64_t before = top[0].count;
+        profile.decay();
+        failures += !expect(profile.top(1)[0].count == before / 2, "HotKeys: decay halves counts");
+
+        const std::string path = "/tmp/kv_test_hot_keys.txt";
+        failures += !expect(profile.save(path), "HotKeys: save");
+        HotKeyProfile loaded(8, 1);
+        failures += !expect(loaded.load(path), "HotKeys: load");
+        auto again = loaded.top(2);
+        failures += !expect(again.size() == 2 && again[0].key == 1 && again[0].count == before / 2 && again[1].key == 2,
+                            "HotKeys: saved order and counts restored");
+        failures += !expect(!loaded.load("/tmp/kv_test_hot_keys_missing.txt"), "HotKeys: missing profile");
+        std::remove(path.c_str());
+    }
+
+    // Recovery log: a restart replays the latest write per key from the earlier files, a batch record comes
+    // back whole, a torn tail ends a file, and retired files are gone
+    {
+        using W = WriteBehindQueue::Write;
+        using Op = WriteBehindQueue::Op;
+        const std::string dir = "/tmp/kv_test_recovery_log";
+        std::filesystem::remove_all(dir);
+        std::string error;
+        uint64_t first_file = 0;
+        {
+            RecoveryLog log;
+            failures += !expect(log.open(dir, RecoveryLog::Options{}, error), "RecoveryLog: open");
+            first_file = log.stats().generation;
+            int queued = 0;
+            failures += !expect(log.append({W{1, Op::Upsert, "a"}}, [&] { ++queued; }) && queued == 1,
+                                "RecoveryLog: after_sync runs once durable");
+            log.append({W{2, Op::Upsert, "b"}});
+            log.append({W{1, Op::Upsert, "a2"}, W{3, Op::Upsert, std::string("\0c", 2)}, W{2, Op::Remove, ""}});
+            failures += !expect(log.replay().writes.empty(), "RecoveryLog: the current file is not replayed");
+            failures += !expect(log.stats().records == 3 && log.stats().syncs >= 1, "RecoveryLog: counters");
+        }
+        {
+            std::ofstream f(dir + "/wal-" + std::to_string(first_file) + ".log", std::ios::binary | std::ios::app);
+            f.write("\x30\x00\x00\x00torn", 8);
+        }
+        RecoveryLog log;
+        failures += !expect(log.open(dir, RecoveryLog::Options{}, error) && log.stats().generation == first_file + 1,
+                            "RecoveryLog: reopen starts a new file");
+        auto replay = log.replay();
+        std::unordered_map<int64_t, W> latest;
+        for (const auto& w : replay.writes) latest.emplace(w.key, w);
+        failures += !expect(replay.records == 3 && replay.files == 1 && latest.size() == 3, "RecoveryLog: replay up to the torn tail");
+        failures += !expect(latest[1].value == "a2" && latest[3].value == std::string("\0c", 2) && latest[2].op == Op::Remove,
+                            "RecoveryLog: latest write per key");
+
+        bool switched = false;
+        const uint64_t next = log.rotate([&] { switched = true; }, error);
+        failures += !expect(next == first_file + 2 && switched && log.stats().generation == next, "RecoveryLog: rotate");
+        log.retire(next);
+        failures += !expect(!std::filesystem::exists(dir + "/wal-" + std::to_string(first_file) + ".log") &&
+                                std::filesystem::exists(dir + "/wal-" + std::to_string(next) + ".log"),
+                            "RecoveryLog: retire deletes the older files");
+        std::vector<W> decoded;
+        const std::string payload = RecoveryLog::encode({W{7, Op::Upsert, "seven"}});
+        failures += !expect(!RecoveryLog::decode(std::string_view(payload).substr(0, payload.size() - 1), decoded),
+                            "RecoveryLog: truncated payload refused");
+        std::filesystem::remove_all(dir);
+    }
+
+    // Write-behind persistence tickets: wait_persisted() covers a write and all earlier ones, and a write that
+    // lands while its key is being flushed does not hold back tickets older than itself
+    {
+        std::mutex gate_mtx;
+        std::condition_variable gate_cv;
+        int allowed = 0; // flush calls allowed to finish
+        int calls = 0;
+        {
+            WriteBehindQueue queue(
+                [&](const std::vector<WriteBehindQueue::Write>& batch, std::vector<char>& ok) {
+                    std::unique_lock<std::mutex> lk(gate_mtx);
+                    int mine = ++calls;
+                    gate_cv.notify_all();
+                    gate_cv.wait(lk, [&] { return allowed >= mine; });
+                    std::fill(ok.begin(), ok.begin() + batch.size(), 1);
+                },
+                16, 16, std::chrono::milliseconds(1), std::chrono::milliseconds(1000));
+            const uint64_t t1 = queue.put(1, WriteBehindQueue::Op::Upsert, "a");
+            {
+                std::unique_lock<std::mutex> lk(gate_mtx);
+                gate_cv.wait(lk, [&] { return calls == 1; }); // key 1 is in flight
+            }
+            const uint64_t t2 = queue.put(1, WriteBehindQueue::Op::Upsert, "b");
+            failures += !expect(t2 == t1 + 1 && !queue.wait_persisted(t1, std::chrono::milliseconds(20)),
+                                "Tickets: an in-flight write is not persisted yet");
+            {
+                std::lock_guard<std::mutex> lk(gate_mtx);
+                allowed = 1;
+            }
+            gate_cv.notify_all();
+            failures += !expect(queue.wait_persisted(t1, std::chrono::milliseconds(1000)), "Tickets: persisted after its flush");
+            failures += !expect(!queue.wait_persisted(t2, std::chrono::milliseconds(20)) && queue.pending(1)->value == "b",
+                                "Tickets: the newer write to the key is still pending");
+            {
+                std::lock_guard<std::mutex> lk(gate_mtx);
+                allowed = 100;
+            }
+            gate_cv.notify_all();
+            failures += !expect(queue.wait_persisted(t2, std::chrono::milliseconds(1000)), "Tickets: all persisted");
+        }
+    }
+
     // Concurrency smoke test: multiple threads upserting disjoint key ranges
     {
         InlineCache cache{InlineCache::Policy::LRU};
@@ -109,6 +584,211 @@ int main() {
         failures += !expect(cache.get(1005).has_value(), "Concurrency: key 1005 present");
     }
 
+    // Pinned cores: operations shipped to the owning core's worker behave like the shared cache, and
+    // concurrent callers on many keys see exact results and aggregated stats
+    {
+        CoreAffinityCache<int64_t> cache{InlineCache::Policy::LRU, 10 * 1024 * 1024, 1031, 4,
+                                         InlineCache::Storage::Chained, InlineCache::Admission::None, 3};
+        failures += !expect(cache.core_count() == 3 && cache.shard_count() == 3, "Cores: one shard per pinned core");
+        failures += !expect(cache.update_or_insert(7, "seven"), "Cores: insert");
+        failures += !expect(!cache.insert_if_absent(7, "other"), "Cores: insert_if_absent keeps existing");
+        auto h = cache.get_handle(7);
+        failures += !expect(h && h->view() == "seven", "Cores: handle read");
+        failures += !expect(cache.update(7, "SEVEN") && cache.get(7).value_or("") == "SEVEN", "Cores: update");
+        failures += !expect(h && h->view() == "seven", "Cores: handle keeps old value after update");
+        failures += !expect(cache.erase(7) && !cache.get(7), "Cores: erase");
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 4; ++t) {
+            callers.emplace_back([&cache, t] {
+                for (int64_t k = t * 1000; k < t * 1000 + 300; ++k) cache.update_or_insert(k, std::to_string(k));
+                for (int64_t k = t * 1000; k < t * 1000 + 300; ++k) (void)cache.get(k);
+            });
+        }
+        for (auto& c : callers) c.join();
+        auto st = cache.stats();
+        failures += !expect(st.size_entries == 1200, "Cores: entries summed over cores");
+        failures += !expect(st.hits == 1200 + 2, "Cores: hits summed over cores");
+        failures += !expect(cache.get(3299).value_or("") == "3299", "Cores: spot check");
+        cache.update_or_insert(1, "short", std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        failures += !expect(cache.expire() == 1, "Cores: expire runs on every core");
+    }
+
+    // SingleFlight: callers overlapping one execution share its result (and its exception); later calls
+    // run the loader again
+    {
+        SingleFlight<int64_t, int> flight;
+        std::atomic<int> runs{0};
+        std::atomic<bool> release{false};
+        std::atomic<int> started{0};
+        std::vector<int> results(4, 0);
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 4; ++t) {
+            callers.emplace_back([&, t] {
+                started.fetch_add(1);
+                results[t] = flight.run(5, [&] {
+                    runs.fetch_add(1);
+                    while (!release.load()) std::this_thread::yield();
+                    return 42;
+                });
+            });
+        }
+        while (started.load() < 4 || flight.in_flight() == 0) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        release.store(true);
+        for (auto& c : callers) c.join();
+        bool allSame = true;
+        for (int r : results) allSame = allSame && r == 42;
+        failures += !expect(allSame, "SingleFlight: every caller receives the result");
+        auto st = flight.stats();
+        failures += !expect(st.executions == static_cast<uint64_t>(runs.load()) && st.executions + st.coalesced == 4,
+                            "SingleFlight: executions plus coalesced calls account for every caller");
+        failures += !expect(runs.load() < 4, "SingleFlight: overlapping callers share an execution");
+        bool coalesced = true;
+        failures += !expect(flight.run(5, [] { return 7; }, &coalesced) == 7 && !coalesced,
+                            "SingleFlight: a call after completion runs again");
+        bool threw = false;
+        try {
+            flight.run(6, []() -> int { throw std::runtime_error("db down"); });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        failures += !expect(threw && flight.in_flight() == 0, "SingleFlight: exceptions propagate and unregister the key");
+    }
+
+    // Statistics under concurrency: counters bumped from many readers are exact, and stats() can be
+    // sampled while writers run
+    {
+        InlineCache cache{InlineCache::Policy::Clock, 10 * 1024 * 1024, 1031, 4};
+        for (int k = 0; k < 64; ++k) cache.update_or_insert(k, "v");
+        std::atomic<bool> stop{false};
+        std::thread sampler([&] { while (!stop.load()) (void)cache.stats(); });
+        std::thread writer([&] { for (int k = 1000; k < 3000; ++k) cache.update_or_insert(k, "w"); });
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&cache] {
+                for (int i = 0; i < 10000; ++i) (void)cache.get(i % 64);
+                for (int i = 0; i < 500; ++i) (void)cache.get(-1 - i);
+            });
+        }
+        for (auto& r : readers) r.join();
+        writer.join();
+        stop.store(true);
+        sampler.join();
+        auto st = cache.stats();
+        failures += !expect(st.hits == 40000, "Stats: concurrent hits counted exactly");
+        failures += !expect(st.misses == 2000, "Stats: concurrent misses counted exactly");
+        failures += !expect(st.size_entries == 64 + 2000, "Stats: entry count published by writers");
+    }
+
+    // Optimistic reads racing writers: every value a reader sees must be one that was written (never torn),
+    // across inline, slab and large values, erases, evictions and index rebuilds, for both engines
+    for (auto storage : {InlineCache::Storage::Chained, InlineCache::Storage::OpenAddressing}) {
+        InlineCache cache{InlineCache::Policy::LRU, 256 * 1024, 64, 2, storage};
+        const size_t lengths[] = {5, 30, 200, 3000, 40000};
+        std::atomic<bool> stop{false};
+        std::atomic<int> torn{0};
+        std::atomic<long> seen{0};
+        std::thread writer([&] {
+            std::mt19937 rng(7);
+            for (int i = 0; i < 30000; ++i) {
+                int k = static_cast<int>(rng() % 256);
+                if (rng() % 5 == 0) { cache.erase(k); continue; }
+                size_t len = lengths[rng() % 5];
+                cache.update_or_insert(k, std::string(len, static_cast<char>('a' + (k + i) % 26)));
+            }
+            stop.store(true);
+        });
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t) {
+            readers.emplace_back([&, t] {
+                int k = t;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    k = (k + 7) % 256;
+                    // alternate copying reads and shared handles
+                    std::optional<std::string> v;
+                    if (k & 1) {
+                        if (auto h = cache.get_handle(k)) v = std::string(h->view());
+                    } else {
+                        v = cache.get(k);
+                    }
+                    if (!v) continue;
+                    seen.fetch_add(1);
+                    bool lengthOk = false;
+                    for (size_t len : lengths) lengthOk = lengthOk || v->size() == len;
+                    bool uniform = v->find_first_not_of((*v)[0]) == std::string::npos;
+                    if (!lengthOk || !uniform) torn.fetch_add(1);
+                }
+            });
+        }
+        writer.join();
+        for (auto& r : readers) r.join();
+        failures += !expect(torn.load() == 0, "Optimistic reads: no torn values under concurrent writes");
+        failures += !expect(seen.load() > 0, "Optimistic reads: readers observed hits");
+    }
+
+    // Shared slab blocks under contention: several writers overwrite and erase slab-sized values while readers
+    // keep handles across those writes. A handle must keep exactly the bytes of the key it was read for until it
+    // is dropped, i.e. a block is never recycled while the entry or a handle still references it
+    {
+        InlineCache cache{InlineCache::Policy::LRU, 512 * 1024, 64, 1};
+        const size_t lengths[] = {100, 104, 108, 3000}; // mostly one size class, so blocks are recycled across keys
+        auto valueFor = [&](int k, int gen) {
+            std::string v = "k" + std::to_string(k) + ":";
+            v.resize(lengths[gen % 4], static_cast<char>('a' + (k + gen) % 26));
+            return v;
+        };
+        auto belongsTo = [&](std::string_view v, int k) {
+            std::string tag = "k" + std::to_string(k) + ":";
+            if (v.size() <= tag.size() || v.substr(0, tag.size()) != tag) return false;
+            return v.find_first_not_of(v[tag.size()], tag.size()) == std::string_view::npos;
+        };
+        std::atomic<int> writersLeft{3};
+        std::atomic<int> bad{0};
+        std::atomic<long> held{0};
+        std::vector<std::thread> threads;
+        for (int w = 0; w < 3; ++w) {
+            threads.emplace_back([&, w] {
+                std::mt19937 rng(100 + w);
+                for (int i = 0; i < 40000; ++i) {
+                    int k = static_cast<int>(rng() % 64);
+                    if (rng() % 4 == 0) cache.erase(k);
+                    else cache.update_or_insert(k, valueFor(k, static_cast<int>(rng() % 1000)));
+                }
+                writersLeft.fetch_sub(1);
+            });
+        }
+        for (int r = 0; r < 4; ++r) {
+            threads.emplace_back([&, r] {
+                std::vector<std::pair<int, std::pair<ValueHandle, std::string>>> kept;
+                int k = r;
+                while (writersLeft.load(std::memory_order_relaxed) > 0) {
+                    k = (k + 5) % 64;
+                    auto h = cache.get_handle(k);
+                    if (!h) continue;
+                    std::string copy(h->view());
+                    if (!belongsTo(copy, k)) bad.fetch_add(1);
+                    kept.push_back({k, {std::move(*h), std::move(copy)}});
+                    if (kept.size() == 16) {
+                        for (auto& [key, entry] : kept) {
+                            if (entry.first.view() != entry.second) bad.fetch_add(1);
+                        }
+                        held.fetch_add(static_cast<long>(kept.size()));
+                        kept.clear();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        failures += !expect(bad.load() == 0, "Shared blocks: held handles keep their key's bytes across overwrites");
+        failures += !expect(held.load() > 0, "Shared blocks: readers held handles");
+        bool intact = true;
+        for (int k = 0; k < 64; ++k) {
+            if (auto v = cache.get(k)) intact = intact && belongsTo(*v, k);
+        }
+        failures += !expect(intact, "Shared blocks: entries hold their own values afterwards");
+    }
+
     if (failures == 0) {
         std::cout << "All InlineCache tests passed." << std::endl;
         return 0;
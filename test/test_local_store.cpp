@@ -0,0 +1,210 @@
+#include "local_store.h"
+#include "write_ahead_log.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <map>
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static bool expect(bool cond, const char* msg) {
+    if (!cond) std::cerr << "ASSERT FAILED: " << msg << "\n";
+    return cond;
+}
+
+static std::string fresh_dir(const char* name) {
+    std::string dir = (fs::temp_directory_path() / (std::string(name) + "-" + std::to_string(::getpid()))).string();
+    fs::remove_all(dir);
+    return dir;
+}
+
+static std::vector<fs::path> logs_in(const std::string& dir) {
+    std::vector<fs::path> out;
+    for (const auto& e : fs::directory_iterator(dir)) {
+        if (e.path().extension() == ".log") out.push_back(e.path());
+    }
+    return out;
+}
+
+// Simulates a crash mid-append: a record head promising more bytes than follow.
+static void append_bytes(const std::string& path, const std::string& bytes) {
+    std::ofstream f(path, std::ios::binary | std::ios::app);
+    f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+int main() {
+    int failures = 0;
+    LocalStore::Options small;
+    small.memtable_bytes = 4096; // a few dozen entries per segment
+    small.compact_segments = 1000; // compaction only when asked
+
+    // Write-ahead log: records replay in order, and replay stops at a torn tail
+    {
+        const std::string dir = fresh_dir("kv_test_wal");
+        fs::create_directories(dir);
+        const std::string path = dir + "/test.log";
+        {
+            WriteAheadLog log;
+            std::string error;
+            failures += !expect(log.open(path, WriteAheadLog::Options{}, error), "WAL: open");
+            failures += !expect(log.write("one") && log.write(std::string("t\0o", 3)), "WAL: durable appends");
+            uint64_t seq = log.append("three");
+            failures += !expect(seq == 3 && log.sync(seq) && log.stats().synced == 3, "WAL: sequence numbers and sync");
+        }
+        std::vector<std::string> seen;
+        uint64_t valid = 0;
+        WriteAheadLog::replay(path, [&](std::string_view r) { seen.emplace_back(r); }, &valid);
+        failures += !expect(seen == std::vector<std::string>({"one", std::string("t\0o", 3), "three"}) &&
+                                valid == fs::file_size(path),
+                            "WAL: replay returns every record");
+        append_bytes(path, std::string("\x09\x00\x00\x00garb", 8));
+        seen.clear();
+        WriteAheadLog::replay(path, [&](std::string_view r) { seen.emplace_back(r); }, &valid);
+        failures += !expect(seen.size() == 3 && valid + 8 == fs::file_size(path), "WAL: torn tail ignored");
+        fs::remove_all(dir);
+    }
+
+    // Point operations: insert is an upsert, update/remove need the key, string keys are a separate space
+    {
+        const std::string dir = fresh_dir("kv_test_local_basic");
+        LocalStore store(dir, small);
+        failures += !expect(store.insert(1, "a") && store.insert(1, "b"), "Local: insert upserts");
+        failures += !expect(store.get(1) && *store.get(1) == "b", "Local: get returns latest value");
+        failures += !expect(!store.update(2, "x") && !store.remove(2), "Local: update/remove of a missing key fail");
+        failures += !expect(store.update(1, "c") && *store.get(1) == "c", "Local: update existing key");
+        failures += !expect(store.insertStringKey("1", "s") && *store.getStringKey("1") == "s" && *store.get(1) == "c",
+                            "Local: string keys are separate from integer keys");
+        failures += !expect(store.remove(1) && !store.get(1) && !store.remove(1), "Local: remove");
+        failures += !expect(store.insert(-5, std::string("\0bin", 4)) && *store.get(-5) == std::string("\0bin", 4),
+                            "Local: negative keys and binary values");
+        bool locked = false;
+        try {
+            LocalStore second(dir, small);
+        } catch (const std::runtime_error&) {
+            locked = true;
+        }
+        failures += !expect(locked, "Local: a directory in use cannot be opened again");
+        fs::remove_all(dir);
+    }
+
+    // Segments and compaction: reads see the newest version across memtable and segments, deletes shadow older
+    // segments, and a merge keeps exactly the live keys
+    {
+        const std::string dir = fresh_dir("kv_test_local_segments");
+        std::map<int64_t, std::string> model;
+        {
+            LocalStore store(dir, small);
+            for (int64_t k = 0; k < 600; ++k) {
+                std::string v = "v" + std::to_string(k);
+                store.insert(k, v);
+                model[k] = v;
+            }
+            for (int64_t k = 0; k < 600; k += 3) {
+                store.update(k, "u" + std::to_string(k));
+                model[k] = "u" + std::to_string(k);
+            }
+            for (int64_t k = 1; k < 600; k += 7) {
+                store.remove(k);
+                model.erase(k);
+            }
+            store.flush();
+            failures += !expect(store.segmentCount() > 3, "Local: full memtables are written out as segments");
+            bool all = true;
+            for (int64_t k = 0; k < 600; ++k) {
+                auto v = store.get(k);
+                auto it = model.find(k);
+                all = all && (it == model.end() ? !v : (v && *v == it->second));
+            }
+            failures += !expect(all, "Local: reads across segments match");
+
+            store.compact();
+            failures += !expect(store.segmentCount() == 1, "Local: compaction merges every segment");
+            std::map<int64_t, std::string> scanned;
+            store.scanRange(INT64_MIN, INT64_MAX, [&](int64_t key, std::string&& value) {
+                scanned.emplace(key, std::move(value));
+                return true;
+            });
+            failures += !expect(scanned == model, "Local: compacted segment holds exactly the live keys");
+            auto metrics = store.metrics();
+            failures += !expect(metrics.value("compactions", 0) == 1 && metrics["segment_records"] == model.size(),
+                                "Local: compaction drops tombstones");
+
+            size_t seen = 0;
+            store.scanRange(100, 199, [&](int64_t, std::string&&) { return ++seen < 5; });
+            failures += !expect(seen == 5, "Local: a sink that stops ends the scan");
+            auto bounds = store.keyBounds();
+            failures += !expect(bounds && bounds->first == 0 && bounds->second == 599, "Local: key bounds");
+        }
+        // reopen: everything comes back from MANIFEST and segments
+        LocalStore reopened(dir, small);
+        auto found = reopened.multiGet({0, 1, 3, 598, 599, 1000});
+        failures += !expect(found.size() == 4 && found[0] == model[0] && found[3] == model[3] && !found.count(1),
+                            "Local: reopened store serves its segments");
+        fs::remove_all(dir);
+    }
+
+    // Recovery: writes only in the log are replayed after a restart, up to a torn tail
+    {
+        const std::string dir = fresh_dir("kv_test_local_recovery");
+        LocalStore::Options big;
+        big.memtable_bytes = 64u << 20; // never flushed: everything lives in the log
+        {
+            LocalStore store(dir, big);
+            for (int64_t k = 0; k < 100; ++k) store.insert(k, "r" + std::to_string(k));
+            store.remove(50);
+            store.insertStringKey("name", "value");
+            failures += !expect(store.segmentCount() == 0, "Recovery: nothing written out yet");
+        }
+        auto logs = logs_in(dir);
+        failures += !expect(logs.size() == 1, "Recovery: one live log");
+        if (!logs.empty()) append_bytes(logs[0].string(), std::string("\x40\x00\x00\x00torn", 8));
+        {
+            LocalStore store(dir, big);
+            failures += !expect(store.get(7) && *store.get(7) == "r7" && !store.get(50) && store.get(99),
+                                "Recovery: logged writes replayed");
+            failures += !expect(store.getStringKey("name") && *store.getStringKey("name") == "value",
+                                "Recovery: string keys replayed");
+            failures += !expect(store.metrics().value("replayed_records", 0) == 102, "Recovery: torn tail skipped");
+            failures += !expect(store.insert(100, "after") && *store.get(100) == "after", "Recovery: writable after replay");
+        }
+        LocalStore again(dir, big);
+        failures += !expect(again.get(100) && again.get(7) && !again.get(50), "Recovery: second restart");
+        fs::remove_all(dir);
+    }
+
+    // Concurrent writers: group commit shares fsyncs, and every acknowledged write is readable
+    {
+        const std::string dir = fresh_dir("kv_test_local_concurrent");
+        LocalStore store(dir, small);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&store, t] {
+                for (int64_t i = 0; i < 300; ++i) store.insert(t * 1000 + i, std::to_string(t * 1000 + i));
+            });
+        }
+        for (auto& w : writers) w.join();
+        bool all = true;
+        for (int t = 0; t < 4; ++t) {
+            for (int64_t i = 0; i < 300; ++i) {
+                auto v = store.get(t * 1000 + i);
+                all = all && v && *v == std::to_string(t * 1000 + i);
+            }
+        }
+        failures += !expect(all, "Concurrent: every write readable");
+        auto log = store.metrics()["log"];
+        failures += !expect(log.value("records", 0) == 1200 && log.value("fsyncs", 0) <= 1200, "Concurrent: log counters");
+        fs::remove_all(dir);
+    }
+
+    if (failures == 0) {
+        std::cout << "All LocalStore tests passed." << std::endl;
+        return 0;
+    }
+    std::cerr << failures << " LocalStore test(s) failed." << std::endl;
+    return 1;
+}
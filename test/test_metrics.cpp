@@ -14,10 +14,10 @@ static bool expect(bool cond, const char* msg) {
 }
 
 struct FakePersistence : PersistenceProvider {
-    bool insert(int, const std::string&) override { return true; }
-    bool update(int, const std::string&) override { return true; }
-    bool remove(int) override { return true; }
-    std::unique_ptr<std::string> get(int) override { return nullptr; }
+    bool insert(int64_t, const std::string&) override { return true; }
+    bool update(int64_t, const std::string&) override { return true; }
+    bool remove(int64_t) override { return true; }
+    std::unique_ptr<std::string> get(int64_t) override { return nullptr; }
 };
 
 static bool wait_until_up(const std::string& host, int port, int retries = 100, int ms = 20) {
@@ -3,7 +3,12 @@
 #include <iostream>
 #include <vector>
 #include <functional>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 #include "nlohmann/json.hpp"
+#include <libpq-fe.h>
 
 // Tiny assert helper
 static bool expect_true(bool cond, const char* msg) {
@@ -11,11 +16,27 @@ static bool expect_true(bool cond, const char* msg) {
     return cond;
 }
 
+// Run a statement outside the adapter (test fixtures only)
+static bool exec_sql(const std::string& conninfo, const char* sql) {
+    PGconn* c = PQconnectdb(conninfo.c_str());
+    PGresult* r = PQstatus(c) == CONNECTION_OK ? PQexec(c, sql) : nullptr;
+    bool ok = r && PQresultStatus(r) == PGRES_COMMAND_OK;
+    if (!ok) std::cerr << "fixture SQL failed: " << PQerrorMessage(c);
+    PQclear(r);
+    PQfinish(c);
+    return ok;
+}
+
 int main()
 {
     // Connection string from env PG_CONNINFO or config/db.json, fallback to dbname=kvstore
     const std::string conninfo = load_conninfo();
 
+    // Writes to keys 209 and 262 fail in the statement itself: with a bytea value column no value is invalid,
+    // so the failure cases below need a constraint to trip over
+    if (!exec_sql(conninfo, "ALTER TABLE kv_store DROP CONSTRAINT IF EXISTS kv_test_reject;"
+                            "ALTER TABLE kv_store ADD CONSTRAINT kv_test_reject CHECK (key NOT IN (209, 262)) NOT VALID;")) return 2;
+
     try {
         PersistenceAdapter db{conninfo};
 
@@ -47,6 +68,52 @@ int main()
         v = db.get(10);
         if (!expect_true(!v, "get removed key should be null")) return 1;
 
+        std::cout << "[CRUD] 64-bit key beyond 2^31\n";
+        const int64_t wide = (int64_t{1} << 40) + 10;
+        db.remove(wide);
+        if (!expect_true(db.insert(wide, "wide"), "insert 64-bit key should succeed")) return 1;
+        v = db.get(wide);
+        if (!expect_true(v && *v == "wide", "get 64-bit key should be 'wide'")) return 1;
+        if (!expect_true(db.remove(wide), "remove 64-bit key should be true")) return 1;
+
+        std::cout << "[CRUD] multiGet returns present keys only, in one query\n";
+        db.remove(12); db.remove(13);
+        db.insert(12, "twelve");
+        db.insert(wide, "wide");
+        auto many = db.multiGet({12, 13, wide, 12});
+        if (!expect_true(many.size() == 2 && many[12] == "twelve" && many[wide] == "wide", "multiGet should return keys 12 and wide")) return 1;
+        if (!expect_true(db.multiGet({}).empty(), "multiGet of no keys should be empty")) return 1;
+        db.remove(12); db.remove(wide);
+
+        std::cout << "[BINARY] values with embedded NULs and arbitrary bytes round-trip\n";
+        if (db.binaryValues()) {
+            std::string raw("a\0b\xff\x00\x7f", 6);
+            db.remove(14);
+            if (!expect_true(db.insert(14, raw), "insert binary value should succeed")) return 1;
+            v = db.get(14);
+            if (!expect_true(v && *v == raw, "get returns every byte of the value")) return 1;
+            auto raw_many = db.multiGet({14});
+            if (!expect_true(raw_many.size() == 1 && raw_many[14] == raw, "multiGet returns every byte")) return 1;
+            auto raw_tx = db.runTransactionJson({{PersistenceAdapter::OpType::Update, 14, raw + raw},
+                                                 {PersistenceAdapter::OpType::Get, 14, ""}},
+                                                PersistenceAdapter::TxMode::RollbackOnError);
+            v = db.get(14);
+            if (!expect_true(raw_tx["success"].get<bool>() && v && *v == raw + raw, "transaction writes binary values")) return 1;
+            if (!expect_true(db.remove(14), "remove binary value")) return 1;
+        } else {
+            std::cout << "  skipped: kv_store.value is text (run sql/init_kv.sql to migrate)\n";
+        }
+
+        std::cout << "[CRUD] string keys (bytea), including bytes that are not valid text\n";
+        const std::string skey = std::string("user\0:42", 8);
+        db.removeStringKey(skey);
+        if (!expect_true(db.insertStringKey(skey, "alice"), "insert string key should succeed")) return 1;
+        v = db.getStringKey(skey);
+        if (!expect_true(v && *v == "alice", "get string key should be 'alice'")) return 1;
+        if (!expect_true(!db.getStringKey("user"), "string key prefix must not match")) return 1;
+        if (!expect_true(db.updateStringKey(skey, "bob"), "update string key should be true")) return 1;
+        if (!expect_true(db.removeStringKey(skey) && !db.getStringKey(skey), "remove string key")) return 1;
+
         // ---------------- Transaction (TxResult) coverage ----------------
         std::cout << "[TX] Silent mode with mixed ops (no Get in TxResult API)\n";
         db.remove(10);
@@ -60,6 +127,9 @@ int main()
         auto txres1 = db.runTransaction(ops_silent, PersistenceAdapter::TxMode::Silent);
         if (!expect_true(txres1.success, "Silent txn should commit despite failures")) return 1;
         if (!expect_true(txres1.failures.size() == 2, "Silent txn should record exactly 2 failures (update 999, remove 999)")) return 1;
+        bool all_no_rows = true;
+        for (const auto& f : txres1.failures) all_no_rows = all_no_rows && f.no_rows;
+        if (!expect_true(all_no_rows, "Silent txn failures on a missing key are flagged no_rows")) return 1;
         if (!expect_true(!db.get(10), "Post Silent txn: key 10 should be absent")) return 1;
 
         std::cout << "[TX] RollbackOnError with mid failure; ensure no effects\n";
@@ -141,6 +211,146 @@ int main()
         if (!expect_true(js3["success"].get<bool>()==true, "silent with failures still success true")) return 1;
         if (!expect_true(!db.get(206), "post JSON silent: 206 removed")) return 1;
 
+        // ---------------- Pipeline mode ----------------
+        std::cout << "[PIPELINE] same results with pipelining on and off\n";
+        for (bool pipelined : {true, false}) {
+            db.setPipelining(pipelined);
+            db.remove(207);
+            auto jp = db.runTransactionJson(js_ops_rb, PersistenceAdapter::TxMode::RollbackOnError);
+            if (!expect_true(jp["success"].get<bool>() == false && jp["results"].size() == 3, "rollback txn stops at the failing op")) return 1;
+            if (!expect_true(!db.get(204), "rolled back insert must not persist")) return 1;
+            std::vector<PersistenceAdapter::Operation> many;
+            for (int i = 0; i < 600; ++i) many.push_back({PersistenceAdapter::OpType::Insert, 207, std::to_string(i)});
+            many.push_back({PersistenceAdapter::OpType::Get, 207, ""});
+            auto big = db.runTransactionJson(many, PersistenceAdapter::TxMode::RollbackOnError);
+            if (!expect_true(big["success"].get<bool>() && big["results"].back()["value"] == "599", "600-op txn spans pipeline chunks")) return 1;
+        }
+        db.setPipelining(true);
+
+        std::cout << "[PIPELINE] silent txn with a statement error reruns with savepoints\n";
+        db.remove(208); db.remove(209);
+        std::vector<PersistenceAdapter::Operation> js_ops_err = {
+            {PersistenceAdapter::OpType::Insert, 208, "ok"},
+            {PersistenceAdapter::OpType::Insert, 209, "\xff"}, // kv_test_reject: the statement itself fails
+            {PersistenceAdapter::OpType::Get,    208, ""}
+        };
+        auto js4 = db.runTransactionJson(js_ops_err, PersistenceAdapter::TxMode::Silent);
+        if (!expect_true(js4["success"].get<bool>() && js4["results"].size() == 3, "silent txn commits around the error")) return 1;
+        if (!expect_true(js4["results"][1]["status"] == "failed" && js4["results"][2]["value"] == "ok", "failed op reported, later ops run")) return 1;
+        auto v208 = db.get(208);
+        if (!expect_true(v208 && *v208 == "ok" && !db.get(209), "post silent error: 208 kept, 209 absent")) return 1;
+        db.remove(207); db.remove(208);
+
+        std::cout << "[PIPELINE] concurrent getAsync calls\n";
+        db.insert(210, "async");
+        std::vector<std::future<std::unique_ptr<std::string>>> futs;
+        for (int i = 0; i < 50; ++i) futs.push_back(db.getAsync(i % 2 ? 210 : 211));
+        bool async_ok = true;
+        for (int i = 0; i < 50; ++i) {
+            auto got = futs[i].get();
+            async_ok = async_ok && (i % 2 ? (got && *got == "async") : !got);
+        }
+        if (!expect_true(async_ok, "batched getAsync results match their keys")) return 1;
+        db.remove(210);
+
+        // ---------------- Async engine ----------------
+        std::cout << "[ASYNC] hundreds of gets and transactions in flight at once\n";
+        if (!expect_true(db.poolMetrics().contains("async_engine"), "async engine running")) return 1;
+        for (int64_t k = 220; k < 230; ++k) db.insert(k, "a" + std::to_string(k));
+        std::vector<std::future<std::unique_ptr<std::string>>> gets;
+        std::vector<std::future<nlohmann::json>> txns;
+        for (int i = 0; i < 400; ++i) {
+            gets.push_back(db.getAsync(220 + i % 12)); // 230 and 231 do not exist
+            if (i % 40 == 0) {
+                txns.push_back(db.runTransactionJsonAsync({{PersistenceAdapter::OpType::Insert, 232, std::to_string(i)},
+                                                           {PersistenceAdapter::OpType::Get, 232, ""}},
+                                                          PersistenceAdapter::TxMode::RollbackOnError));
+            }
+        }
+        bool gets_ok = true;
+        for (int i = 0; i < 400; ++i) {
+            int64_t k = 220 + i % 12;
+            auto got = gets[i].get();
+            gets_ok = gets_ok && (k < 230 ? (got && *got == "a" + std::to_string(k)) : !got);
+        }
+        if (!expect_true(gets_ok, "async gets match their keys")) return 1;
+        bool txns_ok = true;
+        for (auto& f : txns) {
+            auto j = f.get();
+            txns_ok = txns_ok && j["success"].get<bool>() && j["results"][1]["value"].is_string();
+        }
+        if (!expect_true(txns_ok, "async transactions commit and read their own writes")) return 1;
+        auto rb = db.runTransactionJsonAsync(js_ops_rb, PersistenceAdapter::TxMode::RollbackOnError).get();
+        if (!expect_true(!rb["success"].get<bool>() && rb["results"].size() == 3, "async rollback stops at the failing op")) return 1;
+        auto sil = db.runTransactionJsonAsync(js_ops_err, PersistenceAdapter::TxMode::Silent).get();
+        if (!expect_true(sil["success"].get<bool>() && sil["results"][1]["status"] == "failed", "async silent txn reruns around a statement error")) return 1;
+        if (!expect_true(db.poolMetrics()["async_engine"]["in_flight"].get<int64_t>() == 0, "nothing left in flight")) return 1;
+        for (int64_t k = 220; k < 233; ++k) db.remove(k);
+        db.remove(208);
+
+        // ---------------- Write batching ----------------
+        std::cout << "[BATCH] concurrent writes share a commit and keep their own outcomes\n";
+        db.setWriteBatching(64, std::chrono::microseconds(5000));
+        for (int64_t k = 240; k < 260; ++k) db.remove(k);
+        std::vector<std::future<bool>> writes;
+        for (int64_t k = 240; k < 260; ++k) {
+            writes.push_back(std::async(std::launch::async, [&db, k]() { return db.insert(k, "b" + std::to_string(k)); }));
+        }
+        writes.push_back(std::async(std::launch::async, [&db]() { return db.update(261, "missing"); }));
+        writes.push_back(std::async(std::launch::async, [&db]() { return db.insert(262, "\xff"); })); // fails alone
+        std::vector<bool> outcomes;
+        for (auto& f : writes) outcomes.push_back(f.get());
+        bool inserts_ok = std::all_of(outcomes.begin(), outcomes.begin() + 20, [](bool b) { return b; });
+        if (!expect_true(inserts_ok && !outcomes[20] && !outcomes[21], "per-write outcomes: inserts ok, missing update and bad value fail")) return 1;
+        auto v250 = db.get(250);
+        if (!expect_true(v250 && *v250 == "b250" && !db.get(262), "batched inserts persisted")) return 1;
+        auto batch_metrics = db.poolMetrics()["write_batch"];
+        if (!expect_true(batch_metrics["batches"].get<uint64_t>() < batch_metrics["writes"].get<uint64_t>(), "writes were grouped")) return 1;
+
+        std::cout << "[BATCH] same key in one batch applies in submission order\n";
+        auto first = std::async(std::launch::async, [&db]() { return db.insert(263, "first"); });
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        auto second = std::async(std::launch::async, [&db]() { return db.update(263, "second"); });
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        auto gone = std::async(std::launch::async, [&db]() { return db.remove(263); });
+        if (!expect_true(first.get() && second.get() && gone.get() && !db.get(263), "insert, update, remove of one key in order")) return 1;
+        for (int64_t k = 240; k < 260; ++k) db.remove(k);
+        db.setWriteBatching(128, std::chrono::microseconds(200));
+
+        // ---------------- Preload scans ----------------
+        std::cout << "[SCAN] COPY-streamed key range, early stop and key bounds\n";
+        for (int64_t k = 270; k < 280; ++k) db.insert(k, "s" + std::to_string(k));
+        std::vector<std::pair<int64_t, std::string>> scanned;
+        bool scan_ok = db.scanRange(270, 279, [&](int64_t key, std::string&& value) {
+            scanned.emplace_back(key, std::move(value));
+            return true;
+        });
+        std::sort(scanned.begin(), scanned.end());
+        if (!expect_true(scan_ok && scanned.size() == 10 && scanned.front().second == "s270" && scanned.back().first == 279,
+                         "scanRange streams every row of the range")) return 1;
+        size_t seen = 0;
+        bool stopped_ok = db.scanRange(270, 279, [&](int64_t, std::string&&) { return ++seen < 3; });
+        if (!expect_true(stopped_ok && seen == 3, "a sink that stops cancels the scan")) return 1;
+        if (!expect_true(db.get(270) != nullptr, "connection usable after a cancelled scan")) return 1;
+        auto bounds = db.keyBounds();
+        if (!expect_true(bounds && bounds->first <= 270 && bounds->second >= 279, "keyBounds covers stored keys")) return 1;
+        for (int64_t k = 270; k < 280; ++k) db.remove(k);
+
+        // ---------------- Snapshot validation ----------------
+        std::cout << "[VERSION] rows unchanged since a persistence version\n";
+        db.insert(290, "before");
+        db.insert(291, "before");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto version = db.versionNow();
+        if (!expect_true(version.has_value(), "versionNow reports the server clock")) return 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        db.update(291, "after");
+        auto unchanged = db.unchangedSince({290, 291, 292}, *version);
+        if (!expect_true(unchanged == std::vector<int64_t>{290}, "only the row untouched since the version is confirmed")) return 1;
+        db.remove(290);
+        db.remove(291);
+
+        exec_sql(conninfo, "ALTER TABLE kv_store DROP CONSTRAINT IF EXISTS kv_test_reject;");
         std::cout << "All tests passed.\n";
         return 0;
     } catch (const std::exception &e) {
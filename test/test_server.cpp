@@ -1,4 +1,5 @@
 #include "server.h"
+#include "local_store.h"
 #include <httplib.h>
 #include <nlohmann/json.hpp>
 #include <iostream>
@@ -7,6 +8,12 @@
 #include <unordered_map>
 #include <mutex>
 #include <optional>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <cstdio>
 
 using namespace std::chrono_literals;
 
@@ -16,14 +23,15 @@ static bool expect(bool cond, const char* msg) {
 }
 
 struct FakePersistence : PersistenceProvider {
-    bool insert(int key, const std::string& value) override {
+    bool insert(int64_t key, const std::string& value) override {
+        if (int delay = write_delay_ms.load()) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
         std::lock_guard<std::mutex> lock(mtx);
         ++insert_calls;
         store[key] = value;
         return true;
     }
 
-    bool update(int key, const std::string& value) override {
+    bool update(int64_t key, const std::string& value) override {
         std::lock_guard<std::mutex> lock(mtx);
         ++update_calls;
         auto it = store.find(key);
@@ -32,31 +40,118 @@ struct FakePersistence : PersistenceProvider {
         return true;
     }
 
-    bool remove(int key) override {
+    bool remove(int64_t key) override {
+        if (int delay = write_delay_ms.load()) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
         std::lock_guard<std::mutex> lock(mtx);
         ++remove_calls;
+        if (failing_removes > 0) {
+            --failing_removes;
+            return false;
+        }
         return store.erase(key) > 0;
     }
 
-    std::unique_ptr<std::string> get(int key) override {
+    std::unique_ptr<std::string> get(int64_t key) override {
+        if (int delay = get_delay_ms.load()) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
         std::lock_guard<std::mutex> lock(mtx);
         ++get_calls;
+        failReadIfArmed();
         auto it = store.find(key);
         if (it == store.end()) return nullptr;
         return std::make_unique<std::string>(it->second);
     }
 
-    void setDirect(int key, const std::string& value) {
+    std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t>& keys) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        ++multi_get_calls;
+        failReadIfArmed();
+        std::unordered_map<int64_t, std::string> out;
+        for (int64_t key : keys) {
+            auto it = store.find(key);
+            if (it != store.end()) out.emplace(key, it->second);
+        }
+        return out;
+    }
+
+    bool scanRange(int64_t from, int64_t to, const RowSink& sink) override {
+        std::vector<std::pair<int64_t, std::string>> rows;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ++scan_calls;
+            for (const auto& [key, value] : store) {
+                if (key >= from && key <= to) rows.emplace_back(key, value);
+            }
+        }
+        for (auto& [key, value] : rows) {
+            if (!sink(key, std::move(value))) break;
+        }
+        return true;
+    }
+
+    std::optional<std::pair<int64_t, int64_t>> keyBounds() override {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!scannable || store.empty()) return std::nullopt;
+        auto [lo, hi] = std::minmax_element(store.begin(), store.end(),
+                                            [](const auto& a, const auto& b) { return a.first < b.first; });
+        return std::make_pair(lo->first, hi->first);
+    }
+
+    bool insertStringKey(const std::string& key, const std::string& value) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        string_store[key] = value;
+        return true;
+    }
+
+    bool updateStringKey(const std::string& key, const std::string& value) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = string_store.find(key);
+        if (it == string_store.end()) return false;
+        it->second = value;
+        return true;
+    }
+
+    bool removeStringKey(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        return string_store.erase(key) > 0;
+    }
+
+    std::unique_ptr<std::string> getStringKey(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        ++get_calls;
+        auto it = string_store.find(key);
+        if (it == string_store.end()) return nullptr;
+        return std::make_unique<std::string>(it->second);
+    }
+
+    void setDirect(int64_t key, const std::string& value) {
         std::lock_guard<std::mutex> lock(mtx);
         store[key] = value;
     }
 
-    void eraseDirect(int key) {
+    // Make get() take this long, so concurrent requests overlap in flight.
+    void setGetDelay(int ms) { get_delay_ms.store(ms); }
+
+    // Make insert() and remove() take this long, so write-behind flushes overlap new writes.
+    void setWriteDelay(int ms) { write_delay_ms.store(ms); }
+
+    // Make the next n remove() calls fail (key kept), like a backend write error.
+    void failRemoves(int n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        failing_removes = n;
+    }
+
+    // Make the next n get()/multiGet() calls throw, like a lost database connection.
+    void failReads(int n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        failing_reads = n;
+    }
+
+    void eraseDirect(int64_t key) {
         std::lock_guard<std::mutex> lock(mtx);
         store.erase(key);
     }
 
-    std::optional<std::string> valueFor(int key) const {
+    std::optional<std::string> valueFor(int64_t key) const {
         std::lock_guard<std::mutex> lock(mtx);
         auto it = store.find(key);
         if (it == store.end()) return std::nullopt;
@@ -68,6 +163,22 @@ struct FakePersistence : PersistenceProvider {
         return get_calls;
     }
 
+    int multiGetCallCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return multi_get_calls;
+    }
+
+    // Offer keyBounds()/scanRange() for preload; off by default so preload uses multiGet.
+    void setScannable(bool on) {
+        std::lock_guard<std::mutex> lock(mtx);
+        scannable = on;
+    }
+
+    int scanCallCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return scan_calls;
+    }
+
     int insertCallCount() const {
         std::lock_guard<std::mutex> lock(mtx);
         return insert_calls;
@@ -85,11 +196,26 @@ struct FakePersistence : PersistenceProvider {
 
 private:
     mutable std::mutex mtx;
-    std::unordered_map<int, std::string> store;
+    std::unordered_map<int64_t, std::string> store;
+    std::unordered_map<std::string, std::string> string_store;
     mutable int insert_calls{0};
     mutable int update_calls{0};
     mutable int remove_calls{0};
     mutable int get_calls{0};
+    mutable int multi_get_calls{0};
+    int failing_removes{0};
+    int failing_reads{0};
+
+    void failReadIfArmed() {
+        if (failing_reads > 0) {
+            --failing_reads;
+            throw std::runtime_error("connection lost");
+        }
+    }
+    int scan_calls{0};
+    bool scannable{false};
+    std::atomic<int> get_delay_ms{0};
+    std::atomic<int> write_delay_ms{0};
 };
 
 static bool wait_until_up(const std::string& host, int port, int retries = 100, int ms = 20) {
@@ -114,6 +240,8 @@ int main() {
     fake->setDirect(222, "db-only");
     fake->setDirect(333, "bulk-db");
     server.setPersistenceProvider(std::move(fakePersistence), "test-double");
+    // keys 222/333 must stay out of the cache so the read-through paths are exercised
+    server.setSkipPreload(true);
     server.setupRoutes();
 
     // start server in background thread
@@ -185,6 +313,54 @@ int main() {
     } else { std::cerr << "GET /get_key/222 second attempt failed\n"; ++fails; }
     fails += !expect(fake->getCallCount() >= 1, "Persistence get should be called at least once for read-through");
 
+    // Cache hits stream the value from the shared cache block; values that need JSON escaping take the
+    // regular serializer. Both must produce the same JSON document.
+    {
+        const std::string big(4096, 'k');
+        const std::string quoted = "say \"hi\" \\ bye";
+        fake->setDirect(9444, big);
+        fake->setDirect(9445, quoted);
+        for (int round = 0; round < 2; ++round) { // first read hydrates the cache, second is a cache hit
+            auto r1 = cli.Get("/get_key/9444");
+            auto r2 = cli.Get("/get_key/9445");
+            fails += !expect(r1 && r1->status == 200 && r2 && r2->status == 200, "GET hydrated keys should return 200");
+            if (r1 && r2) {
+                auto b1 = nlohmann::json::parse(r1->body);
+                auto b2 = nlohmann::json::parse(r2->body);
+                fails += !expect(b1.value("value", "") == big && b1.value("query_key", "") == "9444", "Large value round-trips");
+                fails += !expect(b2.value("value", "") == quoted && b2.value("found", false), "Escaped value round-trips");
+                if (round == 1) fails += !expect(!b1.contains("source"), "Second read should be a cache hit");
+            }
+        }
+    }
+
+    // Concurrent misses for one key share a single persistence read
+    {
+        fake->setDirect(9451, "hot");
+        fake->setGetDelay(200);
+        int before = fake->getCallCount();
+        std::atomic<int> ok{0};
+        std::vector<std::thread> clients;
+        for (int i = 0; i < 5; ++i) {
+            clients.emplace_back([&] {
+                httplib::Client c(host, port);
+                c.set_read_timeout(5, 0);
+                auto r = c.Get("/get_key/9451");
+                if (r && r->status == 200 && nlohmann::json::parse(r->body).value("value", "") == "hot") ok.fetch_add(1);
+            });
+        }
+        for (auto& c : clients) c.join();
+        fake->setGetDelay(0);
+        int reads = fake->getCallCount() - before;
+        fails += !expect(ok.load() == 5, "Coalesced misses should all receive the value");
+        fails += !expect(reads >= 1 && reads < 5, "Concurrent misses should share persistence reads");
+        if (auto m = cli.Get("/metrics")) {
+            auto mb = nlohmann::json::parse(m->body);
+            fails += !expect(mb.contains("miss_coalescing") && mb["miss_coalescing"].value("coalesced", 0) >= 1,
+                             "Metrics should report coalesced misses");
+        } else { std::cerr << "GET /metrics failed\n"; ++fails; }
+    }
+
     // 3) PATCH /bulk_query (empty body -> JSON errors but HTTP 200)
     if (auto res = cli.Patch("/bulk_query")) {
         fails += !expect(res->status == 200, "PATCH /bulk_query should return 200 even for empty body");
@@ -232,6 +408,106 @@ int main() {
         fails += !expect(body.contains("existing_value"), "Conflict response should include existing_value");
     fails += !expect(body.value("reason", "").find("exists") != std::string::npos, "Conflict response should include reason");
     } else { std::cerr << "POST /insert conflict failed\n"; ++fails; }
+    // ttl_ms expires the cached copy only: after the deadline the key is read back from persistence
+    if (auto res = cli.Post("/insert/9446/fresh?ttl_ms=abc", "", "application/json")) {
+        fails += !expect(res->status == 400, "POST /insert with invalid ttl_ms should return 400");
+    } else { std::cerr << "POST /insert invalid ttl failed\n"; ++fails; }
+    if (auto res = cli.Post("/insert/9446/fresh?ttl_ms=50", "", "application/json")) {
+        fails += !expect(res->status == 201, "POST /insert with ttl_ms should return 201");
+        auto body = nlohmann::json::parse(res->body);
+        fails += !expect(body.value("ttl_ms", 0) == 50, "Insert with ttl should echo ttl_ms");
+        std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        if (auto get = cli.Get("/get_key/9446")) {
+            auto gb = nlohmann::json::parse(get->body);
+            fails += !expect(get->status == 200 && gb.value("value", "") == "fresh", "Expired key should still be served");
+            fails += !expect(gb.contains("source"), "Expired key should be re-read from persistence");
+        } else { std::cerr << "GET /get_key after ttl failed\n"; ++fails; }
+    } else { std::cerr << "POST /insert with ttl failed\n"; ++fails; }
+    // 64-bit keys: values past 2^31 are accepted and distinct from their low 32 bits
+    if (auto res = cli.Post("/insert/4294967297/wide", "", "application/json")) {
+        fails += !expect(res->status == 201, "POST /insert with a 64-bit key should return 201");
+        fails += !expect(fake->valueFor(4294967297LL).value_or("") == "wide", "64-bit key should persist");
+        auto get = cli.Get("/get_key/4294967297");
+        fails += !expect(get && get->status == 200 && nlohmann::json::parse(get->body).value("value", "") == "wide",
+                         "GET 64-bit key should return its value");
+        auto low = cli.Get("/get_key/1");
+        fails += !expect(low && nlohmann::json::parse(low->body).value("value", "") != "wide", "64-bit key must not alias key 1");
+    } else { std::cerr << "POST /insert 64-bit key failed\n"; ++fails; }
+    // Negative cache: a key missing from persistence is remembered, and an insert through the API clears it
+    if (auto res = cli.Get("/get_key/9447")) {
+        fails += !expect(res->status == 404 && !nlohmann::json::parse(res->body).contains("negative_cache"),
+                         "First miss should query persistence");
+        fake->setDirect(9447, "behind-our-back");
+        auto again = cli.Get("/get_key/9447");
+        fails += !expect(again && again->status == 404 && nlohmann::json::parse(again->body).value("negative_cache", false),
+                         "Repeated miss should be answered by the negative cache");
+        auto bulk = cli.Patch("/bulk_query", R"({"data":[9447]})", "application/json");
+        fails += !expect(bulk && nlohmann::json::parse(bulk->body)["results"][0].value("negative_cache", false),
+                         "Bulk query should consult the negative cache");
+        if (auto m = cli.Get("/metrics")) {
+            auto mb = nlohmann::json::parse(m->body);
+            fails += !expect(mb.contains("negative_cache") && mb["negative_cache"].value("hits", 0) >= 2,
+                             "Metrics should report negative cache hits");
+        }
+    } else { std::cerr << "GET /get_key/9447 failed\n"; ++fails; }
+    if (auto res = cli.Get("/get_key/9450")) {
+        fails += !expect(res->status == 404, "Missing key should return 404");
+        auto ins = cli.Post("/insert/9450/now-present", "", "application/json");
+        auto get = cli.Get("/get_key/9450");
+        fails += !expect(ins && ins->status == 201 && get && get->status == 200, "Insert should invalidate the negative entry");
+        auto del = cli.Delete("/delete_key/9450");
+        auto gone = cli.Get("/get_key/9450");
+        fails += !expect(del && gone && gone->status == 404, "Deleted key should return 404");
+        auto bulk = cli.Post("/bulk_update", R"({"operations":[{"operation":"insert","key":9450,"value":"bulk"}]})",
+                             "application/json");
+        get = cli.Get("/get_key/9450");
+        fails += !expect(bulk && get && get->status == 200, "Bulk insert should invalidate the negative entry");
+    } else { std::cerr << "GET /get_key/9450 failed\n"; ++fails; }
+    // A failed persistence read is an error, not a miss: nothing is negatively cached
+    {
+        fake->setDirect(9460, "was-there");
+        fake->failReads(1);
+        auto failed = cli.Get("/get_key/9460");
+        fails += !expect(failed && failed->status == 500 &&
+                         nlohmann::json::parse(failed->body).value("error", "") == "persistence_failure",
+                         "Failed read should return 500");
+        auto get = cli.Get("/get_key/9460");
+        fails += !expect(get && get->status == 200 && nlohmann::json::parse(get->body).value("value", "") == "was-there",
+                         "Failed read must not be negatively cached");
+        fake->setDirect(9461, "also-there");
+        fake->failReads(1);
+        auto bulk = cli.Patch("/bulk_query", R"({"data":[9461]})", "application/json");
+        bool reported = false;
+        if (bulk && bulk->status == 200) {
+            auto body = nlohmann::json::parse(bulk->body);
+            reported = !body.value("success", true) && body.contains("errors") &&
+                       body["errors"][0].value("code", "") == "persistence_error" &&
+                       body["results"][0].value("status", "") == "error";
+        }
+        fails += !expect(reported, "Failed bulk fetch should be reported as a bulk_query error");
+        bulk = cli.Patch("/bulk_query", R"({"data":[9461]})", "application/json");
+        fails += !expect(bulk && nlohmann::json::parse(bulk->body)["results"][0].value("value", "") == "also-there",
+                         "Failed bulk fetch must not be negatively cached");
+    }
+    // String keys: separate key space with its own routes
+    if (auto res = cli.Post("/insert_skey/user:42/alice", "", "application/json")) {
+        fails += !expect(res->status == 201, "POST /insert_skey should return 201");
+        auto dup = cli.Post("/insert_skey/user:42/bob", "", "application/json");
+        fails += !expect(dup && dup->status == 409, "POST /insert_skey existing should return 409");
+        auto get = cli.Get("/get_skey/user:42");
+        fails += !expect(get && get->status == 200 && nlohmann::json::parse(get->body).value("value", "") == "alice",
+                         "GET /get_skey should return the value");
+        auto upd = cli.Put("/update_skey/user:42/carol", "", "application/json");
+        fails += !expect(upd && upd->status == 200, "PUT /update_skey should return 200");
+        get = cli.Get("/get_skey/user:42");
+        fails += !expect(get && nlohmann::json::parse(get->body).value("value", "") == "carol", "Updated string key value");
+        auto del = cli.Delete("/delete_skey/user:42");
+        fails += !expect(del && del->status == 204, "DELETE /delete_skey should return 204");
+        get = cli.Get("/get_skey/user:42");
+        fails += !expect(get && get->status == 404, "Deleted string key should be gone");
+        auto longKey = cli.Get("/get_skey/" + std::string(40, 'k'));
+        fails += !expect(longKey && longKey->status == 400, "Overlong string key should return 400");
+    } else { std::cerr << "POST /insert_skey failed\n"; ++fails; }
 
     // 5) POST /bulk_update accepts transactional operations
     const char* patch_payload = R"({"operations":[{"operation":"insert","key":777,"value":"txn-ins"},{"operation":"get","key":777},{"operation":"update","key":777,"value":"txn-upd"},{"operation":"delete","key":777}]})";
@@ -275,7 +551,11 @@ int main() {
     } else { std::cerr << "GET /get_key/888 failed\n"; ++fails; }
     // Bulk query should accept object payload with data array and provide verbose results
     const char* bulk_payload = "{\"data\":[222,333,\"oops\",444]}";
+    int gets_before_bulk = fake->getCallCount();
+    int multi_gets_before_bulk = fake->multiGetCallCount();
     if (auto res = cli.Patch("/bulk_query", bulk_payload, "application/json")) {
+        fails += !expect(fake->multiGetCallCount() == multi_gets_before_bulk + 1 && fake->getCallCount() == gets_before_bulk,
+                         "Bulk query misses should be fetched with one multiGet");
         fails += !expect(res->status == 200, "PATCH /bulk_query should return 200 for valid payload");
         auto body = nlohmann::json::parse(res->body);
         fails += !expect(body.contains("results") && body["results"].is_array(), "Bulk query should include results array");
@@ -468,6 +748,282 @@ int main() {
 
     if (t.joinable()) t.join();
 
+    // 11) Write-behind mode: acknowledged before persistence, coalesced, read back from the queue, drained on stop
+    {
+        const int wb_port = port + 2;
+        KeyValueServer wb{host, wb_port};
+        auto wbPersistence = std::make_unique<FakePersistence>();
+        auto* wb_fake = wbPersistence.get();
+        wb_fake->setDirect(9462, "old");
+        wb_fake->setWriteDelay(50);
+        wb.setPersistenceProvider(std::move(wbPersistence), "test-double");
+        wb.setSkipPreload(true);
+        wb.setLoggingEnabled(false);
+        wb.setWriteMode(KeyValueServer::WriteMode::Behind);
+        wb.setupRoutes();
+        std::thread wt([&]() { wb.start(); });
+        if (!wait_until_up(host, wb_port)) {
+            std::cerr << "write-behind server did not start\n";
+            ++fails;
+        } else {
+            httplib::Client wc(host, wb_port);
+            wc.set_read_timeout(5, 0);
+            auto ins = wc.Post("/insert/9460/a", "", "application/json");
+            fails += !expect(ins && ins->status == 201, "write-behind insert should return 201");
+            if (ins) {
+                auto body = nlohmann::json::parse(ins->body);
+                fails += !expect(body.value("write_behind", false) && !body.value("persisted", true),
+                                 "write-behind insert is acknowledged before it is persisted");
+            }
+            // "a" is being flushed (50ms); "b" queues behind it and "c" replaces "b"
+            std::this_thread::sleep_for(10ms);
+            auto up1 = wc.Put("/update_key/9460/b", "", "application/json");
+            auto up2 = wc.Put("/update_key/9460/c", "", "application/json");
+            fails += !expect(up1 && up1->status == 200 && up2 && up2->status == 200, "write-behind updates should return 200");
+
+            // a pending delete hides the persisted value
+            auto del = wc.Delete("/delete_key/9462");
+            fails += !expect(del && del->status == 204, "write-behind delete of a persisted key should return 204");
+            auto gone = wc.Get("/get_key/9462");
+            fails += !expect(gone && gone->status == 404, "key with a queued delete should read as absent");
+
+            // a delete the backend rejects stays queued and is retried
+            wb_fake->setDirect(9463, "kept");
+            wb_fake->failRemoves(2);
+            auto del2 = wc.Delete("/delete_key/9463");
+            fails += !expect(del2 && del2->status == 204, "write-behind delete should return 204");
+
+            if (auto m = wc.Get("/metrics")) {
+                auto body = nlohmann::json::parse(m->body);
+                const auto& w = body["write_behind"];
+                fails += !expect(w.value("mode", "") == "behind", "/metrics write_behind mode");
+                fails += !expect(w.value("coalesced", 0) >= 1 && w.contains("queue_depth") && w.contains("flush_latency_ms"),
+                                 "/metrics reports coalescing, depth and flush latency");
+            } else { std::cerr << "GET /metrics (write-behind) failed\n"; ++fails; }
+
+            auto stop = wc.Get("/stop");
+            fails += !expect(stop && stop->status == 200, "write-behind /stop should return 200");
+        }
+        if (wt.joinable()) wt.join();
+        // start() returned: everything acknowledged is persisted
+        fails += !expect(wb_fake->valueFor(9460) == std::optional<std::string>("c"), "drained queue persisted the last value");
+        fails += !expect(!wb_fake->valueFor(9462).has_value(), "drained queue persisted the delete");
+        fails += !expect(!wb_fake->valueFor(9463).has_value() && wb_fake->removeCallCount() >= 4,
+                         "failed deletes are retried until persisted");
+        fails += !expect(wb_fake->insertCallCount() == 2, "three writes to one key cost two persistence writes");
+    }
+
+    // 12) Startup preload streams every key-range partition into the cache in parallel
+    {
+        const int pl_port = port + 3;
+        KeyValueServer pl{host, pl_port};
+        auto plPersistence = std::make_unique<FakePersistence>();
+        auto* pl_fake = plPersistence.get();
+        for (int64_t k = 7000; k < 7100; ++k) pl_fake->setDirect(k, "p" + std::to_string(k));
+        pl_fake->setDirect(int64_t{1} << 40, "far"); // sparse key space: most partitions are empty
+        pl_fake->setDirect(7100, "");                   // empty values are values
+        pl_fake->setScannable(true);
+        pl.setPersistenceProvider(std::move(plPersistence), "test-double");
+        pl.setLoggingEnabled(false);
+        pl.setPreloadThreads(4);
+        pl.setupRoutes();
+        std::thread pt([&]() { pl.start(); });
+        if (!wait_until_up(host, pl_port)) {
+            std::cerr << "preload server did not start\n";
+            ++fails;
+        } else {
+            fails += !expect(pl_fake->scanCallCount() == 4, "preload scans one range per thread");
+            fails += !expect(pl_fake->multiGetCallCount() == 0, "a scannable provider is not preloaded with multiGet");
+            httplib::Client pc(host, pl_port);
+            int gets_before = pl_fake->getCallCount();
+            auto a = pc.Get("/get_key/7042");
+            auto b = pc.Get("/get_key/1099511627776");
+            fails += !expect(a && a->status == 200 && nlohmann::json::parse(a->body).value("value", "") == "p7042",
+                             "preloaded key served");
+            fails += !expect(b && b->status == 200, "preloaded key from the last partition served");
+            auto empty = pc.Get("/get_key/7100");
+            fails += !expect(empty && empty->status == 200 && nlohmann::json::parse(empty->body).value("value", "?").empty(),
+                             "preloaded empty value served");
+            fails += !expect(pl_fake->getCallCount() == gets_before, "preloaded keys are cache hits");
+            pc.Get("/stop");
+        }
+        if (pt.joinable()) pt.join();
+    }
+
+    // 13) Warm restart: the cache is snapshotted on /stop and restored at the next start, minus the entries
+    // persistence no longer confirms
+    {
+        const int ws_port = port + 4;
+        const std::string snapshot = "/tmp/kv_test_server_snapshot.bin";
+        std::remove(snapshot.c_str());
+        auto run_server = [&](std::unique_ptr<FakePersistence> persistence, const std::function<void()>& check) {
+            KeyValueServer ws{host, ws_port};
+            ws.setPersistenceProvider(std::move(persistence), "test-double");
+            ws.setSkipPreload(true);
+            ws.setLoggingEnabled(false);
+            ws.setSnapshot(snapshot);
+            ws.setupRoutes();
+            std::thread st([&]() { ws.start(); });
+            if (!wait_until_up(host, ws_port)) {
+                std::cerr << "snapshot server did not start\n";
+                ++fails;
+            } else {
+                check();
+                httplib::Client(host, ws_port).Get("/stop");
+            }
+            if (st.joinable()) st.join();
+        };
+
+        run_server(std::make_unique<FakePersistence>(), [&]() {
+            httplib::Client wc(host, ws_port);
+            for (int k = 7200; k < 7205; ++k) {
+                auto ins = wc.Post(("/insert/" + std::to_string(k) + "/w" + std::to_string(k)).c_str(), "", "application/json");
+                fails += !expect(ins && ins->status == 201, "snapshot server insert should return 201");
+            }
+        });
+        fails += !expect(std::filesystem::exists(snapshot), "/stop writes the snapshot");
+
+        // the next process finds 7203 rewritten and 7204 deleted behind the cache's back
+        auto wsPersistence = std::make_unique<FakePersistence>();
+        auto* ws_fake = wsPersistence.get();
+        for (int k = 7200; k < 7203; ++k) ws_fake->setDirect(k, "w" + std::to_string(k));
+        ws_fake->setDirect(7203, "fresh");
+        run_server(std::move(wsPersistence), [&]() {
+            httplib::Client rc(host, ws_port);
+            fails += !expect(ws_fake->multiGetCallCount() >= 1, "snapshot entries are validated against persistence");
+            int gets_before = ws_fake->getCallCount();
+            auto warm = rc.Get("/get_key/7201");
+            fails += !expect(warm && warm->status == 200 && nlohmann::json::parse(warm->body).value("value", "") == "w7201",
+                             "restored key served");
+            fails += !expect(ws_fake->getCallCount() == gets_before, "restored keys are cache hits");
+            auto changed = rc.Get("/get_key/7203");
+            fails += !expect(changed && changed->status == 200 && nlohmann::json::parse(changed->body).value("value", "") == "fresh",
+                             "entry changed since the snapshot is read from persistence");
+            auto erased = rc.Get("/get_key/7204");
+            fails += !expect(erased && erased->status == 404, "entry deleted since the snapshot is not restored");
+        });
+        std::remove(snapshot.c_str());
+    }
+
+    // 14) Hot-key profile: reads are profiled and saved on /stop; the next start preloads the hottest keys in the
+    // background instead of the range preload
+    {
+        const int hk_port = port + 5;
+        const std::string profile = "/tmp/kv_test_server_hot_keys.txt";
+        std::remove(profile.c_str());
+        auto seeded = []() {
+            auto persistence = std::make_unique<FakePersistence>();
+            for (int64_t k = 7300; k < 7400; ++k) persistence->setDirect(k, "h" + std::to_string(k));
+            persistence->setDirect(7330, ""); // an empty value is preloaded like any other
+            return persistence;
+        };
+        auto run_server = [&](std::unique_ptr<FakePersistence> persistence, bool skip_preload,
+                              const std::function<void(httplib::Client&)>& check) {
+            KeyValueServer hk{host, hk_port};
+            hk.setPersistenceProvider(std::move(persistence), "test-double");
+            hk.setSkipPreload(skip_preload);
+            hk.setLoggingEnabled(false);
+            hk.setHotKeyProfile(profile, std::chrono::seconds(0), 1);
+            hk.setupRoutes();
+            std::thread ht([&]() { hk.start(); });
+            if (!wait_until_up(host, hk_port)) {
+                std::cerr << "hot-key server did not start\n";
+                ++fails;
+            } else {
+                httplib::Client hc(host, hk_port);
+                check(hc);
+                hc.Get("/stop");
+            }
+            if (ht.joinable()) ht.join();
+        };
+
+        run_server(seeded(), true, [&](httplib::Client& hc) {
+            for (int i = 0; i < 5; ++i) hc.Get("/get_key/7310");
+            hc.Get("/get_key/7320");
+            hc.Patch("/bulk_query", R"({"data":[7320,7330]})", "application/json");
+            if (auto m = hc.Get("/metrics")) {
+                auto body = nlohmann::json::parse(m->body);
+                const auto& h = body["hot_keys"];
+                fails += !expect(h.value("enabled", false) && h.value("tracked", 0) == 3 && h.value("sampled", 0) == 8,
+                                 "/metrics reports the profiled keys");
+            } else { std::cerr << "GET /metrics (hot keys) failed\n"; ++fails; }
+        });
+        fails += !expect(std::filesystem::exists(profile), "/stop saves the hot-key profile");
+
+        auto hkPersistence = seeded();
+        auto* hk_fake = hkPersistence.get();
+        run_server(std::move(hkPersistence), false, [&](httplib::Client& hc) {
+            bool done = false;
+            for (int i = 0; i < 100 && !done; ++i) {
+                if (auto m = hc.Get("/metrics")) {
+                    auto body = nlohmann::json::parse(m->body);
+                    const auto& p = body["hot_keys"]["preload"];
+                    done = p.value("done", false);
+                    if (done) fails += !expect(p.value("keys", 0) == 3 && p.value("loaded", 0) == 3, "hot-key preload loaded the profiled keys");
+                }
+                if (!done) std::this_thread::sleep_for(10ms);
+            }
+            fails += !expect(done, "hot-key preload finishes in the background");
+            fails += !expect(hk_fake->multiGetCallCount() == 1, "hot keys replace the 1..1000 range preload");
+            int gets_before = hk_fake->getCallCount();
+            auto hot = hc.Get("/get_key/7310");
+            fails += !expect(hot && hot->status == 200 && nlohmann::json::parse(hot->body).value("value", "") == "h7310",
+                             "preloaded hot key served");
+            fails += !expect(hk_fake->getCallCount() == gets_before, "preloaded hot keys are cache hits");
+        });
+        std::remove(profile.c_str());
+    }
+
+    // 15) Embedded LocalStore as the persistence provider: writes survive a restart on the same directory and
+    // /metrics reports the storage engine
+    {
+        const int ls_port = port + 6;
+        const std::string data_dir = "/tmp/kv_test_server_local_store";
+        std::filesystem::remove_all(data_dir);
+        auto run_server = [&](const std::function<void(httplib::Client&)>& check) {
+            KeyValueServer ls{host, ls_port};
+            ls.setPersistenceProvider(std::make_unique<LocalStore>(data_dir), "local:" + data_dir);
+            ls.setSkipPreload(true);
+            ls.setLoggingEnabled(false);
+            ls.setupRoutes();
+            std::thread lt([&]() { ls.start(); });
+            if (!wait_until_up(host, ls_port)) {
+                std::cerr << "local-store server did not start\n";
+                ++fails;
+            } else {
+                httplib::Client lc(host, ls_port);
+                check(lc);
+                lc.Get("/stop");
+            }
+            if (lt.joinable()) lt.join();
+        };
+
+        run_server([&](httplib::Client& lc) {
+            auto ins = lc.Post("/insert/7500/durable", "", "application/json");
+            fails += !expect(ins && ins->status == 201, "insert into LocalStore");
+            lc.Post("/insert/7501/gone", "", "application/json");
+            auto del = lc.Delete("/delete_key/7501");
+            fails += !expect(del && del->status == 204, "delete from LocalStore");
+            lc.Post("/insert_skey/name/local", "", "application/json");
+            if (auto m = lc.Get("/metrics")) {
+                auto body = nlohmann::json::parse(m->body);
+                const auto& st = body["persistence_store"];
+                fails += !expect(st.value("engine", "") == "local" && st["log"].value("records", 0) == 4,
+                                 "/metrics reports the LocalStore engine");
+            } else { std::cerr << "GET /metrics (local store) failed\n"; ++fails; }
+        });
+        run_server([&](httplib::Client& lc) {
+            auto kept = lc.Get("/get_key/7500");
+            fails += !expect(kept && kept->status == 200 && nlohmann::json::parse(kept->body).value("value", "") == "durable",
+                             "LocalStore write survives a restart");
+            auto gone = lc.Get("/get_key/7501");
+            fails += !expect(gone && gone->status == 404, "LocalStore delete survives a restart");
+            auto skey = lc.Get("/get_skey/name");
+            fails += !expect(skey && skey->status == 200, "LocalStore string key survives a restart");
+        });
+        std::filesystem::remove_all(data_dir);
+    }
+
     if (fails == 0) {
         std::cout << "All server tests passed." << std::endl;
         return 0;
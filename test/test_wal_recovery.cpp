@@ -0,0 +1,398 @@
+#include "server.h"
+#include "local_store.h"
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+#include <csignal>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// Crash recovery of the write-ahead log: a child process serves writes in write-behind mode over a slow
+// LocalStore (so the queue lags well behind the acknowledgements) and is killed with SIGKILL while clients are
+// still writing. A new server on the same directories must replay the log so that every acknowledged insert,
+// update and delete is visible through the API and in the store itself. The log is checkpointed (rotated and
+// trimmed) several times during the run. A second crash checks that a single-key write racing /bulk_update on
+// the same key is replayed in the order it was acknowledged, and a third that a bulk update whose log append
+// fails after its commit is not undone by a replay either.
+
+using namespace std::chrono_literals;
+
+static bool expect(bool cond, const char* msg) {
+    if (!cond) std::cerr << "ASSERT FAILED: " << msg << "\n";
+    return cond;
+}
+
+static bool wait_until_up(const std::string& host, int port, int retries = 250, int ms = 20) {
+    httplib::Client cli(host, port);
+    cli.set_connection_timeout(0, 200000); // 200ms
+    for (int i = 0; i < retries; ++i) {
+        if (auto res = cli.Get("/")) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+    return false;
+}
+
+// LocalStore whose writes take write_delay, so write-behind flushes fall behind the clients.
+class SlowStore : public PersistenceProvider {
+public:
+    SlowStore(const std::string& dir, std::chrono::milliseconds write_delay) : store_(dir), delay_(write_delay) {}
+    bool insert(int64_t key, const std::string& value) override {
+        std::this_thread::sleep_for(delay_);
+        return store_.insert(key, value);
+    }
+    bool update(int64_t key, const std::string& value) override {
+        std::this_thread::sleep_for(delay_);
+        return store_.update(key, value);
+    }
+    bool remove(int64_t key) override {
+        std::this_thread::sleep_for(delay_);
+        return store_.remove(key);
+    }
+    std::unique_ptr<std::string> get(int64_t key) override { return store_.get(key); }
+    std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t>& keys) override { return store_.multiGet(keys); }
+
+private:
+    LocalStore store_;
+    std::chrono::milliseconds delay_;
+};
+
+// LocalStore whose inserts of one value take write_delay: holds a /bulk_update transaction writing that value open.
+class GatedStore : public PersistenceProvider {
+public:
+    GatedStore(const std::string& dir, std::string gated_value, std::chrono::milliseconds write_delay)
+        : store_(dir), gated_(std::move(gated_value)), delay_(write_delay) {}
+    bool insert(int64_t key, const std::string& value) override {
+        if (value == gated_) std::this_thread::sleep_for(delay_);
+        return store_.insert(key, value);
+    }
+    bool update(int64_t key, const std::string& value) override { return store_.update(key, value); }
+    bool remove(int64_t key) override { return store_.remove(key); }
+    std::unique_ptr<std::string> get(int64_t key) override { return store_.get(key); }
+    std::unordered_map<int64_t, std::string> multiGet(const std::vector<int64_t>& keys) override { return store_.multiGet(keys); }
+
+private:
+    LocalStore store_;
+    std::string gated_;
+    std::chrono::milliseconds delay_;
+};
+
+// What the clients were told: the value of every key with an acknowledged write (nullopt: deleted), and the
+// keys whose last request got no answer, which may or may not have been applied.
+struct Model {
+    std::map<int64_t, std::optional<std::string>> acked;
+    std::set<int64_t> uncertain;
+};
+
+int main() {
+    const std::string host = "localhost";
+    const int port = 23895; // test port
+    const std::string base = (std::filesystem::temp_directory_path() / ("kv_test_wal_recovery-" + std::to_string(::getpid()))).string();
+    const std::string store_dir = base + "/store";
+    const std::string wal_dir = base + "/wal";
+    std::filesystem::remove_all(base);
+    int fails = 0;
+
+    pid_t child = ::fork();
+    if (child < 0) {
+        std::cerr << "fork failed\n";
+        return 2;
+    }
+    if (child == 0) {
+        KeyValueServer server{host, port};
+        server.setPersistenceProvider(std::make_unique<SlowStore>(store_dir, 2ms), "slow-local");
+        server.setWriteMode(KeyValueServer::WriteMode::Behind);
+        server.setWal(wal_dir, std::chrono::microseconds(0), KeyValueServer::default_wal_sync_batch, 16 * 1024);
+        server.setSkipPreload(true);
+        server.setLoggingEnabled(false);
+        server.setupRoutes();
+        server.start();
+        ::_exit(0);
+    }
+
+    if (!wait_until_up(host, port)) {
+        std::cerr << "crashing server did not start\n";
+        ::kill(child, SIGKILL);
+        ::waitpid(child, nullptr, 0);
+        return 2;
+    }
+
+    // 4 writers on disjoint keys: insert i, update i-1 every 3rd step, delete i-2 every 5th step
+    const int writers = 4;
+    std::vector<Model> models(writers);
+    std::atomic<size_t> acked{0};
+    std::vector<std::thread> clients;
+    for (int t = 0; t < writers; ++t) {
+        clients.emplace_back([&, t]() {
+            httplib::Client cli(host, port);
+            cli.set_connection_timeout(1, 0);
+            cli.set_read_timeout(2, 0);
+            Model& model = models[t];
+            const int64_t first = (t + 1) * 1000000;
+            for (int64_t i = 0;; ++i) {
+                struct Step {
+                    int64_t key;
+                    std::optional<std::string> value;
+                    bool update;
+                };
+                std::vector<Step> steps{{first + i, "v" + std::to_string(i), false}};
+                if (i % 3 == 2) steps.push_back({first + i - 1, "u" + std::to_string(i - 1), true});
+                if (i % 5 == 4 && model.acked[first + i - 2]) steps.push_back({first + i - 2, std::nullopt, false});
+                for (const Step& step : steps) {
+                    const std::string k = std::to_string(step.key);
+                    httplib::Result res = !step.value ? cli.Delete("/delete_key/" + k)
+                                          : step.update ? cli.Put("/update_key/" + k + "/" + *step.value, "", "application/json")
+                                                        : cli.Post("/insert/" + k + "/" + *step.value, "", "application/json");
+                    if (!res) {
+                        model.uncertain.insert(step.key); // killed mid-request
+                        return;
+                    }
+                    if (res->status >= 300) {
+                        std::cerr << "unexpected status " << res->status << " for key " << k << "\n";
+                        model.uncertain.insert(step.key);
+                        return;
+                    }
+                    model.acked[step.key] = step.value;
+                    acked.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // kill it mid-stream, after a couple of checkpoints had the chance to run
+    auto deadline = std::chrono::steady_clock::now() + 2500ms;
+    while (std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(10ms);
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+    for (auto& c : clients) c.join();
+    fails += !expect(acked.load() > 1000, "clients got writes acknowledged before the crash");
+
+    // restart on the same directories (full-speed store) and check every acknowledged write
+    size_t checked = 0;
+    {
+        KeyValueServer server{host, port};
+        server.setPersistenceProvider(std::make_unique<LocalStore>(store_dir), "local");
+        server.setWriteMode(KeyValueServer::WriteMode::Behind);
+        server.setWal(wal_dir);
+        server.setSkipPreload(true);
+        server.setLoggingEnabled(false);
+        server.setupRoutes();
+        std::thread st([&]() { server.start(); });
+        if (!wait_until_up(host, port)) {
+            std::cerr << "restarted server did not start\n";
+            ++fails;
+        } else {
+            httplib::Client cli(host, port);
+            if (auto m = cli.Get("/metrics")) {
+                auto body = nlohmann::json::parse(m->body);
+                const auto& wal = body["wal"];
+                fails += !expect(wal.value("enabled", false) && wal["replayed"].value("writes", 0) > 0,
+                                 "the restart replayed writes the crashed server had not persisted");
+            } else { std::cerr << "GET /metrics failed\n"; ++fails; }
+            bool all = true;
+            for (const Model& model : models) {
+                for (const auto& [key, value] : model.acked) {
+                    if (model.uncertain.count(key)) continue;
+                    auto res = cli.Get("/get_key/" + std::to_string(key));
+                    bool ok = res && (value ? res->status == 200 && nlohmann::json::parse(res->body).value("value", "") == *value
+                                            : res->status == 404);
+                    if (!ok && all) std::cerr << "key " << key << " lost its acknowledged write\n";
+                    all = all && ok;
+                    ++checked;
+                }
+            }
+            fails += !expect(all, "every acknowledged write survives the crash");
+            cli.Get("/stop");
+        }
+        if (st.joinable()) st.join();
+    }
+
+    // the replay (and the drain on stop) put the writes into the store itself, and a clean stop leaves no log
+    {
+        LocalStore store(store_dir);
+        bool all = true;
+        for (const Model& model : models) {
+            for (const auto& [key, value] : model.acked) {
+                if (model.uncertain.count(key)) continue;
+                auto stored = store.get(key);
+                all = all && (value ? stored && *stored == *value : !stored);
+            }
+        }
+        fails += !expect(all, "acknowledged writes are persisted after the restart");
+    }
+    size_t logs_with_records = 0;
+    for (const auto& e : std::filesystem::directory_iterator(wal_dir)) {
+        if (std::filesystem::file_size(e.path()) > 0) ++logs_with_records;
+    }
+    fails += !expect(logs_with_records == 0, "a clean stop leaves nothing to replay");
+    std::filesystem::remove_all(base);
+
+    // Replay order: a single-key write that arrives while /bulk_update holds its transaction open on the same
+    // key is acknowledged after the bulk update, so after a crash the log must restore it, not the bulk value
+    {
+        const int bulk_port = port + 1;
+        std::filesystem::remove_all(base);
+        pid_t bulk_child = ::fork();
+        if (bulk_child < 0) {
+            std::cerr << "fork failed\n";
+            return 2;
+        }
+        if (bulk_child == 0) {
+            KeyValueServer server{host, bulk_port};
+            server.setPersistenceProvider(std::make_unique<GatedStore>(store_dir, "bulk", 600ms), "gated-local");
+            server.setWriteMode(KeyValueServer::WriteMode::Behind);
+            server.setWal(wal_dir);
+            server.setSkipPreload(true);
+            server.setLoggingEnabled(false);
+            server.setupRoutes();
+            server.start();
+            ::_exit(0);
+        }
+        if (!wait_until_up(host, bulk_port)) {
+            std::cerr << "bulk update server did not start\n";
+            ::kill(bulk_child, SIGKILL);
+            ::waitpid(bulk_child, nullptr, 0);
+            return 2;
+        }
+        httplib::Client cli(host, bulk_port);
+        cli.set_read_timeout(5, 0);
+        auto first = cli.Post("/insert/7/first", "", "application/json");
+        fails += !expect(first && first->status == 201, "bulk order: key inserted");
+        bool bulk_ok = false;
+        std::thread bulk([&]() {
+            httplib::Client bulk_cli(host, bulk_port);
+            bulk_cli.set_read_timeout(5, 0);
+            const std::string body = R"({"operations":[{"operation":"insert","key":7,"value":"bulk"}]})";
+            auto res = bulk_cli.Post("/bulk_update", body, "application/json");
+            bulk_ok = res && res->status == 200 && nlohmann::json::parse(res->body).value("success", false);
+        });
+        std::this_thread::sleep_for(150ms); // the bulk transaction is now inside the gated insert
+        auto newer = cli.Put("/update_key/7/newer", "", "application/json");
+        bulk.join();
+        fails += !expect(bulk_ok, "bulk order: bulk update committed");
+        fails += !expect(newer && newer->status == 200, "bulk order: single-key write acknowledged");
+        auto live = cli.Get("/get_key/7");
+        fails += !expect(live && live->status == 200 && nlohmann::json::parse(live->body).value("value", "") == "newer",
+                         "bulk order: the later write wins in the cache");
+        ::kill(bulk_child, SIGKILL);
+        ::waitpid(bulk_child, nullptr, 0);
+
+        KeyValueServer server{host, bulk_port};
+        server.setPersistenceProvider(std::make_unique<LocalStore>(store_dir), "local");
+        server.setWriteMode(KeyValueServer::WriteMode::Behind);
+        server.setWal(wal_dir);
+        server.setSkipPreload(true);
+        server.setLoggingEnabled(false);
+        server.setupRoutes();
+        std::thread st([&]() { server.start(); });
+        if (!wait_until_up(host, bulk_port)) {
+            std::cerr << "restarted bulk update server did not start\n";
+            ++fails;
+        } else {
+            auto after = cli.Get("/get_key/7");
+            fails += !expect(after && after->status == 200 && nlohmann::json::parse(after->body).value("value", "") == "newer",
+                             "bulk order: replay keeps the write acknowledged after the bulk update");
+            cli.Get("/stop");
+        }
+        if (st.joinable()) st.join();
+        std::filesystem::remove_all(base);
+    }
+
+    // A bulk update whose log append fails after the commit: the server checkpoints instead, so the older logged
+    // write to its key is not replayed over the committed value after a crash
+    {
+        const int failing_port = port + 2;
+        const std::string trigger = base + "-fail-log";
+        std::filesystem::remove_all(base);
+        std::remove(trigger.c_str());
+        pid_t failing_child = ::fork();
+        if (failing_child < 0) {
+            std::cerr << "fork failed\n";
+            return 2;
+        }
+        if (failing_child == 0) {
+            // once trigger exists, writes to the open log file hit a full device
+            std::thread breaker([&]() {
+                while (!std::filesystem::exists(trigger)) std::this_thread::sleep_for(5ms);
+                int full = ::open("/dev/full", O_WRONLY);
+                for (const auto& e : std::filesystem::directory_iterator("/proc/self/fd")) {
+                    std::error_code ec;
+                    auto target = std::filesystem::read_symlink(e.path(), ec);
+                    if (!ec && target.parent_path() == std::filesystem::path(wal_dir) && target.extension() == ".log") {
+                        ::dup2(full, std::stoi(e.path().filename().string()));
+                    }
+                }
+            });
+            breaker.detach();
+            KeyValueServer server{host, failing_port};
+            server.setPersistenceProvider(std::make_unique<LocalStore>(store_dir), "local");
+            server.setWriteMode(KeyValueServer::WriteMode::Behind);
+            server.setWal(wal_dir);
+            server.setSkipPreload(true);
+            server.setLoggingEnabled(false);
+            server.setupRoutes();
+            server.start();
+            ::_exit(0);
+        }
+        if (!wait_until_up(host, failing_port)) {
+            std::cerr << "failing-log server did not start\n";
+            ::kill(failing_child, SIGKILL);
+            ::waitpid(failing_child, nullptr, 0);
+            return 2;
+        }
+        httplib::Client cli(host, failing_port);
+        cli.set_read_timeout(10, 0);
+        auto old = cli.Post("/insert/9/old", "", "application/json");
+        fails += !expect(old && old->status == 201, "failed log: key inserted");
+        std::ofstream(trigger).put('x');
+        std::this_thread::sleep_for(100ms);
+        const std::string body = R"({"operations":[{"operation":"update","key":9,"value":"bulk"}]})";
+        auto bulk = cli.Post("/bulk_update", body, "application/json");
+        fails += !expect(bulk && bulk->status == 200 && nlohmann::json::parse(bulk->body).value("success", false),
+                         "failed log: a checkpoint covers the committed bulk update");
+        ::kill(failing_child, SIGKILL);
+        ::waitpid(failing_child, nullptr, 0);
+        std::remove(trigger.c_str());
+
+        KeyValueServer server{host, failing_port};
+        server.setPersistenceProvider(std::make_unique<LocalStore>(store_dir), "local");
+        server.setWriteMode(KeyValueServer::WriteMode::Behind);
+        server.setWal(wal_dir);
+        server.setSkipPreload(true);
+        server.setLoggingEnabled(false);
+        server.setupRoutes();
+        std::thread st([&]() { server.start(); });
+        if (!wait_until_up(host, failing_port)) {
+            std::cerr << "restarted failing-log server did not start\n";
+            ++fails;
+        } else {
+            auto after = cli.Get("/get_key/9");
+            fails += !expect(after && after->status == 200 && nlohmann::json::parse(after->body).value("value", "") == "bulk",
+                             "failed log: replay does not restore the write older than the bulk update");
+            cli.Get("/stop");
+        }
+        if (st.joinable()) st.join();
+        std::filesystem::remove_all(base);
+    }
+
+    if (fails == 0) {
+        std::cout << "All WAL recovery tests passed (" << acked.load() << " writes acknowledged, " << checked
+                  << " keys checked)." << std::endl;
+        return 0;
+    }
+    std::cerr << fails << " WAL recovery test(s) failed." << std::endl;
+    return 1;
+}